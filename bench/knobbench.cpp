@@ -0,0 +1,1939 @@
+// Headless benchmark for the rotary knob renderer and drag input.
+// Renders knobs with the software rasterizer and runs the drag math, without Cinema 4D.
+//
+// Build (from the repository root):
+//   g++ -std=c++11 -O2 -pthread -Isource -o knobbench bench/knobbench.cpp source/render/*.cpp source/input/*.cpp
+//
+// Usage:
+//   knobbench [-knobs N,...] [-frames N] [-size N,...] [-oversampling N,...] [-noaa] [-simd scalar|sse2|avx2] [-full] [-atlas N] [-glyphs] [-ticks N] [-drag N] [-savedrag prefix] [-json file] [-ppm file]
+//   knobbench -replay file [-replay file ...] [-frames N] [-json file]
+//   knobbench -dragloop ms [-json file]
+//   knobbench -feed ms [-feedfile file] [-savefeed file] [-json file]
+//   knobbench -asyncdrag [-drag N] [-size N] [-oversampling N] [-noaa] [-atlas N] [-glyphs] [-json file]
+//   knobbench -batch N,... [-knobs N] [-frames N] [-size N] [-oversampling N] [-noaa] [-atlas N] [-glyphs] [-json file] [-ppm file]
+//   knobbench -layercache N [-knobs N] [-frames N] [-size N,...] [-oversampling N,...] [-noaa] [-glyphs] [-json file]
+//   knobbench -assetfile file [-size N,...] [-oversampling N,...] [-noaa] [-atlas N] [-json file]
+//   knobbench -triangles [-frames N] [-size N,...] [-oversampling N,...] [-simd scalar|sse2|avx2] [-json file]
+//
+//   -knobs, -size, -oversampling
+//             Take a comma separated list of values, all combinations are measured
+//   -noaa     Draw without anti-aliasing (use -oversampling 2 for the old look, which
+//             is what the GeClipMap primitives draw in Cinema 4D)
+//   -simd     Instruction set for the anti-aliasing kernels (default: sse2 if supported, avx2 only when selected)
+//   -full     Redraw all layers in every frame, instead of using the cached static layer
+//   -atlas N  Draw the marker from a pre-rendered atlas with N angles (0 = automatic)
+//   -glyphs   Draw the label from a pre-rendered glyph atlas
+//   -ticks N  Number of intervals on the scale (default 10)
+//   -drag N   Number of mouse events per simulated drag (default 1000)
+//   -savedrag Save the simulated drags of the first configuration as prefix-linear.txt and prefix-circular.txt
+//   -replay   Replay a drag recorded in Cinema 4D (or with -savedrag) through the knob's drag code, -frames times.
+//             Fails if the values are not bit-identical to the recorded ones. Nothing is drawn in this mode.
+//   -dragloop Run a simulated drag loop for the given time, once processing every event and once paced to 60 frames
+//             per second, and compare the CPU time per second of dragging. Nothing is drawn in this mode.
+//   -feed     Send a controller stream of the given length (1000 values per second) through a KnobValueRing, with
+//             the stand-in producer thread, once as fast as possible and once with the timing of the stream and a
+//             consumer that drains the ring once per frame like the CustomGUI. Nothing is drawn in this mode.
+//   -feedfile Use a recorded controller stream for -feed instead of the generated one
+//   -savefeed Save the controller stream of -feed to a file, in the format of recorded controller streams
+//   -asyncdrag Simulate a linear drag that draws every changed frame, once on the input thread and once through the
+//             render thread of KnobAsyncRenderer, and compare the time the input thread spends per mouse event.
+//   -batch    Render a bank of knobs (the first -knobs value, default 100) with the batch renderer, like a preset switch,
+//             -frames times for each of the given thread counts. Checks that the frames are identical to the ones
+//             drawn one after the other, and reports the time per bank and the speedup over one thread.
+//   -layercache Draw a panel of knobs (the first -knobs value) in all combinations of -size and -oversampling, mixed, with
+//             one renderer, -frames times. Once drawing the static layer whenever the size changes, and once taking it
+//             from a KnobStaticLayerCache with N layers (0 = default). Checks that the frames are identical.
+//   -assetfile Draw the first frame of a knob in all combinations of -size and -oversampling, with marker and glyph
+//             atlas, once drawing all assets and saving them to a KnobAssetCache file, and once with the file mapped
+//             like in the next session, and once with a copy of the file whose last asset is damaged. Checks that the
+//             frames are identical, that stale files are rejected, and that the damaged asset is drawn again.
+//   -triangles Fill the anti-aliased marker triangle at 256 angles, -frames times for each combination of -size and
+//             -oversampling, once with the version of the polygon fill for 3 corners and once with the one for any
+//             number of corners. Checks that the pixels are identical, and reports the time per triangle.
+//   -json     Write all results as JSON to a file, "-" for stdout
+//
+// For each configuration, the benchmark measures:
+//   - Frame time: all knobs drawn once, like a panel redraw
+//   - Stages: time per knob for each part of a frame (static layer, marker, label, ...)
+//   - Drag latency: time from a mouse event to the new value, label and redraw decision,
+//     for linear and circular dragging
+//   - Allocations: heap allocations per frame, after the first frame
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#include "render/knobassetcache.h"
+#include "render/knobasyncrenderer.h"
+#include "render/knobbatchrenderer.h"
+#include "render/knobbufferpool.h"
+#include "render/knobglyphatlas.h"
+#include "render/knoblabel.h"
+#include "render/knobpainter.h"
+#include "render/knobmarkeratlas.h"
+#include "render/knobrasterizer.h"
+#include "render/knobsimd.h"
+#include "render/knobstaticlayercache.h"
+#include "input/knobcontrollerreplay.h"
+#include "input/knobdragrecording.h"
+#include "input/knobdragsession.h"
+#include "input/knobframepacer.h"
+
+
+/// Number of heap allocations since the start of the program. Counted by the operator new replacements below,
+/// atomic because the batch and async renderers allocate on their own threads.
+static std::atomic<int64_t> g_allocationCount(0);
+
+void *operator new(size_t size)
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	void *p = malloc(size > 0 ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size)
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	void *p = malloc(size > 0 ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size > 0 ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	return malloc(size > 0 ? size : 1);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+
+typedef std::chrono::steady_clock BenchClock;
+
+/// Return the time between two points in microseconds
+static inline double GetMicroseconds(BenchClock::time_point start, BenchClock::time_point end)
+{
+	return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+
+/// Benchmark settings, parsed from the command line
+struct BenchSettings
+{
+	std::vector<int32_t> knobCounts;     ///< Numbers of knobs to draw per frame
+	std::vector<int32_t> sizes;          ///< Knob widths in pixels
+	std::vector<int32_t> oversamplings;  ///< Oversampling factors
+	int32_t frameCount;    ///< Number of frames to draw
+	bool antialiasing;     ///< Draw with anti-aliasing
+	bool fullRedraw;       ///< Don't use the static layer cache
+	int32_t atlasCells;    ///< Number of marker atlas cells, -1 to not use the atlas
+	bool glyphAtlas;       ///< Draw the label from a glyph atlas
+	int32_t scaleTicks;    ///< Number of intervals on the scale
+	int32_t dragEvents;    ///< Number of mouse events per simulated drag
+	const char *jsonFile;  ///< If set, the results are written to this file as JSON
+	const char *ppmFile;   ///< If set, the last drawn knob is written to this file
+	const char *saveDragPrefix;  ///< If set, the simulated drags are saved with this file name prefix
+	std::vector<const char*> replayFiles;  ///< Recorded drags to replay
+	int32_t dragLoopTime;  ///< Duration of the simulated drag loops in milliseconds, 0 to not run them
+	std::vector<int32_t> batchThreads;  ///< Thread counts for the batch renderer, empty to not run it
+	bool asyncDrag;        ///< Compare drawing during a drag on the input thread and on the render thread
+	int32_t feedTime;      ///< Length of the generated controller stream in milliseconds, 0 to not run the feed
+	const char *feedFile;  ///< If set, the controller stream is read from this file
+	const char *saveFeedFile;  ///< If set, the controller stream is saved to this file
+	int32_t layerCacheSize;    ///< Number of layers for the static layer cache comparison, -1 to not run it
+	const char *assetFile;     ///< If set, the asset file comparison is run with this file
+	bool triangles;            ///< Compare the versions of the anti-aliased polygon fill for triangles
+
+	BenchSettings() : frameCount(100), antialiasing(true), fullRedraw(false), atlasCells(-1), glyphAtlas(false), scaleTicks(KNOBPAINTER_SCALETICKS), dragEvents(1000), jsonFile(nullptr), ppmFile(nullptr), saveDragPrefix(nullptr), dragLoopTime(0), asyncDrag(false), feedTime(0), feedFile(nullptr), saveFeedFile(nullptr), layerCacheSize(-1), assetFile(nullptr), triangles(false)
+	{}
+};
+
+
+/// Distribution of a series of measurements
+struct BenchStatistics
+{
+	double mean;
+	double min;
+	double p50;
+	double p95;
+	double p99;
+	double max;
+
+	BenchStatistics() : mean(0.0), min(0.0), p50(0.0), p95(0.0), p99(0.0), max(0.0)
+	{}
+
+	/// Compute the statistics of a series. The series is sorted in the process.
+	static BenchStatistics Compute(std::vector<double> &values)
+	{
+		BenchStatistics result;
+		if (values.empty())
+			return result;
+
+		std::sort(values.begin(), values.end());
+
+		double sum = 0.0;
+		for (size_t i = 0; i < values.size(); ++i)
+			sum += values[i];
+
+		const size_t last = values.size() - 1;
+		result.mean = sum / (double)values.size();
+		result.min = values[0];
+		result.p50 = values[last * 50 / 100];
+		result.p95 = values[last * 95 / 100];
+		result.p99 = values[last * 99 / 100];
+		result.max = values[last];
+		return result;
+	}
+};
+
+
+/// Parts of a frame that are timed separately
+enum BenchStage
+{
+	BENCHSTAGE_BACKGROUND = 0,
+	BENCHSTAGE_SCALE,
+	BENCHSTAGE_BODY,
+	BENCHSTAGE_STATICLAYER,
+	BENCHSTAGE_MARKER,
+	BENCHSTAGE_LABEL,
+	BENCHSTAGE_COUNT
+};
+
+static const char *g_benchStageNames[BENCHSTAGE_COUNT] = { "background", "scale", "body", "staticlayer", "marker", "label" };
+
+
+/// Results of one configuration
+struct BenchResult
+{
+	int32_t knobCount;
+	int32_t size;
+	int32_t oversampling;
+	const char *mode;
+
+	double totalMs;                          ///< Time for all frames
+	BenchStatistics frameMs;                 ///< Time per frame (all knobs)
+	double stageUs[BENCHSTAGE_COUNT];        ///< Average time per knob for each stage, -1 if the stage is not part of the frame
+	BenchStatistics linearDragUs;            ///< Time from mouse event to value, linear mode
+	BenchStatistics circularDragUs;          ///< Time from mouse event to value, circular mode
+	int32_t dragRedraws;                     ///< Events of the linear drag that needed a redraw
+	double allocationsPerFrame;              ///< Heap allocations per frame, after the first frame
+
+	BenchResult() : knobCount(0), size(0), oversampling(0), mode(""), totalMs(0.0), dragRedraws(0), allocationsPerFrame(0.0)
+	{
+		for (int32_t i = 0; i < BENCHSTAGE_COUNT; ++i)
+			stageUs[i] = -1.0;
+	}
+};
+
+
+/// Write a pixel buffer to a binary PPM file
+static bool WritePpm(const KnobPixelBuffer &buffer, const char *filename)
+{
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return false;
+
+	fprintf(file, "P6\n%d %d\n255\n", buffer.GetWidth(), buffer.GetHeight());
+	for (int32_t y = 0; y < buffer.GetHeight(); ++y)
+	{
+		const KnobColor *row = buffer.GetRow(y);
+		for (int32_t x = 0; x < buffer.GetWidth(); ++x)
+		{
+			const uint8_t rgb[3] = { row[x].r, row[x].g, row[x].b };
+			fwrite(rgb, 1, 3, file);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+/// Parse a comma separated list of positive numbers
+static bool ParseList(const char *text, std::vector<int32_t> &values)
+{
+	values.clear();
+	while (*text != 0)
+	{
+		char *end = nullptr;
+		const long value = strtol(text, &end, 10);
+		if (end == text || value <= 0)
+			return false;
+
+		values.push_back((int32_t)value);
+		text = *end == ',' ? end + 1 : end;
+	}
+
+	return !values.empty();
+}
+
+static bool ParseArguments(int argc, char **argv, BenchSettings &settings)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "-knobs") == 0 && hasValue)
+		{
+			if (!ParseList(argv[++i], settings.knobCounts))
+				return false;
+		}
+		else if (strcmp(argv[i], "-frames") == 0 && hasValue)
+			settings.frameCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-size") == 0 && hasValue)
+		{
+			if (!ParseList(argv[++i], settings.sizes))
+				return false;
+		}
+		else if (strcmp(argv[i], "-oversampling") == 0 && hasValue)
+		{
+			if (!ParseList(argv[++i], settings.oversamplings))
+				return false;
+		}
+		else if (strcmp(argv[i], "-noaa") == 0)
+			settings.antialiasing = false;
+		else if (strcmp(argv[i], "-simd") == 0 && hasValue)
+		{
+			++i;
+			if (strcmp(argv[i], "scalar") == 0)
+				SetKnobSimdLevel(KNOBSIMD_SCALAR);
+			else if (strcmp(argv[i], "sse2") == 0)
+				SetKnobSimdLevel(KNOBSIMD_SSE2);
+			else if (strcmp(argv[i], "avx2") == 0)
+				SetKnobSimdLevel(KNOBSIMD_AVX2);
+			else
+				return false;
+		}
+		else if (strcmp(argv[i], "-full") == 0)
+			settings.fullRedraw = true;
+		else if (strcmp(argv[i], "-atlas") == 0 && hasValue)
+			settings.atlasCells = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-glyphs") == 0)
+			settings.glyphAtlas = true;
+		else if (strcmp(argv[i], "-ticks") == 0 && hasValue)
+			settings.scaleTicks = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-drag") == 0 && hasValue)
+			settings.dragEvents = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-savedrag") == 0 && hasValue)
+			settings.saveDragPrefix = argv[++i];
+		else if (strcmp(argv[i], "-replay") == 0 && hasValue)
+			settings.replayFiles.push_back(argv[++i]);
+		else if (strcmp(argv[i], "-dragloop") == 0 && hasValue)
+			settings.dragLoopTime = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-feed") == 0 && hasValue)
+			settings.feedTime = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-feedfile") == 0 && hasValue)
+			settings.feedFile = argv[++i];
+		else if (strcmp(argv[i], "-savefeed") == 0 && hasValue)
+			settings.saveFeedFile = argv[++i];
+		else if (strcmp(argv[i], "-asyncdrag") == 0)
+			settings.asyncDrag = true;
+		else if (strcmp(argv[i], "-batch") == 0 && hasValue)
+		{
+			if (!ParseList(argv[++i], settings.batchThreads))
+				return false;
+		}
+		else if (strcmp(argv[i], "-assetfile") == 0 && hasValue)
+			settings.assetFile = argv[++i];
+		else if (strcmp(argv[i], "-layercache") == 0 && hasValue)
+			settings.layerCacheSize = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-triangles") == 0)
+			settings.triangles = true;
+		else if (strcmp(argv[i], "-json") == 0 && hasValue)
+			settings.jsonFile = argv[++i];
+		else if (strcmp(argv[i], "-ppm") == 0 && hasValue)
+			settings.ppmFile = argv[++i];
+		else
+			return false;
+	}
+
+	if (settings.knobCounts.empty())
+		settings.knobCounts.push_back(100);
+	if (settings.sizes.empty())
+		settings.sizes.push_back(100);
+	if (settings.oversamplings.empty())
+		settings.oversamplings.push_back(1);
+
+	return settings.frameCount > 0 && settings.dragEvents > 0;
+}
+
+
+/// Simulate a mouse drag and measure the time from each mouse event to the new value,
+/// including everything the knob does before it asks for a redraw
+/// @param[in] drawValues The draw values
+/// @param[in] circular True for circular, false for linear dragging
+/// @param[in] eventCount Number of mouse events
+/// @param[out] statistics Time per event in microseconds
+/// @param[out] recording If not nullptr, receives the drag
+/// @return Number of events that changed what the knob looks like
+static int32_t MeasureDrag(const KnobDrawValues &drawValues, bool circular, int32_t eventCount, BenchStatistics &statistics, KnobDragRecording *recording)
+{
+	// The knob area on screen, like the CustomGUI sets it up
+	const double width = (double)drawValues.areaWidth / (double)drawValues.oversampling;
+	KnobDragSettings dragSettings;
+	dragSettings.circular = circular;
+	dragSettings.centerX = dragSettings.centerY = width / 2.0;
+
+	KnobDragSession session(dragSettings, 60);
+	KnobLabelFormatter labelFormatter;
+	labelFormatter.SetFormat(0.01, KNOBLABEL_UNIT_NONE);
+
+	// The drag is recorded, so it can be saved and replayed
+	if (recording)
+		session.SetRecording(recording);
+	session.Start(0.0, width / 2.0, width, 0.0);
+
+	KnobVisualState drawnState;
+	std::vector<double> times;
+	times.reserve((size_t)eventCount);
+	int32_t redraws = 0;
+
+	for (int32_t event = 0; event < eventCount; ++event)
+	{
+		// Linear: move up and down over the whole range. Circular: move around the knob along the scale.
+		double mouseX = width / 2.0;
+		double mouseY = width;
+		const double phase = (double)(event % 200) / 100.0;
+		const double sweep = phase <= 1.0 ? phase : 2.0 - phase;
+		if (circular)
+		{
+			const double angle = (sweep * 2.0 - 1.0) * 2.5;
+			mouseX = width / 2.0 + sin(angle) * width * 0.4;
+			mouseY = width / 2.0 - cos(angle) * width * 0.4;
+		}
+		else
+		{
+			mouseY = width - sweep / dragSettings.multiplier;
+		}
+
+		// What RotaryKnobArea::InputEvent() and RedrawIfChanged() do for a mouse event
+		const BenchClock::time_point start = BenchClock::now();
+
+		const KnobDragStep step = session.Update(KnobDragEvent((double)event, mouseX, mouseY, 0));
+		bool redraw = false;
+		if (step.changed)
+		{
+			KnobVisualState state;
+			GetKnobMarkerKey(drawValues, KnobValueToAngle(step.value, dragSettings.minValue, dragSettings.maxValue, drawValues), state.markerPoints);
+			strncpy(state.label, labelFormatter.GetLabel(step.value), sizeof(state.label) - 1);
+			state.label[sizeof(state.label) - 1] = 0;
+			if (state != drawnState)
+			{
+				drawnState = state;
+				redraw = true;
+			}
+		}
+
+		times.push_back(GetMicroseconds(start, BenchClock::now()));
+		if (redraw)
+			++redraws;
+	}
+
+	double finalValue = 0.0;
+	session.Finish(finalValue);
+
+	statistics = BenchStatistics::Compute(times);
+	return redraws;
+}
+
+/// Draw frames of one configuration and measure everything
+/// @param[out] linearDrag If not nullptr, receives the simulated linear drag
+/// @param[out] circularDrag If not nullptr, receives the simulated circular drag
+/// @return False if something could not be set up
+static bool RunBenchmark(const BenchSettings &settings, int32_t knobCount, int32_t size, int32_t oversampling, KnobPixelBuffer &buffer, BenchResult &result, KnobDragRecording *linearDrag, KnobDragRecording *circularDrag)
+{
+	result.knobCount = knobCount;
+	result.size = size;
+	result.oversampling = oversampling;
+
+	// Same constants as the CustomGUI
+	KnobDrawValues drawValues;
+	KnobRasterizer rasterizer(buffer);
+	rasterizer.SetAntialiasing(settings.antialiasing);
+	rasterizer.SetFontSize(14 * oversampling);
+	drawValues.InitGeometry(size, oversampling, 5, 135.0, 14, rasterizer.GetTextHeight(), settings.antialiasing, settings.scaleTicks);
+	drawValues.SetTheme(KnobTheme::Default());
+
+	// All knobs share the same look, so the static layer only has to be drawn once
+	if (!settings.fullRedraw && !DrawKnobStaticLayer(rasterizer, drawValues))
+		return false;
+
+	// The atlas is built before the clock starts, like it would be shared between knobs in Cinema 4D
+	std::shared_ptr<const KnobMarkerAtlas> atlas;
+	if (!settings.fullRedraw && settings.atlasCells >= 0)
+	{
+		atlas = AcquireKnobMarkerAtlas(drawValues, settings.atlasCells);
+		if (!atlas)
+			return false;
+	}
+	result.mode = settings.fullRedraw ? "full" : (atlas ? "atlas" : "layered");
+
+	// Glyphs of the built-in font, at the label size
+	KnobGlyphAtlas glyphAtlas;
+	if (settings.glyphAtlas)
+	{
+		KnobBuiltinGlyphSource glyphSource(drawValues.labelFontSize);
+		if (!glyphAtlas.Build(glyphSource))
+			return false;
+	}
+	const KnobGlyphAtlas *glyphs = settings.glyphAtlas ? &glyphAtlas : nullptr;
+
+	// Values sweep in steps of 0.01
+	KnobLabelFormatter labelFormatter;
+	labelFormatter.SetFormat(0.01, KNOBLABEL_UNIT_NONE);
+
+	// Frames, timed as a whole
+	std::vector<double> frameTimes;
+	frameTimes.reserve((size_t)settings.frameCount);
+	int64_t allocationsAfterFirstFrame = 0;
+
+	for (int32_t frame = 0; frame < settings.frameCount; ++frame)
+	{
+		if (frame == 1)
+			allocationsAfterFirstFrame = g_allocationCount.load();
+
+		const BenchClock::time_point start = BenchClock::now();
+
+		for (int32_t knob = 0; knob < knobCount; ++knob)
+		{
+			// Sweep every knob through its value range, with a different phase per knob
+			const double value = (double)((frame + knob) % 101) * 0.01;
+			const char *label = labelFormatter.GetLabel(value);
+			const double angle = KnobValueToAngle(value, 0.0, 1.0, drawValues);
+			if (settings.fullRedraw)
+				DrawKnobFrame(rasterizer, drawValues, angle, label, glyphs);
+			else if (atlas)
+				DrawKnobAtlasFrame(rasterizer, drawValues, *atlas, angle, label, glyphs);
+			else
+				DrawKnobLayeredFrame(rasterizer, drawValues, angle, label, glyphs);
+		}
+
+		frameTimes.push_back(GetMicroseconds(start, BenchClock::now()) / 1000.0);
+	}
+
+	if (settings.frameCount > 1)
+		result.allocationsPerFrame = (double)(g_allocationCount.load() - allocationsAfterFirstFrame) / (double)(settings.frameCount - 1);
+
+	for (size_t i = 0; i < frameTimes.size(); ++i)
+		result.totalMs += frameTimes[i];
+	result.frameMs = BenchStatistics::Compute(frameTimes);
+
+	// The same frames again, with a clock around each stage. This adds the clock overhead to each stage,
+	// so the stages don't exactly add up to the frame time.
+	double stageTotals[BENCHSTAGE_COUNT] = {};
+	BenchClock::time_point stageStart;
+	BenchClock::time_point stageEnd;
+	for (int32_t frame = 0; frame < settings.frameCount; ++frame)
+	{
+		for (int32_t knob = 0; knob < knobCount; ++knob)
+		{
+			const double value = (double)((frame + knob) % 101) * 0.01;
+			const char *label = labelFormatter.GetLabel(value);
+			const double angle = KnobValueToAngle(value, 0.0, 1.0, drawValues);
+
+			if (!rasterizer.BeginDraw(drawValues.areaWidth, drawValues.areaWidth))
+				return false;
+
+			stageStart = BenchClock::now();
+			if (settings.fullRedraw)
+			{
+				DrawKnobBackground(rasterizer, drawValues);
+				stageEnd = BenchClock::now();
+				stageTotals[BENCHSTAGE_BACKGROUND] += GetMicroseconds(stageStart, stageEnd);
+
+				stageStart = stageEnd;
+				DrawKnobScale(rasterizer, drawValues);
+				stageEnd = BenchClock::now();
+				stageTotals[BENCHSTAGE_SCALE] += GetMicroseconds(stageStart, stageEnd);
+
+				stageStart = stageEnd;
+				DrawKnobBody(rasterizer, drawValues);
+				stageEnd = BenchClock::now();
+				stageTotals[BENCHSTAGE_BODY] += GetMicroseconds(stageStart, stageEnd);
+
+				stageStart = stageEnd;
+				DrawKnobMarker(rasterizer, drawValues, angle);
+				stageEnd = BenchClock::now();
+			}
+			else
+			{
+				rasterizer.DrawStaticLayer();
+				stageEnd = BenchClock::now();
+				stageTotals[BENCHSTAGE_STATICLAYER] += GetMicroseconds(stageStart, stageEnd);
+
+				stageStart = stageEnd;
+				if (atlas)
+				{
+					int32_t cellX = 0, cellY = 0;
+					atlas->GetCellPosition(atlas->GetCellIndex(angle), cellX, cellY);
+					rasterizer.DrawBuffer(atlas->GetCellOrigin(), atlas->GetCellOrigin(), atlas->GetPixels(), cellX, cellY, atlas->GetCellSize(), atlas->GetCellSize());
+				}
+				else
+				{
+					DrawKnobMarker(rasterizer, drawValues, angle);
+				}
+				stageEnd = BenchClock::now();
+			}
+			stageTotals[BENCHSTAGE_MARKER] += GetMicroseconds(stageStart, stageEnd);
+
+			stageStart = stageEnd;
+			DrawKnobLabel(rasterizer, drawValues, label, glyphs);
+			stageTotals[BENCHSTAGE_LABEL] += GetMicroseconds(stageStart, BenchClock::now());
+
+			rasterizer.EndDraw();
+		}
+	}
+
+	const double knobFrames = (double)settings.frameCount * (double)knobCount;
+	for (int32_t stage = 0; stage < BENCHSTAGE_COUNT; ++stage)
+	{
+		const bool used = settings.fullRedraw ? stage != BENCHSTAGE_STATICLAYER : (stage >= BENCHSTAGE_STATICLAYER);
+		if (used)
+			result.stageUs[stage] = stageTotals[stage] / knobFrames;
+	}
+
+	// Drag input
+	result.dragRedraws = MeasureDrag(drawValues, false, settings.dragEvents, result.linearDragUs, linearDrag);
+	MeasureDrag(drawValues, true, settings.dragEvents, result.circularDragUs, circularDrag);
+
+	return true;
+}
+
+
+/// Results of replaying a recorded drag
+struct BenchReplayResult
+{
+	const char *file;
+	bool circular;                  ///< True if the drag was recorded in circular mode
+	KnobDragReplayResult replay;    ///< Comparison with the recorded values
+	double eventUs;                 ///< Average time per event in microseconds
+
+	BenchReplayResult() : file(""), circular(false), eventUs(0.0)
+	{}
+};
+
+/// Replay a recorded drag, check that it produces the recorded values, and measure how long it takes
+/// @param[in] file The recording
+/// @param[in] repeat Number of timed replays
+/// @param[out] result Receives the results
+/// @return False if the file could not be read
+static bool ReplayDrag(const char *file, int32_t repeat, BenchReplayResult &result)
+{
+	result.file = file;
+
+	KnobDragRecording recording;
+	if (!recording.Load(file))
+		return false;
+
+	std::vector<double> values;
+	if (!recording.Replay(result.replay, &values))
+		return false;
+
+	// Same again with the clock running
+	const BenchClock::time_point start = BenchClock::now();
+	KnobDragReplayResult replay;
+	for (int32_t i = 0; i < repeat; ++i)
+		recording.Replay(replay, &values);
+	const double totalUs = GetMicroseconds(start, BenchClock::now());
+
+	const size_t events = recording.GetEvents().size();
+	result.eventUs = events > 0 ? totalUs / ((double)repeat * (double)events) : 0.0;
+
+	result.circular = recording.GetSettings().circular;
+	return true;
+}
+
+/// Results of a simulated drag loop
+struct BenchDragLoopResult
+{
+	int32_t frameRate;          ///< Frame rate of the loop, 0 if every event is processed
+	KnobDragLoopStats stats;    ///< Events, frames and CPU time
+
+	BenchDragLoopResult() : frameRate(0)
+	{}
+};
+
+/// Run a drag loop like the CustomGUI's, with a mouse that moves all the time. The system hands out events as
+/// fast as the loop asks for them, like MouseDrag() does.
+/// @param[in] drawValues The draw values
+/// @param[in] frameRate Frame rate of the loop, 0 to process every event
+/// @param[in] duration Duration of the drag in milliseconds
+/// @param[out] result Receives the results
+static void MeasureDragLoop(const KnobDrawValues &drawValues, int32_t frameRate, int32_t duration, BenchDragLoopResult &result)
+{
+	result.frameRate = frameRate;
+
+	const double width = (double)drawValues.areaWidth / (double)drawValues.oversampling;
+	KnobDragSettings dragSettings;
+	dragSettings.centerX = dragSettings.centerY = width / 2.0;
+
+	KnobDragSession session(dragSettings, frameRate);
+	KnobFramePacer pacer(frameRate);
+	KnobLabelFormatter labelFormatter;
+	labelFormatter.SetFormat(0.01, KNOBLABEL_UNIT_NONE);
+	KnobVisualState drawnState;
+
+	const BenchClock::time_point start = BenchClock::now();
+	session.Start(0.0, width / 2.0, width, 0.0);
+	pacer.Start(0.0);
+
+	double lastY = width;
+	for (;;)
+	{
+		const double now = GetMicroseconds(start, BenchClock::now()) / 1000.0;
+		if (now >= (double)duration)
+			break;
+
+		// The mouse moves up and down by 100 pixels per second
+		const double phase = fmod(now / 1000.0, 2.0);
+		const double mouseY = width - (phase <= 1.0 ? phase : 2.0 - phase) * 100.0;
+		pacer.AddMovement(0.0, mouseY - lastY);
+		lastY = mouseY;
+
+		if (!pacer.IsFrameDue(now))
+		{
+			const double wait = pacer.GetWaitTime(now);
+			if (wait >= 1.0)
+				std::this_thread::sleep_for(std::chrono::milliseconds((int64_t)wait));
+			continue;
+		}
+
+		// What ProcessDragInput() does, without the drawing
+		const KnobDragStep step = session.Update(KnobDragEvent(now, width / 2.0, mouseY, 0));
+		if (step.changed)
+		{
+			KnobVisualState state;
+			GetKnobMarkerKey(drawValues, KnobValueToAngle(step.value, 0.0, 1.0, drawValues), state.markerPoints);
+			strncpy(state.label, labelFormatter.GetLabel(step.value), sizeof(state.label) - 1);
+			state.label[sizeof(state.label) - 1] = 0;
+			if (state != drawnState)
+				drawnState = state;
+		}
+		pacer.FrameDone(now);
+	}
+
+	double finalValue = 0.0;
+	session.Finish(finalValue);
+	pacer.Finish(GetMicroseconds(start, BenchClock::now()) / 1000.0);
+	result.stats = pacer.GetStats();
+}
+
+/// Results of sending a controller stream through a KnobValueRing
+struct BenchFeedResult
+{
+	bool    paced;             ///< True if the stream was sent with its own timing and drained once per frame
+	int64_t values;            ///< Values in the stream
+	int64_t pushed;            ///< Values the producer got into the ring
+	int64_t superseded;        ///< Values replaced by newer ones while the ring was full
+	int64_t full;              ///< Pushes that found the ring full
+	int32_t frames;            ///< Drains that found values
+	int32_t redraws;           ///< Frames in which marker or label changed
+	double  valuesPerSecond;   ///< Values that went through the ring per second
+	BenchStatistics drainUs;   ///< Time to drain the ring and update the knob, per frame with values
+	bool    finalMatches;      ///< True if the last value taken from the ring is the last value of the stream
+
+	BenchFeedResult() : paced(false), values(0), pushed(0), superseded(0), full(0), frames(0), redraws(0), valuesPerSecond(0.0), finalMatches(false)
+	{}
+};
+
+/// Send a controller stream through a KnobValueRing with a KnobControllerReplay, and drain it like
+/// RotaryKnobArea::Timer() does, either once per frame or as fast as possible
+/// @param[in] recording The stream
+/// @param[in] drawValues The draw values, to tell which frames would be redrawn
+/// @param[in] paced True to send the stream with its own timing, and drain the ring at 60 Hz
+/// @param[out] result Receives the results
+/// @return False if the replay could not be started
+static bool MeasureFeed(const KnobControllerRecording &recording, const KnobDrawValues &drawValues, bool paced, BenchFeedResult &result)
+{
+	result.paced = paced;
+	result.values = (int64_t)recording.GetValues().size();
+
+	KnobValueRing ring;
+	KnobControllerReplay replay;
+	KnobLabelFormatter labelFormatter;
+	labelFormatter.SetFormat(0.01, KNOBLABEL_UNIT_NONE);
+	KnobVisualState drawnState;
+	KnobControllerValue latest;
+	std::vector<double> times;
+
+	const BenchClock::time_point start = BenchClock::now();
+	if (!replay.Start(recording, ring, paced ? 1.0 : 0.0))
+		return false;
+
+	const std::chrono::microseconds frameTime(1000000 / 60);
+	BenchClock::time_point nextFrame = start;
+	for (;;)
+	{
+		// Check before draining, so the values of the last push are not missed
+		const bool finished = replay.GetStats().finished;
+
+		const BenchClock::time_point drainStart = BenchClock::now();
+		if (ring.Drain(latest) > 0)
+		{
+			// What RotaryKnobArea::Timer() does with the latest value, without the drawing
+			KnobVisualState state;
+			GetKnobMarkerKey(drawValues, KnobValueToAngle(latest.value, 0.0, 1.0, drawValues), state.markerPoints);
+			strncpy(state.label, labelFormatter.GetLabel(latest.value), sizeof(state.label) - 1);
+			state.label[sizeof(state.label) - 1] = 0;
+			if (state != drawnState)
+			{
+				drawnState = state;
+				++result.redraws;
+			}
+
+			times.push_back(GetMicroseconds(drainStart, BenchClock::now()));
+			++result.frames;
+		}
+		else if (finished)
+		{
+			break;
+		}
+
+		if (paced)
+		{
+			nextFrame += frameTime;
+			std::this_thread::sleep_until(nextFrame);
+		}
+		else if (ring.IsEmpty())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	const double totalUs = GetMicroseconds(start, BenchClock::now());
+	replay.Stop();
+
+	const KnobControllerReplayStats stats = replay.GetStats();
+	result.pushed = stats.pushed;
+	result.superseded = stats.superseded;
+	result.full = ring.GetFullCount();
+	result.valuesPerSecond = totalUs > 0.0 ? (double)stats.pushed * 1000000.0 / totalUs : 0.0;
+	result.drainUs = BenchStatistics::Compute(times);
+	result.finalMatches = result.frames > 0 && memcmp(&latest, &recording.GetValues().back(), sizeof(latest)) == 0;
+	return true;
+}
+
+/// Results of a drag that draws its frames
+struct BenchAsyncDragResult
+{
+	bool async;                 ///< True if the frames were drawn by the render thread
+	BenchStatistics eventUs;    ///< Time the input thread spends per mouse event
+	int32_t requested;          ///< Frames that were drawn on the input thread, or requested from the render thread
+	int64_t rendered;           ///< Frames the render thread has drawn
+	int64_t presented;          ///< Finished frames the input thread has shown
+	int32_t mismatches;         ///< Shown frames that differ from the same frame drawn on the input thread
+
+	BenchAsyncDragResult() : async(false), requested(0), rendered(0), presented(0), mismatches(0)
+	{}
+};
+
+/// Simulate a linear drag like the CustomGUI's, and draw every frame that changes, either right away on the
+/// input thread or by handing it to a KnobAsyncRenderer and showing its most recent finished frame
+/// @param[in] settings Size, oversampling and number of events
+/// @param[in] async True to draw through the render thread
+/// @param[out] result Receives the results
+/// @return False if something could not be set up
+static bool MeasureAsyncDrag(const BenchSettings &settings, bool async, BenchAsyncDragResult &result)
+{
+	result.async = async;
+
+	// Same constants as the CustomGUI
+	KnobPixelBuffer canvas;
+	KnobRasterizer rasterizer(canvas);
+	rasterizer.SetAntialiasing(settings.antialiasing);
+	rasterizer.SetFontSize(14 * settings.oversamplings[0]);
+	std::shared_ptr<KnobDrawValues> drawValues(new KnobDrawValues());
+	drawValues->InitGeometry(settings.sizes[0], settings.oversamplings[0], 5, 135.0, 14, rasterizer.GetTextHeight(), settings.antialiasing, settings.scaleTicks);
+	drawValues->SetTheme(KnobTheme::Default());
+	if (!DrawKnobStaticLayer(rasterizer, *drawValues))
+		return false;
+
+	std::shared_ptr<const KnobMarkerAtlas> atlas;
+	if (settings.atlasCells >= 0)
+	{
+		atlas = AcquireKnobMarkerAtlas(*drawValues, settings.atlasCells);
+		if (!atlas)
+			return false;
+	}
+
+	std::shared_ptr<KnobGlyphAtlas> glyphs;
+	if (settings.glyphAtlas)
+	{
+		glyphs.reset(new KnobGlyphAtlas());
+		KnobBuiltinGlyphSource glyphSource(drawValues->labelFontSize);
+		if (!glyphs->Build(glyphSource))
+			return false;
+	}
+
+	const double width = (double)settings.sizes[0];
+	KnobDragSettings dragSettings;
+	dragSettings.centerX = dragSettings.centerY = width / 2.0;
+	KnobDragSession session(dragSettings, 60);
+	KnobLabelFormatter labelFormatter;
+	labelFormatter.SetFormat(0.01, KNOBLABEL_UNIT_NONE);
+	session.Start(0.0, width / 2.0, width, 0.0);
+
+	KnobAsyncRenderer renderer;
+	KnobFrameRequest request;
+	request.owner = &result;
+	request.drawValues = drawValues;
+	request.markerAtlas = atlas;
+	request.glyphs = glyphs;
+
+	KnobVisualState drawnState;
+	std::vector<double> times;
+	times.reserve((size_t)settings.dragEvents);
+
+	for (int32_t event = 0; event < settings.dragEvents; ++event)
+	{
+		const double phase = (double)(event % 200) / 100.0;
+		const double sweep = phase <= 1.0 ? phase : 2.0 - phase;
+		const double mouseY = width - sweep / dragSettings.multiplier;
+
+		// What RotaryKnobArea::InputEvent() does for a mouse event, including the drawing
+		const BenchClock::time_point start = BenchClock::now();
+
+		const KnobDragStep step = session.Update(KnobDragEvent((double)event, width / 2.0, mouseY, 0));
+		if (step.changed)
+		{
+			const double angle = KnobValueToAngle(step.value, 0.0, 1.0, *drawValues);
+			KnobVisualState state;
+			GetKnobMarkerKey(*drawValues, angle, state.markerPoints);
+			strncpy(state.label, labelFormatter.GetLabel(step.value), sizeof(state.label) - 1);
+			state.label[sizeof(state.label) - 1] = 0;
+			if (state != drawnState)
+			{
+				drawnState = state;
+				++result.requested;
+				if (async)
+				{
+					request.value = step.value;
+					request.angle = angle;
+					request.state = state;
+					renderer.Request(request);
+				}
+				else if (atlas)
+					DrawKnobAtlasFrame(rasterizer, *drawValues, *atlas, angle, state.label, glyphs.get());
+				else
+					DrawKnobLayeredFrame(rasterizer, *drawValues, angle, state.label, glyphs.get());
+			}
+		}
+
+		// Show what the render thread has finished, like DrawMsg() does
+		if (async && renderer.HasNewFrame())
+		{
+			const KnobAsyncFrame *frame = renderer.FetchFrame();
+			if (frame && frame->valid)
+				canvas = frame->pixels;
+		}
+
+		times.push_back(GetMicroseconds(start, BenchClock::now()));
+	}
+
+	result.eventUs = BenchStatistics::Compute(times);
+	if (async)
+	{
+		// Wait for the last frame, and check that it's the one the input thread would have drawn
+		while (renderer.GetStats().rendered < 1 || renderer.FetchFrame()->sequence != (uint64_t)result.requested)
+			std::this_thread::yield();
+
+		const KnobAsyncFrame *frame = renderer.FetchFrame();
+		const KnobAsyncRendererStats stats = renderer.GetStats();
+		result.rendered = stats.rendered;
+		result.presented = stats.presented;
+
+		const double angle = KnobValueToAngle(frame->value, 0.0, 1.0, *drawValues);
+		if (atlas)
+			DrawKnobAtlasFrame(rasterizer, *drawValues, *atlas, angle, frame->state.label, glyphs.get());
+		else
+			DrawKnobLayeredFrame(rasterizer, *drawValues, angle, frame->state.label, glyphs.get());
+
+		bool same = frame->valid && frame->pixels.GetWidth() == canvas.GetWidth() && frame->pixels.GetHeight() == canvas.GetHeight();
+		for (int32_t y = 0; same && y < canvas.GetHeight(); ++y)
+			same = memcmp(frame->pixels.GetRow(y), canvas.GetRow(y), (size_t)canvas.GetWidth() * sizeof(KnobColor)) == 0;
+		result.mismatches = same ? 0 : 1;
+	}
+	else
+	{
+		result.rendered = result.presented = result.requested;
+	}
+
+	return true;
+}
+
+/// Results of rendering a knob bank with the batch renderer
+struct BenchBatchResult
+{
+	int32_t threads;          ///< Number of threads, including the calling one
+	int32_t knobCount;        ///< Knobs per bank
+	BenchStatistics bankMs;   ///< Time per bank
+	double speedup;           ///< Mean time with one thread divided by the mean time with this many threads
+	int64_t steals;           ///< Number of times a thread took over knobs from another one
+	int32_t mismatches;       ///< Frames that differ from the ones drawn one after the other
+
+	BenchBatchResult() : threads(0), knobCount(0), speedup(0.0), steals(0), mismatches(0)
+	{}
+};
+
+/// Render a bank of knobs with the batch renderer, like the CustomGUI does when a preset is loaded
+/// @param[in] settings Knob count, size, oversampling and bank count
+/// @param[in] threads Number of threads
+/// @param[out] result Receives the results
+/// @param[out] buffer Receives the last knob of the bank
+/// @return False if something could not be set up
+static bool MeasureBatch(const BenchSettings &settings, int32_t threads, BenchBatchResult &result, KnobPixelBuffer &buffer)
+{
+	const int32_t knobCount = settings.knobCounts[0];
+	const int32_t oversampling = settings.oversamplings[0];
+	result.threads = threads;
+	result.knobCount = knobCount;
+
+	// Same constants as the CustomGUI
+	KnobRasterizer rasterizer(buffer);
+	rasterizer.SetAntialiasing(settings.antialiasing);
+	rasterizer.SetFontSize(14 * oversampling);
+	std::shared_ptr<KnobDrawValues> drawValues(new KnobDrawValues());
+	drawValues->InitGeometry(settings.sizes[0], oversampling, 5, 135.0, 14, rasterizer.GetTextHeight(), settings.antialiasing, settings.scaleTicks);
+	drawValues->SetTheme(KnobTheme::Default());
+
+	std::shared_ptr<const KnobMarkerAtlas> atlas;
+	if (settings.atlasCells >= 0)
+	{
+		atlas = AcquireKnobMarkerAtlas(*drawValues, settings.atlasCells);
+		if (!atlas)
+			return false;
+	}
+
+	KnobGlyphAtlas glyphAtlas;
+	if (settings.glyphAtlas)
+	{
+		KnobBuiltinGlyphSource glyphSource(drawValues->labelFontSize);
+		if (!glyphAtlas.Build(glyphSource))
+			return false;
+	}
+
+	// Every knob shows a different value
+	KnobLabelFormatter labelFormatter;
+	labelFormatter.SetFormat(0.01, KNOBLABEL_UNIT_NONE);
+	std::vector<KnobBatchItem> items((size_t)knobCount);
+	for (int32_t knob = 0; knob < knobCount; ++knob)
+	{
+		const double value = (double)(knob % 101) * 0.01;
+		KnobBatchItem &item = items[knob];
+		item.drawValues = drawValues;
+		item.markerAtlas = atlas.get();
+		item.glyphs = settings.glyphAtlas ? &glyphAtlas : nullptr;
+		item.angle = KnobValueToAngle(value, 0.0, 1.0, *drawValues);
+		strncpy(item.label, labelFormatter.GetLabel(value), sizeof(item.label) - 1);
+		item.label[sizeof(item.label) - 1] = 0;
+	}
+
+	// The threads are started once, like the CustomGUI's renderer that lives as long as the plugin
+	KnobBatchRenderer renderer(threads);
+	std::vector<double> bankTimes;
+	bankTimes.reserve((size_t)settings.frameCount);
+	for (int32_t frame = 0; frame < settings.frameCount; ++frame)
+	{
+		const BenchClock::time_point start = BenchClock::now();
+		if (renderer.Render(&items[0], knobCount) != knobCount)
+			return false;
+		bankTimes.push_back(GetMicroseconds(start, BenchClock::now()) / 1000.0);
+	}
+	result.bankMs = BenchStatistics::Compute(bankTimes);
+	result.steals = renderer.GetStealCount();
+
+	// The same knobs one after the other, on this thread
+	if (!DrawKnobStaticLayer(rasterizer, *drawValues))
+		return false;
+	for (int32_t knob = 0; knob < knobCount; ++knob)
+	{
+		const KnobBatchItem &item = items[knob];
+		if (atlas)
+			DrawKnobAtlasFrame(rasterizer, *drawValues, *atlas, item.angle, item.label, item.glyphs);
+		else
+			DrawKnobLayeredFrame(rasterizer, *drawValues, item.angle, item.label, item.glyphs);
+
+		bool same = item.frame->GetWidth() == buffer.GetWidth() && item.frame->GetHeight() == buffer.GetHeight();
+		for (int32_t y = 0; same && y < buffer.GetHeight(); ++y)
+			same = memcmp(item.frame->GetRow(y), buffer.GetRow(y), (size_t)buffer.GetWidth() * sizeof(KnobColor)) == 0;
+		if (!same)
+			++result.mismatches;
+
+		GetSharedKnobBufferPool().Release(item.frame);
+	}
+
+	return true;
+}
+
+/// Results of drawing a panel of knobs with different sizes
+struct BenchLayerCacheResult
+{
+	bool cached;               ///< True if the static layers came from the cache
+	int32_t kinds;             ///< Number of different sizes
+	int32_t knobCount;         ///< Knobs per frame
+	BenchStatistics frameMs;   ///< Time per frame
+	double knobUs;             ///< Mean time per knob
+	int64_t layerDraws;        ///< Static layers drawn by the renderer itself
+	KnobStaticLayerCacheStats cache;  ///< Counters of the cache
+	int32_t mismatches;        ///< Knobs whose last frame differs from the one drawn without the cache
+
+	BenchLayerCacheResult() : cached(false), kinds(0), knobCount(0), knobUs(0.0), layerDraws(0), mismatches(0)
+	{}
+};
+
+/// Return a hash of the pixels of a frame
+static uint64_t HashPixels(const KnobPixelBuffer &buffer)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (int32_t y = 0; y < buffer.GetHeight(); ++y)
+	{
+		const uint8_t *row = (const uint8_t*)buffer.GetRow(y);
+		for (size_t i = 0; i < (size_t)buffer.GetWidth() * sizeof(KnobColor); ++i)
+			hash = (hash ^ row[i]) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+/// Draw a panel of knobs with different sizes, one after the other with one renderer, like the render thread or a batch worker does
+/// @param[in] settings Knob count, sizes, oversampling factors and frame count
+/// @param[in] cached True to take the static layers from a KnobStaticLayerCache, false to draw them whenever the size changes
+/// @param[in,out] hashes Hashes of the last frame of each knob. Filled if empty, otherwise compared.
+/// @param[out] result Receives the results
+/// @return False if something could not be set up
+static bool MeasureLayerCache(const BenchSettings &settings, bool cached, std::vector<uint64_t> &hashes, BenchLayerCacheResult &result)
+{
+	const int32_t knobCount = settings.knobCounts[0];
+	result.cached = cached;
+	result.knobCount = knobCount;
+
+	// Same constants as the CustomGUI, one set of draw values and one glyph atlas for each size
+	KnobPixelBuffer buffer;
+	KnobRasterizer rasterizer(buffer);
+	rasterizer.SetAntialiasing(settings.antialiasing);
+	std::vector<std::shared_ptr<KnobDrawValues> > kinds;
+	std::vector<std::shared_ptr<KnobGlyphAtlas> > glyphs;
+	for (size_t o = 0; o < settings.oversamplings.size(); ++o)
+	{
+		for (size_t s = 0; s < settings.sizes.size(); ++s)
+		{
+			const int32_t oversampling = settings.oversamplings[o];
+			rasterizer.SetFontSize(14 * oversampling);
+			std::shared_ptr<KnobDrawValues> drawValues(new KnobDrawValues());
+			drawValues->InitGeometry(settings.sizes[s], oversampling, 5, 135.0, 14, rasterizer.GetTextHeight(), settings.antialiasing, settings.scaleTicks);
+			drawValues->SetTheme(KnobTheme::Default());
+			kinds.push_back(drawValues);
+
+			std::shared_ptr<KnobGlyphAtlas> glyphAtlas;
+			if (settings.glyphAtlas)
+			{
+				glyphAtlas.reset(new KnobGlyphAtlas());
+				KnobBuiltinGlyphSource glyphSource(drawValues->labelFontSize);
+				if (!glyphAtlas->Build(glyphSource))
+					return false;
+			}
+			glyphs.push_back(glyphAtlas);
+		}
+	}
+	result.kinds = (int32_t)kinds.size();
+
+	KnobStaticLayerCache cache(settings.layerCacheSize > 0 ? settings.layerCacheSize : KNOBSTATICLAYERCACHE_CAPACITY);
+	KnobLabelFormatter labelFormatter;
+	labelFormatter.SetFormat(0.01, KNOBLABEL_UNIT_NONE);
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve((size_t)settings.frameCount);
+	const bool compare = !hashes.empty();
+	for (int32_t frame = 0; frame < settings.frameCount; ++frame)
+	{
+		// Every frame starts with the layer of the last knob, like a renderer that keeps drawing
+		const KnobDrawValues *staticLayer = nullptr;
+		const BenchClock::time_point start = BenchClock::now();
+		for (int32_t knob = 0; knob < knobCount; ++knob)
+		{
+			// Neighboring knobs have different sizes
+			const size_t kind = (size_t)knob % kinds.size();
+			const KnobDrawValues &drawValues = *kinds[kind];
+			if (buffer.GetWidth() != drawValues.areaWidth && !buffer.Init(drawValues.areaWidth, drawValues.areaWidth))
+				return false;
+
+			if (staticLayer != &drawValues)
+			{
+				if (cached)
+				{
+					const std::shared_ptr<const KnobPixelBuffer> layer = cache.Acquire(drawValues);
+					if (!layer)
+						return false;
+					rasterizer.SetStaticLayer(layer);
+				}
+				else
+				{
+					if (!DrawKnobStaticLayer(rasterizer, drawValues))
+						return false;
+					++result.layerDraws;
+				}
+				staticLayer = &drawValues;
+			}
+
+			const double value = (double)((knob + frame) % 101) * 0.01;
+			if (!DrawKnobLayeredFrame(rasterizer, drawValues, KnobValueToAngle(value, 0.0, 1.0, drawValues), labelFormatter.GetLabel(value), glyphs[kind].get()))
+				return false;
+
+			// Only the last frame is compared, hashing every frame would be most of the time
+			if (frame + 1 == settings.frameCount)
+			{
+				const uint64_t hash = HashPixels(buffer);
+				if (!compare)
+					hashes.push_back(hash);
+				else if (hashes[(size_t)knob] != hash)
+					++result.mismatches;
+			}
+		}
+		frameTimes.push_back(GetMicroseconds(start, BenchClock::now()) / 1000.0);
+	}
+
+	result.frameMs = BenchStatistics::Compute(frameTimes);
+	result.knobUs = result.frameMs.mean * 1000.0 / knobCount;
+	result.cache = cache.GetStats();
+	return true;
+}
+
+/// Plugin version the benchmark writes asset files for
+#define BENCH_PLUGINVERSION "knobbench"
+
+/// Results of drawing the first frames of knobs with or without an asset file
+struct BenchAssetFileResult
+{
+	const char *mode;          ///< "drawn", "mapped" or "damaged"
+	int32_t kinds;             ///< Number of different sizes
+	double openMs;             ///< Time to map the file and check its index
+	double firstFrameMs;       ///< Time to get all assets and draw the first frame of each size, including openMs
+	KnobAssetCacheStats cache; ///< Counters of the asset cache
+	int32_t mismatches;        ///< First frames that differ from the ones drawn without the file
+	bool staleRejected;        ///< True if files of another version, with a damaged index and cut off files were not used
+
+	BenchAssetFileResult() : mode(""), kinds(0), openMs(0.0), firstFrameMs(0.0), mismatches(0), staleRejected(false)
+	{}
+};
+
+/// Write a damaged copy of a file
+/// @param[in] filename The file
+/// @param[in] damage Byte to flip, counted from the end if negative, or 0 to cut off the last byte
+/// @param[in] copy The copy
+/// @return False if the copy could not be written
+static bool WriteDamagedAssetFile(const char *filename, int64_t damage, const char *copy)
+{
+	FILE *file = fopen(filename, "rb");
+	if (!file)
+		return false;
+	std::vector<uint8_t> data;
+	uint8_t chunk[4096];
+	for (size_t read = 0; (read = fread(chunk, 1, sizeof(chunk), file)) > 0; )
+		data.insert(data.end(), chunk, chunk + read);
+	fclose(file);
+	if (data.empty() || (damage < 0 ? (uint64_t)-damage : (uint64_t)damage) >= data.size())
+		return false;
+
+	if (damage == 0)
+		data.pop_back();
+	else
+		data[damage < 0 ? data.size() - (size_t)-damage : (size_t)damage] ^= 0x40;
+
+	return ReplaceKnobAssetFile(copy, &data[0], data.size());
+}
+
+/// Return true if the asset cache rejects a damaged copy of a file as a whole
+/// @param[in] filename The file
+/// @param[in] damage Byte to flip, or 0 to cut off the last byte
+static bool IsAssetFileRejected(const char *filename, int64_t damage)
+{
+	const std::string copy = std::string(filename) + ".damaged";
+	if (!WriteDamagedAssetFile(filename, damage, copy.c_str()))
+		return false;
+
+	KnobAssetCache cache;
+	const bool rejected = !cache.Open(copy.c_str(), BENCH_PLUGINVERSION, KNOBASSETCACHE_ASSETVERSION) && cache.GetStats().rejectedFiles == 1;
+	cache.Close();
+	remove(copy.c_str());
+	return rejected;
+}
+
+/// Return true if files of another plugin or asset version, with a damaged index, and cut off files are not used
+static bool AreStaleAssetFilesRejected(const char *filename)
+{
+	KnobAssetCache cache;
+	bool rejected = !cache.Open(filename, "another version", KNOBASSETCACHE_ASSETVERSION);
+	rejected = !cache.Open(filename, BENCH_PLUGINVERSION, KNOBASSETCACHE_ASSETVERSION + 1) && rejected;
+	cache.Close();
+
+	// The entry table starts right after the header
+	return rejected && IsAssetFileRejected(filename, 56) && IsAssetFileRejected(filename, 0);
+}
+
+/// Get the static layer, marker atlas and glyph atlas of knobs in all combinations of size and oversampling through the shared
+/// asset cache, like a new session of the CustomGUI, and draw the first frame of each
+/// @param[in] settings Sizes, oversampling factors and atlas cells
+/// @param[in] filename The asset file
+/// @param[in] save True to start without a file and save one, false to map the file
+/// @param[in,out] hashes Hashes of the first frames. Filled if empty, otherwise compared.
+/// @param[out] result Receives the results
+/// @return False if something could not be set up
+static bool MeasureAssetFile(const BenchSettings &settings, const char *filename, bool save, std::vector<uint64_t> &hashes, BenchAssetFileResult &result)
+{
+	KnobAssetCache &assets = GetSharedKnobAssetCache();
+
+	if (save)
+		remove(filename);
+
+	// The counters are for the whole process
+	const KnobAssetCacheStats before = assets.GetStats();
+	const BenchClock::time_point start = BenchClock::now();
+	if (assets.Open(filename, BENCH_PLUGINVERSION, KNOBASSETCACHE_ASSETVERSION) == save)
+		return false;
+	result.openMs = GetMicroseconds(start, BenchClock::now()) / 1000.0;
+
+	// A new static layer cache, and no atlas left from the first run, like a new session
+	KnobStaticLayerCache layers;
+	KnobPixelBuffer buffer;
+	KnobRasterizer rasterizer(buffer);
+	rasterizer.SetAntialiasing(settings.antialiasing);
+	const bool compare = !hashes.empty();
+	for (size_t o = 0; o < settings.oversamplings.size(); ++o)
+	{
+		for (size_t s = 0; s < settings.sizes.size(); ++s)
+		{
+			const int32_t oversampling = settings.oversamplings[o];
+			rasterizer.SetFontSize(14 * oversampling);
+			KnobDrawValues drawValues;
+			drawValues.InitGeometry(settings.sizes[s], oversampling, 5, 135.0, 14, rasterizer.GetTextHeight(), settings.antialiasing, settings.scaleTicks);
+			drawValues.SetTheme(KnobTheme::Default());
+
+			// The same lookups the CustomGUI does for a knob's first frame
+			const std::shared_ptr<const KnobPixelBuffer> layer = layers.Acquire(drawValues);
+			const std::shared_ptr<const KnobMarkerAtlas> atlas = AcquireKnobMarkerAtlas(drawValues, std::max(settings.atlasCells, (int32_t)0));
+			KnobBuiltinGlyphSource glyphSource(drawValues.labelFontSize);
+			std::shared_ptr<const KnobGlyphAtlas> glyphs = assets.FindGlyphAtlas(glyphSource, "builtin");
+			if (!glyphs)
+			{
+				std::shared_ptr<KnobGlyphAtlas> builtGlyphs = std::make_shared<KnobGlyphAtlas>();
+				if (!builtGlyphs->Build(glyphSource))
+					return false;
+				assets.AddGlyphAtlas(glyphSource, "builtin", *builtGlyphs);
+				glyphs = builtGlyphs;
+			}
+			if (!layer || !atlas)
+				return false;
+
+			rasterizer.SetStaticLayer(layer);
+			if (!DrawKnobAtlasFrame(rasterizer, drawValues, *atlas, KnobValueToAngle(0.5, 0.0, 1.0, drawValues), "0.50", glyphs.get()))
+				return false;
+
+			const uint64_t hash = HashPixels(buffer);
+			if (!compare)
+				hashes.push_back(hash);
+			else if (hashes[(size_t)result.kinds] != hash)
+				++result.mismatches;
+			++result.kinds;
+		}
+	}
+	result.firstFrameMs = GetMicroseconds(start, BenchClock::now()) / 1000.0;
+	result.cache = assets.GetStats();
+	result.cache.hits -= before.hits;
+	result.cache.misses -= before.misses;
+	result.cache.added -= before.added;
+	result.cache.rejectedAssets -= before.rejectedAssets;
+
+	// The mapped layer has to be let go before the file can be replaced on Windows
+	rasterizer.FreeStaticLayer();
+	layers.Clear();
+	if (save)
+		return assets.Save();
+
+	assets.Close();
+	return true;
+}
+
+
+/// Number of marker angles filled per frame in the triangle comparison
+static const int32_t BENCH_TRIANGLEANGLES = 256;
+
+/// Results of filling the marker triangle with one version of the anti-aliased polygon fill
+struct BenchTriangleResult
+{
+	bool specialized;          ///< True for the version for 3 corners, false for the one for any number of corners
+	int32_t size;              ///< Knob width
+	int32_t oversampling;      ///< Oversampling factor
+	BenchStatistics frameUs;   ///< Time to fill the marker at all angles
+	double triangleUs;         ///< Time per triangle, from the median frame
+	int32_t mismatches;        ///< Angles whose pixels differ from the ones filled with the version for 3 corners
+
+	BenchTriangleResult() : specialized(false), size(0), oversampling(0), triangleUs(0.0), mismatches(0)
+	{}
+};
+
+/// Fill the marker triangle of a knob at many angles, with one version of the anti-aliased polygon fill
+/// @param[in] settings Frame count and number of scale intervals
+/// @param[in] size Knob width
+/// @param[in] oversampling Oversampling factor
+/// @param[in] specialized True for the version for 3 corners, false for the one for any number of corners
+/// @param[in,out] hashes Hashes of the marker at each angle. Filled if empty, otherwise compared.
+/// @param[out] result Receives the results
+/// @return False if the buffer could not be allocated
+static bool MeasureTriangles(const BenchSettings &settings, int32_t size, int32_t oversampling, bool specialized, std::vector<uint64_t> &hashes, BenchTriangleResult &result)
+{
+	result.specialized = specialized;
+	result.size = size;
+	result.oversampling = oversampling;
+
+	KnobPixelBuffer buffer;
+	KnobRasterizer rasterizer(buffer);
+	rasterizer.SetAntialiasing(true);
+	rasterizer.SetTriangleKernel(specialized);
+	rasterizer.SetFontSize(14 * oversampling);
+	KnobDrawValues drawValues;
+	drawValues.InitGeometry(size, oversampling, 5, 135.0, 14, rasterizer.GetTextHeight(), true, settings.scaleTicks);
+	drawValues.SetTheme(KnobTheme::Default());
+
+	// Only the fill is measured, the corners are computed beforehand
+	KnobPointF points[BENCH_TRIANGLEANGLES][3];
+	for (int32_t i = 0; i < BENCH_TRIANGLEANGLES; ++i)
+		GetKnobMarkerPoints(drawValues, KnobValueToAngle((double)i / (double)(BENCH_TRIANGLEANGLES - 1), 0.0, 1.0, drawValues), points[i]);
+
+	if (!rasterizer.BeginDraw(drawValues.areaWidth, drawValues.areaWidth))
+		return false;
+	rasterizer.SetColor(drawValues.markerColor);
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve((size_t)settings.frameCount);
+	for (int32_t frame = 0; frame < settings.frameCount; ++frame)
+	{
+		const BenchClock::time_point start = BenchClock::now();
+		for (int32_t i = 0; i < BENCH_TRIANGLEANGLES; ++i)
+			rasterizer.FillPolygon(3, points[i]);
+		frameTimes.push_back(GetMicroseconds(start, BenchClock::now()));
+	}
+	rasterizer.EndDraw();
+
+	// Each angle on its own background, to compare the pixels of both versions
+	const bool compare = !hashes.empty();
+	for (int32_t i = 0; i < BENCH_TRIANGLEANGLES; ++i)
+	{
+		if (!rasterizer.BeginDraw(drawValues.areaWidth, drawValues.areaWidth))
+			return false;
+		DrawKnobBackground(rasterizer, drawValues);
+		rasterizer.SetColor(drawValues.markerColor);
+		rasterizer.FillPolygon(3, points[i]);
+		rasterizer.EndDraw();
+
+		const uint64_t hash = HashPixels(buffer);
+		if (!compare)
+			hashes.push_back(hash);
+		else if (hashes[(size_t)i] != hash)
+			++result.mismatches;
+	}
+
+	result.frameUs = BenchStatistics::Compute(frameTimes);
+	result.triangleUs = result.frameUs.p50 / (double)BENCH_TRIANGLEANGLES;
+	return true;
+}
+
+static void PrintResult(const BenchSettings &settings, const BenchResult &result)
+{
+	printf("knobs=%d frames=%d size=%d oversampling=%d antialiasing=%s simd=%s mode=%s label=%s\n", result.knobCount, settings.frameCount, result.size, result.oversampling, settings.antialiasing ? "on" : "off", GetKnobSimdLevelName(GetKnobSimdLevel()), result.mode, settings.glyphAtlas ? "glyphs" : "text");
+	printf("total %.3f ms, %.3f ms per frame, %.2f us per knob\n", result.totalMs, result.frameMs.mean, result.frameMs.mean * 1000.0 / result.knobCount);
+	printf("frame ms: min %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f\n", result.frameMs.min, result.frameMs.p50, result.frameMs.p95, result.frameMs.p99, result.frameMs.max);
+
+	printf("stages us per knob:");
+	for (int32_t stage = 0; stage < BENCHSTAGE_COUNT; ++stage)
+	{
+		if (result.stageUs[stage] >= 0.0)
+			printf(" %s %.3f", g_benchStageNames[stage], result.stageUs[stage]);
+	}
+	printf("\n");
+
+	printf("drag us per event: linear p50 %.3f p99 %.3f, circular p50 %.3f p99 %.3f (%d of %d events redraw)\n", result.linearDragUs.p50, result.linearDragUs.p99, result.circularDragUs.p50, result.circularDragUs.p99, result.dragRedraws, settings.dragEvents);
+	printf("allocations per frame: %.2f\n", result.allocationsPerFrame);
+}
+
+static void WriteJsonStatistics(FILE *file, const char *name, const BenchStatistics &statistics)
+{
+	fprintf(file, "\"%s\": { \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }", name, statistics.mean, statistics.min, statistics.p50, statistics.p95, statistics.p99, statistics.max);
+}
+
+static bool WriteJson(const BenchSettings &settings, const std::vector<BenchResult> &results, const std::vector<BenchReplayResult> &replays, const std::vector<BenchDragLoopResult> &dragLoops, const std::vector<BenchBatchResult> &batches, const std::vector<BenchAsyncDragResult> &asyncDrags, const std::vector<BenchFeedResult> &feeds, const std::vector<BenchLayerCacheResult> &layerCaches, const std::vector<BenchAssetFileResult> &assetFiles, const std::vector<BenchTriangleResult> &triangles, const char *filename)
+{
+	const bool toStdout = strcmp(filename, "-") == 0;
+	FILE *file = toStdout ? stdout : fopen(filename, "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\n");
+	fprintf(file, "  \"frames\": %d,\n", settings.frameCount);
+	fprintf(file, "  \"antialiasing\": %s,\n", settings.antialiasing ? "true" : "false");
+	fprintf(file, "  \"simd\": \"%s\",\n", GetKnobSimdLevelName(GetKnobSimdLevel()));
+	fprintf(file, "  \"label\": \"%s\",\n", settings.glyphAtlas ? "glyphs" : "text");
+	fprintf(file, "  \"ticks\": %d,\n", settings.scaleTicks);
+	fprintf(file, "  \"dragEvents\": %d,\n", settings.dragEvents);
+	fprintf(file, "  \"results\": [\n");
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult &result = results[i];
+		fprintf(file, "    {\n");
+		fprintf(file, "      \"knobs\": %d, \"size\": %d, \"oversampling\": %d, \"mode\": \"%s\",\n", result.knobCount, result.size, result.oversampling, result.mode);
+		fprintf(file, "      \"totalMs\": %.4f,\n", result.totalMs);
+		fprintf(file, "      ");
+		WriteJsonStatistics(file, "frameMs", result.frameMs);
+		fprintf(file, ",\n      \"stageUsPerKnob\": {");
+
+		bool first = true;
+		for (int32_t stage = 0; stage < BENCHSTAGE_COUNT; ++stage)
+		{
+			if (result.stageUs[stage] < 0.0)
+				continue;
+			fprintf(file, "%s \"%s\": %.4f", first ? "" : ",", g_benchStageNames[stage], result.stageUs[stage]);
+			first = false;
+		}
+
+		fprintf(file, " },\n      ");
+		WriteJsonStatistics(file, "linearDragUs", result.linearDragUs);
+		fprintf(file, ",\n      ");
+		WriteJsonStatistics(file, "circularDragUs", result.circularDragUs);
+		fprintf(file, ",\n      \"dragRedraws\": %d,\n", result.dragRedraws);
+		fprintf(file, "      \"allocationsPerFrame\": %.4f\n", result.allocationsPerFrame);
+		fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"replays\": [\n");
+
+	for (size_t i = 0; i < replays.size(); ++i)
+	{
+		const BenchReplayResult &replay = replays[i];
+		fprintf(file, "    { \"file\": \"%s\", \"mode\": \"%s\", \"events\": %d, \"mismatches\": %d, \"firstMismatch\": %d, \"finishMatches\": %s, \"identical\": %s, \"eventUs\": %.4f }%s\n",
+			replay.file, replay.circular ? "circular" : "linear", replay.replay.events, replay.replay.mismatches, replay.replay.firstMismatch, replay.replay.finishMatches ? "true" : "false", replay.replay.IsIdentical() ? "true" : "false", replay.eventUs, i + 1 < replays.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"dragLoops\": [\n");
+
+	for (size_t i = 0; i < dragLoops.size(); ++i)
+	{
+		const BenchDragLoopResult &loop = dragLoops[i];
+		fprintf(file, "    { \"frameRate\": %d, \"events\": %d, \"frames\": %d, \"wallMs\": %.4f, \"cpuMs\": %.4f, \"cpuMsPerSecond\": %.4f }%s\n",
+			loop.frameRate, loop.stats.events, loop.stats.frames, loop.stats.wallTime, loop.stats.cpuTime, loop.stats.GetCpuPerSecond(), i + 1 < dragLoops.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"batches\": [\n");
+
+	for (size_t i = 0; i < batches.size(); ++i)
+	{
+		const BenchBatchResult &batch = batches[i];
+		fprintf(file, "    { \"threads\": %d, \"knobs\": %d, ", batch.threads, batch.knobCount);
+		WriteJsonStatistics(file, "bankMs", batch.bankMs);
+		fprintf(file, ", \"speedup\": %.4f, \"steals\": %lld, \"mismatches\": %d }%s\n", batch.speedup, (long long)batch.steals, batch.mismatches, i + 1 < batches.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"asyncDrags\": [\n");
+
+	for (size_t i = 0; i < asyncDrags.size(); ++i)
+	{
+		const BenchAsyncDragResult &drag = asyncDrags[i];
+		fprintf(file, "    { \"mode\": \"%s\", ", drag.async ? "async" : "sync");
+		WriteJsonStatistics(file, "eventUs", drag.eventUs);
+		fprintf(file, ", \"requested\": %d, \"rendered\": %lld, \"presented\": %lld, \"mismatches\": %d }%s\n", drag.requested, (long long)drag.rendered, (long long)drag.presented, drag.mismatches, i + 1 < asyncDrags.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"feeds\": [\n");
+
+	for (size_t i = 0; i < feeds.size(); ++i)
+	{
+		const BenchFeedResult &feed = feeds[i];
+		fprintf(file, "    { \"mode\": \"%s\", \"values\": %lld, \"pushed\": %lld, \"superseded\": %lld, \"full\": %lld, \"frames\": %d, \"redraws\": %d, \"valuesPerSecond\": %.1f, ", feed.paced ? "paced" : "unpaced",
+			(long long)feed.values, (long long)feed.pushed, (long long)feed.superseded, (long long)feed.full, feed.frames, feed.redraws, feed.valuesPerSecond);
+		WriteJsonStatistics(file, "drainUs", feed.drainUs);
+		fprintf(file, ", \"finalMatches\": %s }%s\n", feed.finalMatches ? "true" : "false", i + 1 < feeds.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"layerCaches\": [\n");
+
+	for (size_t i = 0; i < layerCaches.size(); ++i)
+	{
+		const BenchLayerCacheResult &layerCache = layerCaches[i];
+		fprintf(file, "    { \"mode\": \"%s\", \"kinds\": %d, \"knobs\": %d, ", layerCache.cached ? "cache" : "redraw", layerCache.kinds, layerCache.knobCount);
+		WriteJsonStatistics(file, "frameMs", layerCache.frameMs);
+		fprintf(file, ", \"knobUs\": %.4f, \"layerDraws\": %lld, \"hits\": %lld, \"misses\": %lld, \"evictions\": %lld, \"layerBytes\": %lld, \"mismatches\": %d }%s\n", layerCache.knobUs, (long long)layerCache.layerDraws,
+			(long long)layerCache.cache.hits, (long long)layerCache.cache.misses, (long long)layerCache.cache.evictions, (long long)layerCache.cache.layerBytes, layerCache.mismatches, i + 1 < layerCaches.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"assetFiles\": [\n");
+
+	for (size_t i = 0; i < assetFiles.size(); ++i)
+	{
+		const BenchAssetFileResult &assetFile = assetFiles[i];
+		const bool mapped = strcmp(assetFile.mode, "mapped") == 0;
+		fprintf(file, "    { \"mode\": \"%s\", \"kinds\": %d, \"openMs\": %.4f, \"firstFrameMs\": %.4f, \"hits\": %lld, \"misses\": %lld, \"added\": %lld, \"damagedAssets\": %lld, \"fileEntries\": %d, \"fileBytes\": %lld, \"mismatches\": %d, \"staleRejected\": %s }%s\n",
+			assetFile.mode, assetFile.kinds, assetFile.openMs, assetFile.firstFrameMs, (long long)assetFile.cache.hits, (long long)assetFile.cache.misses, (long long)assetFile.cache.added, (long long)assetFile.cache.rejectedAssets, assetFile.cache.fileEntries,
+			(long long)assetFile.cache.fileBytes, assetFile.mismatches, mapped ? (assetFile.staleRejected ? "true" : "false") : "null", i + 1 < assetFiles.size() ? "," : "");
+	}
+
+	fprintf(file, "  ],\n");
+	fprintf(file, "  \"triangles\": [\n");
+
+	for (size_t i = 0; i < triangles.size(); ++i)
+	{
+		const BenchTriangleResult &triangle = triangles[i];
+		fprintf(file, "    { \"kernel\": \"%s\", \"size\": %d, \"oversampling\": %d, \"angles\": %d, ", triangle.specialized ? "triangle" : "convex", triangle.size, triangle.oversampling, BENCH_TRIANGLEANGLES);
+		WriteJsonStatistics(file, "frameUs", triangle.frameUs);
+		fprintf(file, ", \"triangleUs\": %.4f, \"mismatches\": %d }%s\n", triangle.triangleUs, triangle.mismatches, i + 1 < triangles.size() ? "," : "");
+	}
+
+	fprintf(file, "  ]\n}\n");
+
+	if (!toStdout)
+		fclose(file);
+	return true;
+}
+
+
+int main(int argc, char **argv)
+{
+	BenchSettings settings;
+	if (!ParseArguments(argc, argv, settings))
+	{
+		fprintf(stderr, "Usage: knobbench [-knobs N,...] [-frames N] [-size N,...] [-oversampling N,...] [-noaa] [-simd scalar|sse2|avx2] [-full] [-atlas N] [-glyphs] [-ticks N] [-drag N] [-savedrag prefix] [-json file] [-ppm file]\n");
+		fprintf(stderr, "       knobbench -replay file [-replay file ...] [-frames N] [-json file]\n");
+		fprintf(stderr, "       knobbench -dragloop ms [-json file]\n");
+		fprintf(stderr, "       knobbench -feed ms [-feedfile file] [-savefeed file] [-json file]\n");
+		fprintf(stderr, "       knobbench -asyncdrag [-drag N] [-size N] [-oversampling N] [-noaa] [-atlas N] [-glyphs] [-json file]\n");
+		fprintf(stderr, "       knobbench -batch N,... [-knobs N] [-frames N] [-size N] [-oversampling N] [-noaa] [-atlas N] [-glyphs] [-json file] [-ppm file]\n");
+		fprintf(stderr, "       knobbench -layercache N [-knobs N] [-frames N] [-size N,...] [-oversampling N,...] [-noaa] [-glyphs] [-json file]\n");
+		fprintf(stderr, "       knobbench -assetfile file [-size N,...] [-oversampling N,...] [-noaa] [-atlas N] [-json file]\n");
+		fprintf(stderr, "       knobbench -triangles [-frames N] [-size N,...] [-oversampling N,...] [-simd scalar|sse2|avx2] [-json file]\n");
+		return 1;
+	}
+
+	// With JSON on stdout, the text output would be in the way
+	const bool printText = !settings.jsonFile || strcmp(settings.jsonFile, "-") != 0;
+
+	KnobPixelBuffer buffer;
+	std::vector<BenchResult> results;
+	std::vector<BenchReplayResult> replays;
+	std::vector<BenchDragLoopResult> dragLoops;
+	std::vector<BenchBatchResult> batches;
+	std::vector<BenchAsyncDragResult> asyncDrags;
+	std::vector<BenchFeedResult> feeds;
+	std::vector<BenchLayerCacheResult> layerCaches;
+	std::vector<BenchAssetFileResult> assetFiles;
+	std::vector<BenchTriangleResult> triangles;
+	bool identical = true;
+
+	if (settings.feedTime > 0 || settings.feedFile)
+	{
+		// A controller that sweeps the value range up and down every two seconds, sending 1000 values per second
+		KnobControllerRecording recording;
+		if (settings.feedFile)
+		{
+			if (!recording.Load(settings.feedFile))
+			{
+				fprintf(stderr, "Could not read %s\n", settings.feedFile);
+				return 1;
+			}
+		}
+		else
+		{
+			for (int32_t time = 0; time < settings.feedTime; ++time)
+				recording.AddValue((double)time, 0.5 - 0.5 * cos((double)time * 3.14159265358979323846 / 1000.0));
+		}
+
+		if (settings.saveFeedFile && !recording.Save(settings.saveFeedFile))
+		{
+			fprintf(stderr, "Could not write %s\n", settings.saveFeedFile);
+			return 1;
+		}
+
+		KnobDrawValues drawValues;
+		drawValues.InitGeometry(settings.sizes[0], settings.oversamplings[0], 5, 135.0, 14, 14, settings.antialiasing);
+
+		for (int32_t i = 0; i < 2; ++i)
+		{
+			BenchFeedResult feed;
+			if (!MeasureFeed(recording, drawValues, i == 1, feed))
+				return 1;
+
+			if (printText)
+				printf("controller feed %s: %lld values, %lld pushed, %lld replaced while full, %.0f values per second, %d frames, %d redraws, drain us p50 %.3f p99 %.3f, last value %s\n", feed.paced ? "paced, drained at 60 Hz" : "unpaced",
+					(long long)feed.values, (long long)feed.pushed, (long long)feed.superseded, feed.valuesPerSecond, feed.frames, feed.redraws, feed.drainUs.p50, feed.drainUs.p99, feed.finalMatches ? "identical" : "DIFFERS");
+
+			identical = identical && feed.finalMatches;
+			feeds.push_back(feed);
+		}
+	}
+	else if (settings.assetFile)
+	{
+		// Without the file first, its frames are the reference. Then with the file, and with a copy where the last asset is damaged.
+		const std::string damagedFile = std::string(settings.assetFile) + ".damaged";
+		std::vector<uint64_t> hashes;
+		for (int32_t i = 0; i < 3; ++i)
+		{
+			BenchAssetFileResult assetFile;
+			assetFile.mode = i == 0 ? "drawn" : (i == 1 ? "mapped" : "damaged");
+			const char *filename = i < 2 ? settings.assetFile : damagedFile.c_str();
+			if ((i == 2 && !WriteDamagedAssetFile(settings.assetFile, -1, filename)) || !MeasureAssetFile(settings, filename, i == 0, hashes, assetFile))
+			{
+				fprintf(stderr, "Could not %s %s\n", i == 0 ? "write" : "use", filename);
+				return 1;
+			}
+			if (i == 1)
+				assetFile.staleRejected = AreStaleAssetFilesRejected(settings.assetFile);
+			if (i == 2)
+				remove(filename);
+
+			if (printText)
+			{
+				printf("first frames of %d sizes, assets %s: %.3f ms", assetFile.kinds, i == 0 ? "drawn" : (i == 1 ? "from mapped file" : "from damaged file"), assetFile.firstFrameMs);
+				if (i == 0)
+					printf(", %lld assets saved\n", (long long)assetFile.cache.added);
+				else
+					printf(" (%.3f ms to map %lld bytes and check the index), %lld hits, %lld misses, %lld damaged, %s", assetFile.openMs, (long long)assetFile.cache.fileBytes, (long long)assetFile.cache.hits, (long long)assetFile.cache.misses,
+						(long long)assetFile.cache.rejectedAssets, assetFile.mismatches == 0 ? "identical" : "FRAMES DIFFER");
+				if (i == 1)
+					printf(", stale files %s\n", assetFile.staleRejected ? "rejected" : "NOT REJECTED");
+				else if (i == 2)
+					printf("\n");
+			}
+
+			identical = identical && assetFile.mismatches == 0 && (i != 1 || assetFile.staleRejected) && (i != 2 || assetFile.cache.rejectedAssets == 1);
+			assetFiles.push_back(assetFile);
+		}
+	}
+	else if (settings.triangles)
+	{
+		// The version for 3 corners first, its pixels are the reference
+		for (size_t o = 0; o < settings.oversamplings.size(); ++o)
+		{
+			for (size_t s = 0; s < settings.sizes.size(); ++s)
+			{
+				std::vector<uint64_t> hashes;
+				for (int32_t i = 0; i < 2; ++i)
+				{
+					BenchTriangleResult triangle;
+					if (!MeasureTriangles(settings, settings.sizes[s], settings.oversamplings[o], i == 0, hashes, triangle))
+						return 1;
+
+					if (printText)
+					{
+						printf("size=%d oversampling=%d, %d marker angles, %s: %.3f us per triangle (frame us p50 %.3f, max %.3f)", triangle.size, triangle.oversampling, BENCH_TRIANGLEANGLES,
+							triangle.specialized ? "fill for 3 corners" : "fill for any corners", triangle.triangleUs, triangle.frameUs.p50, triangle.frameUs.max);
+						if (triangle.specialized)
+							printf("\n");
+						else
+							printf(", 3 corners %.2fx as fast, %s\n", triangle.triangleUs / std::max(triangles.back().triangleUs, 1e-9), triangle.mismatches == 0 ? "identical" : "PIXELS DIFFER");
+					}
+
+					identical = identical && triangle.mismatches == 0;
+					triangles.push_back(triangle);
+				}
+			}
+		}
+	}
+	else if (settings.layerCacheSize >= 0)
+	{
+		// Without the cache first, its frames are the reference
+		std::vector<uint64_t> hashes;
+		for (int32_t i = 0; i < 2; ++i)
+		{
+			BenchLayerCacheResult layerCache;
+			if (!MeasureLayerCache(settings, i == 1, hashes, layerCache))
+				return 1;
+
+			if (printText)
+			{
+				printf("%d sizes mixed, static layers %s: %d knobs, %.3f ms per frame (p50 %.3f, max %.3f), %.2f us per knob", layerCache.kinds, layerCache.cached ? "from cache" : "redrawn", layerCache.knobCount, layerCache.frameMs.mean, layerCache.frameMs.p50, layerCache.frameMs.max, layerCache.knobUs);
+				if (layerCache.cached)
+					printf(", %lld hits, %lld misses, %lld evicted, %lld bytes cached, %s\n", (long long)layerCache.cache.hits, (long long)layerCache.cache.misses, (long long)layerCache.cache.evictions, (long long)layerCache.cache.layerBytes, layerCache.mismatches == 0 ? "identical" : "FRAMES DIFFER");
+				else
+					printf(", %lld static layers drawn\n", (long long)layerCache.layerDraws);
+			}
+
+			identical = identical && layerCache.mismatches == 0;
+			layerCaches.push_back(layerCache);
+		}
+	}
+	else if (settings.asyncDrag)
+	{
+		for (int32_t i = 0; i < 2; ++i)
+		{
+			BenchAsyncDragResult drag;
+			if (!MeasureAsyncDrag(settings, i == 1, drag))
+				return 1;
+
+			if (printText)
+			{
+				printf("drag drawing %s: us per event p50 %.3f p99 %.3f max %.3f, %d frames %s", drag.async ? "on render thread" : "on input thread", drag.eventUs.p50, drag.eventUs.p99, drag.eventUs.max, drag.requested, drag.async ? "requested" : "drawn");
+				if (drag.async)
+					printf(", %lld rendered, %lld shown, last frame %s", (long long)drag.rendered, (long long)drag.presented, drag.mismatches == 0 ? "identical" : "DIFFERS");
+				printf("\n");
+			}
+
+			identical = identical && drag.mismatches == 0;
+			asyncDrags.push_back(drag);
+		}
+	}
+	else if (!settings.batchThreads.empty())
+	{
+		// One thread first, as the reference for the speedup
+		std::vector<int32_t> threadCounts(1, 1);
+		for (size_t i = 0; i < settings.batchThreads.size(); ++i)
+		{
+			if (settings.batchThreads[i] != 1)
+				threadCounts.push_back(settings.batchThreads[i]);
+		}
+
+		for (size_t i = 0; i < threadCounts.size(); ++i)
+		{
+			BenchBatchResult batch;
+			if (!MeasureBatch(settings, threadCounts[i], batch, buffer))
+				return 1;
+			if (batch.bankMs.mean > 0.0)
+				batch.speedup = batches.empty() ? 1.0 : batches[0].bankMs.mean / batch.bankMs.mean;
+
+			if (printText)
+				printf("batch %d threads: %d knobs, %.3f ms per bank (p50 %.3f, max %.3f), speedup %.2f, %lld steals, %s\n", batch.threads, batch.knobCount, batch.bankMs.mean, batch.bankMs.p50, batch.bankMs.max, batch.speedup,
+					(long long)batch.steals, batch.mismatches == 0 ? "identical" : "FRAMES DIFFER");
+
+			identical = identical && batch.mismatches == 0;
+			batches.push_back(batch);
+		}
+
+		if (printText)
+			printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+	}
+	else if (settings.dragLoopTime > 0)
+	{
+		// Every event against one frame at 60 Hz
+		KnobDrawValues drawValues;
+		drawValues.InitGeometry(settings.sizes[0], settings.oversamplings[0], 5, 135.0, 14, 14, settings.antialiasing);
+
+		const int32_t frameRates[2] = { 0, 60 };
+		for (int32_t i = 0; i < 2; ++i)
+		{
+			BenchDragLoopResult loop;
+			MeasureDragLoop(drawValues, frameRates[i], settings.dragLoopTime, loop);
+			if (printText)
+				printf("drag loop %s: %d events, %d frames, %.1f ms CPU per second of dragging\n", loop.frameRate > 0 ? "paced to 60 Hz" : "every event", loop.stats.events, loop.stats.frames, loop.stats.GetCpuPerSecond());
+			dragLoops.push_back(loop);
+		}
+	}
+	else if (!settings.replayFiles.empty())
+	{
+		// Replay recorded drags instead of drawing
+		for (size_t i = 0; i < settings.replayFiles.size(); ++i)
+		{
+			BenchReplayResult replay;
+			if (!ReplayDrag(settings.replayFiles[i], settings.frameCount, replay))
+			{
+				fprintf(stderr, "Could not read %s\n", settings.replayFiles[i]);
+				return 1;
+			}
+
+			if (printText)
+			{
+				printf("replay %s: %d events, %s mode, %.3f us per event, ", replay.file, replay.replay.events, replay.circular ? "circular" : "linear", replay.eventUs);
+				if (replay.replay.IsIdentical())
+					printf("identical\n");
+				else
+					printf("%d events differ (first at event %d)%s\n", replay.replay.mismatches, replay.replay.firstMismatch, replay.replay.finishMatches ? "" : ", final value differs");
+			}
+
+			identical = identical && replay.replay.IsIdentical();
+			replays.push_back(replay);
+		}
+	}
+	else
+	{
+		KnobDragRecording linearDrag;
+		KnobDragRecording circularDrag;
+		for (size_t o = 0; o < settings.oversamplings.size(); ++o)
+		{
+			for (size_t s = 0; s < settings.sizes.size(); ++s)
+			{
+				for (size_t k = 0; k < settings.knobCounts.size(); ++k)
+				{
+					// Only the drags of the first configuration are recorded
+					const bool record = settings.saveDragPrefix && results.empty();
+
+					BenchResult result;
+					if (!RunBenchmark(settings, settings.knobCounts[k], settings.sizes[s], settings.oversamplings[o], buffer, result, record ? &linearDrag : nullptr, record ? &circularDrag : nullptr))
+						return 1;
+
+					if (printText)
+						PrintResult(settings, result);
+					results.push_back(result);
+				}
+			}
+		}
+
+		if (settings.saveDragPrefix)
+		{
+			const std::string linearFile = std::string(settings.saveDragPrefix) + "-linear.txt";
+			const std::string circularFile = std::string(settings.saveDragPrefix) + "-circular.txt";
+			if (!linearDrag.Save(linearFile.c_str()) || !circularDrag.Save(circularFile.c_str()))
+			{
+				fprintf(stderr, "Could not write %s\n", linearFile.c_str());
+				return 1;
+			}
+		}
+	}
+
+	if (settings.jsonFile && !WriteJson(settings, results, replays, dragLoops, batches, asyncDrags, feeds, layerCaches, assetFiles, triangles, settings.jsonFile))
+	{
+		fprintf(stderr, "Could not write %s\n", settings.jsonFile);
+		return 1;
+	}
+
+	if (settings.ppmFile && !WritePpm(buffer, settings.ppmFile))
+	{
+		fprintf(stderr, "Could not write %s\n", settings.ppmFile);
+		return 1;
+	}
+
+	// A replay that doesn't match the recording, or a batch frame that doesn't match the serial one, is a regression
+	return identical ? 0 : 2;
+}
@@ -1,14 +1,14 @@
-enum
-{
-	// string table definitions
-	IDS_TESTOBJECT	= 10000,
-
-	// Other
-	IDS_CUSTOMGUISTRING,
-	IDS_CUSTOMGUI_DOTS,
-	IDS_CUSTOMDATATYPE_DOTS,
-	IDS_CUSTOMGUI_ROTARYKNOB,
-
-	// End of symbol definition
-	_DUMMY_ELEMENT_
-};
+enum
+{
+	// string table definitions
+	IDS_TESTOBJECT	= 10000,
+
+	// Other
+	IDS_CUSTOMGUISTRING,
+	IDS_CUSTOMGUI_DOTS,
+	IDS_CUSTOMDATATYPE_DOTS,
+	IDS_CUSTOMGUI_ROTARYKNOB,
+
+	// End of symbol definition
+	_DUMMY_ELEMENT_
+};
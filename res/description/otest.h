@@ -1,10 +1,22 @@
-#ifndef OTEST_H__
-#define OTEST_H__
-
-enum
-{
-	TEST_PARAM_1   = 10000,
-	TEST_PARAM_2   = 10001
-};
-
-#endif // OTEST_H__
+#ifndef OTEST_H__
+#define OTEST_H__
+
+enum
+{
+	TEST_PARAM_1   = 10000,
+	TEST_PARAM_2   = 10001,
+	TEST_PARAM_3   = 10002,
+	TEST_PARAM_4   = 10008,
+
+	TEST_GROUP_KNOBSTATS    = 10003,
+	TEST_KNOBSTATS_PRINT    = 10004,
+	TEST_KNOBSTATS_SAVE     = 10005,
+	TEST_KNOBSTATS_RESET    = 10006,
+	TEST_KNOBSTATS_SAVEDRAG = 10007,
+
+	TEST_GROUP_CONTROLLER   = 10009,
+	TEST_CONTROLLER_REPLAY  = 10010,
+	TEST_CONTROLLER_STOP    = 10011
+};
+
+#endif // OTEST_H__
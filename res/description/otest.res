@@ -1,13 +1,34 @@
-CONTAINER Otest
-{
-	NAME Otest;
-	INCLUDE Obase;
-
-	GROUP ID_OBJECTPROPERTIES
-	{
-		COLUMNS 3;
-
-		REAL TEST_PARAM_1    { UNIT REAL; MIN 0.0; MAX 1.0; STEP 0.1; CUSTOMGUI ROTARYKNOB; }
-		REAL TEST_PARAM_2    { UNIT REAL; MIN 0.0; MAX 10.0; STEP 0.1; CUSTOMGUI ROTARYKNOB; CIRCULAR; }
-	}
-}
+CONTAINER Otest
+{
+	NAME Otest;
+	INCLUDE Obase;
+
+	GROUP ID_OBJECTPROPERTIES
+	{
+		COLUMNS 3;
+
+		REAL TEST_PARAM_1    { UNIT REAL; MIN 0.0; MAX 1.0; STEP 0.1; CUSTOMGUI ROTARYKNOB; CONTROLLER 1; }
+		REAL TEST_PARAM_2    { UNIT REAL; MIN 0.0; MAX 10.0; STEP 0.1; CUSTOMGUI ROTARYKNOB; CIRCULAR; }
+		REAL TEST_PARAM_3    { UNIT REAL; MIN 0.0; MAX 1.0; STEP 0.01; CUSTOMGUI ROTARYKNOB; MARKER_ATLAS; TICKS 20; }
+		REAL TEST_PARAM_4    { UNIT REAL; MIN 0.0; MAX 100.0; STEP 0.1; CUSTOMGUI ROTARYKNOB; CIRCULAR; TURNS 4.0; SIZE 140; }
+	}
+
+	GROUP TEST_GROUP_KNOBSTATS
+	{
+		DEFAULT 1;
+		COLUMNS 2;
+
+		BUTTON TEST_KNOBSTATS_PRINT { }
+		BUTTON TEST_KNOBSTATS_SAVE  { }
+		BUTTON TEST_KNOBSTATS_RESET { }
+		BUTTON TEST_KNOBSTATS_SAVEDRAG { }
+	}
+
+	GROUP TEST_GROUP_CONTROLLER
+	{
+		COLUMNS 2;
+
+		BUTTON TEST_CONTROLLER_REPLAY { }
+		BUTTON TEST_CONTROLLER_STOP   { }
+	}
+}
@@ -1,615 +1,1303 @@
-#include "c4d.h"
-#include "main.h"
-#include "c4d_symbols.h"
-#include "customgui_rotaryknob.h"
-
-
-/// Maps a value from an input range to an output range
-/// @param[in] value The input value
-/// @param[in] minInput Defines the lower limit of the input range
-/// @param[in] maxInput Defines the upper limit of the input range
-/// @param[in] minOutput Defines the lower limit of the output range
-/// @param[in] maxOutput Defines the upper limit of the output range
-/// @return The mapped value
-static inline Float MapRange(Float value, Float minInput, Float maxInput, Float minOutput, Float maxOutput)
-{
-	if ((maxInput - minInput) == 0)
-		return minOutput;
-	
-	return  minOutput + (maxOutput - minOutput) * ((value - minInput) / (maxInput - minInput));
-}
-
-/// Raster (or "round") a value to a grid.
-/// This is an extended version of Round(), rounding not just to whole numbers but to a grid with any spacing.
-/// The input value will be rounded to the nearest grid point.
-/// @param[in] value The input value
-/// @param[in] grid The grid spacing
-/// @return The rounded value
-static Float RoundGrid(Float value, Float grid)
-{
-	if (grid == 0.0)
-		return 0.0;
-	
-	value = value / grid + 0.5;
-	value = Floor(value);
-	value = value * grid;
-	
-	return value;
-}
-
-
-KnobAreaDrawValues::KnobAreaDrawValues(GeClipMap &clipMap)
-{
-	// Area & background
-	areaWidth = ROTARYKNOBAREA_WIDTH * ROTARYKNOBAREA_OVERSAMPLING;
-	areaHalfWidth = areaWidth / 2;
-	areaRadius = areaHalfWidth - ROTARYKNOBAREA_MARGIN;
-	areaColor = GetGuiWorldColor(COLOR_BG);
-	
-	// Scale
-	scaleRadius1 = areaRadius * 1.1;
-	scaleRadius2 = areaRadius * 1.05;
-	scaleLimitRadians = Rad(ROTARYKNOBAREA_SCALELIMIT);
-	scaleLimitRadiansNeg = Rad(-ROTARYKNOBAREA_SCALELIMIT);
-	scaleColor = GetGuiWorldColor(COLOR_BG_DARK1);
-	
-	// Knob
-	knobOuterCorner1 = ROTARYKNOBAREA_MARGIN;
-	knobOuterCorner2 = areaWidth - ROTARYKNOBAREA_MARGIN;
-	knobOuterColor = GetGuiWorldColor(COLOR_BG_DARK1);
-	
-	knobInnerCorner1 = (Int32)(ROTARYKNOBAREA_MARGIN * 1.15);
-	knobInnerCorner2 = areaWidth - knobInnerCorner1;
-	knobInnerColor = GetGuiWorldColor(COLOR_BG_DARK2);
-	
-	knobCenterCorner1 = (Int32)(-ROTARYKNOBAREA_MARGIN + areaHalfWidth);
-	knobCenterCorner2 = ROTARYKNOBAREA_MARGIN + areaHalfWidth;
-	knobCenterColor = GetGuiWorldColor(COLOR_BG_HIGHLIGHT);
-	
-	// Marker
-	markerLength = areaRadius * 0.8;
-	markerThickness = ROTARYKNOBAREA_MARGIN * 0.6;
-	markerColor = GetGuiWorldColor(COLOR_BG_HIGHLIGHT);
-	
-	// Value label
-	labelPosY = (Int32)(areaHalfWidth * 1.5) - clipMap.GetTextHeight() / 2;
-	labelColor = GetGuiWorldColor(COLOR_MENU_BG_ICON);
-	clipMap.GetDefaultFont(GE_FONT_DEFAULT_SYSTEM, &labelFontDesc);
-}
-
-
-RotaryKnobArea::RotaryKnobArea() : _tristate(false), _value(0.0)
-{
-	if (_canvas)
-	{
-		// Prepare cache with values needed for drawing
-		_drawValues = KnobAreaDrawValues(*_canvas);
-	}
-}
-
-RotaryKnobArea::~RotaryKnobArea()
-{}
-
-Bool RotaryKnobArea::Init()
-{
-	return true;
-}
-
-Bool RotaryKnobArea::InitValues()
-{
-	return true;
-}
-
-Bool RotaryKnobArea::GetMinSize(Int32 &w, Int32 &h)
-{
-	w = h = ROTARYKNOBAREA_WIDTH;
-	
-	return true;
-}
-
-void RotaryKnobArea::DrawMsg(Int32 x1, Int32 y1, Int32 x2, Int32 y2, const BaseContainer &msg)
-{
-	if (!_canvas)
-		return;
-	
-	// Cancel if anything goes wrong
-	if (_canvas->Init(_drawValues.areaWidth, _drawValues.areaWidth, 24) != IMAGERESULT_OK)
-		return;
-	
-	// Select whole user area as clipping area
-	this->OffScreenOn();
-	
-	// Start drawing in ClipMap
-	_canvas->BeginDraw();
-	{
-		// Fill the background
-		DrawBackground(_drawValues);
-		
-		// Draw the scale
-		DrawScale(_drawValues);
-		
-		// Draw the knob
-		DrawKnob(_drawValues);
-		
-		// Draw the marker
-		DrawMarker(_drawValues);
-		
-		// Draw the value
-		DrawValue(_drawValues);
-	}
-	// End drawing in the ClipMap
-	_canvas->EndDraw();
-	
-	// Draw ClipMap to user area
-	this->DrawBitmap(_canvas->GetBitmap(), 0, 0, ROTARYKNOBAREA_WIDTH, ROTARYKNOBAREA_WIDTH, 0, 0, _drawValues.areaWidth, _drawValues.areaWidth, _tristate ? BMP_EMBOSSED : BMP_NORMAL);
-}
-
-Bool RotaryKnobArea::InputEvent(const BaseContainer &msg)
-{
-	const Int32 device  = msg.GetInt32(BFM_INPUT_DEVICE);
-	const Int32 channel = msg.GetInt32(BFM_INPUT_CHANNEL);
-	
-	if (device == BFM_INPUT_MOUSE && channel == BFM_INPUT_MOUSELEFT)
-	{
-		// Catch double click first
-		if (msg.GetBool(BFM_INPUT_DOUBLECLICK))
-		{
-			GePrint("Doubleclick!");
-			
-			// Notify parent GUI
-			// Build message container with ID and value
-			BaseContainer m(BFM_ACTION);
-			m.SetInt32(BFM_ACTION_ID, GetId());
-			m.SetData(BFM_ACTION_VALUE, GeData(_value));
-			m.SetInt32(MSG_KNOBAREAMESSAGE, MSG_KNOBAREAMESSAGE_SHOWPOPUP);
-			SendParentMessage(m);
-
-			return true;
-		}
-		
-		// Container we need later for the query calls
-		BaseContainer channels;
-		BaseContainer state;
-		
-		// Values required for calculating the deltas
-		Int32 startX = msg.GetInt32(BFM_INPUT_X);  // Start X coordinate
-		Int32 startY = msg.GetInt32(BFM_INPUT_Y);  // Start Y coordinate
-		Float deltaX = 0.0;  // Current X delta (only needed to determine if mouse has moved during the drag)
-		Float deltaY = 0.0;  // Current Y delta (no needed at all, but MouseDragStart() wants a Y delta, too)
-		Float oldValue = _value;  // The value at the time when the mouse drag started
-		
-		Global2Local(&startX, &startY);  // Transform start coordinates to user area's local space
-		
-		// Start mouse drag
-		MouseDragStart(BFM_INPUT_MOUSELEFT, startX, startY, MOUSEDRAGFLAGS_DONTHIDEMOUSE);
-		
-		// Check if mouse drag is still continueing
-		while (MouseDrag(&deltaX, &deltaY, &channels) == MOUSEDRAGRESULT_CONTINUE)
-		{
-			// Get state of left mouse button
-			if (!GetInputState(BFM_INPUT_MOUSE, BFM_INPUT_MOUSELEFT, state))
-				break;
-			
-			// Cancel if mouse button not pressed
-			if (state.GetInt32(BFM_INPUT_VALUE) == 0)
-				break;
-			
-			// Mouse has been moved
-			if (deltaX != 0.0 || deltaY != 0.0)
-			{
-				// Circular or linear knob behavior?
-				if (_properties._circularMouse)
-				{
-					// We'll set the value according to the mouse cursor position in the circle
-					
-					// Steps:
-					// 1. Transform the XY mouse coordinates to an angle
-					// 2. Map the resulting angle back to the CustomGUI's value range
-					// 3. Set result as _value
-					
-					// 1. Getting an angle
-					
-					// Get local mouse coordinates
-					Int32 mouseX = state.GetInt32(BFM_INPUT_X);
-					Int32 mouseY = state.GetInt32(BFM_INPUT_Y);
-					Global2Local(&mouseX, &mouseY);
-					
-					// Construct vectors for angle measuretaking
-					Vector coord((Float)mouseX, (Float)mouseY, 0.0);
-					Vector unit(0.0, -1.0, 0.0);
-					
-					// Offset mouse coordinates, because the center of the knob is not at (0;0)
-					Float halfWidth = (Float)ROTARYKNOBAREA_WIDTH / 2.0;
-					coord.x -= halfWidth;
-					coord.y -= halfWidth;
-					
-					// Normalize (required for the Atan2() angle measuring below)
-					coord.Normalize();
-					
-					// Get angle in radians.
-					Float angle = GetAngle(unit, coord);
-					
-					// Since GetAngle() always returns positive values, we have to get our sign back
-					if (coord.x < 0.0)
-						angle *= -1.0;
-
-					// 2, Map the angle to the output range of the GUI element
-					Float newValue = MapRange(angle, Rad(-ROTARYKNOBAREA_SCALELIMIT), Rad(ROTARYKNOBAREA_SCALELIMIT), _properties._descMin, _properties._descMax);
-					
-					//GePrint("MousePos=[" + String::FloatToString(coord.x) + ";" + String::FloatToString(coord.y) + "]; ScaleLimits=[" + String::FloatToString(-ROTARYKNOBAREA_SCALELIMIT) + "°;" + String::FloatToString(ROTARYKNOBAREA_SCALELIMIT) + "]; Angle=" + String::FloatToString(Deg(angle)) + "°; newValue=" + String::FloatToString(newValue));
-
-					// 3. Set as new value
-					_value = newValue;
-				}
-				else
-				{
-					// We calculate our own delta
-					// The delta from the MouseDrag() call is only differential to the previous call,
-					// but we need a delta that's differential to the ORIGINAL (not the previous) mouse position and the current one.
-					Int32 currentY = state.GetInt32(BFM_INPUT_Y);
-					Global2Local(nullptr, &currentY);
-					Float totalDelta = startY - currentY;
-					
-					// Default multiplier (for knob rotating speed)
-					Float multiplier = ROTARYKNOBAREA_MULTIPLIER_NORMAL;
-					
-					// Query SHIFT key. If it's pressed, we'll apply the PRECISE multiplier
-					Bool bShift = channels.GetInt32(BFM_INPUT_QUALIFIER) & QSHIFT;
-					if (bShift)
-						multiplier = ROTARYKNOBAREA_MULTIPLIER_PRECISE; // Precise multiplier. Makes knob rotate slower.
-					
-					// Calculate the change of the value for this drag.
-					// For this, we use the totalDelta and not the current delta (see above for more info)
-					Float valueChange = totalDelta * (_properties._descMax - _properties._descMin) * multiplier;
-					
-					// Update value
-					_value = oldValue + valueChange;
-					
-					// Calculate value grid snapping if CTRL is pressed
-					Bool bCtrl = channels.GetInt32(BFM_INPUT_QUALIFIER) & QCTRL;
-					if (bCtrl)
-						_value = RoundGrid(_value, ROTARYKNOBAREA_VALUEGRIDSIZE);
-				}
-				
-				// Clamp value, just to be on the safe side
-				_value = ClampValue(_value, _properties._descMin, _properties._descMax);
-				
-				// Notify parent GUI
-				// Build message container with ID and value
-				BaseContainer m(BFM_ACTION);
-				m.SetInt32(BFM_ACTION_ID, GetId());
-				m.SetData(BFM_ACTION_VALUE, GeData(_value));
-				m.SetBool(BFM_ACTION_INDRAG, true);  // Important: We're still dragging
-				SendParentMessage(m);
-			}
-		}
-		// Mouse drag is over now
-		MouseDragEnd();
-		return true;
-	}
-	
-	return false;
-}
-
-void RotaryKnobArea::SetProperties(const DescElementProperties &properties)
-{
-	_properties = properties;
-}
-
-void RotaryKnobArea::SetValue(Float newValue, Bool newTristate)
-{
-	_value = newValue;
-	_tristate = newTristate;
-}
-
-Float RotaryKnobArea::GetValue() const
-{
-	return _value;
-}
-
-void RotaryKnobArea::ColorToRGB(const Vector &color, Int32 &r, Int32 &g, Int32 &b) const
-{
-	r = (Int32)(color.x * 255.0);
-	g = (Int32)(color.y * 255.0);
-	b = (Int32)(color.z * 255.0);
-}
-
-void RotaryKnobArea::SetCanvasColor(const Vector &col)
-{
-	Int32 r = 0, g = 0, b = 0;
-	
-	// Get standard GUI color, convert to RGB
-	ColorToRGB(col, r, g, b);
-	
-	// Set color
-	_canvas->SetColor(r, g, b);
-}
-
-void RotaryKnobArea::DrawBackground(const KnobAreaDrawValues &drawValues)
-{
-	SetCanvasColor(drawValues.areaColor);
-	_canvas->FillRect(0, 0, _canvas->GetBw(), _canvas->GetBw());
-}
-
-void RotaryKnobArea::DrawKnob(const KnobAreaDrawValues &drawValues)
-{
-	// Draw outer circle (acts as a bold dark outline)
-	SetCanvasColor(drawValues.knobOuterColor);
-	_canvas->FillEllipse(drawValues.knobOuterCorner1, drawValues.knobOuterCorner1, drawValues.knobOuterCorner2, drawValues.knobOuterCorner2);
-	
-	// Draw inner circle
-	SetCanvasColor(drawValues.knobInnerColor);
-	_canvas->FillEllipse(drawValues.knobInnerCorner1, drawValues.knobInnerCorner1, drawValues.knobInnerCorner2, drawValues.knobInnerCorner2);
-	
-	// Draw center
-	SetCanvasColor(drawValues.knobCenterColor);
-	_canvas->FillEllipse(drawValues.knobCenterCorner1, drawValues.knobCenterCorner1, drawValues.knobCenterCorner2, drawValues.knobCenterCorner2);
-}
-
-//TO DO: Still buggy
-void RotaryKnobArea::DrawScale(const KnobAreaDrawValues &drawValues)
-{
-	// Draw n lines
-	for (Int32 i = 0; i <= 10; ++i)
-	{
-		// Map value to scale
-		Float value = MapRange((Float)i * 0.1, 0.0, 1.0, drawValues.scaleLimitRadiansNeg, drawValues.scaleLimitRadians);
-		
-		// Map value to circle
-		Float x = Sin(value);
-		Float y = Cos(value);
-		
-		// Select radius (every 2nd scale line is shorter)
-		Float radius = (i % 2 == 1) ? drawValues.scaleRadius2 : drawValues.scaleRadius1;
-
-		// Calculate draw coordinates
-		Int32 ox = (Int32)(x * radius);
-		Int32 oy = (Int32)(y * -radius);
-
-		SetCanvasColor(drawValues.scaleColor);
-		
-		_canvas->Line(drawValues.areaHalfWidth, drawValues.areaHalfWidth, ox + drawValues.areaHalfWidth, oy + drawValues.areaHalfWidth);
-	}
-}
-
-void RotaryKnobArea::DrawMarker(const KnobAreaDrawValues &drawValues)
-{
-	// Map value to scale
-	Float value = MapRange(_value, _properties._descMin, _properties._descMax, drawValues.scaleLimitRadiansNeg, drawValues.scaleLimitRadians);
-	
-	// Map value to circle
-	Float x = Sin(value);
-	Float y = Cos(value);
-
-	// Set color
-	SetCanvasColor(drawValues.markerColor);
-	
-	// Set up point array
-	GE_POINT2D points[3];
-	points[0].x = (Int32)(y * drawValues.markerThickness + drawValues.areaHalfWidth);
-	points[0].y = (Int32)(x * drawValues.markerThickness + drawValues.areaHalfWidth);
-	points[1].x = (Int32)(-y * drawValues.markerThickness + drawValues.areaHalfWidth);
-	points[1].y = (Int32)(-x * drawValues.markerThickness + drawValues.areaHalfWidth);
-	points[2].x = (Int32)(x * drawValues.markerLength + drawValues.areaHalfWidth);
-	points[2].y = (Int32)(y * -drawValues.markerLength + drawValues.areaHalfWidth);
-	
-	// Draw
-	_canvas->FillPolygon(3, points);
-}
-
-// Draw value text
-void RotaryKnobArea::DrawValue(KnobAreaDrawValues &drawValues)
-{
-	// Get value string
-	String label = String::FloatToString(_value);
-	
-	// Set font size
-	_canvas->SetFontSize(&drawValues.labelFontDesc, GE_FONT_SIZE_INTERNAL, ROTARYKNOBAREA_FONTSIZE);
-	_canvas->SetFont(&drawValues.labelFontDesc);
-
-	// Draw value string
-	SetCanvasColor(drawValues.labelColor);
-	_canvas->TextAt(drawValues.areaHalfWidth - _canvas->GetTextWidth(label) / 2, drawValues.labelPosY, label);
-}
-
-
-
-// Defining default values
-RotaryKnobCustomGui::RotaryKnobCustomGui(const BaseContainer &settings, CUSTOMGUIPLUGIN *plugin) : iCustomGui(settings, plugin), _tristate(false), _value(0.0)
-{
-	_descProperties = DescElementProperties(settings);
-}
-
-// Rebuild layout
-Bool RotaryKnobCustomGui::CreateLayout()
-{
-	GroupBegin(1000, BFH_SCALEFIT|BFV_FIT, 1, 2, String(), 0, ROTARYKNOBAREA_WIDTH, ROTARYKNOBAREA_WIDTH);
-	{
-		GroupSpace(0, 0);
-		
-		// Add element title
-		if (!_descProperties._hideName)
-			this->AddStaticText(0, BFH_CENTER, 0, 0, _descProperties._descName, 0);
-
-		// Create the knob user area
-		C4DGadget* userArea = this->AddUserArea(IDC_KNOBAREA, BFH_CENTER, ROTARYKNOBAREA_WIDTH, ROTARYKNOBAREA_WIDTH);
-		this->AttachUserArea(_knob, userArea);
-		
-		// Set data in user area
-		_knob.SetProperties(_descProperties);
-		_knob.SetValue(_value, _tristate);
-	}
-	GroupEnd();
-
-	return SUPER::CreateLayout();
-}
-
-// Set values to GUI elements, handle tristates
-Bool RotaryKnobCustomGui::InitValues()
-{
-	// Dummy TriState
-	TriState<Float> triState;
-	triState.Add(_value);
-	
-	// If GUI element is in a tristate state, just add some dummy value to the number field look tristate'y
-	if (_tristate)
-		triState.Add(123.456);
-	
-	// Set tristate to number field and knob area
-	_knob.SetValue(_value, _tristate);
-
-	return SUPER::InitValues();
-}
-
-// An element was used by the user
-Bool RotaryKnobCustomGui::Command(Int32 id, const BaseContainer &msg)
-{
-	switch (id)
-	{
-		case IDC_KNOBAREA:
-		{
-			// Catch our custom KnobArea messages first
-			if (msg.GetInt32(MSG_KNOBAREAMESSAGE) == MSG_KNOBAREAMESSAGE_SHOWPOPUP)
-			{
-				GePrint("Show value entry popup!");
-				return true;
-			}
-			
-			// Get new value from knob user area
-			_value = _knob.GetValue();
-			
-			// Update GUI
-			this->InitValues();
-			
-			// Send message to parent object to update the parameter value
-			SendParentGuiMessage();
-			
-			return true;
-		}
-	}
-
-	return SUPER::Command(id, msg);
-}
-
-Int32 RotaryKnobCustomGui::Message(const BaseContainer& msg, BaseContainer& result)
-{
-	// Cinema wants to get cursor information
-	if (msg.GetId() == BFM_GETCURSORINFO)
-	{
-		// Construct result message container
-		result.SetId(BFM_GETCURSORINFO);
-		result.SetInt32(RESULT_CURSOR, MOUSE_POINT_HAND);
-		result.SetString(RESULT_BUBBLEHELP, String::FloatToString(_value));
-	}
-	
-	return SUPER::Message(msg, result);
-}
-
-// The data is changed from the outside.
-Bool RotaryKnobCustomGui::SetData(const TriState<GeData> &tristate)
-{
-	// Store values internally
-	_value    = tristate.GetValue().GetFloat();
-	_tristate = tristate.GetTri();
-
-	// Set values to GUI elements & trigger redraw
-	this->InitValues();
-	_knob.Redraw();
-
-	return true;
-}
-
-// The data is requested from the outside.
-TriState<GeData> RotaryKnobCustomGui::GetData()
-{
-	// Construct a TriState from the value
-	TriState<GeData> tri;
-	tri.Add(_value);
-
-	return tri;
-}
-
-Int32 RotaryKnobCustomGui::CustomGuiWidth()
-{
-	return ROTARYKNOBAREA_WIDTH;
-}
-
-Int32 RotaryKnobCustomGui::CustomGuiHeight()
-{
-	return ROTARYKNOBAREA_WIDTH;
-}
-
-void RotaryKnobCustomGui::SendParentGuiMessage()
-{
-	// Build message container with ID and value
-	BaseContainer m(BFM_ACTION);
-	m.SetInt32(BFM_ACTION_ID, GetId());
-	m.SetData(BFM_ACTION_VALUE, GeData(_value));
-	
-	// Send message
-	SendParentMessage(m);
-}
-
-
-
-Int32 RotaryKnobCustomGuiData::GetId()
-{
-	return ID_CUSTOMGUI_ROTARYKNOB;
-};
-
-CDialog* RotaryKnobCustomGuiData::Alloc(const BaseContainer &settings)
-{
-	RotaryKnobCustomGui *dlg = NewObj(RotaryKnobCustomGui, settings, GetPlugin());
-  if (!dlg) 
-		return nullptr;
-
-  return dlg->Get();
-};
-
-void RotaryKnobCustomGuiData::Free(CDialog *dlg, void *userdata)
-{
-	if (!dlg || !userdata) 
-		return;
-
-  RotaryKnobCustomGui *sub = static_cast<RotaryKnobCustomGui*>(userdata);
-  DeleteObj(sub);
-};
-
-// Return the resource symbol. This symbol can be used in resource files in combination with "CUSTOMGUI"
-const Char *RotaryKnobCustomGuiData::GetResourceSym()
-{
-	return SYM_ROTARYKNOB;
-};
-
-// Return the pointer to a data structure holding the CustomGUI's custom properties
-CustomProperty *RotaryKnobCustomGuiData::GetProperties()
-{
-	return g_RotaryKnobProps;
-};
-
-// Return the applicable datatypes defined in the stringtable array
-Int32 RotaryKnobCustomGuiData::GetResourceDataType(Int32 *&table)
-{
-	table = stringtable; 
-	return sizeof(stringtable) / sizeof(Int32);
-};
-
-
-// Register the CustomGUI
-Bool RegisterRotaryKnobCustomGui()
-{
-	// Declare, allocate and fill the CustomGUI library
-	static BaseCustomGuiLib rotaryKnobGUIlib;
-	ClearMem(&rotaryKnobGUIlib, sizeof(rotaryKnobGUIlib));
-	FillBaseCustomGui(rotaryKnobGUIlib);
-
-	// Install the CustomGUI library
-	if (!InstallLibrary(ID_CUSTOMGUI_ROTARYKNOB, &rotaryKnobGUIlib, 1000, sizeof(rotaryKnobGUIlib)))
-		return false;
-	
-	// Register the CustomGUI
-	if (!RegisterCustomGuiPlugin(GeLoadString(IDS_CUSTOMGUI_ROTARYKNOB), 0, NewObjClear(RotaryKnobCustomGuiData)))
-		return false;
-
-	return true;
-}
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <vector>
+#include "c4d.h"
+#include "main.h"
+#include "c4d_symbols.h"
+#include "customgui_rotaryknob.h"
+#include "knobcanvaspool.h"
+#include "input/knobcontrollerreplay.h"
+#include "input/knobdragrecording.h"
+#include "render/knobassetcache.h"
+#include "render/knobbufferpool.h"
+#include "render/knobstaticlayercache.h"
+
+
+/// Map a DESC_UNIT to the unit of the value label
+/// @param[in] descUnit The unit, e.g. DESC_UNIT_PERCENT
+/// @return The label unit
+static KnobLabelUnit GetKnobLabelUnit(Int32 descUnit)
+{
+	switch (descUnit)
+	{
+		case DESC_UNIT_PERCENT:
+			return KNOBLABEL_UNIT_PERCENT;
+		case DESC_UNIT_DEGREE:
+			return KNOBLABEL_UNIT_DEGREE;
+		case DESC_UNIT_METER:
+			return KNOBLABEL_UNIT_METER;
+		default:
+			return KNOBLABEL_UNIT_NONE;
+	}
+}
+
+
+/// Return the width and height of the knob area from the SIZE property
+/// @param[in] properties The properties
+/// @return The size in interface units, ROTARYKNOBAREA_WIDTH if it is not set
+static Int32 GetRotaryKnobSize(const DescElementProperties &properties)
+{
+	if (properties._size <= 0)
+		return ROTARYKNOBAREA_WIDTH;
+	
+	return ClampValue(properties._size, ROTARYKNOBAREA_MINWIDTH, ROTARYKNOBAREA_MAXWIDTH);
+}
+
+
+/// Change counters of all knobs together
+static KnobChangeCounters g_knobChangeCounters;
+
+/// Knobs whose frames wait to be rendered together. When a preset is loaded, the parent calls SetData() on all
+/// knobs before any of them gets to draw, so the first DrawMsg() finds all of them here. Only used on the main thread.
+static std::vector<RotaryKnobArea*> g_queuedKnobs;
+
+/// Renders the queued frames on all cores. Created for the first batch, the threads run until the plugin ends.
+static std::unique_ptr<KnobBatchRenderer> g_knobBatchRenderer;
+
+/// Items for the batch renderer, kept so a batch doesn't have to allocate them
+static std::vector<KnobBatchItem> g_knobBatchItems;
+
+/// Renders the frames of the knob that is dragged, on a thread of its own. Created for the first drag, runs until the plugin ends.
+static std::unique_ptr<KnobAsyncRenderer> g_knobAsyncRenderer;
+
+/// A channel that an external controller sends values to. One knob drains it.
+struct KnobControllerChannel
+{
+	KnobValueRing         ring;      ///< Values from the controller thread
+	RotaryKnobArea       *listener;  ///< The knob that takes the values, the only consumer of the ring
+	KnobControllerReplay  replay;    ///< Stands in for a hardware controller. Declared last, so it stops before the ring goes away.
+	
+	KnobControllerChannel() : listener(nullptr)
+	{}
+};
+
+/// Controller channels, created when a knob or a controller first uses them. Only used on the main thread.
+static std::unique_ptr<KnobControllerChannel> g_knobControllerChannels[ROTARYKNOBAREA_CONTROLLERCHANNELS];
+
+/// Return a controller channel
+/// @param[in] channel The channel, starting at 1
+/// @param[in] create True to create the channel if it doesn't exist yet
+/// @return The channel, or nullptr if the number is out of range, or the channel doesn't exist and could not be created
+static KnobControllerChannel *GetKnobControllerChannel(Int32 channel, Bool create)
+{
+	if (channel < 1 || channel > ROTARYKNOBAREA_CONTROLLERCHANNELS)
+		return nullptr;
+	
+	std::unique_ptr<KnobControllerChannel> &controller = g_knobControllerChannels[channel - 1];
+	if (!controller && create)
+		controller.reset(new (std::nothrow) KnobControllerChannel());
+	return controller.get();
+}
+
+/// Increase a change counter of a knob, and the same counter of the aggregate
+/// @param[in] counters The knob's counters
+/// @param[in] counter The counter to increase
+/// @param[in] amount How much to add
+static inline void IncreaseCounter(KnobChangeCounters &counters, Int64 KnobChangeCounters::*counter, Int64 amount = 1)
+{
+	counters.*counter += amount;
+	g_knobChangeCounters.*counter += amount;
+}
+
+
+#if ROTARYKNOB_INSTRUMENTATION
+
+/// Draw rate and stage times of all knobs together, including knobs that don't exist anymore
+static KnobInstrumentation g_knobInstrumentation;
+
+/// All existing knobs, for the per-knob report. Knobs are only created and destroyed on the main thread.
+static std::vector<RotaryKnobArea*> g_instrumentedKnobs;
+
+/// The last drag of any knob, to save it for replay. Only one knob can be dragged at a time.
+static KnobDragRecording g_lastKnobDrag;
+
+/// Writes report lines to the console, or to a text file
+class KnobReportWriter
+{
+public:
+	/// @param[in] file The file to write to, or nullptr for the console
+	explicit KnobReportWriter(BaseFile *file) : _file(file)
+	{}
+	
+	void WriteLine(const String &line)
+	{
+		if (!_file)
+		{
+			GePrint(line);
+			return;
+		}
+		
+		Char *text = line.GetCStringCopy(STRINGENCODING_UTF8);
+		if (!text)
+			return;
+		_file->WriteBytes(text, strlen(text));
+		_file->WriteBytes("\n", 1);
+		DeleteMem(text);
+	}
+	
+private:
+	BaseFile *_file;
+};
+
+/// Format a time in milliseconds
+static inline String FormatMilliseconds(Float time)
+{
+	return String::FloatToString(time, -1, 3) + " ms";
+}
+
+/// Write the latencies of a drag session
+/// @param[in] writer Receives the lines
+/// @param[in] title First line of the block
+/// @param[in] report The latencies
+static void WriteLatencyReport(KnobReportWriter &writer, const String &title, const KnobLatencyReport &report)
+{
+	static const Char *stageNames[KNOBLATENCY_COUNT] = { "message", "Command", "SetData", "draw" };
+	
+	writer.WriteLine(title + ": " + String::IntToString(report.events) + " events, " + String::IntToString(report.superseded) + " never drawn");
+	for (Int32 stage = 0; stage < KNOBLATENCY_COUNT; ++stage)
+	{
+		const KnobLatencyStats &stats = report.stages[stage];
+		if (stats.count == 0)
+			continue;
+		writer.WriteLine("  event to " + String(stageNames[stage]) + ": p50 " + FormatMilliseconds(stats.p50) + ", p95 " + FormatMilliseconds(stats.p95) + ", p99 " + FormatMilliseconds(stats.p99) + ", max " + FormatMilliseconds(stats.max) + " (" + String::IntToString(stats.count) + " events)");
+	}
+}
+
+#endif
+
+
+RotaryKnobArea::RotaryKnobArea() : _tristate(false), _value(0.0), _staticLayerValid(false), _pixelScale(1.0), _batchFrame(nullptr), _batchQueued(false), _shown(false), _asyncDrawing(false), _asyncSequence(0), _controllerChannel(0), _controllerMoving(false)
+{
+	// Get the shared cache with values needed for drawing. The canvas is only allocated when the knob is drawn.
+	_renderer.SetAntialiasing(ROTARYKNOBAREA_ANTIALIASING);
+	AcquireDrawValues();
+	
+	KNOB_INSTRUMENT(g_instrumentedKnobs.push_back(this));
+}
+
+RotaryKnobArea::~RotaryKnobArea()
+{
+	// Let another knob take over the controller channel
+	KnobControllerChannel *controller = GetKnobControllerChannel(_controllerChannel, false);
+	if (controller && controller->listener == this)
+		controller->listener = nullptr;
+	
+	ReleaseBatchFrame();
+	KNOB_INSTRUMENT(g_instrumentedKnobs.erase(std::remove(g_instrumentedKnobs.begin(), g_instrumentedKnobs.end(), this), g_instrumentedKnobs.end()));
+}
+
+Bool RotaryKnobArea::Init()
+{
+	return true;
+}
+
+Bool RotaryKnobArea::InitValues()
+{
+	return true;
+}
+
+Bool RotaryKnobArea::GetMinSize(Int32 &w, Int32 &h)
+{
+	w = h = GetKnobSize();
+	
+	return true;
+}
+
+void RotaryKnobArea::DrawMsg(Int32 x1, Int32 y1, Int32 x2, Int32 y2, const BaseContainer &msg)
+{
+	// Draw with as many pixels as the knob area has on screen
+	UpdatePixelScale();
+	if (!_drawValues)
+		return;
+	
+	KNOB_INSTRUMENT_TIMER(drawTimer, _instrumentation, g_knobInstrumentation, KNOBSTAGE_DRAW);
+	
+	// Select whole user area as clipping area
+	this->OffScreenOn();
+	
+	// Many knobs have changed at once. The first one to draw renders the frames of all of them on all cores,
+	// the others only have to show theirs.
+	if (_batchQueued && (Int32)g_queuedKnobs.size() >= KNOBBATCH_MINITEMS)
+	{
+		KNOB_INSTRUMENT_TIMER(batchTimer, _instrumentation, g_knobInstrumentation, KNOBSTAGE_BATCH);
+		RenderQueuedFrames();
+	}
+	
+	// Get marker position and value string
+	KnobVisualState state;
+	GetVisualState(state);
+	KNOB_INSTRUMENT(Float drawnValue = _value);
+	
+	// During a drag, the render thread draws the frames. Show the most recent one, even if the value has moved on since.
+	const KnobAsyncFrame *asyncFrame = _asyncDrawing ? GetAsyncFrame() : nullptr;
+	if (asyncFrame)
+	{
+		state = asyncFrame->state;
+		KNOB_INSTRUMENT(drawnValue = asyncFrame->value);
+	}
+	
+	// A frame that looks like the last one means someone asked for a redraw that wasn't needed
+	KNOB_INSTRUMENT(const Bool redundant = state == _drawnState);
+	
+	if (asyncFrame || (_batchFrame && state == _batchState))
+	{
+		// The frame is ready, it only has to go into the canvas
+		KNOB_INSTRUMENT_TIMER(frameTimer, _instrumentation, g_knobInstrumentation, KNOBSTAGE_FRAME);
+		if (!DrawFrameBuffer(asyncFrame ? asyncFrame->pixels : *_batchFrame))
+			return;
+	}
+	else
+	{
+		// Background, scale and knob don't change with the value, so they're only drawn once.
+		// With anti-aliasing, all knobs of the same size share the layer from the cache.
+		if (!_staticLayerValid)
+		{
+			KNOB_INSTRUMENT_TIMER(staticLayerTimer, _instrumentation, g_knobInstrumentation, KNOBSTAGE_STATICLAYER);
+			if (_drawValues->antialiasing)
+			{
+				const std::shared_ptr<const KnobPixelBuffer> layer = GetSharedKnobStaticLayerCache().Acquire(*_drawValues);
+				if (!layer)
+					return;
+				_renderer.SetStaticLayer(layer);
+			}
+			else if (!DrawKnobStaticLayer(_renderer, *_drawValues))
+				return;
+			_staticLayerValid = true;
+		}
+		
+		// Put marker and value on top of the static layer, cancel if anything goes wrong
+		KNOB_INSTRUMENT_TIMER(frameTimer, _instrumentation, g_knobInstrumentation, KNOBSTAGE_FRAME);
+		const Float angle = KnobValueToAngle(_value, _properties._descMin, _properties._descMax, *_drawValues);
+		if (_markerAtlas)
+		{
+			if (!DrawKnobAtlasFrame(_renderer, *_drawValues, *_markerAtlas, angle, state.label, _labelGlyphs.get()))
+				return;
+		}
+		else
+		{
+			if (!DrawKnobLayeredFrame(_renderer, *_drawValues, angle, state.label, _labelGlyphs.get()))
+				return;
+		}
+	}
+	_drawnState = state;
+	_shown = true;
+	
+	// Drawn now, one way or the other
+	ReleaseBatchFrame();
+	
+	// Draw ClipMap to user area. Without oversampling, this is a plain copy, at any size.
+	{
+		KNOB_INSTRUMENT_TIMER(blitTimer, _instrumentation, g_knobInstrumentation, KNOBSTAGE_BLIT);
+		const Int32 pixelSize = GetPixelSize();
+		this->DrawBitmap(_renderer.GetCanvas()->GetBitmap(), 0, 0, pixelSize, pixelSize, 0, 0, _drawValues->areaWidth, _drawValues->areaWidth, _tristate ? BMP_EMBOSSED : BMP_NORMAL);
+	}
+	
+	KNOB_INSTRUMENT(const Float now = GeGetMilliSeconds());
+	KNOB_INSTRUMENT(_instrumentation.AddDraw(now, redundant));
+	KNOB_INSTRUMENT(g_knobInstrumentation.AddDraw(now, redundant));
+	KNOB_INSTRUMENT(_latency.MarkValue(KNOBLATENCY_DRAW, drawnValue, now));
+	
+	// The frame is on screen now, the next knob can draw into the same canvas
+	_renderer.ReleaseFrame();
+}
+
+Bool RotaryKnobArea::InputEvent(const BaseContainer &msg)
+{
+	const Int32 device  = msg.GetInt32(BFM_INPUT_DEVICE);
+	const Int32 channel = msg.GetInt32(BFM_INPUT_CHANNEL);
+	
+	if (device == BFM_INPUT_MOUSE && channel == BFM_INPUT_MOUSELEFT)
+	{
+		// Catch double click first
+		if (msg.GetBool(BFM_INPUT_DOUBLECLICK))
+		{
+			GePrint("Doubleclick!");
+			
+			// Notify parent GUI
+			// Build message container with ID and value
+			BaseContainer m(BFM_ACTION);
+			m.SetInt32(BFM_ACTION_ID, GetId());
+			m.SetData(BFM_ACTION_VALUE, GeData(_value));
+			m.SetInt32(MSG_KNOBAREAMESSAGE, MSG_KNOBAREAMESSAGE_SHOWPOPUP);
+			SendParentMessage(m);
+
+			return true;
+		}
+		
+		// Container we need later for the query calls
+		BaseContainer channels;
+		BaseContainer state;
+		
+		// Values required for calculating the deltas
+		Int32 startX = msg.GetInt32(BFM_INPUT_X);  // Start X coordinate
+		Int32 startY = msg.GetInt32(BFM_INPUT_Y);  // Start Y coordinate
+		Float deltaX = 0.0;  // Current X delta (only needed to determine if mouse has moved during the drag)
+		Float deltaY = 0.0;  // Current Y delta (no needed at all, but MouseDragStart() wants a Y delta, too)
+		Int32 qualifier = 0;  // Qualifier keys of the last event
+		
+		Global2Local(&startX, &startY);  // Transform start coordinates to user area's local space
+		
+		// The drag math itself doesn't depend on Cinema 4D, so it can be benchmarked and replayed headlessly
+		KnobDragSettings dragSettings;
+		dragSettings.minValue = _properties._descMin;
+		dragSettings.maxValue = _properties._descMax;
+		dragSettings.circular = _properties._circularMouse;
+		dragSettings.centerX = dragSettings.centerY = (Float)GetPixelSize() / 2.0;
+		dragSettings.scaleLimit = ROTARYKNOBAREA_SCALELIMIT;
+		dragSettings.turns = _properties._turns;
+		
+		// Mouse positions are in the knob area's pixels. The same hand movement should turn the knob as far on every display.
+		// The pixel scale is a whole factor, so a stretched knob area does not change the drag speed.
+		dragSettings.multiplier = ROTARYKNOBAREA_MULTIPLIER_NORMAL / _pixelScale;
+		dragSettings.preciseMultiplier = ROTARYKNOBAREA_MULTIPLIER_PRECISE / _pixelScale;
+		dragSettings.gridSize = ROTARYKNOBAREA_VALUEGRIDSIZE;
+		_dragSession.SetSettings(dragSettings);
+		KNOB_INSTRUMENT(_dragSession.SetRecording(&g_lastKnobDrag));
+		
+		// Start mouse drag
+		MouseDragStart(BFM_INPUT_MOUSELEFT, startX, startY, MOUSEDRAGFLAGS_DONTHIDEMOUSE);
+		StartAsyncDrawing();
+		_dragSession.Start(GeGetMilliSeconds(), startX, startY, _value);
+		_framePacer.Start(GeGetMilliSeconds());
+		KNOB_INSTRUMENT(_latency.StartSession());
+		
+		// Check if mouse drag is still continueing
+		while (MouseDrag(&deltaX, &deltaY, &channels) == MOUSEDRAGRESULT_CONTINUE)
+		{
+			// Only collect the movement until the next display frame. Computing and sending values
+			// for every event would just keep a core busy with values nobody gets to see.
+			_framePacer.AddMovement(deltaX, deltaY);
+			qualifier = channels.GetInt32(BFM_INPUT_QUALIFIER);
+			
+			// Show the frame the render thread has finished last
+			if (_asyncDrawing && g_knobAsyncRenderer->HasNewFrame())
+				Redraw();
+			
+			const Float now = GeGetMilliSeconds();
+			if (!_framePacer.IsFrameDue(now))
+			{
+				// Wait for the next frame instead of spinning
+				const Int32 wait = (Int32)_framePacer.GetWaitTime(now);
+				if (wait > 0)
+					GeSleep(wait);
+				continue;
+			}
+			
+			// Get state of left mouse button
+			if (!GetInputState(BFM_INPUT_MOUSE, BFM_INPUT_MOUSELEFT, state))
+				break;
+			
+			// Cancel if mouse button not pressed
+			if (state.GetInt32(BFM_INPUT_VALUE) == 0)
+				break;
+			
+			ProcessDragInput(state, qualifier);
+			_framePacer.FrameDone(now);
+		}
+		// Mouse drag is over now
+		MouseDragEnd();
+		
+		// Movement since the last frame would be lost otherwise
+		if (_framePacer.HasMovement() && GetInputState(BFM_INPUT_MOUSE, BFM_INPUT_MOUSELEFT, state))
+			ProcessDragInput(state, qualifier);
+		_framePacer.Finish(GeGetMilliSeconds());
+		
+		// Always commit the exact final value, even if the last change was held back
+		Float finalValue = _value;
+		if (_dragSession.Finish(finalValue))
+		{
+			_value = finalValue;
+			SendValueMessage(false);
+		}
+		
+		// The final value is drawn right away, it can't be left to a frame that may not be finished yet
+		_asyncDrawing = false;
+		RedrawIfChanged();
+		
+#if ROTARYKNOB_INSTRUMENTATION
+		// Show where the time went. The last value may still be on its way to the screen,
+		// it is included when the statistics are printed or saved.
+		KnobReportWriter writer(nullptr);
+		WriteLatencyReport(writer, "RotaryKnob \"" + GetName() + "\" drag latency", _latency.GetReport());
+		
+		const KnobDragLoopStats &loopStats = _framePacer.GetStats();
+		writer.WriteLine("  drag loop: " + String::IntToString(loopStats.events) + " events, " + String::IntToString(loopStats.frames) + " frames, " + FormatMilliseconds(loopStats.GetCpuPerSecond()) + " CPU per second");
+#endif
+		
+		return true;
+	}
+	
+	return false;
+}
+
+void RotaryKnobArea::ProcessDragInput(const BaseContainer &state, Int32 qualifier)
+{
+	KNOB_INSTRUMENT_TIMER(inputTimer, _instrumentation, g_knobInstrumentation, KNOBSTAGE_INPUT);
+	const Float eventTime = GeGetMilliSeconds();
+	
+	// Get local mouse coordinates. In linear mode, the value follows the distance to the ORIGINAL
+	// (not the previous) mouse position, so the delta from MouseDrag() can't be used.
+	Int32 mouseX = state.GetInt32(BFM_INPUT_X);
+	Int32 mouseY = state.GetInt32(BFM_INPUT_Y);
+	Global2Local(&mouseX, &mouseY);
+	
+	// SHIFT makes the knob rotate slower, CTRL snaps the value to a grid
+	const Int32 flags = ((qualifier & QSHIFT) ? KNOBDRAG_PRECISE : 0) | ((qualifier & QCTRL) ? KNOBDRAG_SNAP : 0);
+	const KnobDragStep step = _dragSession.Update(KnobDragEvent(eventTime, mouseX, mouseY, flags));
+	_value = step.value;
+	
+	// Nothing to do if the value didn't change, e.g. when dragging beyond min or max
+	if (!step.changed)
+	{
+		IncreaseCounter(_counters, &KnobChangeCounters::messagesSkipped);
+		return;
+	}
+	
+	// Follow this value on its way to the screen
+	KNOB_INSTRUMENT(_latency.BeginEvent(eventTime, _value));
+	
+	// Notify parent GUI, but not more often than the session allows.
+	// Every message makes the parent update the parameter and possibly re-evaluate the scene.
+	if (step.publish)
+		SendValueMessage(true);  // Important: We're still dragging
+	
+	// Show the current value on the knob
+	RedrawIfChanged();
+}
+
+Int32 RotaryKnobArea::Message(const BaseContainer &msg, BaseContainer &result)
+{
+	// The interface colors have changed. The first knob to notice drops the cached draw values, all others just pick up the new ones.
+	switch (msg.GetId())
+	{
+		case BFM_COLORCHG:
+			UpdateGuiKnobTheme();
+			if (AcquireDrawValues())
+				Redraw();
+			break;
+		
+		// Knobs that are not on screen don't need bitmap memory
+		case BFM_VISIBLE_OFF:
+		case BFM_DESTROY:
+			ReleaseCanvases();
+			break;
+	}
+	
+	return SUPER::Message(msg, result);
+}
+
+void RotaryKnobArea::Timer(const BaseContainer &msg)
+{
+	KnobControllerChannel *controller = GetKnobControllerChannel(_controllerChannel, false);
+	if (!controller || controller->listener != this)
+		return;
+	
+	// Only the latest of the values that came in since the last frame is shown
+	KnobControllerValue latest;
+	const Int32 count = controller->ring.Drain(latest);
+	if (count == 0)
+	{
+		// The controller has stopped, commit its last value like the end of a drag
+		if (_controllerMoving)
+		{
+			_controllerMoving = false;
+			SendValueMessage(false);
+		}
+		return;
+	}
+	
+	IncreaseCounter(_counters, &KnobChangeCounters::controllerValues, count);
+	IncreaseCounter(_counters, &KnobChangeCounters::controllerFrames);
+	
+	Float value = latest.value;
+	if (_properties._descMax > _properties._descMin)
+		value = ClampValue(value, _properties._descMin, _properties._descMax);
+	if (value == _value)
+		return;
+	
+	_value = value;
+	_controllerMoving = true;
+	SendValueMessage(true);
+	RedrawIfChanged();
+}
+
+void RotaryKnobArea::SetProperties(const DescElementProperties &properties)
+{
+	_properties = properties;
+	_labelFormatter.SetFormat(_properties._descStep, GetKnobLabelUnit(_properties._descUnit));
+	
+	// The drag loop runs at the same rate as the value updates, there's no point in computing values more often
+	const Int32 dragRate = GetDragRate();
+	_dragSession.SetMaxRate(dragRate);
+	_framePacer.SetFrameRate(dragRate);
+	
+	// Size and scale are part of the shared draw values
+	if (_drawValues && (_drawValues->scaleTickCount != GetScaleTicks() || _drawValues->areaWidth != GetPixelSize() * ROTARYKNOBAREA_OVERSAMPLING))
+		AcquireDrawValues();
+	
+	// Get the shared marker atlas, it's built when the first knob asks for it
+	if (_properties._useMarkerAtlas && _drawValues)
+		_markerAtlas = AcquireKnobMarkerAtlas(*_drawValues, _properties._markerAtlasCells);
+	else
+		_markerAtlas.reset();
+	
+	ListenToController(_properties._controller);
+}
+
+void RotaryKnobArea::SetValue(Float newValue, Bool newTristate)
+{
+	_value = newValue;
+	_tristate = newTristate;
+}
+
+Float RotaryKnobArea::GetValue() const
+{
+	return _value;
+}
+
+const Char *RotaryKnobArea::GetLabel()
+{
+	return _labelFormatter.GetLabel(_value);
+}
+
+void RotaryKnobArea::RedrawIfChanged()
+{
+	IncreaseCounter(_counters, &KnobChangeCounters::redrawRequests);
+	
+	// During a drag, the frame that was last requested from the render thread counts, even if it's not on screen yet
+	KnobVisualState state;
+	GetVisualState(state);
+	if (state == (_asyncDrawing ? _requestedState : _drawnState))
+	{
+		IncreaseCounter(_counters, &KnobChangeCounters::redrawsSkipped);
+		return;
+	}
+	
+	if (_asyncDrawing)
+	{
+		RequestAsyncFrame(state);
+		return;
+	}
+	
+	QueueBatchFrame();
+	Redraw();
+}
+
+KnobChangeCounters &RotaryKnobArea::GetChangeCounters()
+{
+	return _counters;
+}
+
+const String &RotaryKnobArea::GetName() const
+{
+	return _properties._descName;
+}
+
+#if ROTARYKNOB_INSTRUMENTATION
+KnobInstrumentation &RotaryKnobArea::GetInstrumentation()
+{
+	return _instrumentation;
+}
+
+KnobLatencyTracker &RotaryKnobArea::GetLatencyTracker()
+{
+	return _latency;
+}
+#endif
+
+void RotaryKnobArea::GetVisualState(KnobVisualState &state)
+{
+	if (!_drawValues)
+		return;
+	
+	const Float angle = KnobValueToAngle(_value, _properties._descMin, _properties._descMax, *_drawValues);
+	
+	// With the atlas, only the cell index matters
+	if (_markerAtlas)
+		state.markerCell = _markerAtlas->GetCellIndex(angle);
+	else
+		GetKnobMarkerKey(*_drawValues, angle, state.markerPoints);
+	
+	strncpy(state.label, GetLabel(), sizeof(state.label) - 1);
+	state.label[sizeof(state.label) - 1] = 0;
+	state.tristate = _tristate;
+}
+
+Int32 RotaryKnobArea::GetScaleTicks() const
+{
+	if (_properties._scaleTicks > 0)
+		return std::min(_properties._scaleTicks, KNOBPAINTER_MAXSCALETICKS);
+	
+	return GetKnobScaleTicks(_properties._descMin, _properties._descMax, _properties._descStep);
+}
+
+Int32 RotaryKnobArea::GetDragRate() const
+{
+	// Negative rates make no sense, use the default
+	return _properties._dragRate >= 0 ? _properties._dragRate : ROTARYKNOBAREA_DRAGRATE;
+}
+
+Int32 RotaryKnobArea::GetKnobSize() const
+{
+	return GetRotaryKnobSize(_properties);
+}
+
+Int32 RotaryKnobArea::GetPixelSize() const
+{
+	return (Int32)(GetKnobSize() * _pixelScale + 0.5);
+}
+
+void RotaryKnobArea::UpdatePixelScale()
+{
+	// The SDK has no call for the display's backing scale factor, so this is a heuristic: 2 if the knob area got
+	// at least twice the size it asked for, 1 otherwise. The area also grows when a layout stretches it, so only
+	// whole factors are used. A knob stretched to less than twice its size, or on a display with a fractional
+	// scale (e.g. 150%), is drawn with a pixel scale of 1, and one stretched to twice its size like on HiDPI.
+	// This way, all knobs of a size share the same draw values, static layers and atlases.
+	const Int32 areaSize = Min(GetWidth(), GetHeight());
+	const Float pixelScale = areaSize >= GetKnobSize() * 2 ? 2.0 : 1.0;
+	if (pixelScale == _pixelScale)
+		return;
+	
+	_pixelScale = pixelScale;
+	AcquireDrawValues();
+}
+
+Bool RotaryKnobArea::AcquireDrawValues()
+{
+	std::shared_ptr<const KnobDrawValues> drawValues = AcquireGuiKnobDrawValues(GetKnobSize(), _pixelScale, ROTARYKNOBAREA_OVERSAMPLING, ROTARYKNOBAREA_MARGIN, ROTARYKNOBAREA_SCALELIMIT, ROTARYKNOBAREA_FONTSIZE, ROTARYKNOBAREA_ANTIALIASING, GetScaleTicks());
+	if (!drawValues || drawValues == _drawValues)
+		return false;
+	
+	_drawValues = drawValues;
+	
+	// The label is drawn from pre-rendered glyphs, so there's no text layout during drawing
+	_labelGlyphs = AcquireGuiGlyphAtlas(_drawValues->labelFontSize);
+	
+	// Everything drawn with the old draw values is outdated
+	_staticLayerValid = false;
+	_drawnState = KnobVisualState();
+	GetSharedKnobBufferPool().Release(_batchFrame);
+	_batchFrame = nullptr;
+	if (_properties._useMarkerAtlas)
+		_markerAtlas = AcquireKnobMarkerAtlas(*_drawValues, _properties._markerAtlasCells);
+	
+	return true;
+}
+
+void RotaryKnobArea::ReleaseCanvases()
+{
+	_renderer.ReleaseCanvases();
+	ReleaseBatchFrame();
+	_shown = false;
+	
+	// Nothing is cached anymore, the next DrawMsg() has to draw everything
+	_staticLayerValid = false;
+	_drawnState = KnobVisualState();
+}
+
+Bool RotaryKnobArea::CanDrawWithRasterizer() const
+{
+	// The rasterizer only draws the same frame as the GeClipMap renderer with anti-aliasing, and the label from the glyph atlas
+	return _drawValues && _drawValues->antialiasing && _labelGlyphs;
+}
+
+void RotaryKnobArea::QueueBatchFrame()
+{
+	// Hidden knobs won't draw, they would only hold on to their frames
+	if (_batchQueued || !_shown || !CanDrawWithRasterizer())
+		return;
+	
+	g_queuedKnobs.push_back(this);
+	_batchQueued = true;
+}
+
+void RotaryKnobArea::ReleaseBatchFrame()
+{
+	if (_batchQueued)
+	{
+		g_queuedKnobs.erase(std::remove(g_queuedKnobs.begin(), g_queuedKnobs.end(), this), g_queuedKnobs.end());
+		_batchQueued = false;
+	}
+	
+	GetSharedKnobBufferPool().Release(_batchFrame);
+	_batchFrame = nullptr;
+}
+
+Bool RotaryKnobArea::DrawFrameBuffer(const KnobPixelBuffer &frame)
+{
+	const Int32 width = frame.GetWidth();
+	const Int32 height = frame.GetHeight();
+	if (!_renderer.BeginDraw(width, height))
+		return false;
+	
+	_renderer.DrawBuffer(0, 0, frame, 0, 0, width, height);
+	_renderer.EndDraw();
+	return true;
+}
+
+void RotaryKnobArea::StartAsyncDrawing()
+{
+	_asyncDrawing = false;
+	_asyncSequence = 0;
+	_requestedState = _drawnState;
+	if (!CanDrawWithRasterizer())
+		return;
+	
+	// Only one knob can be dragged at a time, so they all share one render thread
+	if (!g_knobAsyncRenderer)
+	{
+		g_knobAsyncRenderer.reset(new (std::nothrow) KnobAsyncRenderer());
+		if (!g_knobAsyncRenderer)
+			return;
+	}
+	_asyncDrawing = true;
+}
+
+void RotaryKnobArea::RequestAsyncFrame(const KnobVisualState &state)
+{
+	KnobFrameRequest request;
+	request.owner = this;
+	request.value = _value;
+	request.angle = KnobValueToAngle(_value, _properties._descMin, _properties._descMax, *_drawValues);
+	request.state = state;
+	request.drawValues = _drawValues;
+	request.markerAtlas = _markerAtlas;
+	request.glyphs = _labelGlyphs;
+	
+	const UInt64 sequence = g_knobAsyncRenderer->Request(request);
+	if (_asyncSequence == 0)
+		_asyncSequence = sequence;
+	_requestedState = state;
+}
+
+const KnobAsyncFrame *RotaryKnobArea::GetAsyncFrame()
+{
+	// Frames of another knob or an earlier drag don't count
+	const KnobAsyncFrame *frame = g_knobAsyncRenderer->FetchFrame();
+	if (!frame || !frame->valid || frame->owner != this || _asyncSequence == 0 || frame->sequence < _asyncSequence)
+		return nullptr;
+	
+	return frame;
+}
+
+void RotaryKnobArea::RenderQueuedFrames()
+{
+	if (!g_knobBatchRenderer)
+	{
+		g_knobBatchRenderer.reset(new (std::nothrow) KnobBatchRenderer());
+		if (!g_knobBatchRenderer)
+			return;
+	}
+	
+	// The frames show what the knobs look like now, they may have changed again since they were queued
+	const Int32 count = (Int32)g_queuedKnobs.size();
+	g_knobBatchItems.resize(count);
+	for (Int32 i = 0; i < count; ++i)
+	{
+		RotaryKnobArea *knob = g_queuedKnobs[i];
+		knob->GetVisualState(knob->_batchState);
+		
+		KnobBatchItem &item = g_knobBatchItems[i];
+		item.drawValues = knob->_drawValues;
+		item.markerAtlas = knob->_markerAtlas.get();
+		item.glyphs = knob->_labelGlyphs.get();
+		item.angle = KnobValueToAngle(knob->_value, knob->_properties._descMin, knob->_properties._descMax, *knob->_drawValues);
+		strncpy(item.label, knob->_batchState.label, sizeof(item.label) - 1);
+		item.label[sizeof(item.label) - 1] = 0;
+		item.frame = knob->_batchFrame;
+	}
+	
+	g_knobBatchRenderer->Render(g_knobBatchItems.data(), count);
+	
+	// Hand the frames to the knobs, their DrawMsg() shows them
+	for (Int32 i = 0; i < count; ++i)
+	{
+		RotaryKnobArea *knob = g_queuedKnobs[i];
+		knob->_batchFrame = g_knobBatchItems[i].frame;
+		knob->_batchQueued = false;
+		g_knobBatchItems[i].drawValues.reset();
+	}
+	g_queuedKnobs.clear();
+}
+
+void RotaryKnobArea::ListenToController(Int32 channel)
+{
+	// The controller is checked at the same rate as the drag loop runs.
+	// The timer counts whole milliseconds, and an interval of 0 would turn it off. Without pacing, it runs every millisecond.
+	const Int32 frameRate = GetDragRate();
+	const Int32 interval = frameRate > 0 ? Max(1000 / frameRate, (Int32)1) : 1;
+	
+	if (channel == _controllerChannel)
+	{
+		if (channel > 0)
+			SetTimer(interval);
+		return;
+	}
+	
+	KnobControllerChannel *controller = GetKnobControllerChannel(_controllerChannel, false);
+	if (controller && controller->listener == this)
+		controller->listener = nullptr;
+	_controllerChannel = 0;
+	_controllerMoving = false;
+	SetTimer(0);
+	
+	controller = GetKnobControllerChannel(channel, true);
+	if (!controller)
+		return;
+	
+	// The ring has only one consumer
+	if (controller->listener)
+	{
+		GePrint("RotaryKnob \"" + GetName() + "\": controller channel " + String::IntToString(channel) + " is already used by \"" + controller->listener->GetName() + "\"");
+		return;
+	}
+	
+	controller->listener = this;
+	_controllerChannel = channel;
+	SetTimer(interval);
+}
+
+void RotaryKnobArea::SendValueMessage(Bool inDrag)
+{
+	IncreaseCounter(_counters, &KnobChangeCounters::valueMessages);
+	
+	// Build message container with ID and value
+	BaseContainer m(BFM_ACTION);
+	m.SetInt32(BFM_ACTION_ID, GetId());
+	m.SetData(BFM_ACTION_VALUE, GeData(_value));
+	m.SetBool(BFM_ACTION_INDRAG, inDrag);
+	
+	// The timestamp of the mouse event travels with the value
+	KNOB_INSTRUMENT(m.SetFloat(MSG_KNOBAREAMESSAGE_EVENTTIME, _latency.GetEventTime()));
+	KNOB_INSTRUMENT(_latency.Mark(KNOBLATENCY_MESSAGE, _latency.GetEventTime(), GeGetMilliSeconds()));
+	
+	SendParentMessage(m);
+}
+
+// Defining default values
+RotaryKnobCustomGui::RotaryKnobCustomGui(const BaseContainer &settings, CUSTOMGUIPLUGIN *plugin) : iCustomGui(settings, plugin), _tristate(false), _value(0.0)
+{
+	_descProperties = DescElementProperties(settings);
+}
+
+// Rebuild layout
+Bool RotaryKnobCustomGui::CreateLayout()
+{
+	const Int32 size = GetRotaryKnobSize(_descProperties);
+	GroupBegin(1000, BFH_SCALEFIT|BFV_FIT, 1, 2, String(), 0, size, size);
+	{
+		GroupSpace(0, 0);
+		
+		// Add element title
+		if (!_descProperties._hideName)
+			this->AddStaticText(0, BFH_CENTER, 0, 0, _descProperties._descName, 0);
+
+		// Create the knob user area
+		C4DGadget* userArea = this->AddUserArea(IDC_KNOBAREA, BFH_CENTER, size, size);
+		this->AttachUserArea(_knob, userArea);
+		
+		// Set data in user area
+		_knob.SetProperties(_descProperties);
+		_knob.SetValue(_value, _tristate);
+	}
+	GroupEnd();
+
+	return SUPER::CreateLayout();
+}
+
+// Set values to GUI elements, handle tristates
+Bool RotaryKnobCustomGui::InitValues()
+{
+	// Dummy TriState
+	TriState<Float> triState;
+	triState.Add(_value);
+	
+	// If GUI element is in a tristate state, just add some dummy value to the number field look tristate'y
+	if (_tristate)
+		triState.Add(123.456);
+	
+	// Set tristate to number field and knob area
+	_knob.SetValue(_value, _tristate);
+
+	return SUPER::InitValues();
+}
+
+// An element was used by the user
+Bool RotaryKnobCustomGui::Command(Int32 id, const BaseContainer &msg)
+{
+	switch (id)
+	{
+		case IDC_KNOBAREA:
+		{
+			// Catch our custom KnobArea messages first
+			if (msg.GetInt32(MSG_KNOBAREAMESSAGE) == MSG_KNOBAREAMESSAGE_SHOWPOPUP)
+			{
+				GePrint("Show value entry popup!");
+				return true;
+			}
+			
+			KNOB_INSTRUMENT(_knob.GetLatencyTracker().Mark(KNOBLATENCY_COMMAND, msg.GetFloat(MSG_KNOBAREAMESSAGE_EVENTTIME, -1.0), GeGetMilliSeconds()));
+			
+			// Get new value from knob user area
+			_value = _knob.GetValue();
+			
+			// Update GUI
+			this->InitValues();
+			
+			// Send message to parent object to update the parameter value.
+			// Pass on if we're still dragging, so the parent can treat the final value differently (e.g. for undo)
+			SendParentGuiMessage(msg.GetBool(BFM_ACTION_INDRAG));
+			
+			return true;
+		}
+	}
+
+	return SUPER::Command(id, msg);
+}
+
+Int32 RotaryKnobCustomGui::Message(const BaseContainer& msg, BaseContainer& result)
+{
+	// Cinema wants to get cursor information
+	if (msg.GetId() == BFM_GETCURSORINFO)
+	{
+		// Construct result message container
+		result.SetId(BFM_GETCURSORINFO);
+		result.SetInt32(RESULT_CURSOR, MOUSE_POINT_HAND);
+		result.SetString(RESULT_BUBBLEHELP, String(_knob.GetLabel()));
+	}
+	
+	return SUPER::Message(msg, result);
+}
+
+// The data is changed from the outside.
+Bool RotaryKnobCustomGui::SetData(const TriState<GeData> &tristate)
+{
+	const Float newValue    = tristate.GetValue().GetFloat();
+	const Bool  newTristate = tristate.GetTri();
+	
+	KNOB_INSTRUMENT_TIMER(setDataTimer, _knob.GetInstrumentation(), g_knobInstrumentation, KNOBSTAGE_SETDATA);
+	
+	// The parameter can't carry the timestamp, so the value is matched to the last mouse event
+	KNOB_INSTRUMENT(_knob.GetLatencyTracker().MarkValue(KNOBLATENCY_SETDATA, newValue, GeGetMilliSeconds()));
+	
+	// Nothing to do if nothing has changed. This happens a lot during mouse drag,
+	// when the parent sends back the value we've just sent to it.
+	IncreaseCounter(_knob.GetChangeCounters(), &KnobChangeCounters::setDataCalls);
+	if (newValue == _value && newTristate == _tristate)
+	{
+		IncreaseCounter(_knob.GetChangeCounters(), &KnobChangeCounters::setDataSkipped);
+		return true;
+	}
+	
+	// Store values internally
+	_value    = newValue;
+	_tristate = newTristate;
+
+	// Set values to GUI elements & trigger redraw
+	this->InitValues();
+	_knob.RedrawIfChanged();
+
+	return true;
+}
+
+// The data is requested from the outside.
+TriState<GeData> RotaryKnobCustomGui::GetData()
+{
+	// Construct a TriState from the value
+	TriState<GeData> tri;
+	tri.Add(_value);
+
+	return tri;
+}
+
+Int32 RotaryKnobCustomGui::CustomGuiWidth()
+{
+	return GetRotaryKnobSize(_descProperties);
+}
+
+Int32 RotaryKnobCustomGui::CustomGuiHeight()
+{
+	return GetRotaryKnobSize(_descProperties);
+}
+
+void RotaryKnobCustomGui::SendParentGuiMessage(Bool inDrag)
+{
+	// Build message container with ID and value
+	BaseContainer m(BFM_ACTION);
+	m.SetInt32(BFM_ACTION_ID, GetId());
+	m.SetData(BFM_ACTION_VALUE, GeData(_value));
+	m.SetBool(BFM_ACTION_INDRAG, inDrag);
+	
+	// Send message
+	SendParentMessage(m);
+}
+
+
+
+const KnobChangeCounters &GetKnobChangeCounters()
+{
+	return g_knobChangeCounters;
+}
+
+Bool StartKnobControllerReplay(const Filename &file, Int32 channel)
+{
+	KnobControllerChannel *controller = GetKnobControllerChannel(channel, true);
+	if (!controller)
+		return false;
+	
+	Char *path = file.GetString().GetCStringCopy(STRINGENCODING_UTF8);
+	if (!path)
+		return false;
+	KnobControllerRecording recording;
+	const Bool loaded = recording.Load(path);
+	DeleteMem(path);
+	if (!loaded)
+		return false;
+	
+	if (!controller->listener)
+		GePrint("RotaryKnob: no knob listens to controller channel " + String::IntToString(channel));
+	return controller->replay.Start(recording, controller->ring);
+}
+
+void StopKnobControllerReplays()
+{
+	for (Int32 channel = 1; channel <= ROTARYKNOBAREA_CONTROLLERCHANNELS; ++channel)
+	{
+		KnobControllerChannel *controller = GetKnobControllerChannel(channel, false);
+		if (!controller || !controller->replay.IsRunning())
+			continue;
+		
+		controller->replay.Stop();
+		const KnobControllerReplayStats stats = controller->replay.GetStats();
+		GePrint("RotaryKnob controller channel " + String::IntToString(channel) + ": " + String::IntToString(stats.pushed) + " values sent, " + String::IntToString(stats.superseded) + " replaced while the ring was full");
+	}
+}
+
+void FreeKnobControllerChannels()
+{
+	// Stops the replays, too
+	for (Int32 i = 0; i < ROTARYKNOBAREA_CONTROLLERCHANNELS; ++i)
+		g_knobControllerChannels[i].reset();
+}
+
+void FreeKnobRenderThreads()
+{
+	g_knobBatchItems.clear();
+	g_knobBatchRenderer.reset();
+	g_knobAsyncRenderer.reset();
+}
+
+/// Map the knob assets of the last session, so the first frames of knobs that look like the ones from then don't have to draw them
+static void OpenKnobAssetCache()
+{
+	const Filename file = GeGetC4DPath(C4D_PATH_PREFS) + Filename("rotaryknob_assets.bin");
+	Char *path = file.GetString().GetCStringCopy(STRINGENCODING_UTF8);
+	if (!path)
+		return;
+	GetSharedKnobAssetCache().Open(path, PLUGIN_VERSION, KNOBASSETCACHE_ASSETVERSION);
+	DeleteMem(path);
+}
+
+void SaveKnobAssetCache()
+{
+	// Static layers may still point into the mapped file, which can't be replaced while they are used
+	GetSharedKnobStaticLayerCache().Clear();
+	if (!GetSharedKnobAssetCache().Save())
+		GePrint("RotaryKnob: could not save the knob assets");
+}
+
+void PrintKnobChangeCounters()
+{
+	const KnobChangeCounters &counters = g_knobChangeCounters;
+	GePrint("RotaryKnob redraws: " + String::IntToString(counters.redrawRequests) + " requested, " + String::IntToString(counters.redrawsSkipped) + " skipped");
+	GePrint("RotaryKnob messages: " + String::IntToString(counters.valueMessages) + " sent, " + String::IntToString(counters.messagesSkipped) + " skipped");
+	GePrint("RotaryKnob SetData: " + String::IntToString(counters.setDataCalls) + " calls, " + String::IntToString(counters.setDataSkipped) + " skipped");
+	GePrint("RotaryKnob controllers: " + String::IntToString(counters.controllerValues) + " values in " + String::IntToString(counters.controllerFrames) + " frames");
+	
+	const KnobCanvasStats canvasStats = GetKnobCanvasStats();
+	GePrint("RotaryKnob canvases: " + String::IntToString(canvasStats.canvasCount) + " in use (" + String::IntToString(canvasStats.canvasBytes) + " bytes), " + String::IntToString(canvasStats.pooledCount) + " pooled (" + String::IntToString(canvasStats.pooledBytes) + " bytes), render buffers " + String::IntToString(canvasStats.bufferBytes) + " bytes, " + String::IntToString(canvasStats.GetResidentBytes()) + " bytes resident");
+	
+	const KnobBufferPoolStats bufferStats = GetSharedKnobBufferPool().GetStats();
+	GePrint("RotaryKnob allocations: " + String::IntToString(canvasStats.allocations) + " of " + String::IntToString(canvasStats.acquires) + " canvases, " + String::IntToString(bufferStats.allocations) + " of " + String::IntToString(bufferStats.acquires) + " frame buffers (" + String::IntToString(bufferStats.pooledBytes) + " bytes pooled)");
+	
+	const KnobStaticLayerCacheStats layerStats = GetSharedKnobStaticLayerCache().GetStats();
+	GePrint("RotaryKnob static layers: " + String::IntToString(layerStats.hits) + " hits, " + String::IntToString(layerStats.misses) + " misses, " + String::IntToString(layerStats.evictions) + " evicted, " + String::IntToString(layerStats.layerCount) + " cached (" + String::IntToString(layerStats.layerBytes) + " bytes)");
+	
+	const KnobAssetCacheStats assetStats = GetSharedKnobAssetCache().GetStats();
+	GePrint("RotaryKnob asset file: " + String::IntToString(assetStats.hits) + " hits, " + String::IntToString(assetStats.misses) + " misses, " + String::IntToString(assetStats.added) + " added, " + String::IntToString(assetStats.fileEntries) + " mapped (" + String::IntToString(assetStats.fileBytes) + " bytes), " + String::IntToString(assetStats.rejectedFiles) + " files and " + String::IntToString(assetStats.rejectedAssets) + " assets rejected");
+}
+
+#if ROTARYKNOB_INSTRUMENTATION
+
+/// Write draw rate, stage times and change counters of a knob or of all knobs
+/// @param[in] writer Receives the lines
+/// @param[in] title First line of the block
+/// @param[in] instrumentation Draw rate and stage times
+/// @param[in] counters Change counters
+static void WriteKnobReport(KnobReportWriter &writer, const String &title, const KnobInstrumentation &instrumentation, const KnobChangeCounters &counters)
+{
+	static const Char *stageNames[KNOBSTAGE_COUNT] = { "draw", "static layer", "frame", "blit", "input", "SetData", "batch" };
+	
+	writer.WriteLine(title + ": " + FormatMilliseconds(instrumentation.GetBusyTime()) + " busy");
+	writer.WriteLine("  draws: " + String::IntToString(instrumentation.draws) + " (" + String::FloatToString(instrumentation.GetDrawsPerSecond(), -1, 1) + "/s average, " + String::IntToString(instrumentation.peakDrawsPerSecond) + "/s peak), " + String::IntToString(instrumentation.redundantDraws) + " redundant");
+	
+	for (Int32 stage = 0; stage < KNOBSTAGE_COUNT; ++stage)
+	{
+		const KnobStageTime &time = instrumentation.stages[stage];
+		if (time.count == 0)
+			continue;
+		writer.WriteLine("  " + String(stageNames[stage]) + ": " + String::IntToString(time.count) + " times, " + FormatMilliseconds(time.GetAverage()) + " average, " + FormatMilliseconds(time.max) + " max, " + FormatMilliseconds(time.total) + " total");
+	}
+	
+	writer.WriteLine("  redraw requests: " + String::IntToString(counters.redrawRequests) + " (" + String::IntToString(counters.redrawsSkipped) + " skipped)");
+	writer.WriteLine("  BFM_ACTION sent: " + String::IntToString(counters.valueMessages) + " (" + String::IntToString(counters.messagesSkipped) + " drag events without change)");
+	writer.WriteLine("  SetData calls: " + String::IntToString(counters.setDataCalls) + " (" + String::IntToString(counters.setDataSkipped) + " skipped)");
+	if (counters.controllerValues > 0)
+		writer.WriteLine("  controller values: " + String::IntToString(counters.controllerValues) + " in " + String::IntToString(counters.controllerFrames) + " frames");
+}
+
+/// Sort knobs by the time they have kept the main thread busy, most first
+static bool CompareKnobBusyTime(RotaryKnobArea *a, RotaryKnobArea *b)
+{
+	return a->GetInstrumentation().GetBusyTime() > b->GetInstrumentation().GetBusyTime();
+}
+
+#endif
+
+Bool DumpKnobInstrumentation(const Filename *file)
+{
+#if ROTARYKNOB_INSTRUMENTATION
+	AutoAlloc<BaseFile> baseFile;
+	if (file)
+	{
+		if (!baseFile || !baseFile->Open(*file, FILEOPEN_WRITE, FILEDIALOG_NONE))
+			return false;
+	}
+	
+	KnobReportWriter writer(file ? (BaseFile*)baseFile : nullptr);
+	WriteKnobReport(writer, "RotaryKnob all knobs (" + String::IntToString(g_instrumentedKnobs.size()) + " open)", g_knobInstrumentation, g_knobChangeCounters);
+	
+	// The knobs that cost the most come first
+	std::vector<RotaryKnobArea*> knobs(g_instrumentedKnobs);
+	std::sort(knobs.begin(), knobs.end(), CompareKnobBusyTime);
+	for (size_t i = 0; i < knobs.size(); ++i)
+	{
+		const String title = "RotaryKnob \"" + knobs[i]->GetName() + "\"";
+		WriteKnobReport(writer, title, knobs[i]->GetInstrumentation(), knobs[i]->GetChangeCounters());
+		WriteLatencyReport(writer, title + " last drag latency", knobs[i]->GetLatencyTracker().GetReport());
+	}
+	
+	if (file)
+		baseFile->Close();
+	return true;
+#else
+	GePrint("RotaryKnob instrumentation is not compiled in, build with ROTARYKNOB_INSTRUMENTATION=1");
+	return false;
+#endif
+}
+
+Bool SaveLastKnobDrag(const Filename &file)
+{
+#if ROTARYKNOB_INSTRUMENTATION
+	if (!g_lastKnobDrag.IsFinished())
+	{
+		GePrint("RotaryKnob: no drag has been recorded yet");
+		return false;
+	}
+	
+	Char *path = file.GetString().GetCStringCopy(STRINGENCODING_UTF8);
+	if (!path)
+		return false;
+	const Bool result = g_lastKnobDrag.Save(path);
+	DeleteMem(path);
+	return result;
+#else
+	GePrint("RotaryKnob drag recording is not compiled in, build with ROTARYKNOB_INSTRUMENTATION=1");
+	return false;
+#endif
+}
+
+void ResetKnobInstrumentation()
+{
+	g_knobChangeCounters = KnobChangeCounters();
+	
+#if ROTARYKNOB_INSTRUMENTATION
+	g_knobInstrumentation = KnobInstrumentation();
+	for (size_t i = 0; i < g_instrumentedKnobs.size(); ++i)
+	{
+		g_instrumentedKnobs[i]->GetInstrumentation() = KnobInstrumentation();
+		g_instrumentedKnobs[i]->GetChangeCounters() = KnobChangeCounters();
+		g_instrumentedKnobs[i]->GetLatencyTracker().StartSession();
+	}
+#endif
+}
+
+
+
+Int32 RotaryKnobCustomGuiData::GetId()
+{
+	return ID_CUSTOMGUI_ROTARYKNOB;
+};
+
+CDialog* RotaryKnobCustomGuiData::Alloc(const BaseContainer &settings)
+{
+	RotaryKnobCustomGui *dlg = NewObj(RotaryKnobCustomGui, settings, GetPlugin());
+  if (!dlg) 
+		return nullptr;
+
+  return dlg->Get();
+};
+
+void RotaryKnobCustomGuiData::Free(CDialog *dlg, void *userdata)
+{
+	if (!dlg || !userdata) 
+		return;
+
+  RotaryKnobCustomGui *sub = static_cast<RotaryKnobCustomGui*>(userdata);
+  DeleteObj(sub);
+};
+
+// Return the resource symbol. This symbol can be used in resource files in combination with "CUSTOMGUI"
+const Char *RotaryKnobCustomGuiData::GetResourceSym()
+{
+	return SYM_ROTARYKNOB;
+};
+
+// Return the pointer to a data structure holding the CustomGUI's custom properties
+CustomProperty *RotaryKnobCustomGuiData::GetProperties()
+{
+	return g_RotaryKnobProps;
+};
+
+// Return the applicable datatypes defined in the stringtable array
+Int32 RotaryKnobCustomGuiData::GetResourceDataType(Int32 *&table)
+{
+	table = stringtable; 
+	return sizeof(stringtable) / sizeof(Int32);
+};
+
+
+// Register the CustomGUI
+Bool RegisterRotaryKnobCustomGui()
+{
+	// Declare, allocate and fill the CustomGUI library
+	static BaseCustomGuiLib rotaryKnobGUIlib;
+	ClearMem(&rotaryKnobGUIlib, sizeof(rotaryKnobGUIlib));
+	FillBaseCustomGui(rotaryKnobGUIlib);
+
+	// Install the CustomGUI library
+	if (!InstallLibrary(ID_CUSTOMGUI_ROTARYKNOB, &rotaryKnobGUIlib, 1000, sizeof(rotaryKnobGUIlib)))
+		return false;
+	
+	// Register the CustomGUI
+	if (!RegisterCustomGuiPlugin(GeLoadString(IDS_CUSTOMGUI_ROTARYKNOB), 0, NewObjClear(RotaryKnobCustomGuiData)))
+		return false;
+
+	// Without the file of the last session, the assets are drawn as before
+	OpenKnobAssetCache();
+
+	return true;
+}
@@ -3,6 +3,17 @@
 
 #include "c4d.h"
 #include "lib_clipmap.h"
+#include "render/knobpainter.h"
+#include "render/knobasyncrenderer.h"
+#include "render/knobbatchrenderer.h"
+#include "render/knobmarkeratlas.h"
+#include "input/knobdragsession.h"
+#include "input/knobframepacer.h"
+#include "input/knoblatencytracker.h"
+#include "input/knobvaluering.h"
+#include "render/knoblabel.h"
+#include "knobrenderer_clipmap.h"
+#include "knobinstrumentation.h"
 
 
 /// Plugin ID for Rotary Knob CustomGUI
@@ -14,12 +25,20 @@ static const Int32 IDC_KNOBAREA = 1001;  ///< The ID of the knob user area
 // IDs for GUI messages
 static const Int32 MSG_KNOBAREAMESSAGE = 1039007;      ///< Unique ID for messages from the KnobArea to the CustomGUI
 static const Int32 MSG_KNOBAREAMESSAGE_SHOWPOPUP = 1;  ///< Show value entry popup
+static const Int32 MSG_KNOBAREAMESSAGE_EVENTTIME = MSG_KNOBAREAMESSAGE + 1;  ///< Time of the mouse event that caused a BFM_ACTION message, for latency tracing
 
 /// ID values for Rotary Knob CustomProperties
 enum
 {
 	ROTARY_HIDE_NAME = 10001,        ///< Hide the parameter name above the knob
-	ROTARY_CIRCULARMOUSE = 10002     ///< Use circular instead of linear mouse movement
+	ROTARY_CIRCULARMOUSE = 10002,    ///< Use circular instead of linear mouse movement
+	ROTARY_MARKERATLAS = 10003,      ///< Draw the marker from a pre-rendered atlas shared by all knobs
+	ROTARY_ATLASCELLS = 10004,       ///< Number of marker angles in the atlas (0 = automatic)
+	ROTARY_DRAGRATE = 10005,         ///< Maximum rate of value updates to the parent during mouse drag, in Hz (default 60, 0 = every mouse event)
+	ROTARY_TURNS = 10006,            ///< Number of turns for the whole value range with CIRCULAR (0 = the scale covers the range)
+	ROTARY_TICKS = 10007,            ///< Number of intervals on the scale (0 = one per DESC_STEP, or fewer if there are too many)
+	ROTARY_CONTROLLER = 10008,       ///< Channel of an external controller that drives the value (0 = none)
+	ROTARY_SIZE = 10009              ///< Width and height of the knob area (0 = ROTARYKNOBAREA_WIDTH)
 };
 
 /// CustomProperties for Rotary Knob CustomGUI
@@ -27,6 +46,13 @@ CustomProperty g_RotaryKnobProps[] =
 {
 	{ CUSTOMTYPE_FLAG, ROTARY_HIDE_NAME, "HIDE_NAME" },
 	{ CUSTOMTYPE_FLAG, ROTARY_CIRCULARMOUSE, "CIRCULAR" },
+	{ CUSTOMTYPE_FLAG, ROTARY_MARKERATLAS, "MARKER_ATLAS" },
+	{ CUSTOMTYPE_LONG, ROTARY_ATLASCELLS, "ATLAS_CELLS" },
+	{ CUSTOMTYPE_LONG, ROTARY_DRAGRATE, "DRAG_RATE" },
+	{ CUSTOMTYPE_REAL, ROTARY_TURNS, "TURNS" },
+	{ CUSTOMTYPE_LONG, ROTARY_TICKS, "TICKS" },
+	{ CUSTOMTYPE_LONG, ROTARY_CONTROLLER, "CONTROLLER" },
+	{ CUSTOMTYPE_LONG, ROTARY_SIZE, "SIZE" },
 	{ CUSTOMTYPE_END, 0, "" }
 };
 
@@ -37,13 +63,18 @@ static Int32 stringtable[] = { DTYPE_REAL }; ///< This array defines the applica
 
 // Some internal constants
 static const Int32 ROTARYKNOBAREA_WIDTH = 100;       ///< Standard width of CustomGUI
-static const Int32 ROTARYKNOBAREA_MARGIN = 10;       ///< Size of margin between knob and border of user area
-static const Int32 ROTARYKNOBAREA_OVERSAMPLING = 2;  ///< Oversampling for the Knob area. The bigger the value, the better the quality (and the slower the drawing)
+static const Int32 ROTARYKNOBAREA_MINWIDTH = 32;     ///< Smallest width that can be set with SIZE
+static const Int32 ROTARYKNOBAREA_MAXWIDTH = 400;    ///< Largest width that can be set with SIZE
+static const Int32 ROTARYKNOBAREA_MARGIN = 5;        ///< Size of margin between knob and border of user area
+static const Int32 ROTARYKNOBAREA_OVERSAMPLING = 1;  ///< Oversampling for the Knob area. Not needed with anti-aliasing; without it, the bigger the value, the better the quality (and the slower the drawing)
+static const Bool  ROTARYKNOBAREA_ANTIALIASING = true; ///< Draw the knob with analytic anti-aliasing
 static const Float ROTARYKNOBAREA_MULTIPLIER_NORMAL = 0.01;   ///< Normal knob move speed
 static const Float ROTARYKNOBAREA_MULTIPLIER_PRECISE = 0.001; ///< Precise (slow) knob move speed
-static const Int32 ROTARYKNOBAREA_FONTSIZE = 28;        ///< Font size for the value display with VALUE_IN_KNOB
+static const Int32 ROTARYKNOBAREA_FONTSIZE = 14;        ///< Font size for the value display with VALUE_IN_KNOB
 static const Float ROTARYKNOBAREA_VALUEGRIDSIZE = 0.5;  ///< Grid size for value snapping during mouse drag
 static const Float ROTARYKNOBAREA_SCALELIMIT = 135.0;  ///< Where the usable range of the rotary knob starts and ends
+static const Int32 ROTARYKNOBAREA_DRAGRATE = 60;       ///< Default maximum rate of value updates to the parent during mouse drag, in Hz
+static const Int32 ROTARYKNOBAREA_CONTROLLERCHANNELS = 16;  ///< Number of channels for external controllers
 
 
 /// This struct holds some of the DESC_ properties required for the rotary knob user area
@@ -51,13 +82,21 @@ struct DescElementProperties
 {
 	Bool  _hideName;       ///< Don't draw the name on top of the knob
 	Bool  _circularMouse;  ///< Use circular instead of linear mouse movement
+	Bool  _useMarkerAtlas;    ///< Draw the marker from a shared pre-rendered atlas
+	Int32 _markerAtlasCells;  ///< Number of marker angles in the atlas (0 = automatic)
+	Int32 _dragRate;          ///< Maximum rate of value updates during mouse drag (0 = no limit)
+	Float _turns;             ///< Number of turns for the whole value range in circular mode (0 = the scale covers the range)
+	Int32 _scaleTicks;        ///< Number of intervals on the scale (0 = automatic)
+	Int32 _controller;        ///< Channel of the external controller (0 = none)
+	Int32 _size;              ///< Width and height of the knob area (0 = standard width)
 	Float _descMin;        ///< Min value
 	Float _descMax;        ///< Max value
 	Float _descStep;       ///< Step size
+	Int32 _descUnit;       ///< Unit (DESC_UNIT_*)
 	String _descName;      ///< Element name
 	
 	/// Default constructor
-	DescElementProperties() : _hideName(false), _circularMouse(false), _descMin(0.0), _descMax(0.0), _descStep(0.0)
+	DescElementProperties() : _hideName(false), _circularMouse(false), _useMarkerAtlas(false), _markerAtlasCells(0), _dragRate(ROTARYKNOBAREA_DRAGRATE), _turns(0.0), _scaleTicks(0), _controller(0), _size(0), _descMin(0.0), _descMax(0.0), _descStep(0.0), _descUnit(DESC_UNIT_FLOAT)
 	{}
 	
 	/// Construct from BaseContainer with DESC_ properties
@@ -65,54 +104,36 @@ struct DescElementProperties
 	{
 		_circularMouse = src.GetBool(ROTARY_CIRCULARMOUSE);
 		_hideName = src.GetBool(ROTARY_HIDE_NAME);
+		_useMarkerAtlas = src.GetBool(ROTARY_MARKERATLAS);
+		_markerAtlasCells = src.GetInt32(ROTARY_ATLASCELLS);
+		_dragRate = src.GetInt32(ROTARY_DRAGRATE, ROTARYKNOBAREA_DRAGRATE);
+		_turns = src.GetFloat(ROTARY_TURNS);
+		_scaleTicks = src.GetInt32(ROTARY_TICKS);
+		_controller = src.GetInt32(ROTARY_CONTROLLER);
+		_size = src.GetInt32(ROTARY_SIZE);
 		_descMin = src.GetFloat(DESC_MIN, 0.0);
 		_descMax = src.GetFloat(DESC_MAX, 0.0);
 		_descStep = src.GetFloat(DESC_STEP, 0.0);
+		_descUnit = src.GetInt32(DESC_UNIT, DESC_UNIT_FLOAT);
 		_descName = src.GetString(DESC_NAME);
 	}
 };
 
 
-/// This struct holds some values that will be used throughout the drawing
-/// functions, so those values don't have to be calculated unnecessarily often.
-struct KnobAreaDrawValues
+/// Counts value changes, and how many of them were skipped because they would not have changed anything
+struct KnobChangeCounters
 {
-	Int32 areaWidth;
-	Int32 areaHalfWidth;
-	Float areaRadius;
-	Vector areaColor;
+	Int64 redrawRequests;   ///< Redraws requested because of a value change
+	Int64 redrawsSkipped;   ///< Redraws skipped because marker and label would look the same
+	Int64 valueMessages;    ///< BFM_ACTION messages sent to the parent
+	Int64 messagesSkipped;  ///< Mouse drag events that did not change the clamped value
+	Int64 setDataCalls;     ///< Calls to SetData()
+	Int64 setDataSkipped;   ///< Calls to SetData() with the value and tristate the knob already had
+	Int64 controllerValues; ///< Values received from an external controller
+	Int64 controllerFrames; ///< Frames in which values from the controller were applied
 	
-	Float scaleRadius1;
-	Float scaleRadius2;
-	Float scaleLimitRadians;
-	Float scaleLimitRadiansNeg;
-	Vector scaleColor;
-	
-	Int32 knobOuterCorner1;
-	Int32 knobOuterCorner2;
-	Vector knobOuterColor;
-	
-	Int32 knobInnerCorner1;
-	Int32 knobInnerCorner2;
-	Vector knobInnerColor;
-	
-	Int32 knobCenterCorner1;
-	Int32 knobCenterCorner2;
-	Vector knobCenterColor;
-	
-	Float markerLength;
-	Float markerThickness;
-	Vector markerColor;
-	
-	Int32 labelPosY;
-	Vector labelColor;
-	BaseContainer labelFontDesc;
-	
-	
-	KnobAreaDrawValues() : areaWidth(0), areaHalfWidth(0), areaRadius(0.0), scaleRadius1(0.0), scaleRadius2(0.0), scaleLimitRadians(0.0), scaleLimitRadiansNeg(0.0), knobOuterCorner1(0), knobOuterCorner2(0), knobInnerCorner1(0), knobInnerCorner2(0), knobCenterCorner1(0), knobCenterCorner2(0), markerLength(0.0), markerThickness(0.0), labelPosY(0)
+	KnobChangeCounters() : redrawRequests(0), redrawsSkipped(0), valueMessages(0), messagesSkipped(0), setDataCalls(0), setDataSkipped(0), controllerValues(0), controllerFrames(0)
 	{}
-	
-	KnobAreaDrawValues(GeClipMap &clipMap);
 };
 
 
@@ -132,6 +153,8 @@ public:
 	
 	virtual void DrawMsg(Int32 x1, Int32 y1, Int32 x2, Int32 y2, const BaseContainer &msg);
 	virtual Bool InputEvent(const BaseContainer &msg);
+	virtual Int32 Message(const BaseContainer &msg, BaseContainer &result);
+	virtual void Timer(const BaseContainer &msg);
 	
 	/// Set properties
 	/// @param[in] properties Ref to a DescElementProperties object
@@ -145,43 +168,133 @@ public:
 	/// Return the current value
 	Float GetValue() const;
 	
+	/// Return the value label, formatted according to step size and unit
+	/// @return The label, valid until the next call
+	const Char *GetLabel();
+	
+	/// Trigger a redraw, but only if marker or label would look different than in the last drawn frame.
+	/// If many knobs change at once, their frames are rendered together on all cores by the first DrawMsg().
+	void RedrawIfChanged();
+	
+	/// Return the change counters of this knob
+	KnobChangeCounters &GetChangeCounters();
+	
+	/// Return the name of the description element, to tell the knobs apart in reports
+	const String &GetName() const;
+	
+#if ROTARYKNOB_INSTRUMENTATION
+	/// Return draw rate and stage times of this knob
+	KnobInstrumentation &GetInstrumentation();
+	
+	/// Return the latency tracker for the current or last drag session
+	KnobLatencyTracker &GetLatencyTracker();
+#endif
+	
 private:
-	/// Converts a color vector (0.0 ... 1.0) to separate RGB values (0 ... 255)
-	void ColorToRGB(const Vector &color, Int32 &r, Int32 &g, Int32 &b) const;
+	/// Determine what the knob would look like with the current value
+	/// @param[out] state Receives the visual state
+	void GetVisualState(KnobVisualState &state);
 	
-	/// Sets a color as draw color in the GeClipMap
-	/// param[in] col The color to set
-	void SetCanvasColor(const Vector &col);
+	/// Return the number of scale intervals from the TICKS property, or from the value range and step
+	Int32 GetScaleTicks() const;
 	
-	/// Draw the knob background
-	/// @note: Must be called between BeginDraw() and EndDraw()
-	void DrawBackground(const KnobAreaDrawValues &drawValues);
+	/// Return the frame rate of the drag loop and the controller timer from the DRAG_RATE property, 0 for no pacing
+	Int32 GetDragRate() const;
 	
-	/// Draw the knob
-	/// @note: Must be called between BeginDraw() and EndDraw()
-	void DrawKnob(const KnobAreaDrawValues &drawValues);
+	/// Return the width and height of the knob area in interface units, from the SIZE property
+	Int32 GetKnobSize() const;
 	
-	/// Draw the scale
-	/// @note: Must be called between BeginDraw() and EndDraw()
-	void DrawScale(const KnobAreaDrawValues &drawValues);
+	/// Return the width and height of the knob area in screen pixels
+	Int32 GetPixelSize() const;
 	
-	/// Draw the knob's marker
-	/// @note: Must be called between BeginDraw() and EndDraw()
-	void DrawMarker(const KnobAreaDrawValues &drawValues);
+	/// Compare the size the knob area actually has to the size it asked for, to find displays with twice
+	/// the pixels per interface unit, and get new draw values if the pixel scale has changed.
+	/// The pixel scale is always 1 or 2, see the implementation.
+	void UpdatePixelScale();
 	
-	/// Draw the value on the knob
-	/// @note: Must be called between BeginDraw() and EndDraw()
-	void DrawValue(KnobAreaDrawValues &drawValues);
+	/// Get the shared draw values for the current theme, and everything that depends on them
+	/// @return True if the draw values have changed
+	Bool AcquireDrawValues();
+	
+	/// Give the canvas memory back while the knob is not visible. It is acquired again in the next DrawMsg().
+	void ReleaseCanvases();
+	
+	/// Return true if frames drawn by the software rasterizer alone look exactly like the ones drawn by the renderer
+	Bool CanDrawWithRasterizer() const;
+	
+	/// Put the knob on the list of knobs whose frames are rendered together
+	void QueueBatchFrame();
+	
+	/// Take the knob off the list of queued knobs, and give its batch frame back
+	void ReleaseBatchFrame();
+	
+	/// Show a frame that has been rendered by another thread
+	/// @param[in] frame The frame
+	/// @return False if the frame could not be drawn
+	Bool DrawFrameBuffer(const KnobPixelBuffer &frame);
+	
+	/// Start handing the frames to the render thread for a drag, if the knob's frames can be drawn there
+	void StartAsyncDrawing();
+	
+	/// Ask the render thread for a frame
+	/// @param[in] state What the frame has to show
+	void RequestAsyncFrame(const KnobVisualState &state);
+	
+	/// Return the most recent frame the render thread has finished for this drag
+	/// @return The frame, or nullptr if there is none
+	const KnobAsyncFrame *GetAsyncFrame();
+	
+	/// Render the frames of all queued knobs in parallel
+	static void RenderQueuedFrames();
+	
+	/// Start taking values from an external controller channel, once per frame. Only one knob can listen to a channel.
+	/// @param[in] channel The channel, 0 to stop listening
+	void ListenToController(Int32 channel);
+	
+	/// Compute the value for the current mouse position during a drag, send it to the parent and redraw
+	/// @param[in] state Input state of the left mouse button, with the mouse position
+	/// @param[in] qualifier Qualifier keys
+	void ProcessDragInput(const BaseContainer &state, Int32 qualifier);
+	
+	/// Send a BFM_ACTION message with our ID and value to the parent GUI element
+	/// @param[in] inDrag True if the value is sent during a mouse drag, false for the final value
+	void SendValueMessage(Bool inDrag);
 	
 private:
 	Bool       _tristate;  ///< True, if the GUI element is in a tristate
 	Float      _value;     ///< The value
 	DescElementProperties  _properties;  ///< Custom properties as specified in the .res file
-	AutoAlloc<GeClipMap>   _canvas;      ///< GeClipMap for drawing the knob
-	KnobAreaDrawValues     _drawValues;  ///< Cache for values used during drawing
+	std::shared_ptr<const KnobDrawValues>   _drawValues;   ///< Shared cache for values used during drawing
+	ClipMapKnobRenderer    _renderer;     ///< Draws the knob. Holds the canvas and the static layer while the knob is visible.
+	Bool                   _staticLayerValid;  ///< False if the static layer has to be redrawn
+	Float                  _pixelScale;   ///< Screen pixels per interface unit of the knob area, 1 or 2
+	std::shared_ptr<const KnobMarkerAtlas>  _markerAtlas;  ///< Shared marker atlas, if enabled in the properties
+	KnobDragSession        _dragSession;  ///< Computes the values during mouse drag, and limits the rate of value updates
+	KnobFramePacer         _framePacer;   ///< Runs the drag loop once per frame, and measures its CPU time
+	KnobVisualState        _drawnState;   ///< What the last drawn frame looked like
+	KnobVisualState        _batchState;   ///< What the batch rendered frame looks like
+	KnobPixelBuffer       *_batchFrame;   ///< Frame rendered by the batch renderer, shown by the next DrawMsg()
+	Bool                   _batchQueued;  ///< True if the knob is waiting for the batch renderer
+	Bool                   _shown;        ///< True if the knob has been drawn since it was last hidden
+	Bool                   _asyncDrawing; ///< True during a drag, while the frames are rendered by the render thread
+	UInt64                 _asyncSequence;   ///< First frame request of the current drag
+	KnobVisualState        _requestedState;  ///< What the last frame requested from the render thread looks like
+	Int32                  _controllerChannel;  ///< Controller channel the knob listens to, 0 for none
+	Bool                   _controllerMoving;   ///< True while values come in from the controller, the last one still has to be committed
+	KnobChangeCounters     _counters;     ///< Counters for skipped redraws and messages
+	KnobLabelFormatter     _labelFormatter;  ///< Formats and caches the value label
+	std::shared_ptr<const KnobGlyphAtlas>   _labelGlyphs;  ///< Shared pre-rendered glyphs for the value label
+#if ROTARYKNOB_INSTRUMENTATION
+	KnobInstrumentation    _instrumentation;  ///< Draw rate and stage times
+	KnobLatencyTracker     _latency;          ///< Follows the mouse events of a drag to the screen
+#endif
 };
 
 
+/// Return the change counters of all knobs together
+const KnobChangeCounters &GetKnobChangeCounters();
+
+
 /// A custom GUI to display a REAL value as a rotary knob
 /// This class implements the actual CustomGUI, including layout, value getting/setting, et cetera.
 class RotaryKnobCustomGui : public iCustomGui
@@ -200,7 +313,8 @@ public:
 	virtual Int32 CustomGuiHeight();
 	
 	/// Simply send a BFM_ACTION message with our ID and value to the parent GUI element
-	void SendParentGuiMessage();
+	/// @param[in] inDrag True if the value is sent during a mouse drag
+	void SendParentGuiMessage(Bool inDrag = false);
 	
 private:
 	Float   _value;        ///< The current value
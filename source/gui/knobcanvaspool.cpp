@@ -0,0 +1,120 @@
+#include <mutex>
+#include <vector>
+#include "knobcanvaspool.h"
+
+
+static std::mutex g_knobCanvasLock;
+static std::vector<GeClipMap*> g_knobCanvasPool;  ///< Unused canvases
+static KnobCanvasStats g_knobCanvasStats;
+
+
+/// Return the bitmap memory of a 24 bit canvas
+static inline Int64 GetCanvasBytes(GeClipMap *canvas)
+{
+	return (Int64)canvas->GetBw() * (Int64)canvas->GetBh() * 3;
+}
+
+
+GeClipMap *AcquireKnobCanvas(Int32 width, Int32 height)
+{
+	GeClipMap *canvas = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(g_knobCanvasLock);
+		++g_knobCanvasStats.acquires;
+
+		// Prefer a canvas that already has the right size
+		for (size_t i = 0; i < g_knobCanvasPool.size(); ++i)
+		{
+			if (g_knobCanvasPool[i]->GetBw() == width && g_knobCanvasPool[i]->GetBh() == height)
+			{
+				canvas = g_knobCanvasPool[i];
+				g_knobCanvasPool.erase(g_knobCanvasPool.begin() + i);
+				break;
+			}
+		}
+		if (!canvas && !g_knobCanvasPool.empty())
+		{
+			canvas = g_knobCanvasPool.back();
+			g_knobCanvasPool.pop_back();
+		}
+
+		if (canvas)
+		{
+			--g_knobCanvasStats.pooledCount;
+			g_knobCanvasStats.pooledBytes -= GetCanvasBytes(canvas);
+		}
+	}
+
+	if (!canvas)
+	{
+		canvas = GeClipMap::Alloc();
+		if (!canvas)
+			return nullptr;
+	}
+
+	// Only reallocate the bitmap if the size doesn't fit. Reused canvases are not cleared, the renderer overwrites all pixels anyway.
+	Bool allocated = false;
+	if (!canvas->GetBitmap() || canvas->GetBw() != width || canvas->GetBh() != height)
+	{
+		if (canvas->Init(width, height, 24) != IMAGERESULT_OK)
+		{
+			GeClipMap::Free(canvas);
+			return nullptr;
+		}
+		allocated = true;
+	}
+
+	std::lock_guard<std::mutex> lock(g_knobCanvasLock);
+	if (allocated)
+		++g_knobCanvasStats.allocations;
+	++g_knobCanvasStats.canvasCount;
+	g_knobCanvasStats.canvasBytes += GetCanvasBytes(canvas);
+
+	return canvas;
+}
+
+void ReleaseKnobCanvas(GeClipMap *canvas)
+{
+	if (!canvas)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(g_knobCanvasLock);
+		--g_knobCanvasStats.canvasCount;
+		g_knobCanvasStats.canvasBytes -= GetCanvasBytes(canvas);
+
+		if ((Int32)g_knobCanvasPool.size() < KNOBCANVASPOOL_MAXPOOLED)
+		{
+			g_knobCanvasPool.push_back(canvas);
+			++g_knobCanvasStats.pooledCount;
+			g_knobCanvasStats.pooledBytes += GetCanvasBytes(canvas);
+			return;
+		}
+	}
+
+	GeClipMap::Free(canvas);
+}
+
+void AddKnobBufferBytes(Int64 delta)
+{
+	std::lock_guard<std::mutex> lock(g_knobCanvasLock);
+	g_knobCanvasStats.bufferBytes += delta;
+}
+
+KnobCanvasStats GetKnobCanvasStats()
+{
+	std::lock_guard<std::mutex> lock(g_knobCanvasLock);
+	return g_knobCanvasStats;
+}
+
+void FreeKnobCanvasPool()
+{
+	std::lock_guard<std::mutex> lock(g_knobCanvasLock);
+
+	for (size_t i = 0; i < g_knobCanvasPool.size(); ++i)
+		GeClipMap::Free(g_knobCanvasPool[i]);
+
+	g_knobCanvasPool.clear();
+	g_knobCanvasStats.pooledCount = 0;
+	g_knobCanvasStats.pooledBytes = 0;
+}
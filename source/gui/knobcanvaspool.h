@@ -0,0 +1,55 @@
+#ifndef KNOBCANVASPOOL_H__
+#define KNOBCANVASPOOL_H__
+
+#include "c4d.h"
+#include "lib_clipmap.h"
+
+
+static const Int32 KNOBCANVASPOOL_MAXPOOLED = 4;  ///< Maximum number of unused canvases kept for reuse, all others are freed
+
+
+/// Memory used by the knobs for drawing
+struct KnobCanvasStats
+{
+	Int32 canvasCount;   ///< Canvases currently held by knobs
+	Int64 canvasBytes;   ///< Bitmap memory of the canvases held by knobs
+	Int32 pooledCount;   ///< Canvases waiting in the pool
+	Int64 pooledBytes;   ///< Bitmap memory of the canvases in the pool
+	Int64 bufferBytes;   ///< Memory of the knobs' software render buffers
+	Int64 acquires;      ///< Number of canvases handed out
+	Int64 allocations;   ///< Number of canvases that had to be allocated or resized
+
+	KnobCanvasStats() : canvasCount(0), canvasBytes(0), pooledCount(0), pooledBytes(0), bufferBytes(0), acquires(0), allocations(0)
+	{}
+
+	/// Return the memory that is currently resident for drawing knobs, in bytes
+	Int64 GetResidentBytes() const
+	{
+		return canvasBytes + pooledBytes + bufferBytes;
+	}
+};
+
+
+/// Get a 24 bit GeClipMap of the given size from the process-wide pool, or allocate a new one.
+/// The contents are undefined.
+/// @param[in] width Width in pixels
+/// @param[in] height Height in pixels
+/// @return The canvas, or nullptr if it could not be allocated. Must be given back with ReleaseKnobCanvas().
+GeClipMap *AcquireKnobCanvas(Int32 width, Int32 height);
+
+/// Give a canvas back to the pool. If the pool is full, the canvas is freed.
+/// @param[in] canvas The canvas, may be nullptr
+void ReleaseKnobCanvas(GeClipMap *canvas);
+
+/// Report a change of the memory used by software render buffers, so it shows up in the stats
+/// @param[in] delta Number of bytes allocated (positive) or freed (negative)
+void AddKnobBufferBytes(Int64 delta);
+
+/// Return the memory used by the knobs for drawing
+KnobCanvasStats GetKnobCanvasStats();
+
+/// Free all canvases in the pool. Call when the plugin ends.
+void FreeKnobCanvasPool();
+
+
+#endif  // KNOBCANVASPOOL_H__
@@ -0,0 +1,151 @@
+#ifndef KNOBINSTRUMENTATION_H__
+#define KNOBINSTRUMENTATION_H__
+
+#include "c4d.h"
+
+
+/// Set to 1 to compile timers and counters into the hot paths of the knob, e.g. with a compiler define
+/// in a release build that's handed to a user with a slow panel. With 0, the instrumentation macros
+/// expand to nothing, and the knobs don't carry any of the data.
+#ifndef ROTARYKNOB_INSTRUMENTATION
+	#ifdef MAXON_TARGET_DEBUG
+		#define ROTARYKNOB_INSTRUMENTATION 1
+	#else
+		#define ROTARYKNOB_INSTRUMENTATION 0
+	#endif
+#endif
+
+
+/// Parts of the knob's work that are timed separately
+enum KnobStage
+{
+	KNOBSTAGE_DRAW = 0,     ///< All of DrawMsg()
+	KNOBSTAGE_STATICLAYER,  ///< Drawing background, scale and knob into the static layer
+	KNOBSTAGE_FRAME,        ///< Drawing marker and label on top of the static layer
+	KNOBSTAGE_BLIT,         ///< Copying the frame to the user area
+	KNOBSTAGE_INPUT,        ///< Handling one mouse event during a drag, including the messages it sends
+	KNOBSTAGE_SETDATA,      ///< Handling a SetData() call from the parent
+	KNOBSTAGE_BATCH,        ///< Rendering the frames of all knobs that changed together, on all threads
+	KNOBSTAGE_COUNT
+};
+
+
+/// Accumulated time of one stage
+struct KnobStageTime
+{
+	Int64 count;  ///< Number of times the stage ran
+	Float total;  ///< Total time in milliseconds
+	Float max;    ///< Longest run in milliseconds
+
+	KnobStageTime() : count(0), total(0.0), max(0.0)
+	{}
+
+	/// Add one run of the stage
+	/// @param[in] time Duration in milliseconds
+	void Add(Float time)
+	{
+		++count;
+		total += time;
+		if (time > max)
+			max = time;
+	}
+
+	/// Return the average duration in milliseconds
+	Float GetAverage() const
+	{
+		return count > 0 ? total / (Float)count : 0.0;
+	}
+};
+
+
+/// Draw rate and stage times of a knob, or of all knobs together
+struct KnobInstrumentation
+{
+	Int64 draws;               ///< Frames drawn by DrawMsg()
+	Int64 redundantDraws;      ///< Frames that looked exactly like the one drawn before
+	Float firstDrawTime;       ///< Time of the first draw in milliseconds, -1 if nothing was drawn yet
+	Float lastDrawTime;        ///< Time of the last draw in milliseconds
+	Float windowStart;         ///< Start of the current one second window, for the peak draw rate
+	Int64 windowDraws;         ///< Draws in the current one second window
+	Int64 peakDrawsPerSecond;  ///< Highest number of draws in any one second window
+	KnobStageTime stages[KNOBSTAGE_COUNT];  ///< Time spent in each stage
+
+	KnobInstrumentation() : draws(0), redundantDraws(0), firstDrawTime(-1.0), lastDrawTime(0.0), windowStart(0.0), windowDraws(0), peakDrawsPerSecond(0)
+	{}
+
+	/// Count a drawn frame
+	/// @param[in] time Current time in milliseconds
+	/// @param[in] redundant True if the frame looked exactly like the one before
+	void AddDraw(Float time, Bool redundant)
+	{
+		++draws;
+		if (redundant)
+			++redundantDraws;
+
+		if (firstDrawTime < 0.0)
+			firstDrawTime = windowStart = time;
+		lastDrawTime = time;
+
+		if (time - windowStart >= 1000.0)
+		{
+			windowStart = time;
+			windowDraws = 0;
+		}
+		++windowDraws;
+		if (windowDraws > peakDrawsPerSecond)
+			peakDrawsPerSecond = windowDraws;
+	}
+
+	/// Return the average number of draws per second between the first and the last draw
+	Float GetDrawsPerSecond() const
+	{
+		const Float duration = lastDrawTime - firstDrawTime;
+		return duration > 0.0 ? (Float)(draws - 1) * 1000.0 / duration : 0.0;
+	}
+
+	/// Return the total time spent in DrawMsg(), mouse input and SetData(), in milliseconds
+	Float GetBusyTime() const
+	{
+		return stages[KNOBSTAGE_DRAW].total + stages[KNOBSTAGE_INPUT].total + stages[KNOBSTAGE_SETDATA].total;
+	}
+};
+
+
+#if ROTARYKNOB_INSTRUMENTATION
+
+/// Measures the time until the end of the scope, and adds it to a knob and to the aggregate of all knobs
+class KnobScopedTimer
+{
+public:
+	KnobScopedTimer(KnobInstrumentation &knob, KnobInstrumentation &total, KnobStage stage) : _knob(knob), _total(total), _stage(stage), _start(GeGetMilliSeconds())
+	{}
+
+	~KnobScopedTimer()
+	{
+		const Float time = GeGetMilliSeconds() - _start;
+		_knob.stages[_stage].Add(time);
+		_total.stages[_stage].Add(time);
+	}
+
+private:
+	KnobInstrumentation &_knob;   ///< Instrumentation of the knob
+	KnobInstrumentation &_total;  ///< Instrumentation of all knobs together
+	KnobStage            _stage;  ///< The measured stage
+	Float                _start;  ///< Start time in milliseconds
+};
+
+/// Compile a statement only if instrumentation is enabled
+#define KNOB_INSTRUMENT(statement) statement
+
+/// Time the rest of the scope as a stage of a knob and of the aggregate
+#define KNOB_INSTRUMENT_TIMER(name, knob, total, stage) KnobScopedTimer name(knob, total, stage)
+
+#else
+
+#define KNOB_INSTRUMENT(statement)
+#define KNOB_INSTRUMENT_TIMER(name, knob, total, stage)
+
+#endif
+
+
+#endif  // KNOBINSTRUMENTATION_H__
@@ -0,0 +1,567 @@
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include "knobrenderer_clipmap.h"
+#include "knobcanvaspool.h"
+#include "render/knobassetcache.h"
+#include "render/knobbufferpool.h"
+#include "render/knobstaticlayercache.h"
+
+
+/// Converts a color vector (0.0 ... 1.0) to a KnobColor
+static inline KnobColor VectorToKnobColor(const Vector &color)
+{
+	return KnobColor::FromFloat(color.x, color.y, color.z);
+}
+
+
+ClipMapKnobRenderer::ClipMapKnobRenderer() : _canvas(nullptr), _staticLayer(nullptr), _current(nullptr), _fontValid(false), _shapes(nullptr), _antialiasing(false), _flushed(true), _bufferBytes(0)
+{}
+
+ClipMapKnobRenderer::~ClipMapKnobRenderer()
+{
+	ReleaseCanvases();
+}
+
+void ClipMapKnobRenderer::ReleaseFrame()
+{
+	ReleaseKnobCanvas(_canvas);
+	_canvas = nullptr;
+	_current = nullptr;
+
+	GetSharedKnobBufferPool().Release(_shapes);
+	_shapes = nullptr;
+	_rasterizer.SetTarget(nullptr);
+}
+
+void ClipMapKnobRenderer::ReleaseCanvases()
+{
+	ReleaseFrame();
+
+	ReleaseKnobCanvas(_staticLayer);
+	_staticLayer = nullptr;
+
+	_rasterizer.FreeStaticLayer();
+	UpdateBufferBytes();
+}
+
+void ClipMapKnobRenderer::UpdateBufferBytes()
+{
+	const Int64 bytes = (Int64)_rasterizer.GetMemorySize();
+	if (bytes != _bufferBytes)
+	{
+		AddKnobBufferBytes(bytes - _bufferBytes);
+		_bufferBytes = bytes;
+	}
+}
+
+void ClipMapKnobRenderer::SetAntialiasing(Bool enable)
+{
+	_antialiasing = enable;
+	_rasterizer.SetAntialiasing(enable);
+}
+
+void ClipMapKnobRenderer::SetStaticLayer(const std::shared_ptr<const KnobPixelBuffer> &layer)
+{
+	if (!_antialiasing)
+		return;
+
+	_rasterizer.SetStaticLayer(layer);
+	UpdateBufferBytes();
+}
+
+void ClipMapKnobRenderer::FlushShapes()
+{
+	if (_flushed)
+		return;
+	_flushed = true;
+
+	// Copy the rasterizer's frame into the canvas bitmap, one row at a time
+	BaseBitmap *bitmap = _canvas->GetBitmap();
+	if (bitmap)
+	{
+		const Int32 width = Min(_shapes->GetWidth(), (Int32)bitmap->GetBw());
+		const Int32 height = Min(_shapes->GetHeight(), (Int32)bitmap->GetBh());
+		for (Int32 y = 0; y < height; ++y)
+			bitmap->SetPixelCnt(0, y, width, (UChar*)_shapes->GetRow(y), sizeof(KnobColor), COLORMODE_RGB, PIXELCNT_0);
+	}
+
+	_canvas->BeginDraw();
+}
+
+Bool ClipMapKnobRenderer::InitClipMap(GeClipMap *&clipMap, Int32 width, Int32 height)
+{
+	// Canvases are only taken from the pool when something is drawn
+	if (!clipMap)
+	{
+		clipMap = AcquireKnobCanvas(width, height);
+		return clipMap != nullptr;
+	}
+
+	// Only reallocate the bitmap if the size has changed
+	if (clipMap->GetBitmap() && clipMap->GetBw() == width && clipMap->GetBh() == height)
+		return true;
+
+	return clipMap->Init(width, height, 24) == IMAGERESULT_OK;
+}
+
+bool ClipMapKnobRenderer::BeginDraw(int32_t width, int32_t height)
+{
+	// Cancel if anything goes wrong
+	if (!InitClipMap(_canvas, width, height))
+		return false;
+
+	_current = _canvas;
+
+	// Shapes go to the rasterizer first, the canvas is only drawn into after FlushShapes()
+	if (_antialiasing)
+	{
+		if (!_shapes)
+		{
+			_shapes = GetSharedKnobBufferPool().Acquire(width, height);
+			if (!_shapes)
+				return false;
+			_rasterizer.SetTarget(_shapes);
+		}
+
+		_flushed = false;
+		return _rasterizer.BeginDraw(width, height);
+	}
+
+	_current->BeginDraw();
+	return true;
+}
+
+void ClipMapKnobRenderer::EndDraw()
+{
+	// Make sure the shapes end up in the canvas, even if no text was drawn
+	if (_antialiasing)
+		FlushShapes();
+
+	_current->EndDraw();
+	UpdateBufferBytes();
+}
+
+bool ClipMapKnobRenderer::BeginStaticLayer(int32_t width, int32_t height)
+{
+	// The static layer has no text, so it can stay in the rasterizer completely
+	if (_antialiasing)
+	{
+		_flushed = false;
+		return _rasterizer.BeginStaticLayer(width, height);
+	}
+
+	if (!InitClipMap(_staticLayer, width, height))
+		return false;
+
+	_current = _staticLayer;
+	_current->BeginDraw();
+	return true;
+}
+
+void ClipMapKnobRenderer::EndStaticLayer()
+{
+	if (_antialiasing)
+	{
+		_rasterizer.EndStaticLayer();
+		_flushed = true;
+		UpdateBufferBytes();
+		return;
+	}
+
+	_current->EndDraw();
+	_current = _canvas;
+}
+
+void ClipMapKnobRenderer::DrawStaticLayer()
+{
+	if (_antialiasing && !_flushed)
+	{
+		_rasterizer.DrawStaticLayer();
+		return;
+	}
+
+	if (!_staticLayer)
+		return;
+
+	_canvas->Blit(0, 0, *_staticLayer, 0, 0, _staticLayer->GetBw() - 1, _staticLayer->GetBh() - 1, GE_CM_BLIT_COPY);
+}
+
+void ClipMapKnobRenderer::DrawBuffer(int32_t x, int32_t y, const KnobPixelBuffer &source, int32_t sx, int32_t sy, int32_t width, int32_t height)
+{
+	if (_antialiasing && !_flushed)
+	{
+		_rasterizer.DrawBuffer(x, y, source, sx, sy, width, height);
+		return;
+	}
+
+	// GeClipMap::SetPixelRGBA() does its own clipping against the canvas, only the source needs to be checked
+	if (sx < 0 || sy < 0 || sx + width > source.GetWidth() || sy + height > source.GetHeight())
+		return;
+
+	for (Int32 row = 0; row < height; ++row)
+	{
+		const KnobColor *sourceRow = source.GetRow(sy + row) + sx;
+		for (Int32 column = 0; column < width; ++column)
+			_current->SetPixelRGBA(x + column, y + row, sourceRow[column].r, sourceRow[column].g, sourceRow[column].b, sourceRow[column].a);
+	}
+}
+
+void ClipMapKnobRenderer::SetColor(const KnobColor &col)
+{
+	_color = col;
+	if (_antialiasing)
+		_rasterizer.SetColor(col);
+
+	if (_current)
+		_current->SetColor(col.r, col.g, col.b, col.a);
+}
+
+void ClipMapKnobRenderer::FillRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (_antialiasing && !_flushed)
+	{
+		_rasterizer.FillRect(x1, y1, x2, y2);
+		return;
+	}
+
+	_current->FillRect(x1, y1, x2, y2);
+}
+
+void ClipMapKnobRenderer::FillEllipse(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (_antialiasing && !_flushed)
+	{
+		_rasterizer.FillEllipse(x1, y1, x2, y2);
+		return;
+	}
+
+	_current->FillEllipse(x1, y1, x2, y2);
+}
+
+void ClipMapKnobRenderer::FillPolygon(int32_t count, const KnobPointF *points)
+{
+	if (count < 3 || !points)
+		return;
+
+	if (_antialiasing && !_flushed)
+	{
+		_rasterizer.FillPolygon(count, points);
+		return;
+	}
+
+	// GeClipMap only knows whole pixels
+	GE_POINT2D clipMapPoints[8];
+	if (count > 8)
+		count = 8;
+
+	for (Int32 i = 0; i < count; ++i)
+	{
+		clipMapPoints[i].x = (Int32)points[i].x;
+		clipMapPoints[i].y = (Int32)points[i].y;
+	}
+
+	_current->FillPolygon(count, clipMapPoints);
+}
+
+void ClipMapKnobRenderer::Line(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (_antialiasing && !_flushed)
+	{
+		_rasterizer.Line(x1, y1, x2, y2);
+		return;
+	}
+
+	_current->Line(x1, y1, x2, y2);
+}
+
+void ClipMapKnobRenderer::FillMask(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t *mask, int32_t stride)
+{
+	if (_antialiasing && !_flushed)
+	{
+		_rasterizer.FillMask(x, y, width, height, mask, stride);
+		return;
+	}
+
+	if (!mask)
+		return;
+
+	// GeClipMap has no blending, so blend pixel by pixel
+	const Int32 canvasWidth = _current->GetBw();
+	const Int32 canvasHeight = _current->GetBh();
+	for (Int32 row = 0; row < height; ++row)
+	{
+		const Int32 py = y + row;
+		if (py < 0 || py >= canvasHeight)
+			continue;
+
+		for (Int32 column = 0; column < width; ++column)
+		{
+			const Int32 px = x + column;
+			const Int32 coverage = mask[row * stride + column];
+			if (coverage == 0 || px < 0 || px >= canvasWidth)
+				continue;
+
+			Int32 r = 0, g = 0, b = 0;
+			_current->GetPixelRGBA(px, py, &r, &g, &b);
+			r += ((Int32)_color.r - r) * coverage / 255;
+			g += ((Int32)_color.g - g) * coverage / 255;
+			b += ((Int32)_color.b - b) * coverage / 255;
+			_current->SetPixelRGBA(px, py, r, g, b);
+		}
+	}
+}
+
+void ClipMapKnobRenderer::SetFontSize(int32_t size)
+{
+	// Only look up the font when text is actually drawn, labels from a glyph atlas don't need it
+	if (!_fontValid)
+	{
+		GeClipMap::GetDefaultFont(GE_FONT_DEFAULT_SYSTEM, &_fontDesc);
+		_fontValid = true;
+	}
+
+	_current->SetFontSize(&_fontDesc, GE_FONT_SIZE_INTERNAL, size);
+	_current->SetFont(&_fontDesc);
+}
+
+int32_t ClipMapKnobRenderer::GetTextWidth(const char *text)
+{
+	return _current->GetTextWidth(String(text));
+}
+
+int32_t ClipMapKnobRenderer::GetTextHeight()
+{
+	return _current->GetTextHeight();
+}
+
+void ClipMapKnobRenderer::TextAt(int32_t x, int32_t y, const char *text)
+{
+	// Text is drawn on top of the shapes
+	if (_antialiasing)
+		FlushShapes();
+
+	_current->TextAt(x, y, String(text));
+}
+
+
+
+ClipMapGlyphSource::ClipMapGlyphSource(Int32 fontSize) : _fontSize(fontSize)
+{
+	GeClipMap::GetDefaultFont(GE_FONT_DEFAULT_SYSTEM, &_fontDesc);
+	InitClipMap(1, 1);
+}
+
+Bool ClipMapGlyphSource::InitClipMap(Int32 width, Int32 height)
+{
+	if (!_clipMap || _clipMap->Init(width, height, 32) != IMAGERESULT_OK)
+		return false;
+
+	_clipMap->SetFontSize(&_fontDesc, GE_FONT_SIZE_INTERNAL, _fontSize);
+	_clipMap->SetFont(&_fontDesc);
+	return true;
+}
+
+int32_t ClipMapGlyphSource::GetLineHeight()
+{
+	return _clipMap ? _clipMap->GetTextHeight() : 0;
+}
+
+int32_t ClipMapGlyphSource::GetAdvance(char ch)
+{
+	if (!_clipMap)
+		return 0;
+
+	const char text[2] = { ch, 0 };
+	return _clipMap->GetTextWidth(String(text));
+}
+
+bool ClipMapGlyphSource::RenderGlyph(char ch, int32_t width, int32_t height, uint8_t *mask, int32_t stride)
+{
+	if (!InitClipMap(width, height))
+		return false;
+
+	// White text on black, so the red channel is the coverage
+	const char text[2] = { ch, 0 };
+	_clipMap->BeginDraw();
+	_clipMap->SetColor(0, 0, 0, 255);
+	_clipMap->FillRect(0, 0, width - 1, height - 1);
+	_clipMap->SetColor(255, 255, 255, 255);
+	_clipMap->TextAt(0, 0, String(text));
+	_clipMap->EndDraw();
+
+	for (Int32 y = 0; y < height; ++y)
+	{
+		for (Int32 x = 0; x < width; ++x)
+		{
+			Int32 r = 0, g = 0, b = 0;
+			_clipMap->GetPixelRGBA(x, y, &r, &g, &b);
+			mask[y * stride + x] = (uint8_t)r;
+		}
+	}
+
+	return true;
+}
+
+
+/// A glyph atlas in the process-wide cache
+struct GuiGlyphAtlasEntry
+{
+	Int32                          fontSize;  ///< Font size the atlas was built with
+	std::weak_ptr<const KnobGlyphAtlas>  atlas;  ///< The atlas. Released when the last knob stops using it.
+};
+
+static std::mutex g_guiGlyphAtlasLock;
+static std::vector<GuiGlyphAtlasEntry> g_guiGlyphAtlases;
+
+std::shared_ptr<const KnobGlyphAtlas> AcquireGuiGlyphAtlas(Int32 fontSize)
+{
+	std::lock_guard<std::mutex> lock(g_guiGlyphAtlasLock);
+
+	for (size_t i = 0; i < g_guiGlyphAtlases.size(); ++i)
+	{
+		if (g_guiGlyphAtlases[i].fontSize == fontSize)
+		{
+			std::shared_ptr<const KnobGlyphAtlas> atlas = g_guiGlyphAtlases[i].atlas.lock();
+			if (atlas)
+				return atlas;
+		}
+	}
+
+	// Not in the cache, take it from the asset file of the last session, or build a new one
+	ClipMapGlyphSource source(fontSize);
+	std::shared_ptr<const KnobGlyphAtlas> atlas = GetSharedKnobAssetCache().FindGlyphAtlas(source, "interface");
+	if (!atlas)
+	{
+		std::shared_ptr<KnobGlyphAtlas> builtAtlas = std::make_shared<KnobGlyphAtlas>();
+		if (!builtAtlas->Build(source))
+			return std::shared_ptr<const KnobGlyphAtlas>();
+		GetSharedKnobAssetCache().AddGlyphAtlas(source, "interface", *builtAtlas);
+		atlas = builtAtlas;
+	}
+
+	// Reuse the slot of an expired atlas with the same size
+	for (size_t i = 0; i < g_guiGlyphAtlases.size(); ++i)
+	{
+		if (g_guiGlyphAtlases[i].fontSize == fontSize)
+		{
+			g_guiGlyphAtlases[i].atlas = atlas;
+			return atlas;
+		}
+	}
+
+	GuiGlyphAtlasEntry entry;
+	entry.fontSize = fontSize;
+	entry.atlas = atlas;
+	g_guiGlyphAtlases.push_back(entry);
+
+	return atlas;
+}
+
+
+/// Draw values in the cache, together with the parameters they were computed from
+struct GuiKnobDrawValuesEntry
+{
+	Int32  width;         ///< Width of the knob area
+	Float  pixelScale;    ///< Screen pixels per interface unit
+	Int32  oversampling;  ///< Oversampling factor
+	Int32  margin;        ///< Margin around the knob
+	Float  scaleLimit;    ///< Scale limit in degrees
+	Int32  fontSize;      ///< Label font size
+	Bool   antialiasing;  ///< Anti-aliasing
+	Int32  scaleTicks;    ///< Number of intervals on the scale
+	std::weak_ptr<KnobDrawValues>  drawValues;  ///< The draw values. Released when the last knob stops using them.
+};
+
+static std::mutex g_guiKnobDrawValuesLock;
+static std::vector<GuiKnobDrawValuesEntry> g_guiKnobDrawValues;
+static KnobTheme g_guiKnobTheme;         ///< Theme the cached draw values use
+static Bool g_guiKnobThemeValid = false;  ///< False if g_guiKnobTheme has not been read from the interface yet
+
+std::shared_ptr<const KnobDrawValues> AcquireGuiKnobDrawValues(Int32 width, Float pixelScale, Int32 oversampling, Int32 margin, Float scaleLimit, Int32 fontSize, Bool antialiasing, Int32 scaleTicks)
+{
+	std::lock_guard<std::mutex> lock(g_guiKnobDrawValuesLock);
+
+	// Forget draw values that are not used anymore
+	g_guiKnobDrawValues.erase(std::remove_if(g_guiKnobDrawValues.begin(), g_guiKnobDrawValues.end(), [](const GuiKnobDrawValuesEntry &entry) { return entry.drawValues.expired(); }), g_guiKnobDrawValues.end());
+
+	for (size_t i = 0; i < g_guiKnobDrawValues.size(); ++i)
+	{
+		const GuiKnobDrawValuesEntry &entry = g_guiKnobDrawValues[i];
+		if (entry.width == width && entry.pixelScale == pixelScale && entry.oversampling == oversampling && entry.margin == margin && entry.scaleLimit == scaleLimit && entry.fontSize == fontSize && entry.antialiasing == antialiasing && entry.scaleTicks == scaleTicks)
+		{
+			std::shared_ptr<KnobDrawValues> drawValues = entry.drawValues.lock();
+			if (drawValues)
+				return drawValues;
+		}
+	}
+
+	if (!g_guiKnobThemeValid)
+	{
+		g_guiKnobTheme = GetGuiKnobTheme();
+		g_guiKnobThemeValid = true;
+	}
+
+	// Not in the cache, compute new ones. The text height is measured once here instead of in every knob.
+	AutoAlloc<GeClipMap> clipMap;
+	if (!clipMap)
+		return std::shared_ptr<const KnobDrawValues>();
+
+	// Everything is drawn in screen pixels. At a pixel scale of 1, that's exactly the sizes that were given.
+	const Int32 pixelWidth = (Int32)(width * pixelScale + 0.5);
+	const Int32 pixelMargin = (Int32)(margin * pixelScale + 0.5);
+	const Int32 pixelFontSize = Max((Int32)(fontSize * pixelScale + 0.5), (Int32)1);
+	const Int32 textHeight = (Int32)(clipMap->GetTextHeight() * pixelScale + 0.5);
+
+	std::shared_ptr<KnobDrawValues> drawValues = std::make_shared<KnobDrawValues>();
+	drawValues->InitGeometry(pixelWidth, oversampling, pixelMargin, scaleLimit, pixelFontSize, textHeight, antialiasing, scaleTicks);
+	drawValues->SetTheme(g_guiKnobTheme);
+
+	GuiKnobDrawValuesEntry entry;
+	entry.width = width;
+	entry.pixelScale = pixelScale;
+	entry.oversampling = oversampling;
+	entry.margin = margin;
+	entry.scaleLimit = scaleLimit;
+	entry.fontSize = fontSize;
+	entry.antialiasing = antialiasing;
+	entry.scaleTicks = scaleTicks;
+	entry.drawValues = drawValues;
+	g_guiKnobDrawValues.push_back(entry);
+
+	return drawValues;
+}
+
+Bool UpdateGuiKnobTheme()
+{
+	const KnobTheme theme = GetGuiKnobTheme();
+
+	std::lock_guard<std::mutex> lock(g_guiKnobDrawValuesLock);
+
+	if (g_guiKnobThemeValid && theme == g_guiKnobTheme)
+		return false;
+
+	// Knobs still holding the old draw values keep them alive until they acquire new ones
+	g_guiKnobTheme = theme;
+	g_guiKnobThemeValid = true;
+	g_guiKnobDrawValues.clear();
+
+	// The static layers in the old colors won't be asked for again
+	GetSharedKnobStaticLayerCache().Clear();
+
+	return true;
+}
+
+
+KnobTheme GetGuiKnobTheme()
+{
+	KnobTheme theme;
+	theme.areaColor = VectorToKnobColor(GetGuiWorldColor(COLOR_BG));
+	theme.scaleColor = VectorToKnobColor(GetGuiWorldColor(COLOR_BG_DARK1));
+	theme.knobOuterColor = VectorToKnobColor(GetGuiWorldColor(COLOR_BG_DARK1));
+	theme.knobInnerColor = VectorToKnobColor(GetGuiWorldColor(COLOR_BG_DARK2));
+	theme.knobCenterColor = VectorToKnobColor(GetGuiWorldColor(COLOR_BG_HIGHLIGHT));
+	theme.markerColor = VectorToKnobColor(GetGuiWorldColor(COLOR_BG_HIGHLIGHT));
+	theme.labelColor = VectorToKnobColor(GetGuiWorldColor(COLOR_MENU_BG_ICON));
+	return theme;
+}
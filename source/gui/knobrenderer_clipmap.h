@@ -0,0 +1,142 @@
+#ifndef KNOBRENDERER_CLIPMAP_H__
+#define KNOBRENDERER_CLIPMAP_H__
+
+#include <memory>
+#include "c4d.h"
+#include "lib_clipmap.h"
+#include "render/knobrasterizer.h"
+#include "render/knobpainter.h"
+#include "render/knobglyphatlas.h"
+
+
+/// KnobRenderer implementation that draws into a GeClipMap.
+/// GeClipMap can't draw anti-aliased shapes. With anti-aliasing enabled, all shapes and the
+/// static layer are drawn by a KnobRasterizer instead, and its pixels are copied into the
+/// GeClipMap before the first text is drawn (or at the end of the frame). Text is always drawn
+/// by the GeClipMap, so it uses the interface font.
+/// The canvas and frame buffer are taken from the pools for each frame and given back with ReleaseFrame(),
+/// the static layer is kept until ReleaseCanvases().
+class ClipMapKnobRenderer : public KnobRenderer
+{
+public:
+	ClipMapKnobRenderer();
+	virtual ~ClipMapKnobRenderer();
+
+	virtual bool BeginDraw(int32_t width, int32_t height);
+	virtual void EndDraw();
+	virtual bool BeginStaticLayer(int32_t width, int32_t height);
+	virtual void EndStaticLayer();
+	virtual void DrawStaticLayer();
+	virtual void DrawBuffer(int32_t x, int32_t y, const KnobPixelBuffer &source, int32_t sx, int32_t sy, int32_t width, int32_t height);
+	virtual void SetColor(const KnobColor &col);
+	virtual void FillRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+	virtual void FillEllipse(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+	virtual void FillPolygon(int32_t count, const KnobPointF *points);
+	virtual void Line(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+	virtual void FillMask(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t *mask, int32_t stride);
+	virtual void SetFontSize(int32_t size);
+	virtual int32_t GetTextWidth(const char *text);
+	virtual int32_t GetTextHeight();
+	virtual void TextAt(int32_t x, int32_t y, const char *text);
+
+	/// Enable or disable anti-aliased drawing. Must not be changed between BeginDraw() and EndDraw().
+	/// @note: The static layer has to be redrawn after changing this.
+	void SetAntialiasing(Bool enable);
+
+	/// Use a static layer drawn elsewhere, e.g. one from the KnobStaticLayerCache, instead of drawing one.
+	/// Only possible with anti-aliasing, where the static layer is kept by the rasterizer.
+	/// @param[in] layer The static layer, only read
+	void SetStaticLayer(const std::shared_ptr<const KnobPixelBuffer> &layer);
+
+	/// Return the canvas with the last drawn frame, or nullptr if there is none
+	GeClipMap *GetCanvas() const
+	{
+		return _canvas;
+	}
+
+	/// Give the canvas and frame buffer back to the pools once the frame has been shown.
+	/// All knobs draw into the same few buffers this way, and the next BeginDraw() gets them back without allocating.
+	void ReleaseFrame();
+
+	/// Give all canvases back to the pool and free the static layer, e.g. when the knob is hidden.
+	/// They are acquired again when the next frame is drawn.
+	/// @note: The static layer has to be redrawn after this.
+	void ReleaseCanvases();
+
+private:
+	/// Make sure a GeClipMap has the given size. It is only reinitialized if the size has changed.
+	/// If there is no GeClipMap yet, it is taken from the canvas pool.
+	Bool InitClipMap(GeClipMap *&clipMap, Int32 width, Int32 height);
+
+	/// Copy the shapes drawn by the rasterizer into the canvas, and start drawing into the canvas
+	void FlushShapes();
+
+	/// Report changes of the render buffer memory to the canvas stats
+	void UpdateBufferBytes();
+
+private:
+	GeClipMap       *_canvas;        ///< The GeClipMap to draw the frames into, from the canvas pool
+	GeClipMap       *_staticLayer;   ///< The GeClipMap that holds the static layer, from the canvas pool
+	GeClipMap       *_current;       ///< The GeClipMap the drawing functions currently draw into
+	BaseContainer    _fontDesc;      ///< Font description for text drawing
+	Bool             _fontValid;     ///< False if _fontDesc has not been set up yet
+	KnobPixelBuffer *_shapes;        ///< Anti-aliased shapes of the current frame, from the shared buffer pool
+	KnobRasterizer   _rasterizer;    ///< Draws the anti-aliased shapes into _shapes
+	Bool             _antialiasing;  ///< Draw shapes with the rasterizer
+	Bool             _flushed;       ///< True if the shapes of the current frame have already been copied into the canvas
+	KnobColor        _color;         ///< Current draw color
+	Int64            _bufferBytes;   ///< Memory of _rasterizer, as last reported to the canvas stats
+};
+
+
+/// KnobGlyphSource that renders the glyphs with a GeClipMap, in the interface font
+class ClipMapGlyphSource : public KnobGlyphSource
+{
+public:
+	/// @param[in] fontSize The font size in pixels
+	explicit ClipMapGlyphSource(Int32 fontSize);
+
+	virtual int32_t GetLineHeight();
+	virtual int32_t GetAdvance(char ch);
+	virtual bool RenderGlyph(char ch, int32_t width, int32_t height, uint8_t *mask, int32_t stride);
+
+private:
+	/// Set up the GeClipMap with the given size and the label font
+	Bool InitClipMap(Int32 width, Int32 height);
+
+private:
+	AutoAlloc<GeClipMap>  _clipMap;   ///< Used for measuring and rendering glyphs
+	BaseContainer         _fontDesc;  ///< Font description
+	Int32                 _fontSize;  ///< Font size
+};
+
+
+/// Return the glyph atlas for value labels in the interface font. All knobs share the same atlas.
+/// @param[in] fontSize The font size in pixels
+/// @return The atlas, or an empty pointer if it could not be built
+std::shared_ptr<const KnobGlyphAtlas> AcquireGuiGlyphAtlas(Int32 fontSize);
+
+
+/// Return the draw values for a knob area in the current interface theme. Knobs with the same
+/// size, pixel scale, oversampling and scale share them, so the colors, the text height and the geometry tables are only computed once.
+/// @param[in] width Width of the knob area in interface units
+/// @param[in] pixelScale Screen pixels per interface unit. Width, margin and font size are multiplied with it.
+/// @param[in] oversampling Oversampling factor
+/// @param[in] margin Margin between knob and border of the knob area in interface units
+/// @param[in] scaleLimit Where the usable range of the knob starts and ends, in degrees
+/// @param[in] fontSize Font size for the value label in interface units
+/// @param[in] antialiasing True if the knob is drawn with anti-aliasing
+/// @param[in] scaleTicks Number of intervals on the scale
+/// @return The draw values, or an empty pointer if they could not be computed
+std::shared_ptr<const KnobDrawValues> AcquireGuiKnobDrawValues(Int32 width, Float pixelScale, Int32 oversampling, Int32 margin, Float scaleLimit, Int32 fontSize, Bool antialiasing, Int32 scaleTicks);
+
+/// Read the interface colors again, e.g. on BFM_COLORCHG. If they have changed, the cached draw values
+/// are dropped and AcquireGuiKnobDrawValues() returns new ones with the new colors.
+/// @return True if the colors have changed since the draw values were cached
+Bool UpdateGuiKnobTheme();
+
+/// Returns the knob colors of the current Cinema 4D interface theme
+KnobTheme GetGuiKnobTheme();
+
+
+#endif  // KNOBRENDERER_CLIPMAP_H__
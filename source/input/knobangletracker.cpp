@@ -0,0 +1,92 @@
+#include <math.h>
+#include "knobangletracker.h"
+
+
+static const double KNOBANGLETRACKER_PI = 3.14159265358979323846;
+static const double KNOBANGLETRACKER_CENTERRADIUS = 2.0;  ///< Mouse positions closer to the center than this don't change the angle
+
+
+/// Wrap an angle difference to -pi..pi
+static inline double WrapAngle(double angle)
+{
+	return angle - floor(angle / (2.0 * KNOBANGLETRACKER_PI) + 0.5) * (2.0 * KNOBANGLETRACKER_PI);
+}
+
+
+KnobAngleTracker::KnobAngleTracker() : _minAngle(-KNOBANGLETRACKER_PI), _maxAngle(KNOBANGLETRACKER_PI), _absolute(true), _angle(0.0), _mouseAngle(0.0), _hasMouseAngle(false)
+{}
+
+void KnobAngleTracker::SetRange(double minAngle, double maxAngle, bool absolute)
+{
+	_minAngle = minAngle;
+	_maxAngle = maxAngle > minAngle ? maxAngle : minAngle;
+	_absolute = absolute;
+}
+
+void KnobAngleTracker::Start(double deltaX, double deltaY, double angle)
+{
+	_mouseAngle = GetMouseAngle(deltaX, deltaY);
+	_hasMouseAngle = !IsInCenter(deltaX, deltaY) && !(_absolute && IsOnSeam(deltaX, deltaY));
+	_angle = Clamp(angle);
+}
+
+double KnobAngleTracker::Update(double deltaX, double deltaY)
+{
+	if (IsInCenter(deltaX, deltaY))
+		return _angle;
+
+	const double mouseAngle = GetMouseAngle(deltaX, deltaY);
+
+	// A drag that started in the center has no direction to measure the movement from yet. In absolute mode, neither
+	// has one that started straight below the center: atan2() puts that point on one side of the seam, and the angle
+	// would stick to that limit while the mouse moves to the other side. The first position off the seam decides.
+	if (!_hasMouseAngle)
+	{
+		if (_absolute)
+		{
+			if (IsOnSeam(deltaX, deltaY))
+				return _angle;
+			_angle = Clamp(mouseAngle);
+		}
+		_mouseAngle = mouseAngle;
+		_hasMouseAngle = true;
+		return _angle;
+	}
+
+	// The shorter way around is the one the mouse took. In absolute mode, it is measured from the tracked
+	// angle, which equals the mouse angle (plus whole turns) unless it has been clamped.
+	if (_absolute)
+		_angle = Clamp(_angle + WrapAngle(mouseAngle - _angle));
+	else
+		_angle = Clamp(_angle + WrapAngle(mouseAngle - _mouseAngle));
+
+	_mouseAngle = mouseAngle;
+	return _angle;
+}
+
+double KnobAngleTracker::GetMouseAngle(double deltaX, double deltaY)
+{
+	if (IsInCenter(deltaX, deltaY))
+		return 0.0;
+
+	return atan2(deltaX, -deltaY);
+}
+
+bool KnobAngleTracker::IsInCenter(double deltaX, double deltaY)
+{
+	return deltaX * deltaX + deltaY * deltaY < KNOBANGLETRACKER_CENTERRADIUS * KNOBANGLETRACKER_CENTERRADIUS;
+}
+
+bool KnobAngleTracker::IsOnSeam(double deltaX, double deltaY)
+{
+	return deltaX == 0.0 && deltaY > 0.0;
+}
+
+double KnobAngleTracker::Clamp(double angle) const
+{
+	if (angle < _minAngle)
+		return _minAngle;
+	if (angle > _maxAngle)
+		return _maxAngle;
+	return angle;
+}
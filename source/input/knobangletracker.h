@@ -0,0 +1,69 @@
+#ifndef KNOBANGLETRACKER_H__
+#define KNOBANGLETRACKER_H__
+
+#include <stdint.h>
+
+
+/// Follows the angle of the mouse around the knob center during a circular drag.
+/// The angle is unwrapped from event to event, so it doesn't jump by a whole turn where atan2() wraps around,
+/// and it is clamped to a range that may span several turns. Each event costs one atan2(), without allocations.
+/// Angles are in radians, clockwise from 12 o'clock.
+class KnobAngleTracker
+{
+public:
+	KnobAngleTracker();
+
+	/// Set the range of the tracked angle
+	/// @param[in] minAngle Lower end of the range
+	/// @param[in] maxAngle Upper end of the range
+	/// @param[in] absolute True to keep the angle on the mouse position. When the mouse has moved beyond a limit,
+	///                     the angle returns as soon as the mouse is closer to the limit's other side. False to
+	///                     add up the mouse movement, so the angle leaves a limit as soon as the mouse turns back.
+	void SetRange(double minAngle, double maxAngle, bool absolute);
+
+	/// Start tracking
+	/// @param[in] deltaX Horizontal distance of the mouse from the center
+	/// @param[in] deltaY Vertical distance of the mouse from the center, positive downwards
+	/// @param[in] angle Angle to start with. Use GetMouseAngle() to start on the mouse position.
+	///                  In absolute mode, a drag that starts in the center or straight below it takes the angle
+	///                  of the first mouse position that lies on one side.
+	void Start(double deltaX, double deltaY, double angle);
+
+	/// Follow the mouse to a new position
+	/// @param[in] deltaX Horizontal distance of the mouse from the center
+	/// @param[in] deltaY Vertical distance of the mouse from the center, positive downwards
+	/// @return The tracked angle
+	double Update(double deltaX, double deltaY);
+
+	/// Return the tracked angle
+	double GetAngle() const
+	{
+		return _angle;
+	}
+
+	/// Return the angle of a mouse position, between -pi and pi
+	/// @param[in] deltaX Horizontal distance of the mouse from the center
+	/// @param[in] deltaY Vertical distance of the mouse from the center, positive downwards
+	static double GetMouseAngle(double deltaX, double deltaY);
+
+private:
+	/// Return true if the mouse is too close to the center to tell a direction
+	static bool IsInCenter(double deltaX, double deltaY);
+
+	/// Return true if the mouse is straight below the center, where GetMouseAngle() could be -pi as well as pi
+	static bool IsOnSeam(double deltaX, double deltaY);
+
+	/// Clamp an angle to the range
+	double Clamp(double angle) const;
+
+private:
+	double _minAngle;    ///< Lower end of the range
+	double _maxAngle;    ///< Upper end of the range
+	bool   _absolute;    ///< Keep the angle on the mouse position instead of adding up movement
+	double _angle;       ///< Tracked angle
+	double _mouseAngle;  ///< Angle of the last mouse position, between -pi and pi
+	bool   _hasMouseAngle;  ///< False while the mouse hasn't left the center since the start (or the seam below it, in absolute mode)
+};
+
+
+#endif  // KNOBANGLETRACKER_H__
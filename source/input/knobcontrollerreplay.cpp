@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+#include "knobcontrollerreplay.h"
+#include "knobrecordingformat.h"
+
+
+static const char   *KNOBCONTROLLERRECORDING_HEADER = "knobcontroller";  ///< First word of a recording file
+static const int32_t KNOBCONTROLLERRECORDING_VERSION = 1;                ///< File format version
+static const int32_t KNOBCONTROLLERREPLAY_RETRYTIME = 1;                 ///< Time to wait before trying again to push into a full ring, in milliseconds
+
+
+void KnobControllerRecording::Clear()
+{
+	_values.clear();
+}
+
+void KnobControllerRecording::AddValue(double time, double value)
+{
+	_values.push_back(KnobControllerValue(time, value));
+}
+
+double KnobControllerRecording::GetDuration() const
+{
+	return _values.empty() ? 0.0 : _values.back().time - _values.front().time;
+}
+
+bool KnobControllerRecording::Save(const char *filename) const
+{
+	FILE *file = fopen(filename, "w");
+	if (!file)
+		return false;
+
+	// Human-readable values are added as comments, the bits are what counts
+	const double startTime = _values.empty() ? 0.0 : _values.front().time;
+	fprintf(file, "%s %d\n", KNOBCONTROLLERRECORDING_HEADER, KNOBCONTROLLERRECORDING_VERSION);
+	fprintf(file, "# value time value\n");
+
+	for (size_t i = 0; i < _values.size(); ++i)
+	{
+		const KnobControllerValue &value = _values[i];
+		fprintf(file, "value %llx %llx  # %.3f %g\n", DoubleToBits(value.time), DoubleToBits(value.value), value.time - startTime, value.value);
+	}
+
+	const bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+bool KnobControllerRecording::Load(const char *filename)
+{
+	Clear();
+
+	FILE *file = fopen(filename, "r");
+	if (!file)
+		return false;
+
+	char line[256];
+	char *words[4];
+	bool valid = true;
+	bool hasHeader = false;
+
+	while (valid && fgets(line, sizeof(line), file))
+	{
+		CutComment(line);
+		const int32_t count = SplitWords(line, words, 4);
+		if (count == 0)
+			continue;
+
+		if (!hasHeader)
+		{
+			valid = count == 2 && strcmp(words[0], KNOBCONTROLLERRECORDING_HEADER) == 0 && atoi(words[1]) == KNOBCONTROLLERRECORDING_VERSION;
+			hasHeader = true;
+		}
+		else if (strcmp(words[0], "value") == 0 && count == 3)
+		{
+			double values[2];
+			valid = ParseDoubles(words + 1, 2, values);
+			if (valid)
+				AddValue(values[0], values[1]);
+		}
+		else
+		{
+			valid = false;
+		}
+	}
+
+	fclose(file);
+
+	if (!valid || _values.empty())
+	{
+		Clear();
+		return false;
+	}
+	return true;
+}
+
+
+KnobControllerReplay::KnobControllerReplay() : _ring(nullptr), _speed(1.0), _quit(false), _pushed(0), _superseded(0), _finished(false)
+{}
+
+KnobControllerReplay::~KnobControllerReplay()
+{
+	Stop();
+}
+
+bool KnobControllerReplay::Start(const KnobControllerRecording &recording, KnobValueRing &ring, double speed)
+{
+	Stop();
+	if (recording.GetValues().empty())
+		return false;
+
+	_values = recording.GetValues();
+	_ring = &ring;
+	_speed = speed;
+	_quit = false;
+	_pushed = 0;
+	_superseded = 0;
+	_finished = false;
+
+	try
+	{
+		_thread = std::thread(&KnobControllerReplay::ReplayThread, this);
+	}
+	catch (...)
+	{
+		return false;
+	}
+	return true;
+}
+
+void KnobControllerReplay::Stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(_quitLock);
+		_quit = true;
+	}
+	_quitSignal.notify_one();
+	_thread.join();
+}
+
+KnobControllerReplayStats KnobControllerReplay::GetStats() const
+{
+	KnobControllerReplayStats stats;
+	stats.pushed = _pushed.load();
+	stats.superseded = _superseded.load();
+	stats.finished = _finished.load();
+	return stats;
+}
+
+bool KnobControllerReplay::WaitUntil(const std::chrono::steady_clock::time_point &time)
+{
+	std::unique_lock<std::mutex> lock(_quitLock);
+	return !_quitSignal.wait_until(lock, time, [this] { return _quit; });
+}
+
+void KnobControllerReplay::ReplayThread()
+{
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	const double firstTime = _values.front().time;
+
+	// A value that didn't fit into the ring, pushed again before the next one
+	bool pending = false;
+	size_t pendingIndex = 0;
+
+	for (size_t i = 0; i < _values.size(); ++i)
+	{
+		if (_speed > 0.0)
+		{
+			const double due = (_values[i].time - firstTime) / _speed;
+			if (!WaitUntil(start + std::chrono::microseconds((int64_t)(due * 1000.0))))
+				return;
+		}
+		else if (i % 1024 == 0)
+		{
+			// Without pacing, only look for a stop now and then
+			std::lock_guard<std::mutex> lock(_quitLock);
+			if (_quit)
+				return;
+		}
+
+		// The consumer only wants the latest value, so an older one that is still waiting is replaced
+		if (pending)
+			++_superseded;
+
+		pending = !_ring->Push(_values[i]);
+		pendingIndex = i;
+		if (!pending)
+			++_pushed;
+	}
+
+	// The last value has to get through, or the parameter would end up at an older one
+	while (pending)
+	{
+		if (!WaitUntil(Clock::now() + std::chrono::milliseconds(KNOBCONTROLLERREPLAY_RETRYTIME)))
+			return;
+
+		pending = !_ring->Push(_values[pendingIndex]);
+		if (!pending)
+			++_pushed;
+	}
+
+	_finished.store(true, std::memory_order_release);
+}
@@ -0,0 +1,116 @@
+#ifndef KNOBCONTROLLERREPLAY_H__
+#define KNOBCONTROLLERREPLAY_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "knobvaluering.h"
+
+
+/// A recorded stream of values from a hardware controller.
+/// Saved as text, in the same format as drag recordings: one line per value, with time and value as the hex bits of the double.
+class KnobControllerRecording
+{
+public:
+	/// Forget all values
+	void Clear();
+
+	/// Add a value at the end of the stream
+	/// @param[in] time When the controller sent the value, in milliseconds
+	/// @param[in] value The value
+	void AddValue(double time, double value);
+
+	/// Return the recorded values, in the order they were sent
+	const std::vector<KnobControllerValue> &GetValues() const
+	{
+		return _values;
+	}
+
+	/// Return the time between the first and the last value, in milliseconds
+	double GetDuration() const;
+
+	/// Write the recording to a text file
+	/// @param[in] filename The file name
+	/// @return False if the file could not be written
+	bool Save(const char *filename) const;
+
+	/// Read a recording from a text file
+	/// @param[in] filename The file name
+	/// @return False if the file could not be read, or holds no values
+	bool Load(const char *filename);
+
+private:
+	std::vector<KnobControllerValue> _values;  ///< The values
+};
+
+
+/// What a KnobControllerReplay has done
+struct KnobControllerReplayStats
+{
+	int64_t pushed;      ///< Values pushed into the ring
+	int64_t superseded;  ///< Values that found the ring full, and were replaced by a newer one before they fit in
+	bool    finished;    ///< True if all values have been sent
+
+	KnobControllerReplayStats() : pushed(0), superseded(0), finished(false)
+	{}
+};
+
+
+/// Stands in for a hardware controller: a thread that pushes the values of a recording into a KnobValueRing,
+/// with the timing of the recording or as fast as it can. If the ring is full, the thread keeps the value, and
+/// pushes it later unless a newer one has come in the meantime. The last value always gets through.
+/// Start() and Stop() are for one thread, usually the main thread.
+class KnobControllerReplay
+{
+public:
+	KnobControllerReplay();
+
+	/// Stop the thread
+	~KnobControllerReplay();
+
+	/// Start sending the values of a recording. Stops a replay that is still running.
+	/// @param[in] recording The values, copied
+	/// @param[in] ring Receives the values. Must live until the replay is stopped, and not get values from anywhere else.
+	/// @param[in] speed 1 for the timing of the recording, 2 for twice as fast, 0 to send the values without waiting
+	/// @return False if the recording is empty or the thread could not be started
+	bool Start(const KnobControllerRecording &recording, KnobValueRing &ring, double speed = 1.0);
+
+	/// Stop sending values, and wait for the thread to end
+	void Stop();
+
+	/// Return true if the thread is still sending values
+	bool IsRunning() const
+	{
+		return _thread.joinable() && !_finished.load(std::memory_order_acquire);
+	}
+
+	/// Return what the replay has done so far
+	KnobControllerReplayStats GetStats() const;
+
+private:
+	/// Send the values, until all are sent or the replay is stopped
+	void ReplayThread();
+
+	/// Wait until a point in time, or until the replay is stopped
+	/// @return False if the replay has been stopped
+	bool WaitUntil(const std::chrono::steady_clock::time_point &time);
+
+private:
+	std::vector<KnobControllerValue> _values;  ///< Copy of the recording
+	KnobValueRing          *_ring;        ///< Receives the values
+	double                  _speed;       ///< Replay speed, 0 for no waiting
+	std::mutex              _quitLock;    ///< Only for waiting and stopping the thread
+	std::condition_variable _quitSignal;  ///< Wakes up the thread when it is stopped
+	bool                    _quit;        ///< True if the thread should end
+	std::atomic<int64_t>    _pushed;      ///< Values pushed
+	std::atomic<int64_t>    _superseded;  ///< Values that didn't fit and were replaced
+	std::atomic<bool>       _finished;    ///< True if the thread has sent all values
+	std::thread             _thread;      ///< The thread
+};
+
+
+#endif  // KNOBCONTROLLERREPLAY_H__
@@ -0,0 +1,91 @@
+#include <math.h>
+#include "knobdragmapper.h"
+
+
+static const double KNOBDRAGMAPPER_PI = 3.14159265358979323846;
+
+
+KnobDragMapper::KnobDragMapper(const KnobDragSettings &settings) : _settings(settings), _startY(0.0), _startValue(0.0)
+{}
+
+void KnobDragMapper::SetSettings(const KnobDragSettings &settings)
+{
+	_settings = settings;
+}
+
+void KnobDragMapper::Start(double x, double y, double value)
+{
+	_startY = y;
+	_startValue = value;
+
+	if (!_settings.circular)
+		return;
+
+	const double deltaX = x - _settings.centerX;
+	const double deltaY = y - _settings.centerY;
+	const double range = _settings.maxValue - _settings.minValue;
+
+	if (_settings.turns > 0.0 && range > 0.0)
+	{
+		// Angle 0 is the start value, the limits are where the value reaches min and max
+		const double anglePerValue = 2.0 * KNOBDRAGMAPPER_PI * _settings.turns / range;
+		_angle.SetRange((_settings.minValue - value) * anglePerValue, (_settings.maxValue - value) * anglePerValue, false);
+		_angle.Start(deltaX, deltaY, 0.0);
+	}
+	else
+	{
+		// The value follows the mouse position. The bottom of the knob is the end of the range on both sides,
+		// so the value doesn't jump from max to min when the mouse passes it.
+		_angle.SetRange(-KNOBDRAGMAPPER_PI, KNOBDRAGMAPPER_PI, true);
+		_angle.Start(deltaX, deltaY, KnobAngleTracker::GetMouseAngle(deltaX, deltaY));
+	}
+}
+
+double KnobDragMapper::Update(double x, double y, bool precise, bool snap)
+{
+	const double range = _settings.maxValue - _settings.minValue;
+	double value = _startValue;
+
+	if (_settings.circular)
+	{
+		// Angle of the mouse position, clockwise from 12 o'clock, with negative angles on the left side
+		const double angle = _angle.Update(x - _settings.centerX, y - _settings.centerY);
+
+		if (_settings.turns > 0.0)
+		{
+			// Each turn adds its part of the value range
+			value = _startValue + range * angle / (2.0 * KNOBDRAGMAPPER_PI * _settings.turns);
+		}
+		else
+		{
+			// Map the angle from the usable range of the scale to the value range
+			const double limit = _settings.scaleLimit * KNOBDRAGMAPPER_PI / 180.0;
+			value = limit > 0.0 ? _settings.minValue + range * (angle + limit) / (2.0 * limit) : _settings.minValue;
+		}
+	}
+	else
+	{
+		// Moving the mouse up increases the value
+		const double totalDelta = _startY - y;
+		value = _startValue + totalDelta * range * (precise ? _settings.preciseMultiplier : _settings.multiplier);
+
+		if (snap)
+			value = RoundGrid(value, _settings.gridSize);
+	}
+
+	// Clamp value, just to be on the safe side
+	if (value < _settings.minValue)
+		value = _settings.minValue;
+	if (value > _settings.maxValue)
+		value = _settings.maxValue;
+
+	return value;
+}
+
+double KnobDragMapper::RoundGrid(double value, double grid)
+{
+	if (grid == 0.0)
+		return 0.0;
+
+	return floor(value / grid + 0.5) * grid;
+}
@@ -0,0 +1,76 @@
+#ifndef KNOBDRAGMAPPER_H__
+#define KNOBDRAGMAPPER_H__
+
+#include <stdint.h>
+#include "knobangletracker.h"
+
+
+/// How mouse movement is turned into knob values
+struct KnobDragSettings
+{
+	double minValue;           ///< Lower end of the value range
+	double maxValue;           ///< Upper end of the value range
+	bool   circular;           ///< Use the mouse angle around the knob center instead of vertical movement
+	double centerX;            ///< Knob center in the coordinates of the mouse positions, for circular mode
+	double centerY;            ///< Knob center in the coordinates of the mouse positions, for circular mode
+	double scaleLimit;         ///< Where the usable range of the knob starts and ends, in degrees
+	double turns;              ///< Number of turns for the whole value range in circular mode, 0 to map the scale to the value range
+	double multiplier;         ///< Value change per pixel of vertical movement, relative to the value range
+	double preciseMultiplier;  ///< Same as multiplier, for precise (slow) dragging
+	double gridSize;           ///< Grid size for value snapping
+
+	KnobDragSettings() : minValue(0.0), maxValue(1.0), circular(false), centerX(0.0), centerY(0.0), scaleLimit(135.0), turns(0.0), multiplier(0.01), preciseMultiplier(0.001), gridSize(0.5)
+	{}
+};
+
+
+/// Computes the knob value from the mouse position during a drag, in linear or circular mode.
+/// Linear mode measures the vertical distance to where the drag started, not the movement since the last
+/// event, so rounding errors don't add up over a long drag. Circular mode maps the angle of the mouse
+/// position around the knob center to the value range. With turns set, circular mode works like an endless
+/// encoder instead: the value follows the mouse from where the drag started, and each turn covers a part of
+/// the value range.
+class KnobDragMapper
+{
+public:
+	/// @param[in] settings Value range and mouse mode
+	explicit KnobDragMapper(const KnobDragSettings &settings = KnobDragSettings());
+
+	/// Set value range and mouse mode
+	void SetSettings(const KnobDragSettings &settings);
+
+	/// Return value range and mouse mode
+	const KnobDragSettings &GetSettings() const
+	{
+		return _settings;
+	}
+
+	/// Start a new drag
+	/// @param[in] x Mouse position where the drag starts
+	/// @param[in] y Mouse position where the drag starts
+	/// @param[in] value The value at the start of the drag
+	void Start(double x, double y, double value);
+
+	/// Compute the value for a mouse position during the drag
+	/// @param[in] x Current mouse position
+	/// @param[in] y Current mouse position
+	/// @param[in] precise True to use the precise multiplier (linear mode only)
+	/// @param[in] snap True to snap the value to the grid (linear mode only)
+	/// @return The new value, clamped to the value range
+	double Update(double x, double y, bool precise, bool snap);
+
+	/// Round a value to the nearest point of a grid with any spacing
+	/// @param[in] value The input value
+	/// @param[in] grid The grid spacing
+	/// @return The rounded value
+	static double RoundGrid(double value, double grid);
+
+private:
+	KnobDragSettings _settings;    ///< Value range and mouse mode
+	double           _startY;      ///< Vertical mouse position at the start of the drag
+	double           _startValue;  ///< Value at the start of the drag
+	KnobAngleTracker _angle;       ///< Angle of the mouse around the knob center, for circular mode
+};
+
+
+#endif  // KNOBDRAGMAPPER_H__
@@ -0,0 +1,50 @@
+#include "knobdragpacer.h"
+
+
+KnobDragPacer::KnobDragPacer(int32_t maxRate) : _minInterval(0.0), _lastPublishTime(0.0), _startValue(0.0), _currentValue(0.0), _published(false), _updateCount(0), _publishCount(0)
+{
+	SetMaxRate(maxRate);
+}
+
+void KnobDragPacer::SetMaxRate(int32_t maxRate)
+{
+	_minInterval = maxRate > 0 ? 1000.0 / (double)maxRate : 0.0;
+}
+
+void KnobDragPacer::Start(double time, double value)
+{
+	// Pretend the last value was published one interval ago, so the first change goes through immediately
+	_lastPublishTime = time - _minInterval;
+	_startValue = value;
+	_currentValue = value;
+	_published = false;
+	_updateCount = 0;
+	_publishCount = 0;
+}
+
+bool KnobDragPacer::Update(double time, double value)
+{
+	++_updateCount;
+	_currentValue = value;
+
+	if (time - _lastPublishTime < _minInterval)
+		return false;
+
+	_lastPublishTime = time;
+	_published = true;
+	++_publishCount;
+
+	return true;
+}
+
+bool KnobDragPacer::Finish(double &value)
+{
+	value = _currentValue;
+
+	// Nothing to commit if the value never changed
+	if (!_published && _currentValue == _startValue)
+		return false;
+
+	++_publishCount;
+	return true;
+}
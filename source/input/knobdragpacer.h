@@ -0,0 +1,59 @@
+#ifndef KNOBDRAGPACER_H__
+#define KNOBDRAGPACER_H__
+
+#include <stdint.h>
+
+
+/// Decides which value changes during a mouse drag are passed on to the parent GUI.
+/// Changes are coalesced to a maximum rate, e.g. the display refresh rate. Values that are
+/// held back are not lost: the last value of a drag is always published by Finish().
+class KnobDragPacer
+{
+public:
+	/// @param[in] maxRate Maximum number of published values per second, 0 for no limit
+	explicit KnobDragPacer(int32_t maxRate = 60);
+
+	/// Set the maximum number of published values per second
+	/// @param[in] maxRate Maximum rate in Hz, 0 for no limit
+	void SetMaxRate(int32_t maxRate);
+
+	/// Start a new drag
+	/// @param[in] time Current time in milliseconds
+	/// @param[in] value The value at the start of the drag
+	void Start(double time, double value);
+
+	/// Pass a new value during the drag
+	/// @param[in] time Current time in milliseconds
+	/// @param[in] value The new value
+	/// @return True if the value should be published now
+	bool Update(double time, double value);
+
+	/// End the drag
+	/// @param[out] value The final value of the drag
+	/// @return True if the value has changed during the drag, and the final value has to be committed
+	bool Finish(double &value);
+
+	/// Return the number of values passed to Update() during the current or last drag
+	int32_t GetUpdateCount() const
+	{
+		return _updateCount;
+	}
+
+	/// Return the number of values published during the current or last drag, including the final commit
+	int32_t GetPublishCount() const
+	{
+		return _publishCount;
+	}
+
+private:
+	double  _minInterval;     ///< Minimum time between two published values, in milliseconds
+	double  _lastPublishTime; ///< Time when the last value was published
+	double  _startValue;      ///< Value at the start of the drag
+	double  _currentValue;    ///< Latest value
+	bool    _published;       ///< True if a value has been published during the current drag
+	int32_t _updateCount;     ///< Number of Update() calls
+	int32_t _publishCount;    ///< Number of published values
+};
+
+
+#endif  // KNOBDRAGPACER_H__
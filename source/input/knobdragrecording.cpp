@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "knobdragrecording.h"
+#include "knobrecordingformat.h"
+
+
+static const char   *KNOBDRAGRECORDING_HEADER = "knobdrag";  ///< First word of a recording file
+static const int32_t KNOBDRAGRECORDING_VERSION = 2;          ///< File format version
+static const size_t  KNOBDRAGRECORDING_RESERVE = 1024;       ///< Events reserved up front, so a usual drag doesn't allocate while recording
+
+
+KnobDragRecording::KnobDragRecording() : _maxRate(0), _startTime(0.0), _startX(0.0), _startY(0.0), _startValue(0.0), _finalValue(0.0), _commit(false), _started(false), _finished(false)
+{
+	_events.reserve(KNOBDRAGRECORDING_RESERVE);
+}
+
+void KnobDragRecording::Clear()
+{
+	_events.clear();
+	_started = false;
+	_finished = false;
+}
+
+void KnobDragRecording::Start(const KnobDragSettings &settings, int32_t maxRate, double time, double x, double y, double value)
+{
+	Clear();
+
+	_settings = settings;
+	_maxRate = maxRate;
+	_startTime = time;
+	_startX = x;
+	_startY = y;
+	_startValue = value;
+	_started = true;
+}
+
+void KnobDragRecording::AddEvent(const KnobDragEvent &event, const KnobDragStep &step)
+{
+	if (!_started || _finished)
+		return;
+
+	KnobDragRecordedEvent recorded;
+	recorded.event = event;
+	recorded.step = step;
+	_events.push_back(recorded);
+}
+
+void KnobDragRecording::Finish(double value, bool commit)
+{
+	if (!_started)
+		return;
+
+	_finalValue = value;
+	_commit = commit;
+	_finished = true;
+}
+
+bool KnobDragRecording::Replay(KnobDragReplayResult &result, std::vector<double> *values) const
+{
+	result = KnobDragReplayResult();
+	if (!_finished)
+		return false;
+
+	if (values)
+	{
+		values->clear();
+		values->reserve(_events.size());
+	}
+
+	KnobDragSession session(_settings, _maxRate);
+	session.Start(_startTime, _startX, _startY, _startValue);
+
+	for (size_t i = 0; i < _events.size(); ++i)
+	{
+		const KnobDragRecordedEvent &recorded = _events[i];
+		const KnobDragStep step = session.Update(recorded.event);
+		if (values)
+			values->push_back(step.value);
+
+		// Compare the bits, not just the values. -0.0 and 0.0 have to stay what they were, too.
+		if (DoubleToBits(step.value) != DoubleToBits(recorded.step.value) || step.changed != recorded.step.changed || step.publish != recorded.step.publish)
+		{
+			if (result.firstMismatch < 0)
+				result.firstMismatch = (int32_t)i;
+			++result.mismatches;
+		}
+		++result.events;
+	}
+
+	double finalValue = 0.0;
+	const bool commit = session.Finish(finalValue);
+	result.finishMatches = commit == _commit && DoubleToBits(finalValue) == DoubleToBits(_finalValue);
+
+	return true;
+}
+
+bool KnobDragRecording::Save(const char *filename) const
+{
+	if (!_finished)
+		return false;
+
+	FILE *file = fopen(filename, "w");
+	if (!file)
+		return false;
+
+	// Human-readable values are added as comments, the bits are what counts
+	fprintf(file, "%s %d\n", KNOBDRAGRECORDING_HEADER, KNOBDRAGRECORDING_VERSION);
+	fprintf(file, "# settings minValue maxValue circular centerX centerY scaleLimit turns multiplier preciseMultiplier gridSize maxRate\n");
+	fprintf(file, "settings %llx %llx %d %llx %llx %llx %llx %llx %llx %llx %d\n", DoubleToBits(_settings.minValue), DoubleToBits(_settings.maxValue), _settings.circular ? 1 : 0,
+		DoubleToBits(_settings.centerX), DoubleToBits(_settings.centerY), DoubleToBits(_settings.scaleLimit), DoubleToBits(_settings.turns), DoubleToBits(_settings.multiplier), DoubleToBits(_settings.preciseMultiplier), DoubleToBits(_settings.gridSize), _maxRate);
+	fprintf(file, "# start time x y value\n");
+	fprintf(file, "start %llx %llx %llx %llx\n", DoubleToBits(_startTime), DoubleToBits(_startX), DoubleToBits(_startY), DoubleToBits(_startValue));
+	fprintf(file, "# event time x y flags value changed publish\n");
+
+	for (size_t i = 0; i < _events.size(); ++i)
+	{
+		const KnobDragRecordedEvent &recorded = _events[i];
+		fprintf(file, "event %llx %llx %llx %d %llx %d %d  # %.3f %g %g %g\n", DoubleToBits(recorded.event.time), DoubleToBits(recorded.event.x), DoubleToBits(recorded.event.y), recorded.event.flags,
+			DoubleToBits(recorded.step.value), recorded.step.changed ? 1 : 0, recorded.step.publish ? 1 : 0, recorded.event.time - _startTime, recorded.event.x, recorded.event.y, recorded.step.value);
+	}
+
+	fprintf(file, "# finish value commit\n");
+	fprintf(file, "finish %llx %d\n", DoubleToBits(_finalValue), _commit ? 1 : 0);
+
+	const bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+bool KnobDragRecording::Load(const char *filename)
+{
+	Clear();
+
+	FILE *file = fopen(filename, "r");
+	if (!file)
+		return false;
+
+	char line[512];
+	char *words[16];
+	bool valid = true;
+	bool hasHeader = false;
+	bool hasSettings = false;
+
+	while (valid && !_finished && fgets(line, sizeof(line), file))
+	{
+		// Cut off comments
+		CutComment(line);
+
+		const int32_t count = SplitWords(line, words, 16);
+		if (count == 0)
+			continue;
+
+		if (!hasHeader)
+		{
+			valid = count == 2 && strcmp(words[0], KNOBDRAGRECORDING_HEADER) == 0 && atoi(words[1]) == KNOBDRAGRECORDING_VERSION;
+			hasHeader = true;
+		}
+		else if (strcmp(words[0], "settings") == 0 && count == 12)
+		{
+			// The circular flag sits between the doubles
+			double values[9];
+			valid = ParseDoubles(words + 1, 2, values) && ParseDoubles(words + 4, 7, values + 2);
+			_settings.minValue = values[0];
+			_settings.maxValue = values[1];
+			_settings.circular = atoi(words[3]) != 0;
+			_settings.centerX = values[2];
+			_settings.centerY = values[3];
+			_settings.scaleLimit = values[4];
+			_settings.turns = values[5];
+			_settings.multiplier = values[6];
+			_settings.preciseMultiplier = values[7];
+			_settings.gridSize = values[8];
+			_maxRate = atoi(words[11]);
+			hasSettings = true;
+		}
+		else if (strcmp(words[0], "start") == 0 && count == 5 && hasSettings)
+		{
+			double values[4];
+			valid = ParseDoubles(words + 1, 4, values);
+			_startTime = values[0];
+			_startX = values[1];
+			_startY = values[2];
+			_startValue = values[3];
+			_started = true;
+		}
+		else if (strcmp(words[0], "event") == 0 && count == 8 && _started)
+		{
+			double values[3];
+			KnobDragRecordedEvent recorded;
+			valid = ParseDoubles(words + 1, 3, values) && ParseDoubleBits(words[5], recorded.step.value);
+			recorded.event = KnobDragEvent(values[0], values[1], values[2], atoi(words[4]));
+			recorded.step.changed = atoi(words[6]) != 0;
+			recorded.step.publish = atoi(words[7]) != 0;
+			_events.push_back(recorded);
+		}
+		else if (strcmp(words[0], "finish") == 0 && count == 3 && _started)
+		{
+			valid = ParseDoubleBits(words[1], _finalValue);
+			_commit = atoi(words[2]) != 0;
+			_finished = true;
+		}
+		else
+		{
+			valid = false;
+		}
+	}
+
+	fclose(file);
+
+	if (!valid || !_finished)
+	{
+		Clear();
+		return false;
+	}
+	return true;
+}
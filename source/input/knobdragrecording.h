@@ -0,0 +1,107 @@
+#ifndef KNOBDRAGRECORDING_H__
+#define KNOBDRAGRECORDING_H__
+
+#include <stdint.h>
+#include <vector>
+#include "knobdragsession.h"
+
+
+/// A recorded mouse event, and what it did to the knob
+struct KnobDragRecordedEvent
+{
+	KnobDragEvent event;  ///< The mouse event
+	KnobDragStep  step;   ///< The result at the time of recording
+};
+
+
+/// Result of replaying a recording
+struct KnobDragReplayResult
+{
+	int32_t events;         ///< Number of replayed events
+	int32_t mismatches;     ///< Events whose value, change or publish decision differs from the recording
+	int32_t firstMismatch;  ///< Index of the first mismatching event, -1 if there is none
+	bool    finishMatches;  ///< True if the final value and commit decision match the recording
+
+	KnobDragReplayResult() : events(0), mismatches(0), firstMismatch(-1), finishMatches(true)
+	{}
+
+	/// Return true if the replay produced exactly the recorded values
+	bool IsIdentical() const
+	{
+		return mismatches == 0 && finishMatches;
+	}
+};
+
+
+/// The exact sequence of mouse events of a drag, with the settings and start state of the knob and the
+/// value each event produced. Filled by a KnobDragSession, and replayed through a new one to check
+/// that the knob still computes bit-identical values.
+/// Recordings are saved as text. Floating point numbers are written as the hex bits of the double,
+/// so they survive the round trip through the file exactly.
+class KnobDragRecording
+{
+public:
+	KnobDragRecording();
+
+	/// Forget the recorded drag
+	void Clear();
+
+	/// Start recording a drag. Called by KnobDragSession::Start().
+	void Start(const KnobDragSettings &settings, int32_t maxRate, double time, double x, double y, double value);
+
+	/// Record a mouse event. Called by KnobDragSession::Update().
+	void AddEvent(const KnobDragEvent &event, const KnobDragStep &step);
+
+	/// Record the end of the drag. Called by KnobDragSession::Finish().
+	void Finish(double value, bool commit);
+
+	/// Return true if a complete drag has been recorded
+	bool IsFinished() const
+	{
+		return _finished;
+	}
+
+	/// Return value range and mouse mode of the recorded drag
+	const KnobDragSettings &GetSettings() const
+	{
+		return _settings;
+	}
+
+	/// Return the recorded events
+	const std::vector<KnobDragRecordedEvent> &GetEvents() const
+	{
+		return _events;
+	}
+
+	/// Feed the recorded events through a new KnobDragSession, and compare the results with the recording
+	/// @param[out] result Receives the comparison
+	/// @param[out] values If not nullptr, receives the value after each event
+	/// @return False if the recording is not complete
+	bool Replay(KnobDragReplayResult &result, std::vector<double> *values = nullptr) const;
+
+	/// Write the recording to a text file
+	/// @param[in] filename The file name
+	/// @return False if the file could not be written, or nothing has been recorded
+	bool Save(const char *filename) const;
+
+	/// Read a recording from a text file
+	/// @param[in] filename The file name
+	/// @return False if the file could not be read or is not a complete recording
+	bool Load(const char *filename);
+
+private:
+	KnobDragSettings _settings;    ///< Value range and mouse mode
+	int32_t          _maxRate;     ///< Maximum rate of values sent to the parent
+	double           _startTime;   ///< Time when the drag started
+	double           _startX;      ///< Mouse position where the drag started
+	double           _startY;      ///< Mouse position where the drag started
+	double           _startValue;  ///< Value at the start of the drag
+	std::vector<KnobDragRecordedEvent> _events;  ///< Recorded mouse events
+	double           _finalValue;  ///< Value committed at the end of the drag
+	bool             _commit;      ///< True if the final value was committed
+	bool             _started;     ///< True if Start() has been called
+	bool             _finished;    ///< True if Finish() has been called
+};
+
+
+#endif  // KNOBDRAGRECORDING_H__
@@ -0,0 +1,62 @@
+#include "knobdragsession.h"
+#include "knobdragrecording.h"
+
+
+KnobDragSession::KnobDragSession(const KnobDragSettings &settings, int32_t maxRate) : _mapper(settings), _pacer(maxRate), _maxRate(maxRate), _value(0.0), _recording(nullptr)
+{}
+
+void KnobDragSession::SetSettings(const KnobDragSettings &settings)
+{
+	_mapper.SetSettings(settings);
+}
+
+void KnobDragSession::SetMaxRate(int32_t maxRate)
+{
+	_maxRate = maxRate;
+	_pacer.SetMaxRate(maxRate);
+}
+
+void KnobDragSession::SetRecording(KnobDragRecording *recording)
+{
+	_recording = recording;
+}
+
+void KnobDragSession::Start(double time, double x, double y, double value)
+{
+	_value = value;
+	_mapper.Start(x, y, value);
+	_pacer.Start(time, value);
+
+	if (_recording)
+		_recording->Start(_mapper.GetSettings(), _maxRate, time, x, y, value);
+}
+
+KnobDragStep KnobDragSession::Update(const KnobDragEvent &event)
+{
+	KnobDragStep step;
+	step.value = _mapper.Update(event.x, event.y, (event.flags & KNOBDRAG_PRECISE) != 0, (event.flags & KNOBDRAG_SNAP) != 0);
+
+	// Nothing to do if the value didn't change, e.g. when dragging beyond min or max
+	if (step.value != _value)
+	{
+		_value = step.value;
+		step.changed = true;
+		step.publish = _pacer.Update(event.time, _value);
+	}
+
+	if (_recording)
+		_recording->AddEvent(event, step);
+
+	return step;
+}
+
+bool KnobDragSession::Finish(double &value)
+{
+	const bool commit = _pacer.Finish(value);
+	_value = value;
+
+	if (_recording)
+		_recording->Finish(value, commit);
+
+	return commit;
+}
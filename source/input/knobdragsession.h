@@ -0,0 +1,112 @@
+#ifndef KNOBDRAGSESSION_H__
+#define KNOBDRAGSESSION_H__
+
+#include <stdint.h>
+#include "knobdragmapper.h"
+#include "knobdragpacer.h"
+
+class KnobDragRecording;
+
+
+/// Qualifier flags of a mouse event
+enum
+{
+	KNOBDRAG_PRECISE = 1,  ///< Precise (slow) dragging, SHIFT in Cinema 4D
+	KNOBDRAG_SNAP    = 2   ///< Snap the value to the grid, CTRL in Cinema 4D
+};
+
+
+/// One mouse event during a drag
+struct KnobDragEvent
+{
+	double  time;   ///< Time of the event in milliseconds
+	double  x;      ///< Mouse position, in the same coordinates as the knob center
+	double  y;      ///< Mouse position
+	int32_t flags;  ///< Qualifiers, KNOBDRAG_ flags
+
+	KnobDragEvent() : time(0.0), x(0.0), y(0.0), flags(0)
+	{}
+
+	KnobDragEvent(double eventTime, double eventX, double eventY, int32_t eventFlags) : time(eventTime), x(eventX), y(eventY), flags(eventFlags)
+	{}
+};
+
+
+/// What a mouse event did to the knob
+struct KnobDragStep
+{
+	double value;    ///< The value after the event
+	bool   changed;  ///< True if the value has changed
+	bool   publish;  ///< True if the new value should be sent to the parent now
+
+	KnobDragStep() : value(0.0), changed(false), publish(false)
+	{}
+};
+
+
+/// Turns the mouse events of a drag into knob values, and decides which of them are sent to the parent.
+/// This is all the decision making of the knob's drag loop, without the Cinema 4D input handling around it,
+/// so a recorded drag can be replayed through exactly the same code.
+class KnobDragSession
+{
+public:
+	/// @param[in] settings Value range and mouse mode
+	/// @param[in] maxRate Maximum number of values per second sent to the parent, 0 for no limit
+	explicit KnobDragSession(const KnobDragSettings &settings = KnobDragSettings(), int32_t maxRate = 60);
+
+	/// Set value range and mouse mode. Takes effect with the next Start().
+	void SetSettings(const KnobDragSettings &settings);
+
+	/// Return value range and mouse mode
+	const KnobDragSettings &GetSettings() const
+	{
+		return _mapper.GetSettings();
+	}
+
+	/// Set the maximum number of values per second sent to the parent
+	/// @param[in] maxRate Maximum rate in Hz, 0 for no limit
+	void SetMaxRate(int32_t maxRate);
+
+	/// Return the maximum number of values per second sent to the parent
+	int32_t GetMaxRate() const
+	{
+		return _maxRate;
+	}
+
+	/// Record all following drags, until it's set to nullptr
+	/// @param[in] recording Receives the drags, may be nullptr. Must stay valid while it's set.
+	void SetRecording(KnobDragRecording *recording);
+
+	/// Start a new drag
+	/// @param[in] time Current time in milliseconds
+	/// @param[in] x Mouse position where the drag starts
+	/// @param[in] y Mouse position where the drag starts
+	/// @param[in] value The value at the start of the drag
+	void Start(double time, double x, double y, double value);
+
+	/// Process a mouse event
+	/// @param[in] event The event
+	/// @return The new value, and what should be done with it
+	KnobDragStep Update(const KnobDragEvent &event);
+
+	/// End the drag
+	/// @param[out] value The final value of the drag
+	/// @return True if the value has changed during the drag, and the final value has to be committed
+	bool Finish(double &value);
+
+	/// Return the current value
+	double GetValue() const
+	{
+		return _value;
+	}
+
+private:
+	KnobDragMapper     _mapper;     ///< Mouse position to value
+	KnobDragPacer      _pacer;      ///< Limits the rate of values sent to the parent
+	int32_t            _maxRate;    ///< Maximum rate of values sent to the parent
+	double             _value;      ///< Current value
+	KnobDragRecording *_recording;  ///< Receives the drags, or nullptr
+};
+
+
+#endif  // KNOBDRAGSESSION_H__
@@ -0,0 +1,95 @@
+#include <math.h>
+#include "knobframepacer.h"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+
+KnobFramePacer::KnobFramePacer(int32_t frameRate) : _interval(0.0), _startTime(0.0), _nextFrame(0.0), _moveX(0.0), _moveY(0.0), _startCpu(0.0)
+{
+	SetFrameRate(frameRate);
+}
+
+void KnobFramePacer::SetFrameRate(int32_t frameRate)
+{
+	_interval = frameRate > 0 ? 1000.0 / (double)frameRate : 0.0;
+}
+
+void KnobFramePacer::Start(double time)
+{
+	_startTime = time;
+	_nextFrame = time;
+	_moveX = _moveY = 0.0;
+	_stats = KnobDragLoopStats();
+	_startCpu = GetThreadCpuTime();
+}
+
+void KnobFramePacer::AddMovement(double deltaX, double deltaY)
+{
+	++_stats.events;
+	_moveX += deltaX;
+	_moveY += deltaY;
+}
+
+bool KnobFramePacer::IsFrameDue(double time) const
+{
+	return HasMovement() && time >= _nextFrame;
+}
+
+double KnobFramePacer::GetWaitTime(double time) const
+{
+	if (IsFrameDue(time) || _interval <= 0.0)
+		return 0.0;
+
+	// Nothing has moved yet, wait for the next frame on the grid
+	if (time >= _nextFrame)
+		return GetNextFrameTime(time) - time;
+
+	return _nextFrame - time;
+}
+
+void KnobFramePacer::FrameDone(double time)
+{
+	++_stats.frames;
+	_moveX = _moveY = 0.0;
+	_nextFrame = GetNextFrameTime(time);
+}
+
+void KnobFramePacer::Finish(double time)
+{
+	_stats.wallTime = time - _startTime;
+	_stats.cpuTime = GetThreadCpuTime() - _startCpu;
+}
+
+double KnobFramePacer::GetNextFrameTime(double time) const
+{
+	if (_interval <= 0.0)
+		return time;
+
+	return _startTime + (floor((time - _startTime) / _interval) + 1.0) * _interval;
+}
+
+double KnobFramePacer::GetThreadCpuTime()
+{
+#if defined(_WIN32)
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0.0;
+
+	// FILETIME counts in 100 nanoseconds
+	const uint64_t kernel = ((uint64_t)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+	const uint64_t user = ((uint64_t)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+	return (double)(kernel + user) / 10000.0;
+#else
+	timespec now;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0)
+		return 0.0;
+
+	return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+#endif
+}
@@ -0,0 +1,96 @@
+#ifndef KNOBFRAMEPACER_H__
+#define KNOBFRAMEPACER_H__
+
+#include <stdint.h>
+
+
+/// What a drag loop has done, to check how much CPU time it takes
+struct KnobDragLoopStats
+{
+	int32_t events;    ///< Input events received from the system
+	int32_t frames;    ///< Frames in which input was processed
+	double  wallTime;  ///< Duration of the drag in milliseconds
+	double  cpuTime;   ///< CPU time of the thread during the drag, in milliseconds
+
+	KnobDragLoopStats() : events(0), frames(0), wallTime(0.0), cpuTime(0.0)
+	{}
+
+	/// Return the CPU time per second of dragging, in milliseconds. 1000 means a whole core was busy.
+	double GetCpuPerSecond() const
+	{
+		return wallTime > 0.0 ? cpuTime * 1000.0 / wallTime : 0.0;
+	}
+};
+
+
+/// Paces a drag loop to the display frame rate.
+/// Input events only accumulate their movement. Once per frame, if anything has moved, the loop processes
+/// the current input state. Between frames, the loop waits instead of spinning. Frames lie on a fixed grid
+/// from the start of the drag, so a late frame doesn't push all following frames back.
+/// All times are in milliseconds.
+class KnobFramePacer
+{
+public:
+	/// @param[in] frameRate Frames per second, 0 to process every event immediately
+	explicit KnobFramePacer(int32_t frameRate = 60);
+
+	/// Set the frame rate
+	/// @param[in] frameRate Frames per second, 0 to process every event immediately
+	void SetFrameRate(int32_t frameRate);
+
+	/// Start a new drag
+	/// @param[in] time Current time
+	void Start(double time);
+
+	/// Add the movement of an input event
+	/// @param[in] deltaX Horizontal movement since the last event
+	/// @param[in] deltaY Vertical movement since the last event
+	void AddMovement(double deltaX, double deltaY);
+
+	/// Return true if the input has moved since the last processed frame
+	bool HasMovement() const
+	{
+		return _moveX != 0.0 || _moveY != 0.0;
+	}
+
+	/// Return true if the input should be processed now
+	/// @param[in] time Current time
+	bool IsFrameDue(double time) const;
+
+	/// Return how long to wait before the next frame. 0 if the input should be processed now.
+	/// @param[in] time Current time
+	double GetWaitTime(double time) const;
+
+	/// The input has been processed for this frame
+	/// @param[in] time Current time
+	void FrameDone(double time);
+
+	/// End the drag
+	/// @param[in] time Current time
+	void Finish(double time);
+
+	/// Return what the current or last drag has done
+	const KnobDragLoopStats &GetStats() const
+	{
+		return _stats;
+	}
+
+	/// Return the CPU time used by the calling thread so far, in milliseconds
+	static double GetThreadCpuTime();
+
+private:
+	/// Return the start of the first frame after a time
+	double GetNextFrameTime(double time) const;
+
+private:
+	double  _interval;    ///< Time between two frames, 0 for no pacing
+	double  _startTime;   ///< Start of the drag, the frame grid starts here
+	double  _nextFrame;   ///< Earliest time for the next frame
+	double  _moveX;       ///< Horizontal movement since the last frame
+	double  _moveY;       ///< Vertical movement since the last frame
+	double  _startCpu;    ///< CPU time of the thread at the start of the drag
+	KnobDragLoopStats _stats;  ///< Statistics of the current drag
+};
+
+
+#endif  // KNOBFRAMEPACER_H__
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include "knoblatencytracker.h"
+
+
+static const size_t KNOBLATENCYTRACKER_RESERVE = 1024;  ///< Samples reserved per stage, so a usual drag doesn't allocate
+
+
+/// Compute the distribution of a series of latencies. The series is sorted in the process.
+static KnobLatencyStats ComputeLatencyStats(std::vector<double> &samples)
+{
+	KnobLatencyStats stats;
+	if (samples.empty())
+		return stats;
+
+	std::sort(samples.begin(), samples.end());
+
+	const size_t last = samples.size() - 1;
+	stats.count = (int32_t)samples.size();
+	stats.p50 = samples[last * 50 / 100];
+	stats.p95 = samples[last * 95 / 100];
+	stats.p99 = samples[last * 99 / 100];
+	stats.max = samples[last];
+	return stats;
+}
+
+
+KnobLatencyTracker::KnobLatencyTracker() : _eventTime(-1.0), _eventValue(0.0), _events(0), _superseded(0)
+{
+	for (int32_t stage = 0; stage < KNOBLATENCY_COUNT; ++stage)
+	{
+		_samples[stage].reserve(KNOBLATENCYTRACKER_RESERVE);
+		_reached[stage] = false;
+	}
+}
+
+void KnobLatencyTracker::StartSession()
+{
+	for (int32_t stage = 0; stage < KNOBLATENCY_COUNT; ++stage)
+	{
+		_samples[stage].clear();
+		_reached[stage] = false;
+	}
+
+	_eventTime = -1.0;
+	_events = 0;
+	_superseded = 0;
+}
+
+void KnobLatencyTracker::BeginEvent(double time, double value)
+{
+	// The previous event will never be shown
+	if (_eventTime >= 0.0 && !_reached[KNOBLATENCY_DRAW])
+		++_superseded;
+
+	_eventTime = time;
+	_eventValue = value;
+	for (int32_t stage = 0; stage < KNOBLATENCY_COUNT; ++stage)
+		_reached[stage] = false;
+
+	++_events;
+}
+
+void KnobLatencyTracker::Mark(KnobLatencyStage stage, double eventTime, double time)
+{
+	if (_eventTime < 0.0 || eventTime != _eventTime || _reached[stage])
+		return;
+
+	_reached[stage] = true;
+	_samples[stage].push_back(time - _eventTime);
+}
+
+void KnobLatencyTracker::MarkValue(KnobLatencyStage stage, double value, double time)
+{
+	if (value != _eventValue)
+		return;
+
+	Mark(stage, _eventTime, time);
+}
+
+KnobLatencyReport KnobLatencyTracker::GetReport() const
+{
+	KnobLatencyReport report;
+	report.events = _events;
+	report.superseded = _superseded;
+
+	std::vector<double> samples;
+	for (int32_t stage = 0; stage < KNOBLATENCY_COUNT; ++stage)
+	{
+		samples = _samples[stage];
+		report.stages[stage] = ComputeLatencyStats(samples);
+	}
+
+	return report;
+}
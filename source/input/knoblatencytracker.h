@@ -0,0 +1,101 @@
+#ifndef KNOBLATENCYTRACKER_H__
+#define KNOBLATENCYTRACKER_H__
+
+#include <stdint.h>
+#include <vector>
+
+
+/// Points on the way from a mouse event to the screen. Each one is measured from the time of the mouse event.
+enum KnobLatencyStage
+{
+	KNOBLATENCY_MESSAGE = 0,  ///< The knob sends the BFM_ACTION message with the new value
+	KNOBLATENCY_COMMAND,      ///< The CustomGUI receives the message in Command()
+	KNOBLATENCY_SETDATA,      ///< The parent has updated the parameter and sends the value back with SetData()
+	KNOBLATENCY_DRAW,         ///< DrawMsg() has put the value on screen
+	KNOBLATENCY_COUNT
+};
+
+
+/// Latency distribution of one stage, in milliseconds
+struct KnobLatencyStats
+{
+	int32_t count;  ///< Number of events that reached the stage
+	double  p50;
+	double  p95;
+	double  p99;
+	double  max;
+
+	KnobLatencyStats() : count(0), p50(0.0), p95(0.0), p99(0.0), max(0.0)
+	{}
+};
+
+
+/// Latencies of a drag session
+struct KnobLatencyReport
+{
+	int32_t events;      ///< Mouse events that changed the value
+	int32_t superseded;  ///< Events that were never drawn, because a newer one came first or the knob looked the same
+	KnobLatencyStats stages[KNOBLATENCY_COUNT];  ///< Latency of each stage
+
+	KnobLatencyReport() : events(0), superseded(0)
+	{}
+};
+
+
+/// Follows each mouse event of a drag session on its way to the screen.
+/// Every event that changes the value gets a timestamp, which is carried along with the value. Each stage
+/// reports the timestamp it has received, and the tracker records the time since the event, but only once
+/// per stage and only for the newest event, because older values will never be shown.
+/// All times are in milliseconds, from the same monotonic clock.
+class KnobLatencyTracker
+{
+public:
+	KnobLatencyTracker();
+
+	/// Start a new drag session and forget the latencies of the previous one
+	void StartSession();
+
+	/// A mouse event has changed the value
+	/// @param[in] time Time of the mouse event
+	/// @param[in] value The new value
+	void BeginEvent(double time, double value);
+
+	/// Return the timestamp of the newest event, to pass it along with the value. -1 if there is none.
+	double GetEventTime() const
+	{
+		return _eventTime;
+	}
+
+	/// Return the value of the newest event
+	double GetEventValue() const
+	{
+		return _eventValue;
+	}
+
+	/// Record that an event has reached a stage
+	/// @param[in] stage The stage
+	/// @param[in] eventTime The timestamp that was passed along, ignored if it doesn't belong to the newest event
+	/// @param[in] time Current time
+	void Mark(KnobLatencyStage stage, double eventTime, double time);
+
+	/// Record that a value has reached a stage, for stages that only get the value and not the timestamp
+	/// @param[in] stage The stage
+	/// @param[in] value The value, ignored if it isn't the value of the newest event
+	/// @param[in] time Current time
+	void MarkValue(KnobLatencyStage stage, double value, double time);
+
+	/// Compute the latencies of the current session
+	/// @return The report
+	KnobLatencyReport GetReport() const;
+
+private:
+	std::vector<double> _samples[KNOBLATENCY_COUNT];  ///< Latencies of all events in the session, for each stage
+	double  _eventTime;                      ///< Timestamp of the newest event, -1 if there is none
+	double  _eventValue;                     ///< Value of the newest event
+	bool    _reached[KNOBLATENCY_COUNT];     ///< Stages the newest event has reached
+	int32_t _events;                         ///< Events in the session
+	int32_t _superseded;                     ///< Events that were never drawn
+};
+
+
+#endif  // KNOBLATENCYTRACKER_H__
@@ -0,0 +1,81 @@
+#ifndef KNOBRECORDINGFORMAT_H__
+#define KNOBRECORDINGFORMAT_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/// Helpers for the text files of drag and controller recordings.
+/// Floating point numbers are written as the hex bits of the double, so they survive the round trip through the file exactly.
+
+
+/// Return the bits of a double as an integer, to write it without rounding
+inline unsigned long long DoubleToBits(double value)
+{
+	unsigned long long bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+/// Parse the hex bits of a double
+/// @param[in] text The text, hex digits without prefix
+/// @param[out] value Receives the value
+/// @return False if the text is not a hex number
+inline bool ParseDoubleBits(const char *text, double &value)
+{
+	char *end = nullptr;
+	const unsigned long long bits = strtoull(text, &end, 16);
+	if (end == text)
+		return false;
+
+	memcpy(&value, &bits, sizeof(value));
+	return true;
+}
+
+/// Split a line into words, in place
+/// @param[in,out] line The line, gets terminated after each word
+/// @param[out] words Receives pointers to the words
+/// @param[in] maxWords Maximum number of words
+/// @return Number of words
+inline int32_t SplitWords(char *line, char **words, int32_t maxWords)
+{
+	int32_t count = 0;
+	char *context = line;
+	while (count < maxWords)
+	{
+		while (*context == ' ' || *context == '\t' || *context == '\r' || *context == '\n')
+			++context;
+		if (*context == 0)
+			break;
+
+		words[count++] = context;
+		while (*context != 0 && *context != ' ' && *context != '\t' && *context != '\r' && *context != '\n')
+			++context;
+		if (*context != 0)
+			*context++ = 0;
+	}
+	return count;
+}
+
+/// Parse a list of words as double bits
+inline bool ParseDoubles(char **words, int32_t count, double *values)
+{
+	for (int32_t i = 0; i < count; ++i)
+	{
+		if (!ParseDoubleBits(words[i], values[i]))
+			return false;
+	}
+	return true;
+}
+
+/// Cut off a comment that starts with '#'
+inline void CutComment(char *line)
+{
+	char *comment = strchr(line, '#');
+	if (comment)
+		*comment = 0;
+}
+
+
+#endif  // KNOBRECORDINGFORMAT_H__
@@ -0,0 +1,44 @@
+#include "knobvaluering.h"
+
+
+KnobValueRing::KnobValueRing(int32_t capacity) : _mask(0), _head(0), _cachedTail(0), _fullCount(0), _tail(0)
+{
+	uint32_t size = 2;
+	while ((int32_t)size < capacity)
+		size *= 2;
+
+	_values.resize(size);
+	_mask = size - 1;
+}
+
+bool KnobValueRing::Push(const KnobControllerValue &value)
+{
+	// The indices run freely and are wrapped when the ring is accessed, so a full ring can be told from an empty one
+	const uint32_t head = _head.load(std::memory_order_relaxed);
+	if (head - _cachedTail > _mask)
+	{
+		_cachedTail = _tail.load(std::memory_order_acquire);
+		if (head - _cachedTail > _mask)
+		{
+			_fullCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+	}
+
+	_values[head & _mask] = value;
+	_head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+int32_t KnobValueRing::Drain(KnobControllerValue &latest)
+{
+	const uint32_t tail = _tail.load(std::memory_order_relaxed);
+	const uint32_t head = _head.load(std::memory_order_acquire);
+	if (head == tail)
+		return 0;
+
+	// Only the latest value counts, the others are skipped without being read
+	latest = _values[(head - 1) & _mask];
+	_tail.store(head, std::memory_order_release);
+	return (int32_t)(head - tail);
+}
@@ -0,0 +1,79 @@
+#ifndef KNOBVALUERING_H__
+#define KNOBVALUERING_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+
+static const int32_t KNOBVALUERING_CAPACITY = 1024;  ///< Default number of values a ring holds. A 1 kHz controller fills it in one second.
+
+
+/// A value from an external controller
+struct KnobControllerValue
+{
+	double time;   ///< When the controller sent the value, in milliseconds
+	double value;  ///< The value, in the range of the parameter
+
+	KnobControllerValue() : time(0.0), value(0.0)
+	{}
+
+	KnobControllerValue(double t, double v) : time(t), value(v)
+	{}
+};
+
+
+/// Lock-free ring buffer that carries controller values from one producer thread to one consumer thread.
+/// The producer pushes every value it gets. The consumer drains the ring once per frame, and only uses the
+/// latest value. Each side only writes its own index, and reads the other one once per call, so a frame
+/// with many values costs the consumer two atomic operations, not two per value.
+/// If the ring is full, Push() fails and the producer has to keep the value and try again later. It must not
+/// drop it: the latest value is the one that counts.
+class KnobValueRing
+{
+public:
+	/// @param[in] capacity Number of values the ring holds, rounded up to a power of 2
+	explicit KnobValueRing(int32_t capacity = KNOBVALUERING_CAPACITY);
+
+	/// Add a value
+	/// @note: Only for the producer thread
+	/// @param[in] value The value
+	/// @return False if the ring is full
+	bool Push(const KnobControllerValue &value);
+
+	/// Take all values out of the ring
+	/// @note: Only for the consumer thread
+	/// @param[out] latest Receives the most recent value, unchanged if the ring is empty
+	/// @return Number of values that were in the ring
+	int32_t Drain(KnobControllerValue &latest);
+
+	/// Return true if there are no values in the ring
+	bool IsEmpty() const
+	{
+		return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+	}
+
+	/// Return the number of values the ring holds
+	int32_t GetCapacity() const
+	{
+		return (int32_t)_values.size();
+	}
+
+	/// Return the number of times Push() found the ring full
+	int64_t GetFullCount() const
+	{
+		return _fullCount.load(std::memory_order_relaxed);
+	}
+
+private:
+	std::vector<KnobControllerValue> _values;  ///< The ring
+	uint32_t              _mask;         ///< Capacity - 1, to wrap the indices
+	std::atomic<uint32_t> _head;         ///< Index of the next value to push, only written by the producer
+	uint32_t              _cachedTail;   ///< The producer's copy of _tail, only read again when the ring looks full
+	std::atomic<int64_t>  _fullCount;    ///< Pushes that found the ring full
+	char                  _padding[64];  ///< Keeps the producer's and the consumer's index off each other's cache line
+	std::atomic<uint32_t> _tail;         ///< Index of the next value to take, only written by the consumer
+};
+
+
+#endif  // KNOBVALUERING_H__
@@ -1,36 +1,48 @@
-#include "c4d.h"
-#include "main.h"
-
-
-#define PLUGIN_VERSION String("RotaryKnob 0.4")
-
-
-Bool PluginStart()
-{
-	// Rotary knob custom gui
-	if (!RegisterRotaryKnobCustomGui())
-		return false;
-
-	// Test object
-	if (!RegisterTestObject())
-		return false;
-
-	GePrint(PLUGIN_VERSION);
-	
-	return true;
-}
-
-void PluginEnd()
-{}
-
-Bool PluginMessage(Int32 id, void* data)
-{
-	switch (id)
-	{
-		case C4DPL_INIT_SYS:
-			if (!resource.Init())
-				return false;		// don't start plugin without resource
-	}
-
-	return false;
-}
+#include "c4d.h"
+#include "main.h"
+
+
+Bool PluginStart()
+{
+	// Rotary knob custom gui
+	if (!RegisterRotaryKnobCustomGui())
+		return false;
+
+	// Test object
+	if (!RegisterTestObject())
+		return false;
+
+	GePrint(String(PLUGIN_VERSION));
+	
+	return true;
+}
+
+void PluginEnd()
+{
+#ifdef MAXON_TARGET_DEBUG
+	// Show how many redraws and messages the knobs have saved
+	PrintKnobChangeCounters();
+#endif
+
+	// All knobs are gone by now, free the canvases they left for reuse
+	FreeKnobCanvasPool();
+	
+	// Stop the render threads and controller replays before the plugin is unloaded
+	FreeKnobRenderThreads();
+	FreeKnobControllerChannels();
+
+	// Nothing uses the knob assets anymore, keep them for the next session
+	SaveKnobAssetCache();
+}
+
+Bool PluginMessage(Int32 id, void* data)
+{
+	switch (id)
+	{
+		case C4DPL_INIT_SYS:
+			if (!resource.Init())
+				return false;		// don't start plugin without resource
+	}
+
+	return false;
+}
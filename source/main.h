@@ -1,9 +1,21 @@
-#ifndef MAIN_H__
-#define MAIN_H__
-
-#include "c4d.h"
-
-Bool RegisterRotaryKnobCustomGui();
-Bool RegisterTestObject();
-
-#endif // MAIN_H__
+#ifndef MAIN_H__
+#define MAIN_H__
+
+#include "c4d.h"
+
+#define PLUGIN_VERSION "RotaryKnob 0.5"
+
+Bool RegisterRotaryKnobCustomGui();
+void PrintKnobChangeCounters();
+Bool DumpKnobInstrumentation(const Filename *file);
+void ResetKnobInstrumentation();
+Bool SaveLastKnobDrag(const Filename &file);
+void FreeKnobCanvasPool();
+void FreeKnobRenderThreads();
+void SaveKnobAssetCache();
+Bool StartKnobControllerReplay(const Filename &file, Int32 channel);
+void StopKnobControllerReplays();
+void FreeKnobControllerChannels();
+Bool RegisterTestObject();
+
+#endif // MAIN_H__
@@ -1,45 +1,98 @@
-#include "c4d.h"
-#include "c4d_symbols.h"
-#include "otest.h"
-#include "main.h"
-
-const Int32 ID_TESTOBJECT = 1038993;
-
-
-/// This plugin implements an object that does absolutely nothing,
-/// it acts simple as a test environment for the CustomGUI.
-class TestObjectData : public ObjectData
-{
-	INSTANCEOF(TestObjectData, ObjectData)
-
-public:
-	virtual Bool Init(GeListNode* node);
-
-	static NodeData* Alloc();
-};
-
-
-// Just set some default values in the three REAL elements
-Bool TestObjectData::Init(GeListNode* node)
-{
-	BaseObject *op = static_cast<BaseObject*>(node);
-	BaseContainer *data = op->GetDataInstance();
-	if (!data)
-		return false;
-
-	data->SetFloat(TEST_PARAM_1, 0.50);
-	data->SetFloat(TEST_PARAM_2, 2.25);
-
-	return true;
-}
-
-NodeData *TestObjectData::Alloc()
-{
-	return NewObjClear(TestObjectData);
-}
-
-
-Bool RegisterTestObject()
-{
-	return RegisterObjectPlugin(ID_TESTOBJECT, GeLoadString(IDS_TESTOBJECT), 0, TestObjectData::Alloc, "Otest", AutoBitmap("otest.tif"), 0);
-}
+#include "c4d.h"
+#include "c4d_symbols.h"
+#include "otest.h"
+#include "main.h"
+
+const Int32 ID_TESTOBJECT = 1038993;
+
+
+/// This plugin implements an object that does absolutely nothing,
+/// it acts simple as a test environment for the CustomGUI.
+class TestObjectData : public ObjectData
+{
+	INSTANCEOF(TestObjectData, ObjectData)
+
+public:
+	virtual Bool Init(GeListNode* node);
+	virtual Bool Message(GeListNode* node, Int32 type, void* data);
+
+	static NodeData* Alloc();
+};
+
+
+// Just set some default values in the three REAL elements
+Bool TestObjectData::Init(GeListNode* node)
+{
+	BaseObject *op = static_cast<BaseObject*>(node);
+	BaseContainer *data = op->GetDataInstance();
+	if (!data)
+		return false;
+
+	data->SetFloat(TEST_PARAM_1, 0.50);
+	data->SetFloat(TEST_PARAM_2, 2.25);
+	data->SetFloat(TEST_PARAM_3, 0.75);
+	data->SetFloat(TEST_PARAM_4, 25.0);
+
+	return true;
+}
+
+// The buttons print, save or reset the draw and input statistics of all knobs, save the last drag for replay,
+// or replay a recorded controller stream into the knob that listens to controller channel 1
+Bool TestObjectData::Message(GeListNode* node, Int32 type, void* data)
+{
+	if (type == MSG_DESCRIPTION_COMMAND && data)
+	{
+		DescriptionCommand *dc = static_cast<DescriptionCommand*>(data);
+		switch (dc->id[0].id)
+		{
+			case TEST_KNOBSTATS_PRINT:
+				DumpKnobInstrumentation(nullptr);
+				break;
+
+			case TEST_KNOBSTATS_SAVE:
+			{
+				Filename file;
+				if (file.FileSelect(FILESELECTTYPE_ANYTHING, FILESELECT_SAVE, "Save knob statistics") && !DumpKnobInstrumentation(&file))
+					GePrint("Could not write " + file.GetString());
+				break;
+			}
+
+			case TEST_KNOBSTATS_SAVEDRAG:
+			{
+				Filename file;
+				if (file.FileSelect(FILESELECTTYPE_ANYTHING, FILESELECT_SAVE, "Save last knob drag") && !SaveLastKnobDrag(file))
+					GePrint("Could not write " + file.GetString());
+				break;
+			}
+
+			case TEST_KNOBSTATS_RESET:
+				ResetKnobInstrumentation();
+				break;
+
+			case TEST_CONTROLLER_REPLAY:
+			{
+				Filename file;
+				if (file.FileSelect(FILESELECTTYPE_ANYTHING, FILESELECT_LOAD, "Replay controller recording") && !StartKnobControllerReplay(file, 1))
+					GePrint("Could not replay " + file.GetString());
+				break;
+			}
+
+			case TEST_CONTROLLER_STOP:
+				StopKnobControllerReplays();
+				break;
+		}
+	}
+
+	return SUPER::Message(node, type, data);
+}
+
+NodeData *TestObjectData::Alloc()
+{
+	return NewObjClear(TestObjectData);
+}
+
+
+Bool RegisterTestObject()
+{
+	return RegisterObjectPlugin(ID_TESTOBJECT, GeLoadString(IDS_TESTOBJECT), 0, TestObjectData::Alloc, "Otest", AutoBitmap("otest.tif"), 0);
+}
@@ -0,0 +1,433 @@
+#include <algorithm>
+#include <new>
+#include "knobassetcache.h"
+
+
+/// The shared cache. A global object instead of a function-local static, which is not thread-safe with every compiler.
+static KnobAssetCache g_sharedKnobAssetCache;
+
+/// Kinds of assets
+static const uint32_t KNOBASSETCACHE_KIND_STATICLAYER = 1;
+static const uint32_t KNOBASSETCACHE_KIND_MARKERATLAS = 2;
+static const uint32_t KNOBASSETCACHE_KIND_GLYPHATLAS = 3;
+
+/// Alignment of keys and assets in the file
+static const size_t KNOBASSETCACHE_ALIGNMENT = 16;
+
+/// First bytes of the file
+static const char KNOBASSETCACHE_MAGIC[8] = { 'K', 'N', 'O', 'B', 'A', 'S', 'S', 'T' };
+
+
+/// Start of the file. It is followed by the index, the entry table and all keys, and then the assets.
+/// The checksum only covers the index, so opening the file doesn't read the assets. Each asset has its own checksum.
+struct KnobAssetFileHeader
+{
+	char     magic[8];    ///< KNOBASSETCACHE_MAGIC
+	uint32_t format;      ///< KNOBASSETCACHE_FORMAT
+	uint32_t entryCount;  ///< Number of assets
+	uint64_t version;     ///< Hash of the plugin and asset version that wrote the file
+	uint64_t fileSize;    ///< Size of the whole file
+	uint64_t indexSize;   ///< Size of the entry table and the keys
+	uint64_t checksum;    ///< Hash of the index
+};
+
+/// An asset in the table after the header. Offsets are from the start of the file.
+struct KnobAssetFileEntry
+{
+	uint32_t kind;        ///< KNOBASSETCACHE_KIND_...
+	uint32_t keySize;     ///< Size of the key
+	uint64_t keyOffset;   ///< Position of the key, in the index
+	uint64_t dataOffset;  ///< Position of the asset, after the index
+	uint64_t dataSize;    ///< Size of the asset
+	uint64_t checksum;    ///< Hash of the asset
+};
+
+
+/// A static layer or atlas that uses pixels in the mapped file, and keeps the file mapped while it is used
+template <class T>
+struct KnobMappedAsset
+{
+	std::shared_ptr<KnobMappedFile> file;   ///< The file
+	T                               asset;  ///< The asset
+};
+
+
+/// Write everything a static layer depends on, the same as what KnobStaticLayerCache tells layers apart by
+static void WriteStaticLayerKey(KnobAssetWriter &key, const KnobDrawValues &drawValues)
+{
+	key.Put(drawValues.areaWidth);
+	key.Put(drawValues.oversampling);
+	key.Put((int32_t)drawValues.antialiasing);
+	key.Put(drawValues.scaleLimitRadians);
+	key.Put(drawValues.scaleTickCount);
+	key.Put(drawValues.knobOuterCorner1);
+	key.Put(drawValues.knobInnerCorner1);
+	key.Put(drawValues.knobCenterCorner1);
+	key.Put(drawValues.areaColor);
+	key.Put(drawValues.scaleColor);
+	key.Put(drawValues.knobOuterColor);
+	key.Put(drawValues.knobInnerColor);
+	key.Put(drawValues.knobCenterColor);
+}
+
+/// Write everything a marker atlas depends on, the same as what AcquireKnobMarkerAtlas() tells atlases apart by
+static void WriteMarkerAtlasKey(KnobAssetWriter &key, const KnobDrawValues &drawValues, int32_t cellCount)
+{
+	WriteStaticLayerKey(key, drawValues);
+	key.Put(drawValues.markerLength);
+	key.Put(drawValues.markerThickness);
+	key.Put(drawValues.markerColor);
+	key.Put(cellCount);
+}
+
+/// Write everything a glyph atlas depends on: the font, and all metrics, so a font that has changed since the last session is noticed
+static void WriteGlyphAtlasKey(KnobAssetWriter &key, KnobGlyphSource &source, const char *sourceName)
+{
+	key.PutBytes(sourceName, strlen(sourceName) + 1);
+	key.Put(source.GetLineHeight());
+	for (const char *ch = KNOBGLYPHATLAS_CHARACTERS; *ch != 0; ++ch)
+		key.Put(source.GetAdvance(*ch));
+}
+
+
+KnobAssetCache::KnobAssetCache() : _version(0)
+{}
+
+bool KnobAssetCache::Open(const char *filename, const char *pluginVersion, uint32_t assetVersion)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_filename = filename;
+	_version = HashKnobAssetBytes(pluginVersion, strlen(pluginVersion), HashKnobAssetBytes(&assetVersion, sizeof(assetVersion)));
+	_file.reset();
+	_fileEntries.clear();
+	_newEntries.clear();
+
+	std::shared_ptr<KnobMappedFile> file = std::make_shared<KnobMappedFile>();
+	if (!file->Open(filename))
+		return false;
+
+	_file = file;
+	if (!ReadFile(_version))
+	{
+		// Another version, or a damaged file. It's replaced by the next Save().
+		_file.reset();
+		_fileEntries.clear();
+		++_stats.rejectedFiles;
+		return false;
+	}
+
+	return true;
+}
+
+bool KnobAssetCache::ReadFile(uint64_t version)
+{
+	const uint8_t *data = _file->GetData();
+	const size_t size = _file->GetSize();
+
+	KnobAssetFileHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+
+	if (memcmp(header.magic, KNOBASSETCACHE_MAGIC, sizeof(header.magic)) != 0 || header.format != KNOBASSETCACHE_FORMAT || header.version != version || header.fileSize != (uint64_t)size)
+		return false;
+	if (header.indexSize > size - sizeof(header) || HashKnobAssetBytes(data + sizeof(header), (size_t)header.indexSize) != header.checksum)
+		return false;
+
+	// Even with the right checksum, nothing is read from outside the index, and no asset from outside the file
+	const size_t indexEnd = sizeof(header) + (size_t)header.indexSize;
+	KnobAssetReader table(data + sizeof(header), (size_t)header.indexSize);
+	for (uint32_t i = 0; i < header.entryCount; ++i)
+	{
+		KnobAssetFileEntry fileEntry;
+		if (!table.Get(fileEntry))
+			return false;
+		if (fileEntry.keyOffset > indexEnd || fileEntry.keySize > indexEnd - fileEntry.keyOffset || fileEntry.dataOffset > size || fileEntry.dataSize > size - fileEntry.dataOffset)
+			return false;
+
+		Entry entry;
+		entry.kind = fileEntry.kind;
+		entry.key.assign(data + fileEntry.keyOffset, data + fileEntry.keyOffset + fileEntry.keySize);
+		entry.data = data + fileEntry.dataOffset;
+		entry.dataSize = (size_t)fileEntry.dataSize;
+		entry.checksum = fileEntry.checksum;
+		_fileEntries.push_back(entry);
+	}
+
+	return true;
+}
+
+bool KnobAssetCache::Save()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	// Without new assets, the file already has everything
+	if (_filename.empty() || _newEntries.empty())
+		return true;
+
+	// The added assets first, newest first, then the ones of the last session that are not replaced by them.
+	// When there are too many, the oldest ones are dropped, and assets that don't fit into the size limit anymore are skipped.
+	std::vector<const Entry*> candidates;
+	for (size_t i = _newEntries.size(); i > 0; --i)
+		candidates.push_back(&_newEntries[i - 1]);
+	for (size_t i = 0; i < _fileEntries.size(); ++i)
+	{
+		bool replaced = false;
+		for (size_t j = 0; j < _newEntries.size() && !replaced; ++j)
+			replaced = _newEntries[j].kind == _fileEntries[i].kind && _newEntries[j].key == _fileEntries[i].key;
+		if (!replaced && !_fileEntries[i].damaged)
+			candidates.push_back(&_fileEntries[i]);
+	}
+	std::vector<const Entry*> entries;
+	int64_t assetBytes = 0;
+	for (size_t i = 0; i < candidates.size() && (int32_t)entries.size() < KNOBASSETCACHE_MAXENTRIES; ++i)
+	{
+		const int64_t entryBytes = (int64_t)(candidates[i]->key.size() + (candidates[i]->data ? candidates[i]->dataSize : candidates[i]->ownData.size()));
+		if (assetBytes + entryBytes > KNOBASSETCACHE_MAXBYTES)
+			continue;
+		assetBytes += entryBytes;
+		entries.push_back(candidates[i]);
+	}
+
+	// Header, table and keys first, the offsets and checksums are filled in below
+	KnobAssetWriter writer;
+	KnobAssetFileHeader header;
+	memcpy(header.magic, KNOBASSETCACHE_MAGIC, sizeof(header.magic));
+	header.format = KNOBASSETCACHE_FORMAT;
+	header.entryCount = (uint32_t)entries.size();
+	header.version = _version;
+	header.fileSize = 0;
+	header.indexSize = 0;
+	header.checksum = 0;
+	writer.Put(header);
+
+	std::vector<KnobAssetFileEntry> table(entries.size());
+	const size_t tableOffset = writer.GetData().size();
+	for (size_t i = 0; i < table.size(); ++i)
+		writer.Put(table[i]);
+
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const Entry &entry = *entries[i];
+		table[i].kind = entry.kind;
+		table[i].keySize = (uint32_t)entry.key.size();
+		table[i].keyOffset = writer.GetData().size();
+		writer.PutBytes(entry.key.empty() ? nullptr : &entry.key[0], entry.key.size());
+	}
+	writer.Align(KNOBASSETCACHE_ALIGNMENT);
+	header.indexSize = writer.GetData().size() - sizeof(header);
+
+	// Assets of the last session keep the checksum from the file, a damaged one that hasn't been used yet stays damaged
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const Entry &entry = *entries[i];
+		const uint8_t *data = entry.data ? entry.data : (entry.ownData.empty() ? nullptr : &entry.ownData[0]);
+		const size_t dataSize = entry.data ? entry.dataSize : entry.ownData.size();
+
+		writer.Align(KNOBASSETCACHE_ALIGNMENT);
+		table[i].dataOffset = writer.GetData().size();
+		table[i].dataSize = dataSize;
+		table[i].checksum = entry.data ? entry.checksum : HashKnobAssetBytes(data, dataSize);
+		writer.PutBytes(data, dataSize);
+	}
+
+	std::vector<uint8_t> &bytes = writer.GetData();
+	if (!table.empty())
+		memcpy(&bytes[tableOffset], &table[0], table.size() * sizeof(KnobAssetFileEntry));
+	header.fileSize = bytes.size();
+	header.checksum = HashKnobAssetBytes(&bytes[sizeof(header)], (size_t)header.indexSize);
+	memcpy(&bytes[0], &header, sizeof(header));
+
+	// The old file has to be let go before it can be replaced
+	_fileEntries.clear();
+	_newEntries.clear();
+	_file.reset();
+
+	return ReplaceKnobAssetFile(_filename.c_str(), &bytes[0], bytes.size());
+}
+
+void KnobAssetCache::Close()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	_filename.clear();
+	_fileEntries.clear();
+	_newEntries.clear();
+	_file.reset();
+}
+
+const KnobAssetCache::Entry *KnobAssetCache::FindEntry(uint32_t kind, const std::vector<uint8_t> &key)
+{
+	for (size_t i = 0; i < _fileEntries.size(); ++i)
+	{
+		Entry &entry = _fileEntries[i];
+		if (entry.kind != kind || entry.key != key)
+			continue;
+
+		// An asset is only checked when it is used the first time, so only the pages of assets that are used are read.
+		// A damaged one is drawn again, like a missing one.
+		if (!entry.verified)
+		{
+			entry.verified = true;
+			entry.damaged = HashKnobAssetBytes(entry.data, entry.dataSize) != entry.checksum;
+			if (entry.damaged)
+				++_stats.rejectedAssets;
+		}
+		if (entry.damaged)
+			break;
+
+		++_stats.hits;
+		return &entry;
+	}
+
+	// Only count misses while there's a file name, before that the cache isn't used at all
+	if (!_filename.empty())
+		++_stats.misses;
+	return nullptr;
+}
+
+void KnobAssetCache::AddEntry(uint32_t kind, const std::vector<uint8_t> &key, std::vector<uint8_t> &data)
+{
+	if (_filename.empty())
+		return;
+
+	// An asset that was dropped from the in-memory caches may be drawn again
+	for (size_t i = 0; i < _newEntries.size(); ++i)
+	{
+		if (_newEntries[i].kind == kind && _newEntries[i].key == key)
+		{
+			_newEntries[i].ownData.swap(data);
+			return;
+		}
+	}
+
+	_newEntries.push_back(Entry());
+	Entry &entry = _newEntries.back();
+	entry.kind = kind;
+	entry.key = key;
+	entry.ownData.swap(data);
+	++_stats.added;
+}
+
+std::shared_ptr<const KnobPixelBuffer> KnobAssetCache::FindStaticLayer(const KnobDrawValues &drawValues)
+{
+	KnobAssetWriter key;
+	WriteStaticLayerKey(key, drawValues);
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	const Entry *entry = FindEntry(KNOBASSETCACHE_KIND_STATICLAYER, key.GetData());
+	if (!entry)
+		return std::shared_ptr<const KnobPixelBuffer>();
+
+	KnobAssetReader reader(entry->data, entry->dataSize);
+	int32_t width = 0, height = 0;
+	reader.Get(width);
+	reader.Get(height);
+	const uint8_t *pixels = reader.IsValid() && width == drawValues.areaWidth && height == drawValues.areaWidth ? reader.GetBytes((size_t)width * (size_t)height * sizeof(KnobColor), sizeof(KnobColor)) : nullptr;
+	if (!pixels)
+		return std::shared_ptr<const KnobPixelBuffer>();
+
+	// The layer is used straight from the file, which stays mapped as long as the layer is used
+	std::shared_ptr<KnobMappedAsset<KnobPixelBuffer> > layer = std::make_shared<KnobMappedAsset<KnobPixelBuffer> >();
+	layer->file = _file;
+	layer->asset.Wrap((const KnobColor*)pixels, width, height);
+	return std::shared_ptr<const KnobPixelBuffer>(layer, &layer->asset);
+}
+
+std::shared_ptr<const KnobMarkerAtlas> KnobAssetCache::FindMarkerAtlas(const KnobDrawValues &drawValues, int32_t cellCount)
+{
+	KnobAssetWriter key;
+	WriteMarkerAtlasKey(key, drawValues, cellCount);
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	const Entry *entry = FindEntry(KNOBASSETCACHE_KIND_MARKERATLAS, key.GetData());
+	if (!entry)
+		return std::shared_ptr<const KnobMarkerAtlas>();
+
+	std::shared_ptr<KnobMappedAsset<KnobMarkerAtlas> > atlas = std::make_shared<KnobMappedAsset<KnobMarkerAtlas> >();
+	KnobAssetReader reader(entry->data, entry->dataSize);
+	if (!atlas->asset.ReadAsset(reader))
+		return std::shared_ptr<const KnobMarkerAtlas>();
+
+	atlas->file = _file;
+	return std::shared_ptr<const KnobMarkerAtlas>(atlas, &atlas->asset);
+}
+
+std::shared_ptr<const KnobGlyphAtlas> KnobAssetCache::FindGlyphAtlas(KnobGlyphSource &source, const char *sourceName)
+{
+	KnobAssetWriter key;
+	WriteGlyphAtlasKey(key, source, sourceName);
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	const Entry *entry = FindEntry(KNOBASSETCACHE_KIND_GLYPHATLAS, key.GetData());
+	if (!entry)
+		return std::shared_ptr<const KnobGlyphAtlas>();
+
+	// Glyph atlases copy their mask, they don't keep the file mapped
+	std::shared_ptr<KnobGlyphAtlas> atlas = std::make_shared<KnobGlyphAtlas>();
+	KnobAssetReader reader(entry->data, entry->dataSize);
+	if (!atlas->ReadAsset(reader))
+		return std::shared_ptr<const KnobGlyphAtlas>();
+
+	return atlas;
+}
+
+void KnobAssetCache::AddStaticLayer(const KnobDrawValues &drawValues, const KnobPixelBuffer &layer)
+{
+	KnobAssetWriter key;
+	WriteStaticLayerKey(key, drawValues);
+
+	KnobAssetWriter data;
+	data.Put(layer.GetWidth());
+	data.Put(layer.GetHeight());
+	data.Align(sizeof(KnobColor));
+	for (int32_t y = 0; y < layer.GetHeight(); ++y)
+		data.PutBytes(layer.GetRow(y), (size_t)layer.GetWidth() * sizeof(KnobColor));
+
+	std::lock_guard<std::mutex> lock(_lock);
+	AddEntry(KNOBASSETCACHE_KIND_STATICLAYER, key.GetData(), data.GetData());
+}
+
+void KnobAssetCache::AddMarkerAtlas(const KnobDrawValues &drawValues, int32_t cellCount, const KnobMarkerAtlas &atlas)
+{
+	KnobAssetWriter key;
+	WriteMarkerAtlasKey(key, drawValues, cellCount);
+
+	KnobAssetWriter data;
+	atlas.WriteAsset(data);
+
+	std::lock_guard<std::mutex> lock(_lock);
+	AddEntry(KNOBASSETCACHE_KIND_MARKERATLAS, key.GetData(), data.GetData());
+}
+
+void KnobAssetCache::AddGlyphAtlas(KnobGlyphSource &source, const char *sourceName, const KnobGlyphAtlas &atlas)
+{
+	KnobAssetWriter key;
+	WriteGlyphAtlasKey(key, source, sourceName);
+
+	KnobAssetWriter data;
+	atlas.WriteAsset(data);
+
+	std::lock_guard<std::mutex> lock(_lock);
+	AddEntry(KNOBASSETCACHE_KIND_GLYPHATLAS, key.GetData(), data.GetData());
+}
+
+KnobAssetCacheStats KnobAssetCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	KnobAssetCacheStats stats = _stats;
+	stats.fileEntries = (int32_t)_fileEntries.size();
+	stats.fileBytes = _file ? (int64_t)_file->GetSize() : 0;
+	return stats;
+}
+
+
+KnobAssetCache &GetSharedKnobAssetCache()
+{
+	return g_sharedKnobAssetCache;
+}
@@ -0,0 +1,139 @@
+#ifndef KNOBASSETCACHE_H__
+#define KNOBASSETCACHE_H__
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "knobassetfile.h"
+#include "knobglyphatlas.h"
+#include "knobmarkeratlas.h"
+#include "knobpainter.h"
+#include "knobpixelbuffer.h"
+
+
+static const uint32_t KNOBASSETCACHE_FORMAT = 2;        ///< Version of the file layout
+static const uint32_t KNOBASSETCACHE_ASSETVERSION = 1;  ///< Version of the drawing code. Increase it whenever a change makes static layers, marker or glyph atlases look different.
+static const int32_t  KNOBASSETCACHE_MAXENTRIES = 64;  ///< Maximum number of assets in a file, the least recently added ones are dropped
+static const int64_t  KNOBASSETCACHE_MAXBYTES = 64 << 20;  ///< Maximum size of the assets in a file, larger ones are skipped
+
+
+/// Counters of a KnobAssetCache
+struct KnobAssetCacheStats
+{
+	int64_t hits;           ///< Assets found in the file
+	int64_t misses;         ///< Assets that were not in the file and had to be drawn
+	int64_t added;          ///< Assets added for the next file
+	int64_t rejectedFiles;  ///< Files that were not used because they were from another version, or their index was damaged
+	int64_t rejectedAssets; ///< Assets in the file that were damaged, and had to be drawn
+	int32_t fileEntries;    ///< Assets in the mapped file
+	int64_t fileBytes;      ///< Size of the mapped file
+
+	KnobAssetCacheStats() : hits(0), misses(0), added(0), rejectedFiles(0), rejectedAssets(0), fileEntries(0), fileBytes(0)
+	{}
+};
+
+
+/// Persistent cache of pre-rendered knob assets: static layers, marker atlases and glyph atlases.
+/// The assets of the last session are memory-mapped read-only from a file, so a knob that
+/// looks like one from the last session doesn't have to draw them again: static layers and
+/// marker atlases are used straight from the mapped file, without copying. Assets are found by
+/// everything they depend on (size, oversampling, colors, ...), and the file as a whole is only
+/// used if it was written by the same plugin version and asset version, and the checksum of its
+/// index is right. Each asset is checked against its own checksum when it is used the first time.
+/// Assets that had to be drawn are added, and written to the file by Save().
+/// Nothing is found or added before Open() has been called. All functions are thread-safe.
+class KnobAssetCache
+{
+public:
+	KnobAssetCache();
+
+	/// Map the file of the last session. Without a valid file, the cache is empty, and Save() writes a new one.
+	/// @param[in] filename The file, UTF-8
+	/// @param[in] pluginVersion Version of the plugin. Files of other versions are not used.
+	/// @param[in] assetVersion KNOBASSETCACHE_ASSETVERSION. Files of other versions are not used, because the assets may look different.
+	/// @return False if the file does not exist, or was not used
+	bool Open(const char *filename, const char *pluginVersion, uint32_t assetVersion);
+
+	/// Write all assets to the file given to Open(): the ones added, and as many of the mapped ones as fit.
+	/// The file is replaced, and the cache is closed afterwards.
+	/// @note: On Windows, the file can only be replaced when no asset from the mapped file is used anymore.
+	/// @return False if the file could not be written
+	bool Save();
+
+	/// Unmap the file and forget the added assets. Assets from the file that are still used stay valid.
+	void Close();
+
+	/// Return the static layer for a set of draw values from the file
+	/// @return The layer, or an empty pointer if it is not in the file
+	std::shared_ptr<const KnobPixelBuffer> FindStaticLayer(const KnobDrawValues &drawValues);
+
+	/// Return the marker atlas for a set of draw values from the file
+	/// @param[in] cellCount The cell count, as given to KnobMarkerAtlas::Build()
+	/// @return The atlas, or an empty pointer if it is not in the file
+	std::shared_ptr<const KnobMarkerAtlas> FindMarkerAtlas(const KnobDrawValues &drawValues, int32_t cellCount);
+
+	/// Return the glyph atlas for a glyph source from the file
+	/// @param[in] source The glyph source, only measured
+	/// @param[in] sourceName Name of the font, to tell sources with the same metrics apart
+	/// @return The atlas, or an empty pointer if it is not in the file
+	std::shared_ptr<const KnobGlyphAtlas> FindGlyphAtlas(KnobGlyphSource &source, const char *sourceName);
+
+	/// Add a static layer for the next file
+	void AddStaticLayer(const KnobDrawValues &drawValues, const KnobPixelBuffer &layer);
+
+	/// Add a marker atlas for the next file
+	void AddMarkerAtlas(const KnobDrawValues &drawValues, int32_t cellCount, const KnobMarkerAtlas &atlas);
+
+	/// Add a glyph atlas for the next file
+	void AddGlyphAtlas(KnobGlyphSource &source, const char *sourceName, const KnobGlyphAtlas &atlas);
+
+	/// Return the counters
+	KnobAssetCacheStats GetStats();
+
+private:
+	/// An asset in the mapped file, or one that has been added
+	struct Entry
+	{
+		uint32_t             kind;      ///< KNOBASSETCACHE_KIND_...
+		std::vector<uint8_t> key;       ///< Everything the asset depends on
+		const uint8_t       *data;      ///< The asset in the mapped file, nullptr for added ones
+		size_t               dataSize;  ///< Size of the asset in the mapped file
+		uint64_t             checksum;  ///< Checksum of the asset in the mapped file
+		bool                 verified;  ///< True if the asset in the mapped file has been checked
+		bool                 damaged;   ///< True if the asset in the mapped file doesn't match its checksum
+		std::vector<uint8_t> ownData;   ///< An added asset
+
+		Entry() : kind(0), data(nullptr), dataSize(0), checksum(0), verified(false), damaged(false)
+		{}
+	};
+
+	/// Look up an asset in the mapped file, and check it if it is used the first time
+	/// @note: _lock must be held
+	/// @return The asset, or nullptr if it is not in the file or damaged
+	const Entry *FindEntry(uint32_t kind, const std::vector<uint8_t> &key);
+
+	/// Add an asset, or replace an added asset with the same key
+	/// @note: _lock must be held
+	void AddEntry(uint32_t kind, const std::vector<uint8_t> &key, std::vector<uint8_t> &data);
+
+	/// Read the entry table of the mapped file, and check everything that can be checked before using it
+	/// @note: _lock must be held
+	bool ReadFile(uint64_t version);
+
+private:
+	std::mutex                      _lock;         ///< Protects everything below
+	std::string                     _filename;     ///< The file given to Open()
+	uint64_t                        _version;      ///< Hash of the versions given to Open()
+	std::shared_ptr<KnobMappedFile> _file;         ///< The mapped file, kept alive by the assets that use it
+	std::vector<Entry>              _fileEntries;  ///< Assets in the mapped file
+	std::vector<Entry>              _newEntries;   ///< Assets added for the next file
+	KnobAssetCacheStats             _stats;        ///< Counters, without fileEntries and fileBytes
+};
+
+
+/// Return the asset cache that all knobs in the process share
+KnobAssetCache &GetSharedKnobAssetCache();
+
+
+#endif  // KNOBASSETCACHE_H__
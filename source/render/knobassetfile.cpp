@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <string>
+#include "knobassetfile.h"
+
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+KnobMappedFile::KnobMappedFile() : _data(nullptr), _size(0), _mapping(nullptr)
+{}
+
+KnobMappedFile::~KnobMappedFile()
+{
+	Close();
+}
+
+#if defined(_WIN32)
+
+/// Convert a UTF-8 path to UTF-16
+static std::wstring GetWidePath(const char *filename)
+{
+	const int length = MultiByteToWideChar(CP_UTF8, 0, filename, -1, nullptr, 0);
+	if (length <= 1)
+		return std::wstring();
+
+	std::vector<wchar_t> path((size_t)length);
+	MultiByteToWideChar(CP_UTF8, 0, filename, -1, &path[0], length);
+	return std::wstring(&path[0]);
+}
+
+bool KnobMappedFile::Open(const char *filename)
+{
+	Close();
+
+	// The path is UTF-8, Windows wants UTF-16
+	const std::wstring path = GetWidePath(filename);
+	if (path.empty())
+		return false;
+
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || (uint64_t)size.QuadPart > (uint64_t)(size_t)-1)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// The mapping keeps the file open, the file handle isn't needed anymore
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	_data = (const uint8_t*)data;
+	_size = (size_t)size.QuadPart;
+	_mapping = mapping;
+	return true;
+}
+
+void KnobMappedFile::Close()
+{
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle((HANDLE)_mapping);
+
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+}
+
+#else
+
+bool KnobMappedFile::Open(const char *filename)
+{
+	Close();
+
+	const int file = open(filename, O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size <= 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// The mapping stays valid after the file is closed
+	void *data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return false;
+
+	_data = (const uint8_t*)data;
+	_size = (size_t)status.st_size;
+	return true;
+}
+
+void KnobMappedFile::Close()
+{
+	if (_data)
+		munmap((void*)_data, _size);
+
+	_data = nullptr;
+	_size = 0;
+}
+
+#endif
+
+
+#if defined(_WIN32)
+
+bool ReplaceKnobAssetFile(const char *filename, const void *data, size_t size)
+{
+	const std::wstring path = GetWidePath(filename);
+	if (path.empty())
+		return false;
+	const std::wstring temporaryPath = path + L".tmp";
+
+	FILE *file = _wfopen(temporaryPath.c_str(), L"wb");
+	if (!file)
+		return false;
+	const bool written = fwrite(data, 1, size, file) == size;
+	if (fclose(file) != 0 || !written || !MoveFileExW(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		_wremove(temporaryPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+#else
+
+bool ReplaceKnobAssetFile(const char *filename, const void *data, size_t size)
+{
+	const std::string temporaryPath = std::string(filename) + ".tmp";
+
+	FILE *file = fopen(temporaryPath.c_str(), "wb");
+	if (!file)
+		return false;
+	const bool written = fwrite(data, 1, size, file) == size;
+	if (fclose(file) != 0 || !written || rename(temporaryPath.c_str(), filename) != 0)
+	{
+		remove(temporaryPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+#endif
+
+
+const uint8_t *KnobAssetReader::GetBytes(size_t size, size_t alignment)
+{
+	if (_failed)
+		return nullptr;
+
+	const size_t offset = (_offset + alignment - 1) / alignment * alignment;
+	if (offset > _size || size > _size - offset)
+	{
+		_failed = true;
+		return nullptr;
+	}
+
+	_offset = offset + size;
+	return _data + offset;
+}
+
+
+uint64_t HashKnobAssetBytes(const void *data, size_t size, uint64_t seed)
+{
+	// FNV-1a on 64 bit words, the files are several megabytes and are hashed every time the plugin starts
+	const uint8_t *bytes = (const uint8_t*)data;
+	uint64_t hash = seed;
+
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, 8);
+		hash = (hash ^ word) * 1099511628211ULL;
+	}
+	for (; i < size; ++i)
+		hash = (hash ^ bytes[i]) * 1099511628211ULL;
+
+	return hash ^ (hash >> 29);
+}
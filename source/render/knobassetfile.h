@@ -0,0 +1,147 @@
+#ifndef KNOBASSETFILE_H__
+#define KNOBASSETFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+
+/// A file mapped into memory, read-only. The operating system only reads the pages that are touched.
+class KnobMappedFile
+{
+public:
+	KnobMappedFile();
+	~KnobMappedFile();
+
+	/// Map a whole file
+	/// @param[in] filename The file, UTF-8
+	/// @return False if the file does not exist, is empty or could not be mapped
+	bool Open(const char *filename);
+
+	/// Unmap the file
+	void Close();
+
+	/// Return the first byte of the file, or nullptr if no file is mapped
+	const uint8_t *GetData() const
+	{
+		return _data;
+	}
+
+	/// Return the size of the file in bytes
+	size_t GetSize() const
+	{
+		return _size;
+	}
+
+private:
+	KnobMappedFile(const KnobMappedFile&);
+	KnobMappedFile &operator =(const KnobMappedFile&);
+
+private:
+	const uint8_t *_data;     ///< The mapped file
+	size_t         _size;     ///< Size of the file
+	void          *_mapping;  ///< Mapping handle on Windows, unused elsewhere
+};
+
+
+/// Appends values to a block of bytes, e.g. an asset or a key in a KnobAssetCache file
+class KnobAssetWriter
+{
+public:
+	/// Append a value as it is in memory
+	template <class T>
+	void Put(const T &value)
+	{
+		PutBytes(&value, sizeof(T));
+	}
+
+	/// Append bytes
+	void PutBytes(const void *data, size_t size)
+	{
+		const size_t offset = _data.size();
+		_data.resize(offset + size);
+		if (size > 0)
+			memcpy(&_data[offset], data, size);
+	}
+
+	/// Append zeros up to the next multiple of an alignment, relative to the start of the block
+	void Align(size_t alignment)
+	{
+		_data.resize((_data.size() + alignment - 1) / alignment * alignment, 0);
+	}
+
+	/// Return the bytes written so far
+	const std::vector<uint8_t> &GetData() const
+	{
+		return _data;
+	}
+
+	std::vector<uint8_t> &GetData()
+	{
+		return _data;
+	}
+
+private:
+	std::vector<uint8_t> _data;  ///< The block
+};
+
+
+/// Reads values from a block of bytes written by a KnobAssetWriter. Never reads past the end of the block:
+/// once a read fails, all further reads fail, too.
+class KnobAssetReader
+{
+public:
+	/// @param[in] data The block
+	/// @param[in] size Size of the block
+	KnobAssetReader(const uint8_t *data, size_t size) : _data(data), _size(size), _offset(0), _failed(false)
+	{}
+
+	/// Read a value
+	/// @return False if the block ends before the value
+	template <class T>
+	bool Get(T &value)
+	{
+		const uint8_t *bytes = GetBytes(sizeof(T), 1);
+		if (!bytes)
+			return false;
+		memcpy(&value, bytes, sizeof(T));
+		return true;
+	}
+
+	/// Skip to the next multiple of an alignment, and return a pointer to the next bytes without copying them
+	/// @param[in] size Number of bytes
+	/// @param[in] alignment Alignment, relative to the start of the block, as used with KnobAssetWriter::Align()
+	/// @return The bytes, or nullptr if the block ends before
+	const uint8_t *GetBytes(size_t size, size_t alignment);
+
+	/// Return true if all reads so far have succeeded
+	bool IsValid() const
+	{
+		return !_failed;
+	}
+
+private:
+	const uint8_t *_data;    ///< The block
+	size_t         _size;    ///< Size of the block
+	size_t         _offset;  ///< Position of the next read
+	bool           _failed;  ///< True if a read went past the end
+};
+
+
+/// Write a file by writing a temporary file next to it first, and replacing the file with it.
+/// Readers never see a partly written file this way.
+/// @param[in] filename The file, UTF-8
+/// @param[in] data The contents
+/// @param[in] size Size of the contents
+/// @return False if the file could not be written or replaced
+bool ReplaceKnobAssetFile(const char *filename, const void *data, size_t size);
+
+/// Return a 64 bit hash of a block of bytes
+/// @param[in] data The bytes
+/// @param[in] size Number of bytes
+/// @param[in] seed Hash of the bytes before, to hash several blocks as one
+uint64_t HashKnobAssetBytes(const void *data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+
+#endif  // KNOBASSETFILE_H__
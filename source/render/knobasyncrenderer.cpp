@@ -0,0 +1,112 @@
+#include "knobasyncrenderer.h"
+#include "knobstaticlayercache.h"
+
+
+KnobAsyncRenderer::KnobAsyncRenderer() : _sequence(0), _hasFrame(false), _quit(false), _requestCount(0), _presentedCount(0), _renderedCount(0)
+{
+	_thread = std::thread(&KnobAsyncRenderer::RenderThread, this);
+}
+
+KnobAsyncRenderer::~KnobAsyncRenderer()
+{
+	{
+		std::lock_guard<std::mutex> lock(_wakeLock);
+		_quit = true;
+	}
+	_wake.notify_one();
+	_thread.join();
+}
+
+uint64_t KnobAsyncRenderer::Request(const KnobFrameRequest &request)
+{
+	KnobFrameRequest &slot = _requests.GetWriteSlot();
+	slot = request;
+	slot.sequence = ++_sequence;
+	_requests.Publish();
+	++_requestCount;
+
+	// The render thread only holds the lock while it checks for requests, so this doesn't wait for a frame to be rendered
+	{
+		std::lock_guard<std::mutex> lock(_wakeLock);
+	}
+	_wake.notify_one();
+
+	return _sequence;
+}
+
+const KnobAsyncFrame *KnobAsyncRenderer::FetchFrame()
+{
+	if (_frames.Fetch())
+	{
+		_hasFrame = true;
+		++_presentedCount;
+	}
+
+	return _hasFrame ? &_frames.GetReadSlot() : nullptr;
+}
+
+KnobAsyncRendererStats KnobAsyncRenderer::GetStats() const
+{
+	KnobAsyncRendererStats stats;
+	stats.requests = _requestCount;
+	stats.rendered = _renderedCount.load();
+	stats.presented = _presentedCount;
+	return stats;
+}
+
+void KnobAsyncRenderer::RenderThread()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_wakeLock);
+			_wake.wait(lock, [this] { return _quit || _requests.HasMessage(); });
+			if (_quit)
+				return;
+		}
+
+		// Only the latest request counts, older ones have been replaced
+		_requests.Fetch();
+		KnobFrameRequest &request = _requests.GetReadSlot();
+
+		KnobAsyncFrame &frame = _frames.GetWriteSlot();
+		frame.owner = request.owner;
+		frame.sequence = request.sequence;
+		frame.value = request.value;
+		frame.state = request.state;
+		frame.valid = RenderFrame(request, frame);
+		_frames.Publish();
+		++_renderedCount;
+
+		// Don't keep the knob's draw values and atlases alive longer than needed, the static layer holds on to its own
+		request.drawValues.reset();
+		request.markerAtlas.reset();
+		request.glyphs.reset();
+	}
+}
+
+bool KnobAsyncRenderer::RenderFrame(const KnobFrameRequest &request, KnobAsyncFrame &frame)
+{
+	if (!request.drawValues)
+		return false;
+	const KnobDrawValues &drawValues = *request.drawValues;
+
+	_rasterizer.SetTarget(&frame.pixels);
+
+	// The static layer only changes when another knob (or the same knob with a new theme) is dragged
+	if (_staticLayer != request.drawValues)
+	{
+		_staticLayer.reset();
+		const std::shared_ptr<const KnobPixelBuffer> layer = GetSharedKnobStaticLayerCache().Acquire(drawValues);
+		if (!layer)
+			return false;
+		_rasterizer.SetAntialiasing(drawValues.antialiasing);
+		_rasterizer.SetStaticLayer(layer);
+		_staticLayer = request.drawValues;
+	}
+
+	if (request.markerAtlas)
+		return DrawKnobAtlasFrame(_rasterizer, drawValues, *request.markerAtlas, request.angle, request.state.label, request.glyphs.get());
+
+	return DrawKnobLayeredFrame(_rasterizer, drawValues, request.angle, request.state.label, request.glyphs.get());
+}
@@ -0,0 +1,119 @@
+#ifndef KNOBASYNCRENDERER_H__
+#define KNOBASYNCRENDERER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "knobglyphatlas.h"
+#include "knobmailbox.h"
+#include "knobmarkeratlas.h"
+#include "knobpainter.h"
+#include "knobrasterizer.h"
+
+
+/// What a knob wants to see in its next frame
+struct KnobFrameRequest
+{
+	const void     *owner;     ///< The knob that asked for the frame, only used to tell frames of different knobs apart
+	uint64_t        sequence;  ///< Number of the request, assigned by KnobAsyncRenderer::Request()
+	double          value;     ///< The value the frame shows, for latency tracing
+	double          angle;     ///< Marker angle, as returned by KnobValueToAngle()
+	KnobVisualState state;     ///< What the frame looks like, including the label
+	std::shared_ptr<const KnobDrawValues>  drawValues;   ///< Geometry and colors
+	std::shared_ptr<const KnobMarkerAtlas> markerAtlas;  ///< Marker atlas, or empty to draw the marker
+	std::shared_ptr<const KnobGlyphAtlas>  glyphs;       ///< Glyph atlas for the label, or empty for the built-in font
+
+	KnobFrameRequest() : owner(nullptr), sequence(0), value(0.0), angle(0.0)
+	{}
+};
+
+
+/// A frame rendered by the KnobAsyncRenderer
+struct KnobAsyncFrame
+{
+	const void     *owner;     ///< The knob that asked for the frame
+	uint64_t        sequence;  ///< Number of the request
+	double          value;     ///< The value the frame shows
+	KnobVisualState state;     ///< What the frame looks like
+	KnobPixelBuffer pixels;    ///< The frame, reused for later frames
+	bool            valid;     ///< False if the frame could not be rendered
+
+	KnobAsyncFrame() : owner(nullptr), sequence(0), value(0.0), valid(false)
+	{}
+};
+
+
+/// Counters of a KnobAsyncRenderer
+struct KnobAsyncRendererStats
+{
+	int64_t requests;    ///< Frames requested
+	int64_t rendered;    ///< Frames rendered. Requests that are replaced by a newer one before the thread gets to them are not.
+	int64_t presented;   ///< New frames taken by FetchFrame()
+
+	KnobAsyncRendererStats() : requests(0), rendered(0), presented(0)
+	{}
+};
+
+
+/// Renders knob frames on a thread of its own, into a back buffer, while the calling thread handles input.
+/// Requests go to the render thread through a lock-free mailbox, and finished frames come back through
+/// another one. Both only keep the latest message, so a request the thread hasn't started yet is replaced
+/// by a newer one, and a frame that is finished before the last one was shown is shown instead.
+/// Request() never waits for rasterization, and FetchFrame() never waits for a frame to finish: it
+/// returns the most recent completed one.
+/// All functions except the constructor and destructor are for a single thread, the one that handles input.
+class KnobAsyncRenderer
+{
+public:
+	/// Start the render thread
+	KnobAsyncRenderer();
+
+	/// Stop the render thread
+	~KnobAsyncRenderer();
+
+	/// Ask for a frame. Replaces a request that the render thread hasn't started yet.
+	/// @param[in] request What to draw. owner, drawValues and angle have to be set, the sequence is assigned.
+	/// @return The sequence number of the request
+	uint64_t Request(const KnobFrameRequest &request);
+
+	/// Return true if a frame has been finished that FetchFrame() hasn't returned yet
+	bool HasNewFrame() const
+	{
+		return _frames.HasMessage();
+	}
+
+	/// Return the most recent finished frame
+	/// @return The frame, valid until the next call. nullptr if no frame has been finished yet.
+	const KnobAsyncFrame *FetchFrame();
+
+	/// Return the counters
+	KnobAsyncRendererStats GetStats() const;
+
+private:
+	/// Wait for requests and render them, until the renderer is destroyed
+	void RenderThread();
+
+	/// Render a request into a frame
+	/// @return False if the frame could not be rendered
+	bool RenderFrame(const KnobFrameRequest &request, KnobAsyncFrame &frame);
+
+private:
+	KnobMailbox<KnobFrameRequest>  _requests;     ///< Requests from the input thread
+	KnobMailbox<KnobAsyncFrame>    _frames;       ///< Finished frames for the input thread
+	uint64_t                       _sequence;     ///< Number of the last request
+	bool                           _hasFrame;     ///< True if FetchFrame() has fetched a frame
+	KnobRasterizer                 _rasterizer;   ///< Draws the frames, only used by the render thread
+	std::shared_ptr<const KnobDrawValues> _staticLayer;  ///< Draw values the rasterizer's static layer belongs to
+	std::mutex                     _wakeLock;     ///< Only for sleeping and waking up the render thread, never held while rendering
+	std::condition_variable        _wake;         ///< Signals a new request, or the end of the renderer
+	bool                           _quit;         ///< True if the render thread should end
+	int64_t                        _requestCount;   ///< Frames requested
+	int64_t                        _presentedCount; ///< Frames fetched
+	std::atomic<int64_t>           _renderedCount;  ///< Frames rendered, counted by the render thread
+	std::thread                    _thread;       ///< The render thread, started last
+};
+
+
+#endif  // KNOBASYNCRENDERER_H__
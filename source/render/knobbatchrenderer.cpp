@@ -0,0 +1,72 @@
+#include "knobbatchrenderer.h"
+#include "knobbufferpool.h"
+#include "knobstaticlayercache.h"
+
+
+KnobBatchRenderer::KnobBatchRenderer(int32_t threadCount) : _pool(threadCount), _workers((size_t)_pool.GetWorkerCount())
+{}
+
+int32_t KnobBatchRenderer::Render(KnobBatchItem *items, int32_t count)
+{
+	if (!items || count <= 0)
+		return 0;
+
+	RenderJob job(*this, items);
+	_pool.Run(count, job);
+	return job.GetRendered();
+}
+
+void KnobBatchRenderer::FreeStaticLayers()
+{
+	for (size_t i = 0; i < _workers.size(); ++i)
+	{
+		_workers[i].rasterizer.FreeStaticLayer();
+		_workers[i].staticLayer.reset();
+	}
+}
+
+void KnobBatchRenderer::RenderJob::Execute(int32_t index, int32_t worker)
+{
+	if (_renderer.RenderItem(_renderer._workers[worker], _items[index]))
+		++_rendered;
+}
+
+bool KnobBatchRenderer::RenderItem(Worker &worker, KnobBatchItem &item)
+{
+	if (item.drawValues && !item.frame)
+		item.frame = GetSharedKnobBufferPool().Acquire(item.drawValues->areaWidth, item.drawValues->areaWidth);
+
+	if (!item.drawValues || !item.frame || !DrawItem(worker, item))
+	{
+		GetSharedKnobBufferPool().Release(item.frame);
+		item.frame = nullptr;
+		return false;
+	}
+	return true;
+}
+
+bool KnobBatchRenderer::DrawItem(Worker &worker, const KnobBatchItem &item)
+{
+	const KnobDrawValues &drawValues = *item.drawValues;
+	KnobRasterizer &rasterizer = worker.rasterizer;
+	rasterizer.SetTarget(item.frame);
+
+	// Knobs of the same size and theme share their draw values, so most of the time the worker's static layer fits.
+	// If not, the layer comes from the shared cache, where it is only drawn once for all workers.
+	if (worker.staticLayer != item.drawValues)
+	{
+		worker.staticLayer.reset();
+		const std::shared_ptr<const KnobPixelBuffer> layer = GetSharedKnobStaticLayerCache().Acquire(drawValues);
+		if (!layer)
+			return false;
+		rasterizer.SetAntialiasing(drawValues.antialiasing);
+		rasterizer.SetStaticLayer(layer);
+		worker.staticLayer = item.drawValues;
+	}
+
+	const bool drawn = item.markerAtlas ? DrawKnobAtlasFrame(rasterizer, drawValues, *item.markerAtlas, item.angle, item.label, item.glyphs)
+		: DrawKnobLayeredFrame(rasterizer, drawValues, item.angle, item.label, item.glyphs);
+
+	rasterizer.SetTarget(nullptr);
+	return drawn;
+}
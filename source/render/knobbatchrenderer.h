@@ -0,0 +1,109 @@
+#ifndef KNOBBATCHRENDERER_H__
+#define KNOBBATCHRENDERER_H__
+
+#include <memory>
+#include <vector>
+#include "knobpainter.h"
+#include "knoblabel.h"
+#include "knobmarkeratlas.h"
+#include "knobrasterizer.h"
+#include "knobthreadpool.h"
+
+
+static const int32_t KNOBBATCH_MINITEMS = 4;  ///< Fewer knobs than this are not worth waking up the threads for
+
+
+/// A knob frame to render in a batch
+struct KnobBatchItem
+{
+	std::shared_ptr<const KnobDrawValues> drawValues;  ///< Geometry and colors
+	const KnobMarkerAtlas *markerAtlas;  ///< Marker atlas, or nullptr to draw the marker
+	const KnobGlyphAtlas  *glyphs;       ///< Glyph atlas for the label, or nullptr for the built-in font
+	double                 angle;        ///< Marker angle, as returned by KnobValueToAngle()
+	char                   label[KNOBLABEL_MAXLENGTH];  ///< The value label
+	KnobPixelBuffer       *frame;        ///< Receives the frame, from the shared buffer pool. Must be given back with KnobBufferPool::Release().
+
+	KnobBatchItem() : markerAtlas(nullptr), glyphs(nullptr), angle(0.0), frame(nullptr)
+	{
+		label[0] = 0;
+	}
+};
+
+
+/// Renders many knob frames at once, in parallel, each into its own buffer.
+/// Used when lots of knobs change together, e.g. when a preset is loaded. Each worker has its own
+/// KnobRasterizer, which takes a static layer from the shared KnobStaticLayerCache when the worker
+/// gets a knob with different draw values. Everything else the items point to is only read.
+class KnobBatchRenderer
+{
+public:
+	/// @param[in] threadCount Number of threads including the calling thread, 0 for one per hardware thread
+	explicit KnobBatchRenderer(int32_t threadCount = 0);
+
+	/// Return the number of threads that render, including the calling thread
+	int32_t GetThreadCount() const
+	{
+		return _pool.GetWorkerCount();
+	}
+
+	/// Render the frames of all items. Returns when all frames are done, so the calling thread can present them.
+	/// Items that already have a frame are drawn into it, all others get one from the shared buffer pool.
+	/// @param[in,out] items The knobs, receive their frames. Items whose frame could not be rendered get nullptr.
+	/// @param[in] count Number of items
+	/// @return Number of frames that were rendered
+	int32_t Render(KnobBatchItem *items, int32_t count);
+
+	/// Return the number of times a thread had to take over knobs from a slower one
+	int64_t GetStealCount() const
+	{
+		return _pool.GetStealCount();
+	}
+
+	/// Release the static layers of all workers
+	void FreeStaticLayers();
+
+private:
+	/// Rendering state of one worker
+	struct Worker
+	{
+		KnobRasterizer rasterizer;  ///< Draws the frames
+		std::shared_ptr<const KnobDrawValues> staticLayer;  ///< Draw values the rasterizer's static layer belongs to
+		char padding[64];           ///< Keeps the state of neighboring workers off each other's cache lines
+	};
+
+	/// The job the thread pool runs
+	class RenderJob : public KnobParallelJob
+	{
+	public:
+		RenderJob(KnobBatchRenderer &renderer, KnobBatchItem *items) : _renderer(renderer), _items(items), _rendered(0)
+		{}
+
+		virtual void Execute(int32_t index, int32_t worker);
+
+		/// Return the number of rendered frames
+		int32_t GetRendered() const
+		{
+			return _rendered.load();
+		}
+
+	private:
+		KnobBatchRenderer    &_renderer;
+		KnobBatchItem        *_items;
+		std::atomic<int32_t>  _rendered;
+	};
+
+	/// Render the frame of one item. If that fails, the item's frame is given back.
+	/// @return False if the frame could not be rendered
+	bool RenderItem(Worker &worker, KnobBatchItem &item);
+
+	/// Draw the static layer if needed, and the frame of an item into its buffer
+	/// @return False if something could not be drawn
+	bool DrawItem(Worker &worker, const KnobBatchItem &item);
+
+private:
+	KnobThreadPool       _pool;     ///< Runs the jobs
+	std::vector<Worker>  _workers;  ///< One per thread of the pool
+};
+
+
+#endif  // KNOBBATCHRENDERER_H__
@@ -0,0 +1,120 @@
+#include <new>
+#include "knobbufferpool.h"
+
+
+/// The shared pool. A global object instead of a function-local static, which is not thread-safe with every compiler.
+static KnobBufferPool g_sharedKnobBufferPool;
+
+
+KnobBufferPool::KnobBufferPool()
+{}
+
+KnobBufferPool::~KnobBufferPool()
+{
+	Clear();
+}
+
+int32_t KnobBufferPool::GetBucket(size_t pixelCount)
+{
+	int32_t bucket = 0;
+	while (bucket < KNOBBUFFERPOOL_BUCKETS && ((size_t)1 << bucket) < pixelCount)
+		++bucket;
+
+	return bucket < KNOBBUFFERPOOL_BUCKETS ? bucket : -1;
+}
+
+KnobPixelBuffer *KnobBufferPool::Acquire(int32_t width, int32_t height)
+{
+	if (width <= 0 || height <= 0)
+		return nullptr;
+
+	const int32_t bucket = GetBucket((size_t)width * (size_t)height);
+	if (bucket < 0)
+		return nullptr;
+
+	KnobPixelBuffer *buffer = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		++_stats.acquires;
+
+		std::vector<KnobPixelBuffer*> &buffers = _buckets[bucket];
+		if (!buffers.empty())
+		{
+			buffer = buffers.back();
+			buffers.pop_back();
+			--_stats.pooledCount;
+			_stats.pooledBytes -= (int64_t)buffer->GetMemorySize();
+		}
+		else
+		{
+			++_stats.allocations;
+		}
+	}
+
+	// New buffers get the full bucket size, so they fit any size that maps to the bucket
+	if (!buffer)
+	{
+		buffer = new (std::nothrow) KnobPixelBuffer();
+		if (!buffer)
+			return nullptr;
+		buffer->Reserve((size_t)1 << bucket);
+	}
+
+	buffer->Init(width, height);
+	return buffer;
+}
+
+void KnobBufferPool::Release(KnobPixelBuffer *buffer)
+{
+	if (!buffer)
+		return;
+
+	// The largest bucket the buffer can serve without reallocating
+	const size_t capacity = buffer->GetMemorySize() / sizeof(KnobColor);
+	int32_t bucket = -1;
+	while (bucket + 1 < KNOBBUFFERPOOL_BUCKETS && ((size_t)1 << (bucket + 1)) <= capacity)
+		++bucket;
+
+	if (bucket >= 0)
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		std::vector<KnobPixelBuffer*> &buffers = _buckets[bucket];
+		if ((int32_t)buffers.size() < KNOBBUFFERPOOL_MAXPERBUCKET)
+		{
+			buffers.push_back(buffer);
+			++_stats.pooledCount;
+			_stats.pooledBytes += (int64_t)buffer->GetMemorySize();
+			return;
+		}
+	}
+
+	delete buffer;
+}
+
+void KnobBufferPool::Clear()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	for (int32_t bucket = 0; bucket < KNOBBUFFERPOOL_BUCKETS; ++bucket)
+	{
+		for (size_t i = 0; i < _buckets[bucket].size(); ++i)
+			delete _buckets[bucket][i];
+		_buckets[bucket].clear();
+	}
+
+	_stats.pooledCount = 0;
+	_stats.pooledBytes = 0;
+}
+
+KnobBufferPoolStats KnobBufferPool::GetStats()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _stats;
+}
+
+
+KnobBufferPool &GetSharedKnobBufferPool()
+{
+	return g_sharedKnobBufferPool;
+}
@@ -0,0 +1,68 @@
+#ifndef KNOBBUFFERPOOL_H__
+#define KNOBBUFFERPOOL_H__
+
+#include <mutex>
+#include <vector>
+#include "knobpixelbuffer.h"
+
+
+static const int32_t KNOBBUFFERPOOL_BUCKETS = 25;        ///< Number of size buckets, the largest one holds 2^24 pixels
+static const int32_t KNOBBUFFERPOOL_MAXPERBUCKET = 4;    ///< Maximum number of unused buffers kept per bucket, all others are freed
+
+
+/// Allocation counters of a KnobBufferPool
+struct KnobBufferPoolStats
+{
+	int64_t acquires;     ///< Number of buffers handed out
+	int64_t allocations;  ///< Number of buffers that had to be allocated, because the bucket was empty
+	int32_t pooledCount;  ///< Unused buffers in the pool
+	int64_t pooledBytes;  ///< Memory of the unused buffers
+
+	KnobBufferPoolStats() : acquires(0), allocations(0), pooledCount(0), pooledBytes(0)
+	{}
+};
+
+
+/// Pool of pixel buffers for drawing frames, shared by all knobs.
+/// Buffers are sorted into buckets by their pixel count, rounded up to the next power of two.
+/// A buffer from a bucket can hold any size up to the bucket size, so once every bucket
+/// that is used has a buffer, drawing frames doesn't allocate memory anymore. Buffers are
+/// handed out with whatever pixels they had before, they are not cleared.
+class KnobBufferPool
+{
+public:
+	KnobBufferPool();
+	~KnobBufferPool();
+
+	/// Get a buffer, initialized to the given size
+	/// @param[in] width Width in pixels
+	/// @param[in] height Height in pixels
+	/// @return The buffer, or nullptr if the size is invalid. Must be given back with Release().
+	KnobPixelBuffer *Acquire(int32_t width, int32_t height);
+
+	/// Give a buffer back to the pool
+	/// @param[in] buffer The buffer, may be nullptr
+	void Release(KnobPixelBuffer *buffer);
+
+	/// Free all unused buffers
+	void Clear();
+
+	/// Return the allocation counters
+	KnobBufferPoolStats GetStats();
+
+private:
+	/// Return the bucket for a number of pixels, or -1 if it's too big
+	static int32_t GetBucket(size_t pixelCount);
+
+private:
+	std::mutex                      _lock;                             ///< Protects everything below
+	std::vector<KnobPixelBuffer*>   _buckets[KNOBBUFFERPOOL_BUCKETS];  ///< Unused buffers, by size
+	KnobBufferPoolStats             _stats;                            ///< Allocation counters
+};
+
+
+/// Return the pool that all knobs in the process share
+KnobBufferPool &GetSharedKnobBufferPool();
+
+
+#endif  // KNOBBUFFERPOOL_H__
@@ -0,0 +1,52 @@
+#include "knobfont.h"
+
+
+/// A glyph of the built-in font
+struct KnobFontGlyph
+{
+	char    ch;                         ///< The character
+	uint8_t rows[KNOBFONT_GLYPHHEIGHT]; ///< Bitmap, one byte per row
+};
+
+
+/// 5x7 pixel glyphs for all characters that can appear in a value label
+static const KnobFontGlyph g_knobFontGlyphs[] =
+{
+	{ ' ',    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } },
+	{ '0',    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E } },
+	{ '1',    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E } },
+	{ '2',    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F } },
+	{ '3',    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E } },
+	{ '4',    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 } },
+	{ '5',    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E } },
+	{ '6',    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E } },
+	{ '7',    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+	{ '8',    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E } },
+	{ '9',    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C } },
+	{ '-',    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 } },
+	{ '+',    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 } },
+	{ '.',    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C } },
+	{ ',',    { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 } },
+	{ '%',    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 } },
+	{ 'E',    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F } },
+	{ 'c',    { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E } },
+	{ 'e',    { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E } },
+	{ 'g',    { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E } },
+	{ 'k',    { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 } },
+	{ 'm',    { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 } },
+	{ 's',    { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E } },
+	{ '\xB0', { 0x0C, 0x12, 0x12, 0x0C, 0x00, 0x00, 0x00 } }
+};
+
+
+const uint8_t *GetKnobFontGlyph(char ch)
+{
+	const int32_t glyphCount = (int32_t)(sizeof(g_knobFontGlyphs) / sizeof(KnobFontGlyph));
+	for (int32_t i = 0; i < glyphCount; ++i)
+	{
+		if (g_knobFontGlyphs[i].ch == ch)
+			return g_knobFontGlyphs[i].rows;
+	}
+
+	return nullptr;
+}
@@ -0,0 +1,31 @@
+#ifndef KNOBFONT_H__
+#define KNOBFONT_H__
+
+#include <stdint.h>
+
+
+// Metrics of the built-in bitmap font, in font pixels
+static const int32_t KNOBFONT_GLYPHWIDTH = 5;   ///< Width of a glyph bitmap
+static const int32_t KNOBFONT_GLYPHHEIGHT = 7;  ///< Height of a glyph bitmap
+static const int32_t KNOBFONT_ADVANCE = 6;      ///< Horizontal distance from one glyph to the next
+static const int32_t KNOBFONT_LINEHEIGHT = 9;   ///< Height of a line of text
+
+
+/// Return the bitmap of a glyph in the built-in font.
+/// The font covers everything a value label can contain: digits, sign, decimal separators,
+/// exponent, and the characters of the common unit suffixes.
+/// @param[in] ch The character (Latin-1, 0xB0 is the degree sign)
+/// @return Pointer to KNOBFONT_GLYPHHEIGHT rows, bit 4 of each row is the leftmost pixel. Or nullptr, if the character is not in the font.
+const uint8_t *GetKnobFontGlyph(char ch);
+
+/// Return the integer factor by which the font pixels are scaled for a font size
+/// @param[in] fontSize The font size (i.e. the desired line height in pixels)
+/// @return The scale factor, at least 1
+inline int32_t GetKnobFontScale(int32_t fontSize)
+{
+	const int32_t scale = fontSize / KNOBFONT_LINEHEIGHT;
+	return scale < 1 ? 1 : scale;
+}
+
+
+#endif  // KNOBFONT_H__
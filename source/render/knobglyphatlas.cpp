@@ -0,0 +1,183 @@
+#include <string.h>
+#include <algorithm>
+#include "knobglyphatlas.h"
+#include "knobfont.h"
+
+
+KnobBuiltinGlyphSource::KnobBuiltinGlyphSource(int32_t fontSize) : _fontScale(GetKnobFontScale(fontSize))
+{}
+
+int32_t KnobBuiltinGlyphSource::GetLineHeight()
+{
+	return KNOBFONT_LINEHEIGHT * _fontScale;
+}
+
+int32_t KnobBuiltinGlyphSource::GetAdvance(char ch)
+{
+	return GetKnobFontGlyph(ch) ? KNOBFONT_ADVANCE * _fontScale : 0;
+}
+
+bool KnobBuiltinGlyphSource::RenderGlyph(char ch, int32_t width, int32_t height, uint8_t *mask, int32_t stride)
+{
+	const uint8_t *glyph = GetKnobFontGlyph(ch);
+	if (!glyph)
+		return false;
+
+	// Same placement as KnobRasterizer::TextAt()
+	const int32_t top = (KNOBFONT_LINEHEIGHT - KNOBFONT_GLYPHHEIGHT) / 2 * _fontScale;
+	for (int32_t y = 0; y < height; ++y)
+	{
+		const int32_t row = (y - top) / _fontScale;
+		if (y < top || row >= KNOBFONT_GLYPHHEIGHT)
+			continue;
+
+		for (int32_t x = 0; x < width && x < KNOBFONT_GLYPHWIDTH * _fontScale; ++x)
+		{
+			if (glyph[row] & (0x10 >> (x / _fontScale)))
+				mask[y * stride + x] = 255;
+		}
+	}
+
+	return true;
+}
+
+
+KnobGlyphAtlas::KnobGlyphAtlas() : _maskWidth(0), _lineHeight(0)
+{
+	for (int32_t i = 0; i < 256; ++i)
+		_index[i] = -1;
+}
+
+bool KnobGlyphAtlas::Build(KnobGlyphSource &source)
+{
+	_lineHeight = source.GetLineHeight();
+	if (_lineHeight <= 0)
+		return false;
+
+	// Place all glyphs next to each other. One extra column catches anti-aliased edges that reach past the advance.
+	_glyphs.clear();
+	_maskWidth = 0;
+	for (const char *ch = KNOBGLYPHATLAS_CHARACTERS; *ch != 0; ++ch)
+	{
+		Glyph glyph;
+		glyph.advance = source.GetAdvance(*ch);
+		glyph.width = glyph.advance + 1;
+		glyph.inkWidth = 0;
+		glyph.maskX = _maskWidth;
+
+		_index[(uint8_t)*ch] = (int16_t)_glyphs.size();
+		_glyphs.push_back(glyph);
+		_maskWidth += glyph.width;
+	}
+
+	_mask.assign((size_t)_maskWidth * (size_t)_lineHeight, 0);
+
+	for (const char *ch = KNOBGLYPHATLAS_CHARACTERS; *ch != 0; ++ch)
+	{
+		const Glyph &glyph = _glyphs[_index[(uint8_t)*ch]];
+		if (*ch != ' ' && !source.RenderGlyph(*ch, glyph.width, _lineHeight, &_mask[glyph.maskX], _maskWidth))
+			return false;
+	}
+
+	// Find the rightmost covered column of each glyph, for measuring the last glyph of a text
+	for (size_t i = 0; i < _glyphs.size(); ++i)
+	{
+		Glyph &glyph = _glyphs[i];
+		glyph.inkWidth = 0;
+		for (int32_t y = 0; y < _lineHeight; ++y)
+		{
+			const uint8_t *row = &_mask[(size_t)y * (size_t)_maskWidth + (size_t)glyph.maskX];
+			for (int32_t x = glyph.width - 1; x >= glyph.inkWidth; --x)
+			{
+				if (row[x] != 0)
+				{
+					glyph.inkWidth = x + 1;
+					break;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+void KnobGlyphAtlas::WriteAsset(KnobAssetWriter &writer) const
+{
+	writer.Put(_maskWidth);
+	writer.Put(_lineHeight);
+	writer.Put((int32_t)_glyphs.size());
+	for (const char *ch = KNOBGLYPHATLAS_CHARACTERS; *ch != 0; ++ch)
+		writer.Put(_glyphs[_index[(uint8_t)*ch]]);
+	writer.PutBytes(_mask.empty() ? nullptr : &_mask[0], _mask.size());
+}
+
+bool KnobGlyphAtlas::ReadAsset(KnobAssetReader &reader)
+{
+	int32_t glyphCount = 0;
+	reader.Get(_maskWidth);
+	reader.Get(_lineHeight);
+	reader.Get(glyphCount);
+	if (!reader.IsValid() || _maskWidth <= 0 || _lineHeight <= 0 || glyphCount != (int32_t)sizeof(KNOBGLYPHATLAS_CHARACTERS) - 1)
+		return false;
+
+	// Glyphs are stored in the order of KNOBGLYPHATLAS_CHARACTERS, like Build() creates them
+	_glyphs.clear();
+	for (const char *ch = KNOBGLYPHATLAS_CHARACTERS; *ch != 0; ++ch)
+	{
+		Glyph glyph;
+		if (!reader.Get(glyph) || glyph.maskX < 0 || glyph.width < 0 || glyph.maskX + glyph.width > _maskWidth)
+			return false;
+
+		_index[(uint8_t)*ch] = (int16_t)_glyphs.size();
+		_glyphs.push_back(glyph);
+	}
+
+	// The mask is small, so it's copied instead of read from the file while drawing
+	const size_t maskSize = (size_t)_maskWidth * (size_t)_lineHeight;
+	const uint8_t *mask = reader.GetBytes(maskSize, 1);
+	if (!mask)
+		return false;
+	_mask.assign(mask, mask + maskSize);
+
+	return true;
+}
+
+int32_t KnobGlyphAtlas::GetTextWidth(const char *text) const
+{
+	if (!text)
+		return 0;
+
+	// The spacing after the last glyph is not part of the text
+	int32_t width = 0;
+	int32_t lastSpacing = 0;
+	for (; *text != 0; ++text)
+	{
+		const int16_t index = _index[(uint8_t)*text];
+		if (index < 0)
+			continue;
+
+		const Glyph &glyph = _glyphs[index];
+		width += glyph.advance;
+		lastSpacing = glyph.inkWidth > 0 ? std::max(glyph.advance - glyph.inkWidth, 0) : 0;
+	}
+
+	return width - lastSpacing;
+}
+
+void KnobGlyphAtlas::DrawText(KnobRenderer &renderer, int32_t x, int32_t y, const char *text) const
+{
+	if (!text || _mask.empty())
+		return;
+
+	for (; *text != 0; ++text)
+	{
+		const int16_t index = _index[(uint8_t)*text];
+		if (index < 0)
+			continue;
+
+		const Glyph &glyph = _glyphs[index];
+		if (*text != ' ')
+			renderer.FillMask(x, y, glyph.width, _lineHeight, &_mask[glyph.maskX], _maskWidth);
+		x += glyph.advance;
+	}
+}
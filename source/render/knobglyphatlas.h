@@ -0,0 +1,111 @@
+#ifndef KNOBGLYPHATLAS_H__
+#define KNOBGLYPHATLAS_H__
+
+#include <vector>
+#include "knobassetfile.h"
+#include "knobrenderer.h"
+
+
+/// All characters a value label can contain: digits, sign, decimal separators, exponent and unit suffixes
+static const char KNOBGLYPHATLAS_CHARACTERS[] = " 0123456789-+.,%Ecegkms\xB0";
+
+
+/// Provides the glyphs for a KnobGlyphAtlas, e.g. from a font of the host application
+class KnobGlyphSource
+{
+public:
+	virtual ~KnobGlyphSource()
+	{}
+
+	/// Return the height of a line of text in pixels
+	virtual int32_t GetLineHeight() = 0;
+
+	/// Return the horizontal advance of a character in pixels
+	virtual int32_t GetAdvance(char ch) = 0;
+
+	/// Render a character into a coverage mask. The mask is cleared to 0 before.
+	/// @param[in] ch The character
+	/// @param[in] width Width of the mask area
+	/// @param[in] height Height of the mask area (the line height)
+	/// @param[out] mask Pointer to the upper left corner of the mask area, coverage 0 ... 255
+	/// @param[in] stride Distance between two mask rows in bytes
+	/// @return False if the glyph could not be rendered
+	virtual bool RenderGlyph(char ch, int32_t width, int32_t height, uint8_t *mask, int32_t stride) = 0;
+};
+
+
+/// Glyph source for the built-in bitmap font from knobfont.h
+class KnobBuiltinGlyphSource : public KnobGlyphSource
+{
+public:
+	/// @param[in] fontSize The font size in pixels
+	explicit KnobBuiltinGlyphSource(int32_t fontSize);
+
+	virtual int32_t GetLineHeight();
+	virtual int32_t GetAdvance(char ch);
+	virtual bool RenderGlyph(char ch, int32_t width, int32_t height, uint8_t *mask, int32_t stride);
+
+private:
+	int32_t _fontScale;  ///< Scale factor for the font pixels
+};
+
+
+/// Pre-rendered coverage masks of all label characters, in one row.
+/// Measuring a label only adds up cached advances, and drawing it blends the masks
+/// with KnobRenderer::FillMask(), so there's no text layout at all while drawing frames.
+class KnobGlyphAtlas
+{
+public:
+	KnobGlyphAtlas();
+
+	/// Render all characters of KNOBGLYPHATLAS_CHARACTERS
+	/// @param[in] source The glyph source
+	/// @return False if memory could not be allocated or a glyph could not be rendered
+	bool Build(KnobGlyphSource &source);
+
+	/// Write the atlas, e.g. into a KnobAssetCache file
+	void WriteAsset(KnobAssetWriter &writer) const;
+
+	/// Read an atlas written by WriteAsset()
+	/// @return False if the data is not a valid atlas
+	bool ReadAsset(KnobAssetReader &reader);
+
+	/// Return the width of a text in pixels, without the spacing after the last character. Characters that are not in the atlas are ignored.
+	int32_t GetTextWidth(const char *text) const;
+
+	/// Return the height of a line of text in pixels
+	int32_t GetLineHeight() const
+	{
+		return _lineHeight;
+	}
+
+	/// Draw a text with the renderer's current color, with (x, y) being its upper left corner.
+	/// Characters that are not in the atlas are skipped.
+	/// @note: Must be called between BeginDraw() and EndDraw()
+	void DrawText(KnobRenderer &renderer, int32_t x, int32_t y, const char *text) const;
+
+	/// Return the size of the atlas in bytes
+	size_t GetMemorySize() const
+	{
+		return _mask.size();
+	}
+
+private:
+	/// A character in the atlas
+	struct Glyph
+	{
+		int32_t maskX;    ///< Left border of the glyph in the mask
+		int32_t width;    ///< Width of the glyph in the mask
+		int32_t advance;  ///< Horizontal distance to the next character
+		int32_t inkWidth; ///< Width of the covered part of the glyph
+	};
+
+	std::vector<Glyph>   _glyphs;       ///< All glyphs
+	int16_t              _index[256];   ///< Index in _glyphs for each character, or -1
+	std::vector<uint8_t> _mask;         ///< Coverage of all glyphs, row by row
+	int32_t              _maskWidth;    ///< Width of the mask
+	int32_t              _lineHeight;   ///< Height of the mask
+};
+
+
+#endif  // KNOBGLYPHATLAS_H__
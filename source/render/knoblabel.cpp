@@ -0,0 +1,126 @@
+#include <math.h>
+#include "knoblabel.h"
+
+
+static const double KNOBLABEL_PI = 3.14159265358979323846;
+
+/// Powers of ten up to 10^KNOBLABEL_MAXDECIMALS
+static const double g_knobLabelPowers[KNOBLABEL_MAXDECIMALS + 1] = { 1.0, 10.0, 100.0, 1000.0, 10000.0, 100000.0, 1000000.0 };
+
+
+KnobLabelFormatter::KnobLabelFormatter() : _scale(1.0), _suffix(""), _decimals(KNOBLABEL_DEFAULTDECIMALS), _labelValue(0.0), _labelValid(false)
+{
+	_label[0] = 0;
+}
+
+void KnobLabelFormatter::SetFormat(double step, KnobLabelUnit unit)
+{
+	switch (unit)
+	{
+		case KNOBLABEL_UNIT_PERCENT:
+			_scale = 100.0;
+			_suffix = " %";
+			break;
+
+		case KNOBLABEL_UNIT_DEGREE:
+			_scale = 180.0 / KNOBLABEL_PI;
+			_suffix = "\xB0";
+			break;
+
+		case KNOBLABEL_UNIT_METER:
+			_scale = 1.0;
+			_suffix = " cm";
+			break;
+
+		default:
+			_scale = 1.0;
+			_suffix = "";
+			break;
+	}
+
+	// The step is given in value units, but the precision has to fit the displayed number
+	_decimals = step > 0.0 ? GetDecimalsForStep(step * _scale) : KNOBLABEL_DEFAULTDECIMALS;
+	_labelValid = false;
+}
+
+const char *KnobLabelFormatter::GetLabel(double value)
+{
+	if (_labelValid && value == _labelValue)
+		return _label;
+
+	FormatNumber(value * _scale, _decimals, _suffix, _label, KNOBLABEL_MAXLENGTH);
+	_labelValue = value;
+	_labelValid = true;
+
+	return _label;
+}
+
+int32_t KnobLabelFormatter::GetDecimalsForStep(double step)
+{
+	if (!(step > 0.0))
+		return KNOBLABEL_DEFAULTDECIMALS;
+
+	// Find the first power of ten that makes the step a whole number
+	for (int32_t decimals = 0; decimals < KNOBLABEL_MAXDECIMALS; ++decimals)
+	{
+		const double scaled = step * g_knobLabelPowers[decimals];
+		if (fabs(scaled - floor(scaled + 0.5)) <= scaled * 1.0e-6)
+			return decimals;
+	}
+
+	return KNOBLABEL_MAXDECIMALS;
+}
+
+int32_t KnobLabelFormatter::FormatNumber(double value, int32_t decimals, const char *suffix, char *buffer, int32_t bufferSize)
+{
+	if (!buffer || bufferSize <= 0)
+		return 0;
+
+	decimals = decimals < 0 ? 0 : (decimals > KNOBLABEL_MAXDECIMALS ? KNOBLABEL_MAXDECIMALS : decimals);
+
+	// Longest possible number: sign, 20 digits, decimal point, decimals
+	char number[32];
+	int32_t length = 0;
+
+	// Round to an integer number of the last decimal place. This also keeps "-0.00" from showing up.
+	const double scaled = fabs(value) * g_knobLabelPowers[decimals];
+	if (!(scaled < 1.8e19))
+	{
+		// Infinite, NaN, or just too big for the label
+		number[length++] = '-';
+		number[length++] = '-';
+		number[length++] = '-';
+	}
+	else
+	{
+		uint64_t units = (uint64_t)(scaled + 0.5);
+		if (value < 0.0 && units != 0)
+			number[length++] = '-';
+
+		// Digits in reverse order, at least one before the decimal point
+		char digits[32];
+		int32_t digitCount = 0;
+		do
+		{
+			digits[digitCount++] = (char)('0' + (int32_t)(units % 10));
+			units /= 10;
+		} while (units != 0 || digitCount <= decimals);
+
+		for (int32_t i = digitCount - 1; i >= 0; --i)
+		{
+			number[length++] = digits[i];
+			if (i == decimals && decimals > 0)
+				number[length++] = '.';
+		}
+	}
+
+	// Copy number and suffix, as much as fits
+	int32_t written = 0;
+	for (int32_t i = 0; i < length && written < bufferSize - 1; ++i)
+		buffer[written++] = number[i];
+	for (; suffix && *suffix != 0 && written < bufferSize - 1; ++suffix)
+		buffer[written++] = *suffix;
+	buffer[written] = 0;
+
+	return written;
+}
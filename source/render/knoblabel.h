@@ -0,0 +1,66 @@
+#ifndef KNOBLABEL_H__
+#define KNOBLABEL_H__
+
+#include <stdint.h>
+
+
+/// Unit a value label is displayed in
+enum KnobLabelUnit
+{
+	KNOBLABEL_UNIT_NONE = 0,  ///< Plain number
+	KNOBLABEL_UNIT_PERCENT,   ///< Value 1.0 is displayed as "100 %"
+	KNOBLABEL_UNIT_DEGREE,    ///< Value in radians, displayed in degrees
+	KNOBLABEL_UNIT_METER      ///< Distance, displayed in cm
+};
+
+static const int32_t KNOBLABEL_MAXLENGTH = 64;       ///< Size of a label buffer, including the terminating 0
+static const int32_t KNOBLABEL_MAXDECIMALS = 6;      ///< Maximum number of decimal places
+static const int32_t KNOBLABEL_DEFAULTDECIMALS = 2;  ///< Decimal places if there is no step size
+
+
+/// Formats the value label of a knob. Precision and unit are set up once, formatting
+/// doesn't allocate memory and is skipped if the value hasn't changed since the last call.
+class KnobLabelFormatter
+{
+public:
+	KnobLabelFormatter();
+
+	/// Set up the format
+	/// @param[in] step Step size of the value (e.g. DESC_STEP). Determines the number of decimal places: a step of 0.25 shows 2 of them, a step of 1.0 none.
+	/// @param[in] unit The unit to display the value in
+	void SetFormat(double step, KnobLabelUnit unit);
+
+	/// Return the label for a value
+	/// @param[in] value The value
+	/// @return The formatted label, valid until the next call of GetLabel() or SetFormat()
+	const char *GetLabel(double value);
+
+	/// Return the number of decimal places
+	int32_t GetDecimals() const
+	{
+		return _decimals;
+	}
+
+	/// Format a number into a buffer, without using the cache
+	/// @param[in] value The number
+	/// @param[in] decimals Number of decimal places, 0 ... KNOBLABEL_MAXDECIMALS
+	/// @param[in] suffix Text to append, e.g. a unit. May be nullptr.
+	/// @param[out] buffer The buffer to write into
+	/// @param[in] bufferSize Size of the buffer in bytes
+	/// @return Length of the text, without the terminating 0
+	static int32_t FormatNumber(double value, int32_t decimals, const char *suffix, char *buffer, int32_t bufferSize);
+
+	/// Return the number of decimal places needed to display multiples of a step size exactly
+	static int32_t GetDecimalsForStep(double step);
+
+private:
+	double      _scale;       ///< Factor from value to displayed number
+	const char *_suffix;      ///< Unit text appended to the number
+	int32_t     _decimals;    ///< Number of decimal places
+	double      _labelValue;  ///< The value _label was formatted from
+	bool        _labelValid;  ///< False if _label has to be formatted again
+	char        _label[KNOBLABEL_MAXLENGTH];  ///< The last formatted label
+};
+
+
+#endif  // KNOBLABEL_H__
@@ -0,0 +1,72 @@
+#ifndef KNOBMAILBOX_H__
+#define KNOBMAILBOX_H__
+
+#include <stdint.h>
+#include <atomic>
+
+
+/// Lock-free single-slot mailbox between one producer and one consumer thread.
+/// The consumer only ever sees the latest message: a message that hasn't been fetched yet is
+/// replaced by the next one. There are three slots, one for each side and one in between, and
+/// Publish() and Fetch() swap their own slot with the one in between. Neither side ever waits
+/// for the other, and a slot's contents are only touched by the side that owns it, so T can be
+/// anything that is default constructible, including buffers that are reused for every message.
+template <class T>
+class KnobMailbox
+{
+public:
+	KnobMailbox() : _write(0), _read(1), _shared(2)
+	{}
+
+	/// Return the slot the producer writes the next message into. It still has the contents of an older message.
+	/// @note: Only for the producer thread
+	T &GetWriteSlot()
+	{
+		return _slots[_write];
+	}
+
+	/// Hand the message in the write slot to the consumer. The producer gets a new write slot.
+	/// @note: Only for the producer thread
+	void Publish()
+	{
+		_write = _shared.exchange(_write | KNOBMAILBOX_NEW, std::memory_order_acq_rel) & KNOBMAILBOX_INDEX;
+	}
+
+	/// Return true if a message has been published that the consumer hasn't fetched yet
+	bool HasMessage() const
+	{
+		return (_shared.load(std::memory_order_acquire) & KNOBMAILBOX_NEW) != 0;
+	}
+
+	/// Take the latest message into the read slot
+	/// @note: Only for the consumer thread
+	/// @return False if there is no new message, the read slot still holds the last one
+	bool Fetch()
+	{
+		if (!HasMessage())
+			return false;
+
+		_read = _shared.exchange(_read, std::memory_order_acq_rel) & KNOBMAILBOX_INDEX;
+		return true;
+	}
+
+	/// Return the slot with the last fetched message
+	/// @note: Only for the consumer thread
+	T &GetReadSlot()
+	{
+		return _slots[_read];
+	}
+
+private:
+	static const uint32_t KNOBMAILBOX_INDEX = 3;  ///< Bits of the slot index
+	static const uint32_t KNOBMAILBOX_NEW = 4;    ///< Set in _shared if the slot in between holds a message that hasn't been fetched
+
+	T                      _slots[3];     ///< Write slot, read slot and the one in between
+	uint32_t               _write;        ///< Index of the producer's slot
+	char                   _padding[64];  ///< Keeps the producer's and the consumer's index off each other's cache line
+	uint32_t               _read;         ///< Index of the consumer's slot
+	std::atomic<uint32_t>  _shared;       ///< Index of the slot in between, and KNOBMAILBOX_NEW
+};
+
+
+#endif  // KNOBMAILBOX_H__
@@ -0,0 +1,206 @@
+#include <math.h>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include "knobassetcache.h"
+#include "knobmarkeratlas.h"
+#include "knobrasterizer.h"
+
+
+KnobMarkerAtlas::KnobMarkerAtlas() : _cellCount(0), _cellSize(0), _cellOrigin(0), _columns(0), _angleMin(0.0), _angleMax(0.0)
+{}
+
+int32_t KnobMarkerAtlas::ComputeCellCount(const KnobDrawValues &drawValues, double maxError)
+{
+	// Distance of the marker tip from the knob center, in pixels on screen
+	const double tipRadius = drawValues.markerLength / drawValues.oversampling;
+	if (tipRadius <= 0.0 || maxError <= 0.0)
+		return 2;
+
+	// With rounding to the nearest cell, the angle is off by at most half a step,
+	// which moves the tip by (less than) tipRadius * step / 2.
+	const double maxStep = 2.0 * maxError / tipRadius;
+	const double range = drawValues.scaleLimitRadians - drawValues.scaleLimitRadiansNeg;
+
+	return std::max((int32_t)ceil(range / maxStep) + 1, (int32_t)2);
+}
+
+bool KnobMarkerAtlas::Build(const KnobDrawValues &drawValues, int32_t cellCount)
+{
+	_cellCount = std::max(cellCount, (int32_t)2);
+	_angleMin = drawValues.scaleLimitRadiansNeg;
+	_angleMax = drawValues.scaleLimitRadians;
+
+	// Square around the knob center that contains the marker at every angle
+	const int32_t halfSize = (int32_t)ceil(drawValues.markerLength + drawValues.markerThickness) + 1;
+	_cellOrigin = std::max(drawValues.areaHalfWidth - halfSize, (int32_t)0);
+	_cellSize = std::min(2 * halfSize + 1, drawValues.areaWidth - _cellOrigin);
+
+	// Arrange cells in a roughly square grid
+	_columns = (int32_t)ceil(sqrt((double)_cellCount));
+	const int32_t rows = (_cellCount + _columns - 1) / _columns;
+	if (!_pixels.Init(_columns * _cellSize, rows * _cellSize))
+		return false;
+
+	// Render the knob once for every cell, and copy the marker region into the atlas
+	KnobPixelBuffer frame;
+	KnobRasterizer rasterizer(frame);
+	rasterizer.SetAntialiasing(drawValues.antialiasing);
+	if (!DrawKnobStaticLayer(rasterizer, drawValues))
+		return false;
+
+	for (int32_t i = 0; i < _cellCount; ++i)
+	{
+		const double angle = _angleMin + (_angleMax - _angleMin) * (double)i / (double)(_cellCount - 1);
+
+		if (!rasterizer.BeginDraw(drawValues.areaWidth, drawValues.areaWidth))
+			return false;
+		rasterizer.DrawStaticLayer();
+		DrawKnobMarker(rasterizer, drawValues, angle);
+		rasterizer.EndDraw();
+
+		int32_t cellX = 0, cellY = 0;
+		GetCellPosition(i, cellX, cellY);
+		for (int32_t row = 0; row < _cellSize; ++row)
+			std::copy(frame.GetRow(_cellOrigin + row) + _cellOrigin, frame.GetRow(_cellOrigin + row) + _cellOrigin + _cellSize, _pixels.GetRow(cellY + row) + cellX);
+	}
+
+	return true;
+}
+
+void KnobMarkerAtlas::WriteAsset(KnobAssetWriter &writer) const
+{
+	writer.Put(_cellCount);
+	writer.Put(_cellSize);
+	writer.Put(_cellOrigin);
+	writer.Put(_columns);
+	writer.Put(_angleMin);
+	writer.Put(_angleMax);
+	writer.Put(_pixels.GetWidth());
+	writer.Put(_pixels.GetHeight());
+
+	writer.Align(sizeof(KnobColor));
+	for (int32_t y = 0; y < _pixels.GetHeight(); ++y)
+		writer.PutBytes(_pixels.GetRow(y), (size_t)_pixels.GetWidth() * sizeof(KnobColor));
+}
+
+bool KnobMarkerAtlas::ReadAsset(KnobAssetReader &reader)
+{
+	int32_t width = 0, height = 0;
+	reader.Get(_cellCount);
+	reader.Get(_cellSize);
+	reader.Get(_cellOrigin);
+	reader.Get(_columns);
+	reader.Get(_angleMin);
+	reader.Get(_angleMax);
+	reader.Get(width);
+	reader.Get(height);
+	if (!reader.IsValid() || _cellCount < 2 || _cellSize <= 0 || _columns <= 0 || width < _columns * _cellSize || height < (_cellCount + _columns - 1) / _columns * _cellSize)
+		return false;
+
+	const uint8_t *pixels = reader.GetBytes((size_t)width * (size_t)height * sizeof(KnobColor), sizeof(KnobColor));
+	if (!pixels)
+		return false;
+
+	_pixels.Wrap((const KnobColor*)pixels, width, height);
+	return true;
+}
+
+int32_t KnobMarkerAtlas::GetCellIndex(double angle) const
+{
+	if (_cellCount < 2 || _angleMax == _angleMin)
+		return 0;
+
+	const int32_t index = (int32_t)floor((angle - _angleMin) / (_angleMax - _angleMin) * (double)(_cellCount - 1) + 0.5);
+	return std::min(std::max(index, (int32_t)0), _cellCount - 1);
+}
+
+void KnobMarkerAtlas::GetCellPosition(int32_t index, int32_t &x, int32_t &y) const
+{
+	x = (index % _columns) * _cellSize;
+	y = (index / _columns) * _cellSize;
+}
+
+
+/// An atlas in the process-wide cache, together with the parameters it was built from
+struct KnobMarkerAtlasEntry
+{
+	KnobDrawValues                       drawValues;  ///< Draw values the atlas was built with
+	int32_t                              cellCount;   ///< Requested cell count
+	std::weak_ptr<const KnobMarkerAtlas> atlas;       ///< The atlas. Released when the last knob stops using it.
+};
+
+static std::mutex g_knobMarkerAtlasLock;
+static std::vector<KnobMarkerAtlasEntry> g_knobMarkerAtlases;
+
+
+/// Check if two sets of draw values result in the same atlas
+static bool IsSameAtlas(const KnobDrawValues &a, const KnobDrawValues &b)
+{
+	return a.areaWidth == b.areaWidth && a.oversampling == b.oversampling && a.antialiasing == b.antialiasing && a.scaleLimitRadians == b.scaleLimitRadians && a.scaleTickCount == b.scaleTickCount
+		&& a.markerLength == b.markerLength && a.markerThickness == b.markerThickness
+		&& a.areaColor == b.areaColor && a.scaleColor == b.scaleColor && a.knobOuterColor == b.knobOuterColor
+		&& a.knobInnerColor == b.knobInnerColor && a.knobCenterColor == b.knobCenterColor && a.markerColor == b.markerColor;
+}
+
+std::shared_ptr<const KnobMarkerAtlas> AcquireKnobMarkerAtlas(const KnobDrawValues &drawValues, int32_t cellCount)
+{
+	if (cellCount <= 0)
+		cellCount = KnobMarkerAtlas::ComputeCellCount(drawValues, 1.0);
+
+	std::lock_guard<std::mutex> lock(g_knobMarkerAtlasLock);
+
+	// Forget atlases that are not used anymore
+	g_knobMarkerAtlases.erase(std::remove_if(g_knobMarkerAtlases.begin(), g_knobMarkerAtlases.end(), [](const KnobMarkerAtlasEntry &entry) { return entry.atlas.expired(); }), g_knobMarkerAtlases.end());
+
+	for (size_t i = 0; i < g_knobMarkerAtlases.size(); ++i)
+	{
+		const KnobMarkerAtlasEntry &entry = g_knobMarkerAtlases[i];
+		if (entry.cellCount == cellCount && IsSameAtlas(entry.drawValues, drawValues))
+		{
+			std::shared_ptr<const KnobMarkerAtlas> atlas = entry.atlas.lock();
+			if (atlas)
+				return atlas;
+		}
+	}
+
+	// Not in the cache. Take it from the last session, or build a new one.
+	std::shared_ptr<const KnobMarkerAtlas> atlas = GetSharedKnobAssetCache().FindMarkerAtlas(drawValues, cellCount);
+	if (!atlas)
+	{
+		std::shared_ptr<KnobMarkerAtlas> builtAtlas = std::make_shared<KnobMarkerAtlas>();
+		if (!builtAtlas->Build(drawValues, cellCount))
+			return std::shared_ptr<const KnobMarkerAtlas>();
+		GetSharedKnobAssetCache().AddMarkerAtlas(drawValues, cellCount, *builtAtlas);
+		atlas = builtAtlas;
+	}
+
+	KnobMarkerAtlasEntry entry;
+	entry.drawValues = drawValues;
+	entry.cellCount = cellCount;
+	entry.atlas = atlas;
+	g_knobMarkerAtlases.push_back(entry);
+
+	return atlas;
+}
+
+bool DrawKnobAtlasFrame(KnobRenderer &renderer, const KnobDrawValues &drawValues, const KnobMarkerAtlas &atlas, double angle, const char *label, const KnobGlyphAtlas *glyphs)
+{
+	if (!renderer.BeginDraw(drawValues.areaWidth, drawValues.areaWidth))
+		return false;
+
+	// Background, scale and knob
+	renderer.DrawStaticLayer();
+
+	// Knob center with the pre-rendered marker
+	int32_t cellX = 0, cellY = 0;
+	atlas.GetCellPosition(atlas.GetCellIndex(angle), cellX, cellY);
+	renderer.DrawBuffer(atlas.GetCellOrigin(), atlas.GetCellOrigin(), atlas.GetPixels(), cellX, cellY, atlas.GetCellSize(), atlas.GetCellSize());
+
+	// Draw the value
+	DrawKnobLabel(renderer, drawValues, label, glyphs);
+
+	renderer.EndDraw();
+
+	return true;
+}
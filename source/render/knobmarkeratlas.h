@@ -0,0 +1,93 @@
+#ifndef KNOBMARKERATLAS_H__
+#define KNOBMARKERATLAS_H__
+
+#include <memory>
+#include "knobassetfile.h"
+#include "knobpainter.h"
+
+
+/// Pre-rendered images of the knob with its marker at a number of quantized angles.
+/// All cells are stored in one pixel buffer. A cell only covers the square around
+/// the knob center that the marker can reach, the rest comes from the static layer.
+class KnobMarkerAtlas
+{
+public:
+	KnobMarkerAtlas();
+
+	/// Render all cells
+	/// @param[in] drawValues The draw values to render the knob with
+	/// @param[in] cellCount Number of quantized marker angles, at least 2
+	/// @return False if memory could not be allocated
+	bool Build(const KnobDrawValues &drawValues, int32_t cellCount);
+
+	/// Write the atlas, e.g. into a KnobAssetCache file
+	void WriteAsset(KnobAssetWriter &writer) const;
+
+	/// Read an atlas written by WriteAsset(). The pixels are not copied, they must stay valid as long as the atlas is used.
+	/// @return False if the data is not a valid atlas
+	bool ReadAsset(KnobAssetReader &reader);
+
+	/// Compute the number of cells that is needed to keep the quantization error
+	/// at the marker tip below a maximum distance
+	/// @param[in] drawValues The draw values
+	/// @param[in] maxError Maximum distance of the marker tip from its exact position, in pixels on screen
+	/// @return The number of cells
+	static int32_t ComputeCellCount(const KnobDrawValues &drawValues, double maxError);
+
+	/// Return the index of the cell that shows the marker closest to an angle
+	/// @param[in] angle The marker angle, as returned by KnobValueToAngle()
+	int32_t GetCellIndex(double angle) const;
+
+	/// Return the upper left corner of a cell in the atlas
+	void GetCellPosition(int32_t index, int32_t &x, int32_t &y) const;
+
+	/// Return the number of cells
+	int32_t GetCellCount() const
+	{
+		return _cellCount;
+	}
+
+	/// Return the width and height of a cell
+	int32_t GetCellSize() const
+	{
+		return _cellSize;
+	}
+
+	/// Return where the upper left corner of a cell is placed in the knob frame (same for x and y)
+	int32_t GetCellOrigin() const
+	{
+		return _cellOrigin;
+	}
+
+	/// Return the atlas pixels
+	const KnobPixelBuffer &GetPixels() const
+	{
+		return _pixels;
+	}
+
+private:
+	KnobPixelBuffer _pixels;         ///< All cells
+	int32_t         _cellCount;      ///< Number of cells
+	int32_t         _cellSize;       ///< Width and height of a cell
+	int32_t         _cellOrigin;     ///< Position of a cell in the knob frame
+	int32_t         _columns;        ///< Number of cells per atlas row
+	double          _angleMin;       ///< Marker angle of the first cell
+	double          _angleMax;       ///< Marker angle of the last cell
+};
+
+
+/// Return a marker atlas for the given draw values. Atlases are shared by all knobs in the process,
+/// an atlas is only rendered once for each combination of size and colors, or taken from the shared KnobAssetCache.
+/// @param[in] drawValues The draw values
+/// @param[in] cellCount Number of quantized marker angles, or 0 to choose it automatically (error at the marker tip below one pixel)
+/// @return The atlas, or an empty pointer if it could not be built
+std::shared_ptr<const KnobMarkerAtlas> AcquireKnobMarkerAtlas(const KnobDrawValues &drawValues, int32_t cellCount);
+
+/// Draw a knob frame by placing an atlas cell on top of the static layer and drawing the label, including BeginDraw() and EndDraw()
+/// @note: DrawKnobStaticLayer() must have been called before
+/// @param[in] glyphs Glyph atlas for the label, or nullptr
+/// @return False if the renderer could not start drawing
+bool DrawKnobAtlasFrame(KnobRenderer &renderer, const KnobDrawValues &drawValues, const KnobMarkerAtlas &atlas, double angle, const char *label, const KnobGlyphAtlas *glyphs = nullptr);
+
+
+#endif  // KNOBMARKERATLAS_H__
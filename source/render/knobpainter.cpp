@@ -0,0 +1,308 @@
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include "knobpainter.h"
+#include "knobglyphatlas.h"
+
+
+static const double KNOBPAINTER_PI = 3.14159265358979323846;
+
+
+/// Maps a value from an input range to an output range
+/// @param[in] value The input value
+/// @param[in] minInput Defines the lower limit of the input range
+/// @param[in] maxInput Defines the upper limit of the input range
+/// @param[in] minOutput Defines the lower limit of the output range
+/// @param[in] maxOutput Defines the upper limit of the output range
+/// @return The mapped value
+static inline double MapRange(double value, double minInput, double maxInput, double minOutput, double maxOutput)
+{
+	if ((maxInput - minInput) == 0)
+		return minOutput;
+
+	return  minOutput + (maxOutput - minOutput) * ((value - minInput) / (maxInput - minInput));
+}
+
+
+/// Calculate the corners of the marker triangle, without the table
+static void ComputeMarkerCorners(const KnobDrawValues &drawValues, double angle, KnobPointF *points)
+{
+	// Map angle to circle
+	double x = sin(angle);
+	double y = cos(angle);
+
+	points[0].x = y * drawValues.markerThickness + drawValues.areaHalfWidth;
+	points[0].y = x * drawValues.markerThickness + drawValues.areaHalfWidth;
+	points[1].x = -y * drawValues.markerThickness + drawValues.areaHalfWidth;
+	points[1].y = -x * drawValues.markerThickness + drawValues.areaHalfWidth;
+	points[2].x = x * drawValues.markerLength + drawValues.areaHalfWidth;
+	points[2].y = y * -drawValues.markerLength + drawValues.areaHalfWidth;
+}
+
+
+void KnobDrawValues::InitGeometry(int32_t width, int32_t oversampling, int32_t margin, double scaleLimit, int32_t fontSize, int32_t textHeight, bool antialiasing, int32_t scaleTicks)
+{
+	// Margin and font size are given on screen, but all geometry is in drawing pixels
+	margin *= oversampling;
+	fontSize *= oversampling;
+
+	// Area & background
+	this->oversampling = oversampling;
+	this->antialiasing = antialiasing;
+	areaWidth = width * oversampling;
+	areaHalfWidth = areaWidth / 2;
+	areaRadius = areaHalfWidth - margin;
+
+	// Scale
+	scaleRadius1 = areaRadius * 1.1;
+	scaleRadius2 = areaRadius * 1.05;
+	scaleLimitRadians = scaleLimit * KNOBPAINTER_PI / 180.0;
+	scaleLimitRadiansNeg = -scaleLimitRadians;
+	scaleTickCount = std::min(std::max(scaleTicks, (int32_t)1), KNOBPAINTER_MAXSCALETICKS);
+
+	scaleTickEnds.resize((size_t)scaleTickCount + 1);
+	for (int32_t i = 0; i <= scaleTickCount; ++i)
+	{
+		// Map tick to scale
+		double value = MapRange((double)i, 0.0, (double)scaleTickCount, scaleLimitRadiansNeg, scaleLimitRadians);
+
+		// Select radius (every 2nd scale line is shorter, if that leaves long lines at both ends)
+		double radius = (i % 2 == 1 && scaleTickCount % 2 == 0) ? scaleRadius2 : scaleRadius1;
+
+		// Calculate draw coordinates
+		scaleTickEnds[i].x = (int32_t)(sin(value) * radius) + areaHalfWidth;
+		scaleTickEnds[i].y = (int32_t)(cos(value) * -radius) + areaHalfWidth;
+	}
+
+	// Knob
+	knobOuterCorner1 = margin;
+	knobOuterCorner2 = areaWidth - margin;
+
+	knobInnerCorner1 = (int32_t)(margin * 1.15);
+	knobInnerCorner2 = areaWidth - knobInnerCorner1;
+
+	knobCenterCorner1 = (int32_t)(-margin + areaHalfWidth);
+	knobCenterCorner2 = margin + areaHalfWidth;
+
+	// Marker
+	markerLength = areaRadius * 0.8;
+	markerThickness = margin * 0.6;
+
+	// One marker table entry per step of the precision the tip is drawn with, along the arc of the tip
+	const double steps = antialiasing ? (double)KNOBPAINTER_SUBPIXELSTEPS : 1.0;
+	const double angleRange = scaleLimitRadians - scaleLimitRadiansNeg;
+	const int32_t markerAngles = std::max((int32_t)ceil(angleRange * markerLength * steps) + 1, (int32_t)2);
+	markerAngleStep = angleRange / (double)(markerAngles - 1);
+
+	markerCorners.resize((size_t)markerAngles * 3);
+	for (int32_t i = 0; i < markerAngles; ++i)
+		ComputeMarkerCorners(*this, scaleLimitRadiansNeg + markerAngleStep * (double)i, &markerCorners[(size_t)i * 3]);
+
+	// Value label
+	labelFontSize = fontSize;
+	labelPosY = (int32_t)(areaHalfWidth * 1.5) - textHeight / 2;
+}
+
+void KnobDrawValues::SetTheme(const KnobTheme &theme)
+{
+	areaColor = theme.areaColor;
+	scaleColor = theme.scaleColor;
+	knobOuterColor = theme.knobOuterColor;
+	knobInnerColor = theme.knobInnerColor;
+	knobCenterColor = theme.knobCenterColor;
+	markerColor = theme.markerColor;
+	labelColor = theme.labelColor;
+}
+
+
+bool KnobVisualState::operator ==(const KnobVisualState &other) const
+{
+	for (int32_t i = 0; i < 3; ++i)
+	{
+		if (markerPoints[i].x != other.markerPoints[i].x || markerPoints[i].y != other.markerPoints[i].y)
+			return false;
+	}
+
+	return markerCell == other.markerCell && tristate == other.tristate && strcmp(label, other.label) == 0;
+}
+
+
+int32_t GetKnobScaleTicks(double minValue, double maxValue, double step)
+{
+	const double range = maxValue - minValue;
+	if (step <= 0.0 || range <= 0.0)
+		return KNOBPAINTER_SCALETICKS;
+
+	const double ticks = floor(range / step + 0.5);
+	if (ticks < 1.0 || ticks > 1.0e6 || fabs(ticks * step - range) > step * 1.0e-6)
+		return KNOBPAINTER_SCALETICKS;
+
+	int32_t count = (int32_t)ticks;
+	while (count > KNOBPAINTER_MAXSCALETICKS)
+	{
+		if (count % 10 == 0)
+			count /= 10;
+		else if (count % 5 == 0)
+			count /= 5;
+		else if (count % 2 == 0)
+			count /= 2;
+		else
+			return KNOBPAINTER_SCALETICKS;
+	}
+	return count;
+}
+
+double KnobValueToAngle(double value, double minValue, double maxValue, const KnobDrawValues &drawValues)
+{
+	return MapRange(value, minValue, maxValue, drawValues.scaleLimitRadiansNeg, drawValues.scaleLimitRadians);
+}
+
+void DrawKnobBackground(KnobRenderer &renderer, const KnobDrawValues &drawValues)
+{
+	renderer.SetColor(drawValues.areaColor);
+	renderer.FillRect(0, 0, drawValues.areaWidth, drawValues.areaWidth);
+}
+
+void DrawKnobScale(KnobRenderer &renderer, const KnobDrawValues &drawValues)
+{
+	renderer.SetColor(drawValues.scaleColor);
+
+	// Draw n lines
+	for (size_t i = 0; i < drawValues.scaleTickEnds.size(); ++i)
+		renderer.Line(drawValues.areaHalfWidth, drawValues.areaHalfWidth, drawValues.scaleTickEnds[i].x, drawValues.scaleTickEnds[i].y);
+}
+
+void DrawKnobBody(KnobRenderer &renderer, const KnobDrawValues &drawValues)
+{
+	// Draw outer circle (acts as a bold dark outline)
+	renderer.SetColor(drawValues.knobOuterColor);
+	renderer.FillEllipse(drawValues.knobOuterCorner1, drawValues.knobOuterCorner1, drawValues.knobOuterCorner2, drawValues.knobOuterCorner2);
+
+	// Draw inner circle
+	renderer.SetColor(drawValues.knobInnerColor);
+	renderer.FillEllipse(drawValues.knobInnerCorner1, drawValues.knobInnerCorner1, drawValues.knobInnerCorner2, drawValues.knobInnerCorner2);
+
+	// Draw center
+	renderer.SetColor(drawValues.knobCenterColor);
+	renderer.FillEllipse(drawValues.knobCenterCorner1, drawValues.knobCenterCorner1, drawValues.knobCenterCorner2, drawValues.knobCenterCorner2);
+}
+
+void GetKnobMarkerPoints(const KnobDrawValues &drawValues, double angle, KnobPointF *points)
+{
+	const int32_t angleCount = (int32_t)(drawValues.markerCorners.size() / 3);
+	if (angleCount < 2 || drawValues.markerAngleStep <= 0.0)
+	{
+		ComputeMarkerCorners(drawValues, angle, points);
+		return;
+	}
+
+	// Nearest entry of the table
+	const int32_t index = std::min(std::max((int32_t)floor((angle - drawValues.scaleLimitRadiansNeg) / drawValues.markerAngleStep + 0.5), (int32_t)0), angleCount - 1);
+	const KnobPointF *corners = &drawValues.markerCorners[(size_t)index * 3];
+	points[0] = corners[0];
+	points[1] = corners[1];
+	points[2] = corners[2];
+}
+
+void GetKnobMarkerKey(const KnobDrawValues &drawValues, double angle, KnobPoint *points)
+{
+	KnobPointF exactPoints[3];
+	GetKnobMarkerPoints(drawValues, angle, exactPoints);
+
+	// Same truncation as the aliased renderers
+	const double steps = drawValues.antialiasing ? (double)KNOBPAINTER_SUBPIXELSTEPS : 1.0;
+	for (int32_t i = 0; i < 3; ++i)
+	{
+		points[i].x = (int32_t)(exactPoints[i].x * steps);
+		points[i].y = (int32_t)(exactPoints[i].y * steps);
+	}
+}
+
+void DrawKnobMarker(KnobRenderer &renderer, const KnobDrawValues &drawValues, double angle)
+{
+	// Set color
+	renderer.SetColor(drawValues.markerColor);
+
+	// Set up point array
+	KnobPointF points[3];
+	GetKnobMarkerPoints(drawValues, angle, points);
+
+	// Draw
+	renderer.FillPolygon(3, points);
+}
+
+void DrawKnobLabel(KnobRenderer &renderer, const KnobDrawValues &drawValues, const char *label, const KnobGlyphAtlas *glyphs)
+{
+	// Pre-rendered glyphs, no text layout needed
+	if (glyphs)
+	{
+		renderer.SetColor(drawValues.labelColor);
+		glyphs->DrawText(renderer, drawValues.areaHalfWidth - glyphs->GetTextWidth(label) / 2, drawValues.labelPosY, label);
+		return;
+	}
+
+	// Set font size
+	renderer.SetFontSize(drawValues.labelFontSize);
+
+	// Draw value string
+	renderer.SetColor(drawValues.labelColor);
+	renderer.TextAt(drawValues.areaHalfWidth - renderer.GetTextWidth(label) / 2, drawValues.labelPosY, label);
+}
+
+bool DrawKnobFrame(KnobRenderer &renderer, const KnobDrawValues &drawValues, double angle, const char *label, const KnobGlyphAtlas *glyphs)
+{
+	if (!renderer.BeginDraw(drawValues.areaWidth, drawValues.areaWidth))
+		return false;
+
+	// Fill the background
+	DrawKnobBackground(renderer, drawValues);
+
+	// Draw the scale
+	DrawKnobScale(renderer, drawValues);
+
+	// Draw the knob
+	DrawKnobBody(renderer, drawValues);
+
+	// Draw the marker
+	DrawKnobMarker(renderer, drawValues, angle);
+
+	// Draw the value
+	DrawKnobLabel(renderer, drawValues, label, glyphs);
+
+	renderer.EndDraw();
+
+	return true;
+}
+
+bool DrawKnobStaticLayer(KnobRenderer &renderer, const KnobDrawValues &drawValues)
+{
+	if (!renderer.BeginStaticLayer(drawValues.areaWidth, drawValues.areaWidth))
+		return false;
+
+	DrawKnobBackground(renderer, drawValues);
+	DrawKnobScale(renderer, drawValues);
+	DrawKnobBody(renderer, drawValues);
+
+	renderer.EndStaticLayer();
+
+	return true;
+}
+
+bool DrawKnobLayeredFrame(KnobRenderer &renderer, const KnobDrawValues &drawValues, double angle, const char *label, const KnobGlyphAtlas *glyphs)
+{
+	if (!renderer.BeginDraw(drawValues.areaWidth, drawValues.areaWidth))
+		return false;
+
+	// Background, scale and knob
+	renderer.DrawStaticLayer();
+
+	// Draw the marker
+	DrawKnobMarker(renderer, drawValues, angle);
+
+	// Draw the value
+	DrawKnobLabel(renderer, drawValues, label, glyphs);
+
+	renderer.EndDraw();
+
+	return true;
+}
@@ -0,0 +1,179 @@
+#ifndef KNOBPAINTER_H__
+#define KNOBPAINTER_H__
+
+#include <vector>
+#include "knobrenderer.h"
+
+class KnobGlyphAtlas;
+
+
+/// Precision of the marker corners with anti-aliasing, in steps per pixel.
+/// Marker movements smaller than this don't trigger a redraw.
+static const int32_t KNOBPAINTER_SUBPIXELSTEPS = 4;
+
+/// Default number of intervals on the scale
+static const int32_t KNOBPAINTER_SCALETICKS = 10;
+
+/// Maximum number of intervals on the scale. More would just be a gray ring.
+static const int32_t KNOBPAINTER_MAXSCALETICKS = 40;
+
+
+/// This struct holds some values that will be used throughout the drawing
+/// functions, so those values don't have to be calculated unnecessarily often.
+/// Scale and marker geometry are looked up from tables, so drawing a frame doesn't need any trigonometry.
+struct KnobDrawValues
+{
+	int32_t oversampling;
+	bool antialiasing;
+	int32_t areaWidth;
+	int32_t areaHalfWidth;
+	double areaRadius;
+	KnobColor areaColor;
+
+	double scaleRadius1;
+	double scaleRadius2;
+	double scaleLimitRadians;
+	double scaleLimitRadiansNeg;
+	int32_t scaleTickCount;               ///< Number of intervals on the scale
+	std::vector<KnobPoint> scaleTickEnds;  ///< Outer ends of the scale lines, they all start at the center
+	KnobColor scaleColor;
+
+	int32_t knobOuterCorner1;
+	int32_t knobOuterCorner2;
+	KnobColor knobOuterColor;
+
+	int32_t knobInnerCorner1;
+	int32_t knobInnerCorner2;
+	KnobColor knobInnerColor;
+
+	int32_t knobCenterCorner1;
+	int32_t knobCenterCorner2;
+	KnobColor knobCenterColor;
+
+	double markerLength;
+	double markerThickness;
+	double markerAngleStep;                 ///< Angle between two entries of the marker table
+	std::vector<KnobPointF> markerCorners;  ///< Corners of the marker triangle for evenly spaced angles, 3 per angle
+	KnobColor markerColor;
+
+	int32_t labelFontSize;
+	int32_t labelPosY;
+	KnobColor labelColor;
+
+
+	KnobDrawValues() : oversampling(1), antialiasing(false), areaWidth(0), areaHalfWidth(0), areaRadius(0.0), scaleRadius1(0.0), scaleRadius2(0.0), scaleLimitRadians(0.0), scaleLimitRadiansNeg(0.0), scaleTickCount(0), knobOuterCorner1(0), knobOuterCorner2(0), knobInnerCorner1(0), knobInnerCorner2(0), knobCenterCorner1(0), knobCenterCorner2(0), markerLength(0.0), markerThickness(0.0), markerAngleStep(0.0), labelFontSize(0), labelPosY(0)
+	{}
+
+	/// Calculate the geometry of the knob
+	/// @param[in] width Width of the knob area on screen
+	/// @param[in] oversampling Oversampling factor, the knob is drawn at width * oversampling
+	/// @param[in] margin Margin between knob and border of the knob area on screen
+	/// @param[in] scaleLimit Where the usable range of the knob starts and ends, in degrees
+	/// @param[in] fontSize Font size for the value label on screen
+	/// @param[in] textHeight Height of a line of text, in drawing pixels
+	/// @param[in] antialiasing True if the renderer draws with anti-aliasing (usually without oversampling)
+	/// @param[in] scaleTicks Number of intervals on the scale
+	void InitGeometry(int32_t width, int32_t oversampling, int32_t margin, double scaleLimit, int32_t fontSize, int32_t textHeight, bool antialiasing, int32_t scaleTicks = KNOBPAINTER_SCALETICKS);
+
+	/// Set the colors
+	void SetTheme(const KnobTheme &theme);
+};
+
+
+/// Everything that determines what a knob frame looks like.
+/// If two states are equal, drawing them produces the same pixels, so a redraw can be skipped.
+struct KnobVisualState
+{
+	KnobPoint markerPoints[3];  ///< Corners of the marker triangle, as returned by GetKnobMarkerKey()
+	int32_t   markerCell;       ///< Marker atlas cell, or -1 if the marker is not drawn from an atlas
+	char      label[64];        ///< The value label
+	bool      tristate;         ///< Tristate display
+
+	KnobVisualState() : markerCell(-1), tristate(false)
+	{
+		for (int32_t i = 0; i < 3; ++i)
+			markerPoints[i].x = markerPoints[i].y = 0;
+		label[0] = 0;
+	}
+
+	bool operator ==(const KnobVisualState &other) const;
+
+	bool operator !=(const KnobVisualState &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+
+/// Find a number of scale intervals that puts a line on every step of the value range.
+/// If that would be too many, only every 2nd, 5th, 10th... step gets a line.
+/// @param[in] minValue Lower limit of the value range
+/// @param[in] maxValue Upper limit of the value range
+/// @param[in] step Step size of the value
+/// @return The number of intervals, or KNOBPAINTER_SCALETICKS if the steps don't divide the range evenly
+int32_t GetKnobScaleTicks(double minValue, double maxValue, double step);
+
+/// Maps a value from the knob's value range to the marker angle
+/// @param[in] value The value
+/// @param[in] minValue Lower limit of the value range
+/// @param[in] maxValue Upper limit of the value range
+/// @param[in] drawValues The draw values
+/// @return Angle of the marker in radians, 0.0 is pointing straight up
+double KnobValueToAngle(double value, double minValue, double maxValue, const KnobDrawValues &drawValues);
+
+/// Calculate the corners of the marker triangle.
+/// The angle is rounded to the nearest entry of the marker table, which moves the tip by less than half
+/// the precision the marker is drawn with.
+/// @param[in] drawValues The draw values
+/// @param[in] angle The marker angle, as returned by KnobValueToAngle()
+/// @param[out] points Array of 3 points that receives the corners
+void GetKnobMarkerPoints(const KnobDrawValues &drawValues, double angle, KnobPointF *points);
+
+/// Calculate the corners of the marker triangle, rounded to the precision they are drawn with
+/// (whole pixels, or KNOBPAINTER_SUBPIXELSTEPS with anti-aliasing). Markers with equal keys look the same.
+/// @param[in] drawValues The draw values
+/// @param[in] angle The marker angle, as returned by KnobValueToAngle()
+/// @param[out] points Array of 3 points that receives the rounded corners
+void GetKnobMarkerKey(const KnobDrawValues &drawValues, double angle, KnobPoint *points);
+
+/// Draw the knob background
+/// @note: Must be called between BeginDraw() and EndDraw()
+void DrawKnobBackground(KnobRenderer &renderer, const KnobDrawValues &drawValues);
+
+/// Draw the scale
+/// @note: Must be called between BeginDraw() and EndDraw()
+void DrawKnobScale(KnobRenderer &renderer, const KnobDrawValues &drawValues);
+
+/// Draw the knob
+/// @note: Must be called between BeginDraw() and EndDraw()
+void DrawKnobBody(KnobRenderer &renderer, const KnobDrawValues &drawValues);
+
+/// Draw the knob's marker
+/// @note: Must be called between BeginDraw() and EndDraw()
+/// @param[in] angle The marker angle, as returned by KnobValueToAngle()
+void DrawKnobMarker(KnobRenderer &renderer, const KnobDrawValues &drawValues, double angle);
+
+/// Draw the value on the knob
+/// @note: Must be called between BeginDraw() and EndDraw()
+/// @param[in] label The text to draw
+/// @param[in] glyphs Glyph atlas to draw the text from, or nullptr to use the renderer's text functions
+void DrawKnobLabel(KnobRenderer &renderer, const KnobDrawValues &drawValues, const char *label, const KnobGlyphAtlas *glyphs = nullptr);
+
+/// Draw a complete knob frame, including BeginDraw() and EndDraw()
+/// @param[in] glyphs Glyph atlas for the label, or nullptr
+/// @return False if the renderer could not start drawing
+bool DrawKnobFrame(KnobRenderer &renderer, const KnobDrawValues &drawValues, double angle, const char *label, const KnobGlyphAtlas *glyphs = nullptr);
+
+/// Draw background, scale and knob into the renderer's static layer.
+/// Only needs to be called again when the draw values have changed.
+/// @return False if the renderer could not allocate the static layer
+bool DrawKnobStaticLayer(KnobRenderer &renderer, const KnobDrawValues &drawValues);
+
+/// Draw a knob frame by compositing marker and label on top of the static layer, including BeginDraw() and EndDraw()
+/// @note: DrawKnobStaticLayer() must have been called before
+/// @param[in] glyphs Glyph atlas for the label, or nullptr
+/// @return False if the renderer could not start drawing
+bool DrawKnobLayeredFrame(KnobRenderer &renderer, const KnobDrawValues &drawValues, double angle, const char *label, const KnobGlyphAtlas *glyphs = nullptr);
+
+
+#endif  // KNOBPAINTER_H__
@@ -0,0 +1,68 @@
+#include <string.h>
+#include "knobpixelbuffer.h"
+
+
+KnobPixelBuffer::KnobPixelBuffer(const KnobPixelBuffer &other) : _width(0), _height(0), _data(nullptr), _wrapped(false)
+{
+	*this = other;
+}
+
+KnobPixelBuffer &KnobPixelBuffer::operator =(const KnobPixelBuffer &other)
+{
+	if (this == &other)
+		return *this;
+
+	if (other._width <= 0 || other._height <= 0 || !Init(other._width, other._height))
+	{
+		Free();
+		return *this;
+	}
+
+	memcpy(_data, other._data, (size_t)_width * (size_t)_height * sizeof(KnobColor));
+	return *this;
+}
+
+bool KnobPixelBuffer::Init(int32_t width, int32_t height)
+{
+	if (width <= 0 || height <= 0)
+		return false;
+
+	const size_t pixelCount = (size_t)width * (size_t)height;
+	if (_pixels.size() < pixelCount)
+		_pixels.resize(pixelCount);
+
+	_width = width;
+	_height = height;
+	_data = &_pixels[0];
+	_wrapped = false;
+
+	return true;
+}
+
+void KnobPixelBuffer::Wrap(const KnobColor *pixels, int32_t width, int32_t height)
+{
+	// Never written through, see the note on Wrap()
+	_width = width;
+	_height = height;
+	_data = const_cast<KnobColor*>(pixels);
+	_wrapped = true;
+}
+
+void KnobPixelBuffer::Reserve(size_t pixelCount)
+{
+	// Resized, not just reserved: Init() only ever shrinks the used part, so the pixels are never cleared again
+	if (_pixels.size() < pixelCount)
+		_pixels.resize(pixelCount);
+
+	if (!_wrapped)
+		_data = _pixels.empty() ? nullptr : &_pixels[0];
+}
+
+void KnobPixelBuffer::Free()
+{
+	std::vector<KnobColor>().swap(_pixels);
+	_width = 0;
+	_height = 0;
+	_data = nullptr;
+	_wrapped = false;
+}
@@ -0,0 +1,89 @@
+#ifndef KNOBPIXELBUFFER_H__
+#define KNOBPIXELBUFFER_H__
+
+#include <stddef.h>
+#include <vector>
+#include "knobtypes.h"
+
+
+/// A plain RGBA pixel buffer.
+/// Usually the buffer owns its pixels, but it can also show pixels that belong to someone else, e.g. a memory-mapped file.
+class KnobPixelBuffer
+{
+public:
+	KnobPixelBuffer() : _width(0), _height(0), _data(nullptr), _wrapped(false)
+	{}
+
+	/// Copy the pixels of another buffer. The copy always owns its pixels.
+	KnobPixelBuffer(const KnobPixelBuffer &other);
+
+	/// Copy the pixels of another buffer. The copy always owns its pixels.
+	KnobPixelBuffer &operator =(const KnobPixelBuffer &other);
+
+	/// Set the size of the buffer. Memory is only reallocated if the buffer grows.
+	/// A buffer that shows someone else's pixels gets pixels of its own again.
+	/// @return False if memory could not be allocated
+	bool Init(int32_t width, int32_t height);
+
+	/// Show pixels that belong to someone else instead of the buffer's own, without copying them.
+	/// They must stay valid as long as the buffer shows them, and are only read: the buffer must only be used as const, until the next Init() or Free().
+	/// @param[in] pixels The pixels, row by row without padding
+	/// @param[in] width Width in pixels
+	/// @param[in] height Height in pixels
+	void Wrap(const KnobColor *pixels, int32_t width, int32_t height);
+
+	/// Return true if the buffer shows someone else's pixels
+	bool IsWrapped() const
+	{
+		return _wrapped;
+	}
+
+	/// Allocate memory for a number of pixels up front, so Init() won't have to reallocate (or clear) for sizes up to that
+	void Reserve(size_t pixelCount);
+
+	/// Release the memory. The buffer is empty afterwards.
+	void Free();
+
+	/// Return the allocated memory in bytes. Pixels shown with Wrap() are not included.
+	size_t GetMemorySize() const
+	{
+		return _pixels.capacity() * sizeof(KnobColor);
+	}
+
+	int32_t GetWidth() const
+	{
+		return _width;
+	}
+
+	int32_t GetHeight() const
+	{
+		return _height;
+	}
+
+	/// Return a pointer to the first pixel of a row
+	KnobColor *GetRow(int32_t y)
+	{
+		return _data + (size_t)y * (size_t)_width;
+	}
+
+	const KnobColor *GetRow(int32_t y) const
+	{
+		return _data + (size_t)y * (size_t)_width;
+	}
+
+	/// Return a pixel
+	const KnobColor &GetPixel(int32_t x, int32_t y) const
+	{
+		return GetRow(y)[x];
+	}
+
+private:
+	int32_t _width;                  ///< Width in pixels
+	int32_t _height;                 ///< Height in pixels
+	std::vector<KnobColor> _pixels;  ///< Pixel data, row by row
+	KnobColor *_data;                ///< The pixels the buffer shows, _pixels or the ones given to Wrap()
+	bool _wrapped;                   ///< True if the buffer shows someone else's pixels
+};
+
+
+#endif  // KNOBPIXELBUFFER_H__
@@ -0,0 +1,699 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "knobrasterizer.h"
+#include "knobfont.h"
+#include "knobsimd.h"
+
+
+/// Maximum number of polygon edges crossing a single scanline
+static const int32_t KNOBRASTERIZER_MAXCROSSINGS = 32;
+
+/// Maximum number of polygon corners
+static const int32_t KNOBRASTERIZER_MAXPOINTS = 32;
+
+
+/// Check if a polygon is convex, i.e. all corners turn in the same direction
+static bool IsConvexPolygon(int32_t count, const KnobPointF *points)
+{
+	int32_t sign = 0;
+	for (int32_t i = 0; i < count; ++i)
+	{
+		const KnobPointF &a = points[i];
+		const KnobPointF &b = points[(i + 1) % count];
+		const KnobPointF &c = points[(i + 2) % count];
+		const double cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+		if (cross == 0.0)
+			continue;
+
+		const int32_t turn = cross > 0.0 ? 1 : -1;
+		if (sign != 0 && turn != sign)
+			return false;
+		sign = turn;
+	}
+
+	return true;
+}
+
+
+KnobRasterizer::KnobRasterizer() : _target(nullptr), _current(nullptr), _fontScale(1), _antialiasing(false), _triangleKernel(true)
+{}
+
+KnobRasterizer::KnobRasterizer(KnobPixelBuffer &target) : _target(&target), _current(&target), _fontScale(1), _antialiasing(false), _triangleKernel(true)
+{}
+
+bool KnobRasterizer::BeginDraw(int32_t width, int32_t height)
+{
+	_current = _target;
+	if (!_target || !_target->Init(width, height))
+		return false;
+
+	InitCoverage(width);
+	return true;
+}
+
+void KnobRasterizer::EndDraw()
+{}
+
+bool KnobRasterizer::BeginStaticLayer(int32_t width, int32_t height)
+{
+	_sharedStaticLayer.reset();
+	if (!_staticLayer.Init(width, height))
+		return false;
+
+	InitCoverage(width);
+
+	_current = &_staticLayer;
+	return true;
+}
+
+void KnobRasterizer::EndStaticLayer()
+{
+	_current = _target;
+}
+
+void KnobRasterizer::DrawStaticLayer()
+{
+	const KnobPixelBuffer &layer = _sharedStaticLayer ? *_sharedStaticLayer : _staticLayer;
+	const int32_t width = std::min(_target->GetWidth(), layer.GetWidth());
+	const int32_t height = std::min(_target->GetHeight(), layer.GetHeight());
+
+	for (int32_t y = 0; y < height; ++y)
+		memcpy(_target->GetRow(y), layer.GetRow(y), (size_t)width * sizeof(KnobColor));
+}
+
+void KnobRasterizer::DrawBuffer(int32_t x, int32_t y, const KnobPixelBuffer &source, int32_t sx, int32_t sy, int32_t width, int32_t height)
+{
+	// Clip against source and destination
+	if (x < 0)
+	{
+		sx -= x;
+		width += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		sy -= y;
+		height += y;
+		y = 0;
+	}
+	width = std::min(width, std::min(_current->GetWidth() - x, source.GetWidth() - sx));
+	height = std::min(height, std::min(_current->GetHeight() - y, source.GetHeight() - sy));
+	if (width <= 0 || height <= 0 || sx < 0 || sy < 0)
+		return;
+
+	for (int32_t row = 0; row < height; ++row)
+		memcpy(_current->GetRow(y + row) + x, source.GetRow(sy + row) + sx, (size_t)width * sizeof(KnobColor));
+}
+
+void KnobRasterizer::InitCoverage(int32_t width)
+{
+	if ((int32_t)_coverage.size() < width)
+		_coverage.resize((size_t)width);
+}
+
+void KnobRasterizer::SetColor(const KnobColor &col)
+{
+	_color = col;
+}
+
+void KnobRasterizer::FillSpan(int32_t y, int32_t x1, int32_t x2)
+{
+	if (y < 0 || y >= _current->GetHeight())
+		return;
+
+	x1 = std::max(x1, (int32_t)0);
+	x2 = std::min(x2, _current->GetWidth() - 1);
+	if (x1 > x2)
+		return;
+
+	KnobColor *row = _current->GetRow(y);
+	std::fill(row + x1, row + x2 + 1, _color);
+}
+
+void KnobRasterizer::SetPixel(int32_t x, int32_t y)
+{
+	if (x < 0 || y < 0 || x >= _current->GetWidth() || y >= _current->GetHeight())
+		return;
+
+	_current->GetRow(y)[x] = _color;
+}
+
+void KnobRasterizer::FillRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (x1 > x2)
+		std::swap(x1, x2);
+	if (y1 > y2)
+		std::swap(y1, y2);
+
+	for (int32_t y = y1; y <= y2; ++y)
+		FillSpan(y, x1, x2);
+}
+
+void KnobRasterizer::FillEllipse(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (_antialiasing)
+	{
+		FillEllipseAntialiased(x1, y1, x2, y2);
+		return;
+	}
+
+	if (x1 > x2)
+		std::swap(x1, x2);
+	if (y1 > y2)
+		std::swap(y1, y2);
+
+	// Center and radii. The extra half pixel makes the ellipse touch the rectangle's border pixels.
+	const double centerX = (x1 + x2) * 0.5;
+	const double centerY = (y1 + y2) * 0.5;
+	const double radiusX = (x2 - x1) * 0.5 + 0.5;
+	const double radiusY = (y2 - y1) * 0.5 + 0.5;
+
+	for (int32_t y = y1; y <= y2; ++y)
+	{
+		const double dy = (y - centerY) / radiusY;
+		const double t = 1.0 - dy * dy;
+		if (t < 0.0)
+			continue;
+
+		const double halfSpan = radiusX * sqrt(t);
+		FillSpan(y, (int32_t)ceil(centerX - halfSpan), (int32_t)floor(centerX + halfSpan));
+	}
+}
+
+void KnobRasterizer::FillPolygon(int32_t count, const KnobPointF *points)
+{
+	if (count < 3 || !points)
+		return;
+
+	// The anti-aliased fill relies on the polygon being convex (which the knob marker is, and every triangle)
+	if (_antialiasing && count == 3 && _triangleKernel)
+	{
+		FillConvexPolygonAntialiased<3>(count, points);
+		return;
+	}
+	if (_antialiasing && IsConvexPolygon(count, points))
+	{
+		FillConvexPolygonAntialiased<0>(count, points);
+		return;
+	}
+
+	// Truncate to whole pixels, like GeClipMap
+	KnobPoint pixelPoints[KNOBRASTERIZER_MAXPOINTS];
+	count = std::min(count, KNOBRASTERIZER_MAXPOINTS);
+	for (int32_t i = 0; i < count; ++i)
+	{
+		pixelPoints[i].x = (int32_t)points[i].x;
+		pixelPoints[i].y = (int32_t)points[i].y;
+	}
+
+	FillPolygonAliased(count, pixelPoints);
+}
+
+void KnobRasterizer::FillPolygonAliased(int32_t count, const KnobPoint *points)
+{
+	// Vertical extent
+	int32_t minY = points[0].y;
+	int32_t maxY = points[0].y;
+	for (int32_t i = 1; i < count; ++i)
+	{
+		minY = std::min(minY, points[i].y);
+		maxY = std::max(maxY, points[i].y);
+	}
+
+	// Scanline fill, even-odd rule
+	double crossings[KNOBRASTERIZER_MAXCROSSINGS];
+	for (int32_t y = minY; y <= maxY; ++y)
+	{
+		int32_t crossingCount = 0;
+
+		for (int32_t i = 0, j = count - 1; i < count; j = i++)
+		{
+			const KnobPoint &a = points[i];
+			const KnobPoint &b = points[j];
+
+			// Half-open test, so vertices shared by two edges are only counted once
+			if ((a.y <= y && b.y > y) || (b.y <= y && a.y > y))
+			{
+				if (crossingCount < KNOBRASTERIZER_MAXCROSSINGS)
+					crossings[crossingCount++] = a.x + (double)(y - a.y) * (double)(b.x - a.x) / (double)(b.y - a.y);
+			}
+		}
+
+		std::sort(crossings, crossings + crossingCount);
+
+		for (int32_t i = 0; i + 1 < crossingCount; i += 2)
+			FillSpan(y, (int32_t)ceil(crossings[i]), (int32_t)floor(crossings[i + 1]));
+	}
+
+	// Flat top and bottom edges are not covered by the half-open test above
+	for (int32_t i = 0, j = count - 1; i < count; j = i++)
+	{
+		if (points[i].y == points[j].y && (points[i].y == minY || points[i].y == maxY))
+			FillSpan(points[i].y, std::min(points[i].x, points[j].x), std::max(points[i].x, points[j].x));
+	}
+}
+
+void KnobRasterizer::Line(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (_antialiasing)
+	{
+		LineAntialiased(x1, y1, x2, y2);
+		return;
+	}
+
+	// Bresenham
+	const int32_t dx = abs(x2 - x1);
+	const int32_t dy = -abs(y2 - y1);
+	const int32_t stepX = x1 < x2 ? 1 : -1;
+	const int32_t stepY = y1 < y2 ? 1 : -1;
+	int32_t error = dx + dy;
+
+	for (;;)
+	{
+		SetPixel(x1, y1);
+		if (x1 == x2 && y1 == y2)
+			break;
+
+		const int32_t error2 = 2 * error;
+		if (error2 >= dy)
+		{
+			error += dy;
+			x1 += stepX;
+		}
+		if (error2 <= dx)
+		{
+			error += dx;
+			y1 += stepY;
+		}
+	}
+}
+
+void KnobRasterizer::FillEllipseAntialiased(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (x1 > x2)
+		std::swap(x1, x2);
+	if (y1 > y2)
+		std::swap(y1, y2);
+
+	// Same outline as the aliased ellipse: it passes through the outer borders of the rectangle's border pixels
+	const double centerX = (x1 + x2) * 0.5;
+	const double centerY = (y1 + y2) * 0.5;
+	const double radiusX = (x2 - x1) * 0.5 + 0.5;
+	const double radiusY = (y2 - y1) * 0.5 + 0.5;
+
+	// Pixels inside the inner ellipse are fully covered, pixels outside the outer ellipse are not covered at all.
+	// Only the ring between them needs the distance evaluation.
+	const double outerX = radiusX + 0.5;
+	const double outerY = radiusY + 0.5;
+	const double innerX = radiusX - 0.5;
+	const double innerY = radiusY - 0.5;
+
+	const int32_t firstRow = std::max((int32_t)ceil(centerY - outerY), (int32_t)0);
+	const int32_t lastRow = std::min((int32_t)floor(centerY + outerY), _current->GetHeight() - 1);
+	const int32_t lastColumn = _current->GetWidth() - 1;
+	const KnobSimdKernels &kernels = GetKnobSimdKernels();
+
+	for (int32_t y = firstRow; y <= lastRow; ++y)
+	{
+		const double dy = y - centerY;
+		const double outerT = 1.0 - (dy * dy) / (outerY * outerY);
+		if (outerT < 0.0)
+			continue;
+
+		const double outerHalfSpan = outerX * sqrt(outerT);
+		const int32_t spanStart = std::max((int32_t)ceil(centerX - outerHalfSpan), (int32_t)0);
+		const int32_t spanEnd = std::min((int32_t)floor(centerX + outerHalfSpan), lastColumn);
+
+		// Fully covered part of the row
+		int32_t solidStart = spanEnd + 1;
+		int32_t solidEnd = spanEnd;
+		if (innerX > 0.0 && innerY > 0.0 && fabs(dy) < innerY)
+		{
+			const double innerHalfSpan = innerX * sqrt(1.0 - (dy * dy) / (innerY * innerY));
+			solidStart = std::max((int32_t)ceil(centerX - innerHalfSpan), spanStart);
+			solidEnd = std::min((int32_t)floor(centerX + innerHalfSpan), spanEnd);
+			if (solidStart <= solidEnd)
+				FillSpan(y, solidStart, solidEnd);
+			else
+			{
+				solidStart = spanEnd + 1;
+				solidEnd = spanEnd;
+			}
+		}
+
+		// Edge pixels left and right of the fully covered part
+		KnobEllipseRow ellipseRow;
+		ellipseRow.centerX = (float)centerX;
+		ellipseRow.invRadiusX = (float)(1.0 / radiusX);
+		ellipseRow.nySquared = (float)((dy / radiusY) * (dy / radiusY));
+		ellipseRow.gradientYSquared = (float)((dy / (radiusY * radiusY)) * (dy / (radiusY * radiusY)));
+		ellipseRow.centerDistance = (float)-radiusX;
+
+		KnobColor *row = _current->GetRow(y);
+		auto blendEdge = [&](int32_t start, int32_t end)
+		{
+			if (start > end)
+				return;
+			kernels.ellipseCoverage(&_coverage[0], start, end - start + 1, ellipseRow);
+			kernels.blendSpan(row + start, &_coverage[0], end - start + 1, _color);
+		};
+		blendEdge(spanStart, solidStart - 1);
+		blendEdge(solidEnd + 1, spanEnd);
+	}
+}
+
+template <int32_t COUNT>
+void KnobRasterizer::FillConvexPolygonAntialiased(int32_t count, const KnobPointF *points)
+{
+	// With a fixed number of corners, all loops have fixed counts, and every corner gets a bevel line
+	const int32_t MAXLINES = 2 * (COUNT > 0 ? COUNT : KNOBRASTERIZER_MAXPOINTS);
+	count = COUNT > 0 ? COUNT : std::min(count, KNOBRASTERIZER_MAXPOINTS);
+
+	// Vertex average, lies inside a convex polygon
+	double centerX = 0.0, centerY = 0.0;
+	double minY = points[0].y, maxY = points[0].y;
+	for (int32_t i = 0; i < count; ++i)
+	{
+		centerX += points[i].x;
+		centerY += points[i].y;
+		minY = std::min(minY, points[i].y);
+		maxY = std::max(maxY, points[i].y);
+	}
+	centerX /= (double)count;
+	centerY /= (double)count;
+
+	// Outward normals of the polygon's supporting lines. The signed distance of (x, y) from such a line is normalX * x + normalY * y - offset.
+	// Each edge has one, and each corner gets one along its bisector: without those, the edge lines would extend sharp corners
+	// (like the marker tip) far beyond the polygon.
+	double normalX[MAXLINES];
+	double normalY[MAXLINES];
+	double offset[MAXLINES];
+	int32_t edgeCount = 0;
+	for (int32_t i = 0, j = count - 1; i < count; j = i++)
+	{
+		const double dx = points[i].x - points[j].x;
+		const double dy = points[i].y - points[j].y;
+		const double length = sqrt(dx * dx + dy * dy);
+		if (length <= 0.0)
+		{
+			// Leave polygons with duplicate corners to the general version
+			if (COUNT > 0)
+			{
+				FillConvexPolygonAntialiased<0>(count, points);
+				return;
+			}
+			continue;
+		}
+
+		double nx = dy / length;
+		double ny = -dx / length;
+		double c = nx * points[j].x + ny * points[j].y;
+		if (nx * centerX + ny * centerY - c > 0.0)
+		{
+			nx = -nx;
+			ny = -ny;
+			c = -c;
+		}
+
+		normalX[edgeCount] = nx;
+		normalY[edgeCount] = ny;
+		offset[edgeCount] = c;
+		++edgeCount;
+	}
+	if (edgeCount < 3)
+		return;
+
+	// Corner bevels. Edge e ends at the corner where edge (e + 1) starts.
+	int32_t lineCount = edgeCount;
+	for (int32_t e = 0; e < edgeCount; ++e)
+	{
+		const int32_t next = (e + 1) % edgeCount;
+		const double nx = normalX[e] + normalX[next];
+		const double ny = normalY[e] + normalY[next];
+		const double length = sqrt(nx * nx + ny * ny);
+
+		// Corner point: intersection of both edge lines
+		const double det = normalX[e] * normalY[next] - normalY[e] * normalX[next];
+		if (length <= 1.0e-6 || fabs(det) <= 1.0e-12)
+		{
+			// No bevel needed. Repeating the edge line keeps the line count fixed without changing any distance.
+			if (COUNT > 0)
+			{
+				normalX[lineCount] = normalX[e];
+				normalY[lineCount] = normalY[e];
+				offset[lineCount] = offset[e];
+				++lineCount;
+			}
+			continue;
+		}
+		const double cornerX = (offset[e] * normalY[next] - normalY[e] * offset[next]) / det;
+		const double cornerY = (normalX[e] * offset[next] - offset[e] * normalX[next]) / det;
+
+		normalX[lineCount] = nx / length;
+		normalY[lineCount] = ny / length;
+		offset[lineCount] = normalX[lineCount] * cornerX + normalY[lineCount] * cornerY;
+		++lineCount;
+	}
+	if (COUNT > 0)
+		lineCount = MAXLINES;
+
+	const int32_t firstRow = std::max((int32_t)floor(minY - 0.5), (int32_t)0);
+	const int32_t lastRow = std::min((int32_t)ceil(maxY + 0.5), _current->GetHeight() - 1);
+	const int32_t lastColumn = _current->GetWidth() - 1;
+	const KnobSimdKernels &kernels = GetKnobSimdKernels();
+
+	// The row loop only multiplies
+	float kernelNormalX[MAXLINES];
+	double invNormalX[MAXLINES];
+	for (int32_t e = 0; e < lineCount; ++e)
+	{
+		kernelNormalX[e] = (float)normalX[e];
+		invNormalX[e] = fabs(normalX[e]) < 1.0e-12 ? 0.0 : 1.0 / normalX[e];
+	}
+
+	for (int32_t y = firstRow; y <= lastRow; ++y)
+	{
+		// Each line limits the row to a range of x. Intersecting the ranges where the distance is below 0.5
+		// gives the pixels that can be covered, intersecting the ranges where it is below -0.5 gives the fully covered ones.
+		float rowOffset[MAXLINES];
+		double outerMin = -1.0e30, outerMax = 1.0e30;
+		double innerMin = -1.0e30, innerMax = 1.0e30;
+		for (int32_t e = 0; e < lineCount; ++e)
+		{
+			const double b = normalY[e] * y - offset[e];
+			rowOffset[e] = (float)b;
+			if (invNormalX[e] == 0.0)
+			{
+				if (b >= 0.5)
+					outerMin = 1.0e30;
+				if (b > -0.5)
+					innerMin = 1.0e30;
+			}
+			else if (normalX[e] > 0.0)
+			{
+				outerMax = std::min(outerMax, (0.5 - b) * invNormalX[e]);
+				innerMax = std::min(innerMax, (-0.5 - b) * invNormalX[e]);
+			}
+			else
+			{
+				outerMin = std::max(outerMin, (0.5 - b) * invNormalX[e]);
+				innerMin = std::max(innerMin, (-0.5 - b) * invNormalX[e]);
+			}
+		}
+		if (outerMin > outerMax)
+			continue;
+
+		const int32_t spanStart = (int32_t)std::max(floor(outerMin), 0.0);
+		const int32_t spanEnd = (int32_t)std::min(ceil(outerMax), (double)lastColumn);
+
+		int32_t solidStart = spanEnd + 1;
+		int32_t solidEnd = spanEnd;
+		if (innerMin <= innerMax)
+		{
+			solidStart = (int32_t)std::max(ceil(innerMin), (double)spanStart);
+			solidEnd = (int32_t)std::min(floor(innerMax), (double)spanEnd);
+			if (solidStart <= solidEnd)
+				FillSpan(y, solidStart, solidEnd);
+			else
+			{
+				solidStart = spanEnd + 1;
+				solidEnd = spanEnd;
+			}
+		}
+
+		// Edge pixels. Inside a convex polygon, the distance to the outline is the distance to the closest edge line.
+		// Outside, the largest distance to any supporting line is a close estimate.
+		KnobColor *row = _current->GetRow(y);
+		auto blendEdge = [&](int32_t start, int32_t end)
+		{
+			if (start > end)
+				return;
+			kernels.polygonCoverage(&_coverage[0], start, end - start + 1, lineCount, kernelNormalX, rowOffset);
+			kernels.blendSpan(row + start, &_coverage[0], end - start + 1, _color);
+		};
+		blendEdge(spanStart, solidStart - 1);
+		blendEdge(solidEnd + 1, spanEnd);
+	}
+}
+
+void KnobRasterizer::LineAntialiased(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	// A one pixel wide line covers a pixel by about (1 - distance from the line's center)
+	const int32_t dx = x2 - x1;
+	const int32_t dy = y2 - y1;
+	const double lengthSquared = (double)(dx * dx + dy * dy);
+	const double length = sqrt(lengthSquared);
+
+	const int32_t firstRow = std::max(std::min(y1, y2) - 1, (int32_t)0);
+	const int32_t lastRow = std::min(std::max(y1, y2) + 1, _current->GetHeight() - 1);
+	const int32_t minColumn = std::max(std::min(x1, x2) - 1, (int32_t)0);
+	const int32_t maxColumn = std::min(std::max(x1, x2) + 1, _current->GetWidth() - 1);
+	const KnobSimdKernels &kernels = GetKnobSimdKernels();
+
+	KnobLineRow lineRow;
+	lineRow.startX = (float)x1;
+	lineRow.startY = (float)y1;
+	lineRow.deltaX = (float)dx;
+	lineRow.deltaY = (float)dy;
+	lineRow.invLengthSquared = lengthSquared > 0.0 ? (float)(1.0 / lengthSquared) : 0.0f;
+
+	for (int32_t y = firstRow; y <= lastRow; ++y)
+	{
+		// Horizontal range of the pixels closer than one pixel to the line
+		int32_t spanStart = minColumn;
+		int32_t spanEnd = maxColumn;
+		if (dy != 0)
+		{
+			const double centerX = x1 + (double)(y - y1) * (double)dx / (double)dy;
+			const double halfSpan = length / fabs((double)dy);
+			spanStart = std::max((int32_t)floor(centerX - halfSpan), minColumn);
+			spanEnd = std::min((int32_t)ceil(centerX + halfSpan), maxColumn);
+		}
+		if (spanStart > spanEnd)
+			continue;
+
+		lineRow.y = (float)y;
+		lineRow.rowTerm = (float)((y - y1) * dy);
+
+		const int32_t count = spanEnd - spanStart + 1;
+		kernels.lineCoverage(&_coverage[0], spanStart, count, lineRow);
+		kernels.blendSpan(_current->GetRow(y) + spanStart, &_coverage[0], count, _color);
+	}
+}
+
+void KnobRasterizer::FillMask(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t *mask, int32_t stride)
+{
+	if (!mask)
+		return;
+
+	// Clip against the frame
+	if (x < 0)
+	{
+		mask -= x;
+		width += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		mask -= (ptrdiff_t)y * stride;
+		height += y;
+		y = 0;
+	}
+	width = std::min(width, _current->GetWidth() - x);
+	height = std::min(height, _current->GetHeight() - y);
+	if (width <= 0 || height <= 0)
+		return;
+
+	InitCoverage(width);
+	const KnobSimdKernels &kernels = GetKnobSimdKernels();
+
+	for (int32_t row = 0; row < height; ++row, mask += stride)
+	{
+		KnobColor *rowPixels = _current->GetRow(y + row) + x;
+
+		// Glyph masks are mostly empty or fully covered, only partially covered runs need blending
+		int32_t i = 0;
+		while (i < width)
+		{
+			const int32_t start = i;
+			if (mask[i] == 0)
+			{
+				while (i < width && mask[i] == 0)
+					++i;
+			}
+			else if (mask[i] == 255)
+			{
+				while (i < width && mask[i] == 255)
+					rowPixels[i++] = _color;
+			}
+			else
+			{
+				while (i < width && mask[i] != 0 && mask[i] != 255)
+				{
+					_coverage[i - start] = (float)mask[i] * (1.0f / 255.0f);
+					++i;
+				}
+				kernels.blendSpan(rowPixels + start, &_coverage[0], i - start, _color);
+			}
+		}
+	}
+}
+
+void KnobRasterizer::SetFontSize(int32_t size)
+{
+	_fontScale = GetKnobFontScale(size);
+}
+
+int32_t KnobRasterizer::GetTextWidth(const char *text)
+{
+	if (!text)
+		return 0;
+
+	int32_t length = 0;
+	while (text[length] != 0)
+		++length;
+
+	if (length == 0)
+		return 0;
+
+	// The spacing after the last glyph is not part of the text
+	return (length * KNOBFONT_ADVANCE - (KNOBFONT_ADVANCE - KNOBFONT_GLYPHWIDTH)) * _fontScale;
+}
+
+int32_t KnobRasterizer::GetTextHeight()
+{
+	return KNOBFONT_LINEHEIGHT * _fontScale;
+}
+
+void KnobRasterizer::TextAt(int32_t x, int32_t y, const char *text)
+{
+	if (!text)
+		return;
+
+	// Glyphs are vertically centered in the line
+	const int32_t top = y + (KNOBFONT_LINEHEIGHT - KNOBFONT_GLYPHHEIGHT) / 2 * _fontScale;
+
+	for (; *text != 0; ++text, x += KNOBFONT_ADVANCE * _fontScale)
+	{
+		const uint8_t *glyph = GetKnobFontGlyph(*text);
+		if (!glyph)
+			continue;
+
+		for (int32_t row = 0; row < KNOBFONT_GLYPHHEIGHT; ++row)
+		{
+			for (int32_t column = 0; column < KNOBFONT_GLYPHWIDTH; ++column)
+			{
+				if (!(glyph[row] & (0x10 >> column)))
+					continue;
+
+				// Draw one font pixel as a block of _fontScale * _fontScale pixels
+				const int32_t px = x + column * _fontScale;
+				const int32_t py = top + row * _fontScale;
+				for (int32_t i = 0; i < _fontScale; ++i)
+					FillSpan(py + i, px, px + _fontScale - 1);
+			}
+		}
+	}
+}
@@ -0,0 +1,140 @@
+#ifndef KNOBRASTERIZER_H__
+#define KNOBRASTERIZER_H__
+
+#include <memory>
+#include "knobrenderer.h"
+
+
+/// Pure C++ software implementation of KnobRenderer.
+/// Renders into a KnobPixelBuffer without any dependency on Cinema 4D,
+/// so the knob drawing code can be run, profiled and optimized headlessly.
+///
+/// With anti-aliasing enabled, ellipses, polygons and lines are drawn with analytic
+/// coverage: each edge pixel is blended with the shape color by the amount of the pixel
+/// that lies inside the shape, estimated from its signed distance to the shape outline.
+/// This gives smooth edges at native resolution, without oversampling. Coverage and
+/// blending are computed a row span at a time by the SIMD kernels from knobsimd.h.
+class KnobRasterizer : public KnobRenderer
+{
+public:
+	/// Construct without a buffer. SetTarget() must be called before drawing.
+	KnobRasterizer();
+
+	/// @param[in] target The buffer to draw into
+	explicit KnobRasterizer(KnobPixelBuffer &target);
+
+	virtual bool BeginDraw(int32_t width, int32_t height);
+	virtual void EndDraw();
+	virtual bool BeginStaticLayer(int32_t width, int32_t height);
+	virtual void EndStaticLayer();
+	virtual void DrawStaticLayer();
+	virtual void DrawBuffer(int32_t x, int32_t y, const KnobPixelBuffer &source, int32_t sx, int32_t sy, int32_t width, int32_t height);
+	virtual void SetColor(const KnobColor &col);
+	virtual void FillRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+	virtual void FillEllipse(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+	virtual void FillPolygon(int32_t count, const KnobPointF *points);
+	virtual void Line(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+	virtual void FillMask(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t *mask, int32_t stride);
+	virtual void SetFontSize(int32_t size);
+	virtual int32_t GetTextWidth(const char *text);
+	virtual int32_t GetTextHeight();
+	virtual void TextAt(int32_t x, int32_t y, const char *text);
+
+	/// Enable or disable anti-aliased drawing of ellipses, polygons and lines
+	void SetAntialiasing(bool enable)
+	{
+		_antialiasing = enable;
+	}
+
+	/// Return true if anti-aliasing is enabled
+	bool GetAntialiasing() const
+	{
+		return _antialiasing;
+	}
+
+	/// Fill anti-aliased triangles with the version of the polygon fill for exactly 3 corners (the default),
+	/// or with the one for any number of corners. Both draw the same pixels, knobbench -triangles compares their speed.
+	void SetTriangleKernel(bool enable)
+	{
+		_triangleKernel = enable;
+	}
+
+	/// Return the buffer this rasterizer draws into, or nullptr
+	KnobPixelBuffer *GetTarget()
+	{
+		return _target;
+	}
+
+	/// Set the buffer to draw into. Must not be changed between BeginDraw() and EndDraw().
+	void SetTarget(KnobPixelBuffer *target)
+	{
+		_target = target;
+		_current = target;
+	}
+
+	/// Release the memory of the static layer. It has to be drawn again before it can be used.
+	void FreeStaticLayer()
+	{
+		_staticLayer.Free();
+		_sharedStaticLayer.reset();
+	}
+
+	/// Use a static layer that has been drawn elsewhere, e.g. one from the KnobStaticLayerCache, instead of drawing one.
+	/// It is used until the next BeginStaticLayer() or FreeStaticLayer().
+	/// @param[in] layer The static layer, only read
+	void SetStaticLayer(const std::shared_ptr<const KnobPixelBuffer> &layer)
+	{
+		_staticLayer.Free();
+		_sharedStaticLayer = layer;
+	}
+
+	/// Return the static layer drawn by the last BeginStaticLayer() and EndStaticLayer()
+	const KnobPixelBuffer &GetStaticLayer() const
+	{
+		return _staticLayer;
+	}
+
+	/// Return the memory held by the rasterizer itself (static layer and coverage), in bytes. A static layer set with SetStaticLayer() is not included.
+	size_t GetMemorySize() const
+	{
+		return _staticLayer.GetMemorySize() + _coverage.capacity() * sizeof(float);
+	}
+
+private:
+	/// Fill a horizontal span of pixels. Coordinates are clipped.
+	void FillSpan(int32_t y, int32_t x1, int32_t x2);
+
+	/// Set a single pixel. Coordinates are clipped.
+	void SetPixel(int32_t x, int32_t y);
+
+	/// Make sure the coverage buffer can hold a row of the given width
+	void InitCoverage(int32_t width);
+
+	/// Scanline fill of a polygon with whole pixel corners, even-odd rule
+	void FillPolygonAliased(int32_t count, const KnobPoint *points);
+
+	/// Anti-aliased fill of a convex polygon with subpixel corners.
+	/// COUNT > 0 is a version for polygons with exactly COUNT corners, with fixed loop counts. 0 handles any count.
+	template <int32_t COUNT>
+	void FillConvexPolygonAntialiased(int32_t count, const KnobPointF *points);
+
+	/// Anti-aliased ellipse that fits into the given rectangle
+	void FillEllipseAntialiased(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+	/// Anti-aliased line, one pixel wide
+	void LineAntialiased(int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+private:
+	KnobPixelBuffer    *_target;       ///< The buffer to draw into
+	KnobPixelBuffer     _staticLayer;  ///< Cached static layer
+	std::shared_ptr<const KnobPixelBuffer> _sharedStaticLayer;  ///< Static layer drawn elsewhere, used instead of _staticLayer if set
+	KnobPixelBuffer    *_current;      ///< The buffer the drawing functions currently draw into
+	KnobColor           _color;        ///< Current draw color
+	int32_t             _fontScale;    ///< Scale factor for the built-in font
+	bool                _antialiasing; ///< Draw shapes with anti-aliasing
+	bool                _triangleKernel;  ///< Fill triangles with the version for 3 corners
+	std::vector<float>  _coverage;     ///< Coverage of the span that is currently drawn
+};
+
+
+#endif  // KNOBRASTERIZER_H__
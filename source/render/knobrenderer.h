@@ -0,0 +1,91 @@
+#ifndef KNOBRENDERER_H__
+#define KNOBRENDERER_H__
+
+#include "knobpixelbuffer.h"
+
+
+/// Abstract drawing backend for the rotary knob.
+/// The knob drawing functions only talk to this interface, so the same drawing code
+/// can render into a GeClipMap (inside Cinema 4D) or into a plain RGBA buffer (headless).
+/// Coordinates are pixels, all rectangles are inclusive (like in GeClipMap).
+class KnobRenderer
+{
+public:
+	virtual ~KnobRenderer()
+	{}
+
+	/// Prepare the backend for drawing a frame of the given size
+	/// @param[in] width Width of the frame in pixels
+	/// @param[in] height Height of the frame in pixels
+	/// @return False if the drawing surface could not be allocated
+	virtual bool BeginDraw(int32_t width, int32_t height) = 0;
+
+	/// Finish drawing the current frame
+	virtual void EndDraw() = 0;
+
+	/// Start drawing into the static layer instead of the frame.
+	/// The static layer holds the parts of the knob that don't change with the value.
+	/// @param[in] width Width of the layer in pixels
+	/// @param[in] height Height of the layer in pixels
+	/// @return False if the layer could not be allocated
+	virtual bool BeginStaticLayer(int32_t width, int32_t height) = 0;
+
+	/// Finish drawing into the static layer
+	virtual void EndStaticLayer() = 0;
+
+	/// Copy the static layer into the current frame
+	/// @note: Must be called between BeginDraw() and EndDraw()
+	virtual void DrawStaticLayer() = 0;
+
+	/// Copy a rectangle of pixels from a buffer into the current frame
+	/// @note: Must be called between BeginDraw() and EndDraw()
+	/// @param[in] x Left border of the destination rectangle
+	/// @param[in] y Upper border of the destination rectangle
+	/// @param[in] source The buffer to copy from
+	/// @param[in] sx Left border of the source rectangle
+	/// @param[in] sy Upper border of the source rectangle
+	/// @param[in] width Width of the rectangle
+	/// @param[in] height Height of the rectangle
+	virtual void DrawBuffer(int32_t x, int32_t y, const KnobPixelBuffer &source, int32_t sx, int32_t sy, int32_t width, int32_t height) = 0;
+
+	/// Set the color used by all following drawing calls
+	virtual void SetColor(const KnobColor &col) = 0;
+
+	/// Fill a rectangle
+	virtual void FillRect(int32_t x1, int32_t y1, int32_t x2, int32_t y2) = 0;
+
+	/// Fill the ellipse that fits into the given rectangle
+	virtual void FillEllipse(int32_t x1, int32_t y1, int32_t x2, int32_t y2) = 0;
+
+	/// Fill a polygon. Backends without anti-aliasing truncate the points to whole pixels.
+	/// @param[in] count Number of points
+	/// @param[in] points Pointer to an array of count points
+	virtual void FillPolygon(int32_t count, const KnobPointF *points) = 0;
+
+	/// Draw a line
+	virtual void Line(int32_t x1, int32_t y1, int32_t x2, int32_t y2) = 0;
+
+	/// Blend the current color into the frame, weighted by an 8 bit coverage mask (e.g. a glyph)
+	/// @param[in] x Left border of the destination rectangle
+	/// @param[in] y Upper border of the destination rectangle
+	/// @param[in] width Width of the mask
+	/// @param[in] height Height of the mask
+	/// @param[in] mask Pointer to the coverage of the upper left pixel, 0 ... 255
+	/// @param[in] stride Distance between two mask rows in bytes
+	virtual void FillMask(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t *mask, int32_t stride) = 0;
+
+	/// Set the font size used by all following text calls
+	virtual void SetFontSize(int32_t size) = 0;
+
+	/// Return the width of a text in pixels
+	virtual int32_t GetTextWidth(const char *text) = 0;
+
+	/// Return the height of a line of text in pixels
+	virtual int32_t GetTextHeight() = 0;
+
+	/// Draw a text, with (x, y) being its upper left corner
+	virtual void TextAt(int32_t x, int32_t y, const char *text) = 0;
+};
+
+
+#endif  // KNOBRENDERER_H__
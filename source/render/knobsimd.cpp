@@ -0,0 +1,288 @@
+#include <algorithm>
+#include "knobsimd.h"
+#include "knobsimd_scalar.h"
+
+
+//----------------------------------------------------------------------------------------
+// Scalar kernels
+//----------------------------------------------------------------------------------------
+
+static void EllipseCoverageScalar(float *coverage, int32_t x, int32_t count, const KnobEllipseRow &row)
+{
+	for (int32_t i = 0; i < count; ++i)
+		coverage[i] = EllipseCoverage((float)(x + i), row);
+}
+
+template <int32_t LINES>
+static void PolygonCoverageScalarLines(float *coverage, int32_t x, int32_t count, int32_t lineCount, const float *normalX, const float *rowOffset)
+{
+	for (int32_t i = 0; i < count; ++i)
+		coverage[i] = PolygonCoverage<LINES>((float)(x + i), lineCount, normalX, rowOffset);
+}
+
+static void PolygonCoverageScalar(float *coverage, int32_t x, int32_t count, int32_t lineCount, const float *normalX, const float *rowOffset)
+{
+	if (lineCount == KNOBSIMD_TRIANGLELINES)
+		PolygonCoverageScalarLines<KNOBSIMD_TRIANGLELINES>(coverage, x, count, lineCount, normalX, rowOffset);
+	else
+		PolygonCoverageScalarLines<0>(coverage, x, count, lineCount, normalX, rowOffset);
+}
+
+static void LineCoverageScalar(float *coverage, int32_t x, int32_t count, const KnobLineRow &row)
+{
+	for (int32_t i = 0; i < count; ++i)
+		coverage[i] = LineCoverage((float)(x + i), row);
+}
+
+static void BlendSpanScalar(KnobColor *pixels, const float *coverage, int32_t count, const KnobColor &color)
+{
+	const float colorAlpha = (float)color.a / 255.0f;
+	for (int32_t i = 0; i < count; ++i)
+		BlendPixel(pixels[i], coverage[i], color, colorAlpha);
+}
+
+static const KnobSimdKernels g_knobKernelsScalar = { EllipseCoverageScalar, PolygonCoverageScalar, LineCoverageScalar, BlendSpanScalar };
+
+
+#ifdef KNOBSIMD_X86
+
+//----------------------------------------------------------------------------------------
+// SSE2 kernels, 4 pixels at a time
+//----------------------------------------------------------------------------------------
+
+static inline __m128 ClampCoverageSse2(__m128 coverage)
+{
+	return _mm_min_ps(_mm_max_ps(coverage, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+/// Return the x coordinates of 4 consecutive pixels
+static inline __m128 PixelXSse2(int32_t x)
+{
+	return _mm_add_ps(_mm_set1_ps((float)x), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+}
+
+static void EllipseCoverageSse2(float *coverage, int32_t x, int32_t count, const KnobEllipseRow &row)
+{
+	const __m128 centerX = _mm_set1_ps(row.centerX);
+	const __m128 invRadiusX = _mm_set1_ps(row.invRadiusX);
+	const __m128 nySquared = _mm_set1_ps(row.nySquared);
+	const __m128 gradientYSquared = _mm_set1_ps(row.gradientYSquared);
+	const __m128 centerDistance = _mm_set1_ps(row.centerDistance);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 nx = _mm_mul_ps(_mm_sub_ps(PixelXSse2(x + i), centerX), invRadiusX);
+		const __m128 k = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(nx, nx), nySquared));
+		const __m128 gradientX = _mm_mul_ps(nx, invRadiusX);
+		const __m128 gradient = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(gradientX, gradientX), gradientYSquared));
+
+		// Where the gradient is 0, the division gives garbage that is masked out
+		const __m128 valid = _mm_cmpgt_ps(gradient, _mm_setzero_ps());
+		const __m128 distance = _mm_or_ps(_mm_and_ps(valid, _mm_div_ps(_mm_mul_ps(_mm_sub_ps(k, one), k), gradient)), _mm_andnot_ps(valid, centerDistance));
+
+		_mm_storeu_ps(coverage + i, ClampCoverageSse2(_mm_sub_ps(half, distance)));
+	}
+
+	for (; i < count; ++i)
+		coverage[i] = EllipseCoverage((float)(x + i), row);
+}
+
+template <int32_t LINES>
+static void PolygonCoverageSse2Lines(float *coverage, int32_t x, int32_t count, int32_t lineCount, const float *normalX, const float *rowOffset)
+{
+	if (LINES > 0)
+		lineCount = LINES;
+
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 px = PixelXSse2(x + i);
+		__m128 distance = _mm_set1_ps(-1.0e30f);
+		for (int32_t e = 0; e < lineCount; ++e)
+			distance = _mm_max_ps(distance, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(normalX[e]), px), _mm_set1_ps(rowOffset[e])));
+
+		_mm_storeu_ps(coverage + i, ClampCoverageSse2(_mm_sub_ps(half, distance)));
+	}
+
+	for (; i < count; ++i)
+		coverage[i] = PolygonCoverage<LINES>((float)(x + i), lineCount, normalX, rowOffset);
+}
+
+static void PolygonCoverageSse2(float *coverage, int32_t x, int32_t count, int32_t lineCount, const float *normalX, const float *rowOffset)
+{
+	if (lineCount == KNOBSIMD_TRIANGLELINES)
+		PolygonCoverageSse2Lines<KNOBSIMD_TRIANGLELINES>(coverage, x, count, lineCount, normalX, rowOffset);
+	else
+		PolygonCoverageSse2Lines<0>(coverage, x, count, lineCount, normalX, rowOffset);
+}
+
+static void LineCoverageSse2(float *coverage, int32_t x, int32_t count, const KnobLineRow &row)
+{
+	const __m128 startX = _mm_set1_ps(row.startX);
+	const __m128 deltaX = _mm_set1_ps(row.deltaX);
+	const __m128 rowTerm = _mm_set1_ps(row.rowTerm);
+	const __m128 invLengthSquared = _mm_set1_ps(row.invLengthSquared);
+	const __m128 ey = _mm_set1_ps(row.y);
+	const __m128 startY = _mm_set1_ps(row.startY);
+	const __m128 deltaY = _mm_set1_ps(row.deltaY);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 px = PixelXSse2(x + i);
+		const __m128 t = ClampCoverageSse2(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(px, startX), deltaX), rowTerm), invLengthSquared));
+		const __m128 dx = _mm_sub_ps(px, _mm_add_ps(startX, _mm_mul_ps(t, deltaX)));
+		const __m128 dy = _mm_sub_ps(ey, _mm_add_ps(startY, _mm_mul_ps(t, deltaY)));
+		const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+
+		_mm_storeu_ps(coverage + i, ClampCoverageSse2(_mm_sub_ps(one, distance)));
+	}
+
+	for (; i < count; ++i)
+		coverage[i] = LineCoverage((float)(x + i), row);
+}
+
+/// Blend one pixel, given as 4 float channels
+static inline __m128i BlendChannelsSse2(__m128 pixel, __m128 alpha, __m128 keep, __m128 color)
+{
+	const __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pixel, keep), _mm_mul_ps(color, alpha)), _mm_set1_ps(0.5f));
+	return _mm_cvttps_epi32(result);
+}
+
+static void BlendSpanSse2(KnobColor *pixels, const float *coverage, int32_t count, const KnobColor &color)
+{
+	const float colorAlpha = (float)color.a / 255.0f;
+	const __m128 colorAlphaVector = _mm_set1_ps(colorAlpha);
+	const __m128 colorVector = _mm_set_ps(255.0f, (float)color.b, (float)color.g, (float)color.r);
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128i zero = _mm_setzero_si128();
+
+	int32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		// Expand 4 RGBA pixels to 4 float vectors
+		const __m128i packed = _mm_loadu_si128((const __m128i*)(pixels + i));
+		const __m128i low = _mm_unpacklo_epi8(packed, zero);
+		const __m128i high = _mm_unpackhi_epi8(packed, zero);
+		const __m128 p0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+		const __m128 p1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+		const __m128 p2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+		const __m128 p3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+
+		const __m128 alpha = _mm_mul_ps(_mm_loadu_ps(coverage + i), colorAlphaVector);
+		const __m128 keep = _mm_sub_ps(one, alpha);
+
+		const __m128i r0 = BlendChannelsSse2(p0, _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(keep, keep, _MM_SHUFFLE(0, 0, 0, 0)), colorVector);
+		const __m128i r1 = BlendChannelsSse2(p1, _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(keep, keep, _MM_SHUFFLE(1, 1, 1, 1)), colorVector);
+		const __m128i r2 = BlendChannelsSse2(p2, _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(keep, keep, _MM_SHUFFLE(2, 2, 2, 2)), colorVector);
+		const __m128i r3 = BlendChannelsSse2(p3, _mm_shuffle_ps(alpha, alpha, _MM_SHUFFLE(3, 3, 3, 3)), _mm_shuffle_ps(keep, keep, _MM_SHUFFLE(3, 3, 3, 3)), colorVector);
+
+		// Pack back to 8 bit
+		_mm_storeu_si128((__m128i*)(pixels + i), _mm_packus_epi16(_mm_packs_epi32(r0, r1), _mm_packs_epi32(r2, r3)));
+	}
+
+	for (; i < count; ++i)
+		BlendPixel(pixels[i], coverage[i], color, colorAlpha);
+}
+
+static const KnobSimdKernels g_knobKernelsSse2 = { EllipseCoverageSse2, PolygonCoverageSse2, LineCoverageSse2, BlendSpanSse2 };
+
+
+#endif  // KNOBSIMD_X86
+
+
+//----------------------------------------------------------------------------------------
+// Dispatch
+//----------------------------------------------------------------------------------------
+
+/// Check which instruction sets the CPU (and OS) support
+static KnobSimdLevel DetectKnobSimdLevel()
+{
+#ifdef KNOBSIMD_X86
+	#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		const bool sse2 = (info[3] & (1 << 26)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+
+		// AVX2 also needs the OS to save the YMM registers
+		bool avx2 = false;
+		if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	#else
+		__builtin_cpu_init();
+		const bool sse2 = __builtin_cpu_supports("sse2") != 0;
+		const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+	#endif
+
+	if (avx2)
+		return KNOBSIMD_AVX2;
+	if (sse2)
+		return KNOBSIMD_SSE2;
+#endif
+
+	return KNOBSIMD_SCALAR;
+}
+
+static const KnobSimdLevel g_knobSimdSupportedLevel = DetectKnobSimdLevel();
+static KnobSimdLevel g_knobSimdLevel = std::min(g_knobSimdSupportedLevel, KNOBSIMD_SSE2);
+
+
+KnobSimdLevel GetSupportedKnobSimdLevel()
+{
+	return g_knobSimdSupportedLevel;
+}
+
+KnobSimdLevel GetDefaultKnobSimdLevel()
+{
+	return std::min(g_knobSimdSupportedLevel, KNOBSIMD_SSE2);
+}
+
+KnobSimdLevel GetKnobSimdLevel()
+{
+	return g_knobSimdLevel;
+}
+
+KnobSimdLevel SetKnobSimdLevel(KnobSimdLevel level)
+{
+	g_knobSimdLevel = std::min(level, g_knobSimdSupportedLevel);
+	return g_knobSimdLevel;
+}
+
+const char *GetKnobSimdLevelName(KnobSimdLevel level)
+{
+	switch (level)
+	{
+		case KNOBSIMD_AVX2:
+			return "avx2";
+		case KNOBSIMD_SSE2:
+			return "sse2";
+		default:
+			return "scalar";
+	}
+}
+
+const KnobSimdKernels &GetKnobSimdKernels()
+{
+#ifdef KNOBSIMD_X86
+	if (g_knobSimdLevel == KNOBSIMD_AVX2)
+		return g_knobKernelsAvx2;
+	if (g_knobSimdLevel == KNOBSIMD_SSE2)
+		return g_knobKernelsSse2;
+#endif
+
+	return g_knobKernelsScalar;
+}
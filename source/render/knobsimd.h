@@ -0,0 +1,82 @@
+#ifndef KNOBSIMD_H__
+#define KNOBSIMD_H__
+
+#include "knobtypes.h"
+
+
+/// Instruction set used by the shape kernels
+enum KnobSimdLevel
+{
+	KNOBSIMD_SCALAR = 0,  ///< Plain C++
+	KNOBSIMD_SSE2   = 1,  ///< 4 pixels at a time
+	KNOBSIMD_AVX2   = 2   ///< 8 pixels at a time. Only used when selected with SetKnobSimdLevel(), see GetDefaultKnobSimdLevel().
+};
+
+
+/// Per-row parameters for the ellipse coverage kernel.
+/// The ellipse is centered at (centerX, row y), with the row's normalized vertical offset already applied.
+struct KnobEllipseRow
+{
+	float centerX;          ///< Horizontal center of the ellipse
+	float invRadiusX;       ///< 1 / horizontal radius
+	float nySquared;        ///< Squared vertical offset of the row from the center, divided by the vertical radius
+	float gradientYSquared; ///< Squared vertical component of the gradient of the implicit ellipse function in this row
+	float centerDistance;   ///< Distance to use where the gradient vanishes (the center)
+};
+
+/// Per-row parameters for the line coverage kernel
+struct KnobLineRow
+{
+	float startX;           ///< Start point of the line
+	float startY;
+	float deltaX;           ///< End point minus start point
+	float deltaY;
+	float invLengthSquared; ///< 1 / squared length of the line, or 0 for a single point
+	float y;                ///< The row
+	float rowTerm;          ///< (y - startY) * deltaY
+};
+
+
+/// Function table with the shape kernels for one instruction set.
+/// Coverage kernels write one coverage value (0.0 ... 1.0) per pixel, for count pixels starting at x.
+/// All implementations produce bit-identical results.
+struct KnobSimdKernels
+{
+	/// Coverage of pixels by an anti-aliased ellipse
+	void (*ellipseCoverage)(float *coverage, int32_t x, int32_t count, const KnobEllipseRow &row);
+
+	/// Coverage of pixels by an anti-aliased convex polygon, given as supporting lines.
+	/// The signed distance from line e is normalX[e] * x + rowOffset[e] in the current row.
+	void (*polygonCoverage)(float *coverage, int32_t x, int32_t count, int32_t lineCount, const float *normalX, const float *rowOffset);
+
+	/// Coverage of pixels by an anti-aliased line, one pixel wide
+	void (*lineCoverage)(float *coverage, int32_t x, int32_t count, const KnobLineRow &row);
+
+	/// Blend a color into a span of pixels, weighted by coverage
+	void (*blendSpan)(KnobColor *pixels, const float *coverage, int32_t count, const KnobColor &color);
+};
+
+
+/// Return the best instruction set the CPU supports
+KnobSimdLevel GetSupportedKnobSimdLevel();
+
+/// Return the instruction set that is used unless another one is selected: SSE2 if the CPU supports it.
+/// The spans of a knob are mostly too short for 8 pixels at a time, and AVX2 measured slower than SSE2 in knobbench.
+KnobSimdLevel GetDefaultKnobSimdLevel();
+
+/// Return the instruction set currently used by GetKnobSimdKernels()
+KnobSimdLevel GetKnobSimdLevel();
+
+/// Select the instruction set, e.g. to compare them in a benchmark.
+/// Levels the CPU doesn't support fall back to the best supported one.
+/// @return The level that is used now
+KnobSimdLevel SetKnobSimdLevel(KnobSimdLevel level);
+
+/// Return the name of an instruction set
+const char *GetKnobSimdLevelName(KnobSimdLevel level);
+
+/// Return the kernels for the current instruction set. By default the ones of GetDefaultKnobSimdLevel().
+const KnobSimdKernels &GetKnobSimdKernels();
+
+
+#endif  // KNOBSIMD_H__
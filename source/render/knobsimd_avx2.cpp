@@ -0,0 +1,160 @@
+// The AVX2 kernels, in a file of their own so MSVC can compile it with /arch:AVX (set for this file
+// in the project). Without it, MSVC encodes the scalar code and 128 bit intrinsics here with legacy SSE
+// instructions, and switching between those and 256 bit AVX code costs more than the wider vectors gain.
+// /arch:AVX2 is not used, because MSVC may then fuse multiplies and adds, and the results would no
+// longer be identical to the other kernels. GCC and Clang compile the functions for AVX2 by their
+// target attribute. Nothing here may run before GetKnobSimdKernels() has checked the CPU.
+#include "knobsimd_scalar.h"
+
+#ifdef KNOBSIMD_X86
+
+#if defined(_MSC_VER)
+	#pragma fp_contract(off)
+#endif
+
+
+//----------------------------------------------------------------------------------------
+// AVX2 kernels, 8 pixels at a time
+//----------------------------------------------------------------------------------------
+
+KNOBSIMD_TARGET_AVX2 static inline __m256 ClampCoverageAvx2(__m256 coverage)
+{
+	return _mm256_min_ps(_mm256_max_ps(coverage, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+}
+
+/// Return the x coordinates of 8 consecutive pixels
+KNOBSIMD_TARGET_AVX2 static inline __m256 PixelXAvx2(int32_t x)
+{
+	return _mm256_add_ps(_mm256_set1_ps((float)x), _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f));
+}
+
+KNOBSIMD_TARGET_AVX2 static void EllipseCoverageAvx2(float *coverage, int32_t x, int32_t count, const KnobEllipseRow &row)
+{
+	const __m256 centerX = _mm256_set1_ps(row.centerX);
+	const __m256 invRadiusX = _mm256_set1_ps(row.invRadiusX);
+	const __m256 nySquared = _mm256_set1_ps(row.nySquared);
+	const __m256 gradientYSquared = _mm256_set1_ps(row.gradientYSquared);
+	const __m256 centerDistance = _mm256_set1_ps(row.centerDistance);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 nx = _mm256_mul_ps(_mm256_sub_ps(PixelXAvx2(x + i), centerX), invRadiusX);
+		const __m256 k = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), nySquared));
+		const __m256 gradientX = _mm256_mul_ps(nx, invRadiusX);
+		const __m256 gradient = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(gradientX, gradientX), gradientYSquared));
+
+		const __m256 valid = _mm256_cmp_ps(gradient, _mm256_setzero_ps(), _CMP_GT_OQ);
+		const __m256 distance = _mm256_blendv_ps(centerDistance, _mm256_div_ps(_mm256_mul_ps(_mm256_sub_ps(k, one), k), gradient), valid);
+
+		_mm256_storeu_ps(coverage + i, ClampCoverageAvx2(_mm256_sub_ps(half, distance)));
+	}
+
+	// The scalar code is compiled for AVX2 here, too, so there is no switch between AVX and SSE instructions
+	for (; i < count; ++i)
+		coverage[i] = EllipseCoverage((float)(x + i), row);
+}
+
+template <int32_t LINES>
+KNOBSIMD_TARGET_AVX2 static void PolygonCoverageAvx2Lines(float *coverage, int32_t x, int32_t count, int32_t lineCount, const float *normalX, const float *rowOffset)
+{
+	if (LINES > 0)
+		lineCount = LINES;
+
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 px = PixelXAvx2(x + i);
+		__m256 distance = _mm256_set1_ps(-1.0e30f);
+		for (int32_t e = 0; e < lineCount; ++e)
+			distance = _mm256_max_ps(distance, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(normalX[e]), px), _mm256_set1_ps(rowOffset[e])));
+
+		_mm256_storeu_ps(coverage + i, ClampCoverageAvx2(_mm256_sub_ps(half, distance)));
+	}
+
+	// The marker's edges are mostly shorter than a vector. The scalar code is compiled for AVX2 here, too,
+	// so there is no switch between AVX and SSE instructions.
+	for (; i < count; ++i)
+		coverage[i] = PolygonCoverage<LINES>((float)(x + i), lineCount, normalX, rowOffset);
+}
+
+KNOBSIMD_TARGET_AVX2 static void PolygonCoverageAvx2(float *coverage, int32_t x, int32_t count, int32_t lineCount, const float *normalX, const float *rowOffset)
+{
+	if (lineCount == KNOBSIMD_TRIANGLELINES)
+		PolygonCoverageAvx2Lines<KNOBSIMD_TRIANGLELINES>(coverage, x, count, lineCount, normalX, rowOffset);
+	else
+		PolygonCoverageAvx2Lines<0>(coverage, x, count, lineCount, normalX, rowOffset);
+}
+
+KNOBSIMD_TARGET_AVX2 static void LineCoverageAvx2(float *coverage, int32_t x, int32_t count, const KnobLineRow &row)
+{
+	const __m256 startX = _mm256_set1_ps(row.startX);
+	const __m256 deltaX = _mm256_set1_ps(row.deltaX);
+	const __m256 rowTerm = _mm256_set1_ps(row.rowTerm);
+	const __m256 invLengthSquared = _mm256_set1_ps(row.invLengthSquared);
+	const __m256 ey = _mm256_set1_ps(row.y);
+	const __m256 startY = _mm256_set1_ps(row.startY);
+	const __m256 deltaY = _mm256_set1_ps(row.deltaY);
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 px = PixelXAvx2(x + i);
+		const __m256 t = ClampCoverageAvx2(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(px, startX), deltaX), rowTerm), invLengthSquared));
+		const __m256 dx = _mm256_sub_ps(px, _mm256_add_ps(startX, _mm256_mul_ps(t, deltaX)));
+		const __m256 dy = _mm256_sub_ps(ey, _mm256_add_ps(startY, _mm256_mul_ps(t, deltaY)));
+		const __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+
+		_mm256_storeu_ps(coverage + i, ClampCoverageAvx2(_mm256_sub_ps(one, distance)));
+	}
+
+	for (; i < count; ++i)
+		coverage[i] = LineCoverage((float)(x + i), row);
+}
+
+/// Blend two pixels, given as 8 float channels
+KNOBSIMD_TARGET_AVX2 static inline __m256i BlendChannelsAvx2(const KnobColor *pixels, __m256 alpha, __m256 keep, __m256i pair, __m256 color)
+{
+	const __m256 pixel = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)pixels)));
+	const __m256 pairAlpha = _mm256_permutevar8x32_ps(alpha, pair);
+	const __m256 pairKeep = _mm256_permutevar8x32_ps(keep, pair);
+	const __m256 result = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(pixel, pairKeep), _mm256_mul_ps(color, pairAlpha)), _mm256_set1_ps(0.5f));
+	return _mm256_cvttps_epi32(result);
+}
+
+KNOBSIMD_TARGET_AVX2 static void BlendSpanAvx2(KnobColor *pixels, const float *coverage, int32_t count, const KnobColor &color)
+{
+	const float colorAlpha = (float)color.a / 255.0f;
+	const __m256 colorAlphaVector = _mm256_set1_ps(colorAlpha);
+	const __m256 colorVector = _mm256_setr_ps((float)color.r, (float)color.g, (float)color.b, 255.0f, (float)color.r, (float)color.g, (float)color.b, 255.0f);
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	int32_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 alpha = _mm256_mul_ps(_mm256_loadu_ps(coverage + i), colorAlphaVector);
+		const __m256 keep = _mm256_sub_ps(one, alpha);
+
+		// Each vector holds the 4 channels of 2 pixels
+		const __m256i r01 = BlendChannelsAvx2(pixels + i + 0, alpha, keep, _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1), colorVector);
+		const __m256i r23 = BlendChannelsAvx2(pixels + i + 2, alpha, keep, _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3), colorVector);
+		const __m256i r45 = BlendChannelsAvx2(pixels + i + 4, alpha, keep, _mm256_setr_epi32(4, 4, 4, 4, 5, 5, 5, 5), colorVector);
+		const __m256i r67 = BlendChannelsAvx2(pixels + i + 6, alpha, keep, _mm256_setr_epi32(6, 6, 6, 6, 7, 7, 7, 7), colorVector);
+
+		// Packing works within 128 bit lanes and leaves the pixels in the order 0 2 4 6 1 3 5 7
+		const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(r01, r23), _mm256_packs_epi32(r45, r67));
+		_mm256_storeu_si256((__m256i*)(pixels + i), _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+	}
+
+	for (; i < count; ++i)
+		BlendPixel(pixels[i], coverage[i], color, colorAlpha);
+}
+
+extern const KnobSimdKernels g_knobKernelsAvx2 = { EllipseCoverageAvx2, PolygonCoverageAvx2, LineCoverageAvx2, BlendSpanAvx2 };
+
+#endif  // KNOBSIMD_X86
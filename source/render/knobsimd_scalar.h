@@ -0,0 +1,101 @@
+#ifndef KNOBSIMD_SCALAR_H__
+#define KNOBSIMD_SCALAR_H__
+
+#include <math.h>
+#include "knobsimd.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define KNOBSIMD_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		// MSVC compiles intrinsics for any instruction set without extra switches. knobsimd_avx2.cpp
+		// is compiled with /arch:AVX, so all code in it uses the VEX encoding.
+		#include <intrin.h>
+		#define KNOBSIMD_TARGET_AVX2
+	#else
+		// GCC and Clang only accept AVX2 intrinsics in functions that are compiled for AVX2.
+		// This way the rest of the plugin keeps running on CPUs without AVX2.
+		#define KNOBSIMD_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+
+//----------------------------------------------------------------------------------------
+// Scalar kernels. The SIMD kernels use them for the pixels that don't fill a whole vector,
+// and do exactly the same floating point operations in the same order.
+// Everything here has internal linkage: knobsimd_avx2.cpp compiles it with other instruction
+// set switches, and the linker must not pick that version for the other kernels.
+//----------------------------------------------------------------------------------------
+
+/// Same as std::min() and std::max(), whose out-of-line copies would be shared with knobsimd_avx2.cpp
+static inline float KnobSimdMin(float a, float b)
+{
+	return b < a ? b : a;
+}
+
+static inline float KnobSimdMax(float a, float b)
+{
+	return a < b ? b : a;
+}
+
+static inline float ClampCoverage(float coverage)
+{
+	return KnobSimdMin(KnobSimdMax(coverage, 0.0f), 1.0f);
+}
+
+static inline float EllipseCoverage(float x, const KnobEllipseRow &row)
+{
+	// The distance is the implicit ellipse function divided by its gradient length, which is exact for circles
+	const float nx = (x - row.centerX) * row.invRadiusX;
+	const float k = sqrtf(nx * nx + row.nySquared);
+	const float gradientX = nx * row.invRadiusX;
+	const float gradient = sqrtf(gradientX * gradientX + row.gradientYSquared);
+	const float distance = gradient > 0.0f ? (k - 1.0f) * k / gradient : row.centerDistance;
+	return ClampCoverage(0.5f - distance);
+}
+
+/// Number of supporting lines of an anti-aliased triangle (3 edges and 3 corner bevels).
+/// The polygon kernels have a version with this many lines compiled in.
+static const int32_t KNOBSIMD_TRIANGLELINES = 6;
+
+/// LINES > 0 is the number of lines, known at compile time. 0 uses lineCount.
+template <int32_t LINES>
+static inline float PolygonCoverage(float x, int32_t lineCount, const float *normalX, const float *rowOffset)
+{
+	if (LINES > 0)
+		lineCount = LINES;
+
+	float distance = -1.0e30f;
+	for (int32_t e = 0; e < lineCount; ++e)
+		distance = KnobSimdMax(distance, normalX[e] * x + rowOffset[e]);
+	return ClampCoverage(0.5f - distance);
+}
+
+static inline float LineCoverage(float x, const KnobLineRow &row)
+{
+	// Distance from the closest point on the line segment
+	const float t = ClampCoverage(((x - row.startX) * row.deltaX + row.rowTerm) * row.invLengthSquared);
+	const float ex = x - (row.startX + t * row.deltaX);
+	const float ey = row.y - (row.startY + t * row.deltaY);
+	return ClampCoverage(1.0f - sqrtf(ex * ex + ey * ey));
+}
+
+static inline void BlendPixel(KnobColor &pixel, float coverage, const KnobColor &color, float colorAlpha)
+{
+	const float alpha = coverage * colorAlpha;
+	const float keep = 1.0f - alpha;
+
+	pixel.r = (uint8_t)((float)pixel.r * keep + (float)color.r * alpha + 0.5f);
+	pixel.g = (uint8_t)((float)pixel.g * keep + (float)color.g * alpha + 0.5f);
+	pixel.b = (uint8_t)((float)pixel.b * keep + (float)color.b * alpha + 0.5f);
+	pixel.a = (uint8_t)((float)pixel.a * keep + 255.0f * alpha + 0.5f);
+}
+
+
+#ifdef KNOBSIMD_X86
+/// The AVX2 kernels, in knobsimd_avx2.cpp
+extern const KnobSimdKernels g_knobKernelsAvx2;
+#endif
+
+
+#endif  // KNOBSIMD_SCALAR_H__
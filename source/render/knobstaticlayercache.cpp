@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <new>
+#include "knobassetcache.h"
+#include "knobstaticlayercache.h"
+
+
+/// The shared cache. A global object instead of a function-local static, which is not thread-safe with every compiler.
+static KnobStaticLayerCache g_sharedKnobStaticLayerCache;
+
+
+KnobStaticLayerCache::Key::Key(const KnobDrawValues &drawValues) : areaWidth(drawValues.areaWidth), oversampling(drawValues.oversampling), antialiasing(drawValues.antialiasing),
+	scaleLimitRadians(drawValues.scaleLimitRadians), scaleTickCount(drawValues.scaleTickCount), knobOuterCorner1(drawValues.knobOuterCorner1), knobInnerCorner1(drawValues.knobInnerCorner1),
+	knobCenterCorner1(drawValues.knobCenterCorner1), areaColor(drawValues.areaColor), scaleColor(drawValues.scaleColor), knobOuterColor(drawValues.knobOuterColor),
+	knobInnerColor(drawValues.knobInnerColor), knobCenterColor(drawValues.knobCenterColor)
+{}
+
+bool KnobStaticLayerCache::Key::operator ==(const Key &other) const
+{
+	return areaWidth == other.areaWidth && oversampling == other.oversampling && antialiasing == other.antialiasing && scaleLimitRadians == other.scaleLimitRadians
+		&& scaleTickCount == other.scaleTickCount && knobOuterCorner1 == other.knobOuterCorner1 && knobInnerCorner1 == other.knobInnerCorner1 && knobCenterCorner1 == other.knobCenterCorner1
+		&& areaColor == other.areaColor && scaleColor == other.scaleColor && knobOuterColor == other.knobOuterColor && knobInnerColor == other.knobInnerColor && knobCenterColor == other.knobCenterColor;
+}
+
+
+KnobStaticLayerCache::KnobStaticLayerCache(int32_t capacity) : _capacity(std::max(capacity, (int32_t)1))
+{}
+
+std::shared_ptr<const KnobPixelBuffer> KnobStaticLayerCache::Acquire(const KnobDrawValues &drawValues)
+{
+	const Key key(drawValues);
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	for (size_t i = 0; i < _entries.size(); ++i)
+	{
+		if (_entries[i].key == key)
+		{
+			// Move it to the front, the layers at the back are the first to go
+			++_stats.hits;
+			std::rotate(_entries.begin(), _entries.begin() + i, _entries.begin() + i + 1);
+			return _entries.front().layer;
+		}
+	}
+
+	// Not in the cache. Maybe the last session has drawn it, otherwise it's drawn now.
+	// Layers are drawn rarely enough that the other threads can wait for it.
+	++_stats.misses;
+	std::shared_ptr<const KnobPixelBuffer> layer = GetSharedKnobAssetCache().FindStaticLayer(drawValues);
+	if (!layer)
+	{
+		_rasterizer.SetAntialiasing(drawValues.antialiasing);
+		if (!DrawKnobStaticLayer(_rasterizer, drawValues))
+			return std::shared_ptr<const KnobPixelBuffer>();
+
+		layer.reset(new (std::nothrow) KnobPixelBuffer(_rasterizer.GetStaticLayer()));
+		if (!layer || layer->GetWidth() != drawValues.areaWidth)
+			return std::shared_ptr<const KnobPixelBuffer>();
+		GetSharedKnobAssetCache().AddStaticLayer(drawValues, *layer);
+	}
+
+	_entries.insert(_entries.begin(), Entry(key, layer));
+	Trim();
+	return layer;
+}
+
+void KnobStaticLayerCache::SetCapacity(int32_t capacity)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_capacity = std::max(capacity, (int32_t)1);
+	Trim();
+}
+
+void KnobStaticLayerCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_entries.clear();
+	_rasterizer.FreeStaticLayer();
+}
+
+KnobStaticLayerCacheStats KnobStaticLayerCache::GetStats()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	KnobStaticLayerCacheStats stats = _stats;
+	stats.layerCount = (int32_t)_entries.size();
+	for (size_t i = 0; i < _entries.size(); ++i)
+		stats.layerBytes += (int64_t)_entries[i].layer->GetMemorySize();
+	return stats;
+}
+
+void KnobStaticLayerCache::Trim()
+{
+	while ((int32_t)_entries.size() > _capacity)
+	{
+		_entries.pop_back();
+		++_stats.evictions;
+	}
+}
+
+
+KnobStaticLayerCache &GetSharedKnobStaticLayerCache()
+{
+	return g_sharedKnobStaticLayerCache;
+}
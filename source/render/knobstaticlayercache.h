@@ -0,0 +1,108 @@
+#ifndef KNOBSTATICLAYERCACHE_H__
+#define KNOBSTATICLAYERCACHE_H__
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "knobpainter.h"
+#include "knobpixelbuffer.h"
+#include "knobrasterizer.h"
+
+
+static const int32_t KNOBSTATICLAYERCACHE_CAPACITY = 8;  ///< Default number of static layers the cache keeps
+
+
+/// Counters of a KnobStaticLayerCache
+struct KnobStaticLayerCacheStats
+{
+	int64_t hits;        ///< Static layers found in the cache
+	int64_t misses;      ///< Static layers that had to be drawn
+	int64_t evictions;   ///< Static layers dropped because the cache was full
+	int32_t layerCount;  ///< Static layers in the cache
+	int64_t layerBytes;  ///< Memory of the static layers in the cache
+
+	KnobStaticLayerCacheStats() : hits(0), misses(0), evictions(0), layerCount(0), layerBytes(0)
+	{}
+};
+
+
+/// Cache of static layers (background, scale and knob), shared by all knobs and render threads.
+/// There is one layer for each combination of size, pixel scale, oversampling, scale lines and colors that is in use,
+/// so knobs of the same kind don't draw their own, and a renderer that switches between knobs of different sizes
+/// takes the layers from here instead of drawing them again for every knob. The cache keeps a limited number of
+/// layers, and drops the one that was used the longest time ago when it is full. Layers that are dropped while
+/// a renderer still uses them stay alive until it lets go of them.
+/// Layers that are not in the cache are taken from the shared KnobAssetCache if the last session has drawn them.
+/// The layers are drawn by a KnobRasterizer, so they are only what a ClipMapKnobRenderer draws with anti-aliasing.
+/// All functions are thread-safe.
+class KnobStaticLayerCache
+{
+public:
+	/// @param[in] capacity Maximum number of static layers
+	explicit KnobStaticLayerCache(int32_t capacity = KNOBSTATICLAYERCACHE_CAPACITY);
+
+	/// Return the static layer for a set of draw values. Draws it if it is not in the cache.
+	/// @param[in] drawValues The draw values
+	/// @return The static layer, or an empty pointer if it could not be drawn
+	std::shared_ptr<const KnobPixelBuffer> Acquire(const KnobDrawValues &drawValues);
+
+	/// Set the maximum number of static layers. Drops the least recently used ones if there are more.
+	void SetCapacity(int32_t capacity);
+
+	/// Drop all static layers, e.g. when the colors have changed
+	void Clear();
+
+	/// Return the counters
+	KnobStaticLayerCacheStats GetStats();
+
+private:
+	/// Everything a static layer depends on
+	struct Key
+	{
+		int32_t   areaWidth;
+		int32_t   oversampling;
+		bool      antialiasing;
+		double    scaleLimitRadians;
+		int32_t   scaleTickCount;
+		int32_t   knobOuterCorner1;
+		int32_t   knobInnerCorner1;
+		int32_t   knobCenterCorner1;
+		KnobColor areaColor;
+		KnobColor scaleColor;
+		KnobColor knobOuterColor;
+		KnobColor knobInnerColor;
+		KnobColor knobCenterColor;
+
+		explicit Key(const KnobDrawValues &drawValues);
+
+		bool operator ==(const Key &other) const;
+	};
+
+	/// A static layer in the cache
+	struct Entry
+	{
+		Key key;                                       ///< What the layer was drawn for
+		std::shared_ptr<const KnobPixelBuffer> layer;  ///< The layer
+
+		Entry(const Key &k, const std::shared_ptr<const KnobPixelBuffer> &l) : key(k), layer(l)
+		{}
+	};
+
+	/// Drop the least recently used layers until there are no more than the capacity
+	/// @note: _lock must be held
+	void Trim();
+
+private:
+	std::mutex                 _lock;        ///< Protects everything below
+	std::vector<Entry>         _entries;     ///< The layers, the most recently used one first
+	int32_t                    _capacity;    ///< Maximum number of layers
+	KnobRasterizer             _rasterizer;  ///< Draws the layers
+	KnobStaticLayerCacheStats  _stats;       ///< Counters, without layerCount and layerBytes
+};
+
+
+/// Return the static layer cache that all knobs in the process share
+KnobStaticLayerCache &GetSharedKnobStaticLayerCache();
+
+
+#endif  // KNOBSTATICLAYERCACHE_H__
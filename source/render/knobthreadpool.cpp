@@ -0,0 +1,173 @@
+#include <algorithm>
+#include "knobthreadpool.h"
+
+
+/// Return the number of workers to use
+/// @param[in] workerCount Requested number of workers, 0 for one per hardware thread
+static int32_t GetKnobWorkerCount(int32_t workerCount)
+{
+	if (workerCount <= 0)
+		workerCount = (int32_t)std::thread::hardware_concurrency();
+
+	return std::min(std::max(workerCount, (int32_t)1), KNOBTHREADPOOL_MAXWORKERS);
+}
+
+
+KnobThreadPool::KnobThreadPool(int32_t workerCount) : _ranges((size_t)GetKnobWorkerCount(workerCount)), _job(nullptr), _generation(0), _busy(0), _quit(false), _steals(0)
+{
+	_threads.reserve(_ranges.size() - 1);
+	for (int32_t worker = 1; worker < (int32_t)_ranges.size(); ++worker)
+		_threads.push_back(std::thread(&KnobThreadPool::WorkerThread, this, worker));
+}
+
+KnobThreadPool::~KnobThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_quit = true;
+	}
+	_started.notify_all();
+
+	for (size_t i = 0; i < _threads.size(); ++i)
+		_threads[i].join();
+}
+
+void KnobThreadPool::Run(int32_t count, KnobParallelJob &job)
+{
+	if (count <= 0)
+		return;
+
+	std::lock_guard<std::mutex> runLock(_runLock);
+
+	// Nothing to share, don't wake anyone up
+	const int32_t workerCount = GetWorkerCount();
+	if (workerCount == 1 || count == 1)
+	{
+		for (int32_t index = 0; index < count; ++index)
+			job.Execute(index, 0);
+		return;
+	}
+
+	// Equal shares for everyone. The workers are all waiting, so nobody looks at the ranges yet.
+	for (int32_t worker = 0; worker < workerCount; ++worker)
+	{
+		Range &range = _ranges[worker];
+		range.begin = (int32_t)((int64_t)count * worker / workerCount);
+		range.end = (int32_t)((int64_t)count * (worker + 1) / workerCount);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_job = &job;
+		_busy = workerCount;
+		++_generation;
+	}
+	_started.notify_all();
+
+	Work(0);
+
+	// The others may still be busy with their last item
+	std::unique_lock<std::mutex> lock(_lock);
+	--_busy;
+	_finished.wait(lock, [this] { return _busy == 0; });
+	_job = nullptr;
+}
+
+void KnobThreadPool::WorkerThread(int32_t worker)
+{
+	int64_t generation = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			_started.wait(lock, [this, generation] { return _quit || _generation != generation; });
+			if (_quit)
+				return;
+			generation = _generation;
+		}
+
+		Work(worker);
+
+		bool last = false;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			last = --_busy == 0;
+		}
+		if (last)
+			_finished.notify_all();
+	}
+}
+
+void KnobThreadPool::Work(int32_t worker)
+{
+	int32_t index = 0;
+	for (;;)
+	{
+		while (TakeItem(worker, index))
+			_job->Execute(index, worker);
+
+		if (!Steal(worker))
+			return;
+	}
+}
+
+bool KnobThreadPool::TakeItem(int32_t worker, int32_t &index)
+{
+	Range &range = _ranges[worker];
+	std::lock_guard<std::mutex> lock(range.lock);
+	if (range.begin >= range.end)
+		return false;
+
+	index = range.begin++;
+	return true;
+}
+
+bool KnobThreadPool::Steal(int32_t worker)
+{
+	const int32_t workerCount = GetWorkerCount();
+	for (;;)
+	{
+		// Look for the fullest range. It may have shrunk by the time it's locked again.
+		int32_t victim = -1;
+		int32_t victimCount = 0;
+		for (int32_t i = 1; i < workerCount; ++i)
+		{
+			const int32_t other = (worker + i) % workerCount;
+			Range &range = _ranges[other];
+			std::lock_guard<std::mutex> lock(range.lock);
+			const int32_t count = range.end - range.begin;
+			if (count > victimCount)
+			{
+				victim = other;
+				victimCount = count;
+			}
+		}
+
+		if (victim < 0)
+			return false;
+
+		// Take the back half, the owner keeps working on the front. With a single item left, take that.
+		int32_t begin = 0;
+		int32_t end = 0;
+		{
+			Range &range = _ranges[victim];
+			std::lock_guard<std::mutex> lock(range.lock);
+			const int32_t count = range.end - range.begin;
+			if (count <= 0)
+				continue;  // Someone was faster, look again
+
+			begin = range.end - (count + 1) / 2;
+			end = range.end;
+			range.end = begin;
+		}
+
+		Range &own = _ranges[worker];
+		{
+			std::lock_guard<std::mutex> lock(own.lock);
+			own.begin = begin;
+			own.end = end;
+		}
+		++_steals;
+		return true;
+	}
+}
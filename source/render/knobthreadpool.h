@@ -0,0 +1,100 @@
+#ifndef KNOBTHREADPOOL_H__
+#define KNOBTHREADPOOL_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+static const int32_t KNOBTHREADPOOL_MAXWORKERS = 64;  ///< Maximum number of workers, including the calling thread
+
+
+/// A job for KnobThreadPool::Run(), split into items that can be processed independently
+class KnobParallelJob
+{
+public:
+	virtual ~KnobParallelJob()
+	{}
+
+	/// Process one item. Called concurrently for different items.
+	/// @param[in] index Index of the item, 0 ... count - 1
+	/// @param[in] worker Index of the worker that calls this, 0 ... GetWorkerCount() - 1. Each worker only runs one item at a time,
+	/// so per-worker scratch data can be used without locking. Worker 0 is the thread that called Run().
+	virtual void Execute(int32_t index, int32_t worker) = 0;
+};
+
+
+/// Runs the items of a job on a fixed set of threads, with work stealing.
+/// Each worker starts with an equal share of the item range and takes items from the front of it.
+/// A worker that runs out steals the back half of the biggest range left, so items that take
+/// longer than others don't leave the rest of the threads waiting. The thread that calls Run()
+/// works on the job, too, and Run() only returns when all items are done.
+class KnobThreadPool
+{
+public:
+	/// @param[in] workerCount Number of workers including the calling thread, 0 for one per hardware thread
+	explicit KnobThreadPool(int32_t workerCount = 0);
+	~KnobThreadPool();
+
+	/// Return the number of workers, including the calling thread
+	int32_t GetWorkerCount() const
+	{
+		return (int32_t)_ranges.size();
+	}
+
+	/// Process all items of a job. Only one job runs at a time, other callers wait.
+	/// @param[in] count Number of items
+	/// @param[in] job The job
+	void Run(int32_t count, KnobParallelJob &job);
+
+	/// Return the number of times a worker has taken items from another worker's range
+	int64_t GetStealCount() const
+	{
+		return _steals.load();
+	}
+
+private:
+	/// Items of the current job that a worker still has to process
+	struct Range
+	{
+		std::mutex lock;   ///< Protects begin and end, the owner and thieves take items from here
+		int32_t    begin;  ///< First item left
+		int32_t    end;    ///< One after the last item left
+
+		Range() : begin(0), end(0)
+		{}
+	};
+
+	/// Wait for jobs and work on them, until the pool is destroyed
+	void WorkerThread(int32_t worker);
+
+	/// Process items of the current job until there are none left in any range
+	void Work(int32_t worker);
+
+	/// Take the next item from a worker's own range
+	/// @return False if the range is empty
+	bool TakeItem(int32_t worker, int32_t &index);
+
+	/// Move the back half of the fullest other range into a worker's own range
+	/// @return False if there was nothing left to steal
+	bool Steal(int32_t worker);
+
+private:
+	std::vector<Range>        _ranges;     ///< Item ranges, one per worker
+	std::vector<std::thread>  _threads;    ///< Workers 1 ... n, worker 0 is the calling thread
+	std::mutex                _runLock;    ///< Only one Run() at a time
+	std::mutex                _lock;       ///< Protects the job state below
+	std::condition_variable   _started;    ///< Signals a new job, or the end of the pool
+	std::condition_variable   _finished;   ///< Signals that a worker is done with the job
+	KnobParallelJob          *_job;        ///< The current job
+	int64_t                   _generation; ///< Incremented for every job, so a worker doesn't run the same job twice
+	int32_t                   _busy;       ///< Workers still working on the current job
+	bool                      _quit;       ///< True if the threads should end
+	std::atomic<int64_t>      _steals;     ///< Number of steals
+};
+
+
+#endif  // KNOBTHREADPOOL_H__
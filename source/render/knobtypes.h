@@ -0,0 +1,95 @@
+#ifndef KNOBTYPES_H__
+#define KNOBTYPES_H__
+
+#include <stdint.h>
+
+
+/// 8 bit RGBA color, as used by the knob renderers
+struct KnobColor
+{
+	uint8_t r;  ///< Red
+	uint8_t g;  ///< Green
+	uint8_t b;  ///< Blue
+	uint8_t a;  ///< Alpha (255 = opaque)
+
+	/// Default constructor, opaque black
+	KnobColor() : r(0), g(0), b(0), a(255)
+	{}
+
+	/// Construct from separate RGBA values (0 ... 255)
+	KnobColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = 255) : r(red), g(green), b(blue), a(alpha)
+	{}
+
+	/// Construct from float color components (0.0 ... 1.0), e.g. the components of a C4D color Vector
+	static KnobColor FromFloat(double red, double green, double blue)
+	{
+		return KnobColor((uint8_t)(red * 255.0), (uint8_t)(green * 255.0), (uint8_t)(blue * 255.0));
+	}
+
+	bool operator ==(const KnobColor &other) const
+	{
+		return r == other.r && g == other.g && b == other.b && a == other.a;
+	}
+
+	bool operator !=(const KnobColor &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+
+/// Integer 2D point, equivalent to GE_POINT2D
+struct KnobPoint
+{
+	int32_t x;
+	int32_t y;
+};
+
+
+/// 2D point with subpixel precision, for shapes that are drawn anti-aliased
+struct KnobPointF
+{
+	double x;
+	double y;
+};
+
+
+/// The set of colors a knob is drawn with
+struct KnobTheme
+{
+	KnobColor areaColor;        ///< Background of the knob area
+	KnobColor scaleColor;       ///< Scale lines
+	KnobColor knobOuterColor;   ///< Outer circle of the knob
+	KnobColor knobInnerColor;   ///< Inner circle of the knob
+	KnobColor knobCenterColor;  ///< Center of the knob
+	KnobColor markerColor;      ///< Value marker
+	KnobColor labelColor;       ///< Value label
+
+	/// Returns a theme that resembles the default Cinema 4D interface colors.
+	/// Used when rendering without the host application.
+	static KnobTheme Default()
+	{
+		KnobTheme theme;
+		theme.areaColor = KnobColor(51, 51, 51);
+		theme.scaleColor = KnobColor(34, 34, 34);
+		theme.knobOuterColor = KnobColor(34, 34, 34);
+		theme.knobInnerColor = KnobColor(26, 26, 26);
+		theme.knobCenterColor = KnobColor(102, 102, 102);
+		theme.markerColor = KnobColor(102, 102, 102);
+		theme.labelColor = KnobColor(204, 204, 204);
+		return theme;
+	}
+
+	bool operator ==(const KnobTheme &other) const
+	{
+		return areaColor == other.areaColor && scaleColor == other.scaleColor && knobOuterColor == other.knobOuterColor && knobInnerColor == other.knobInnerColor && knobCenterColor == other.knobCenterColor && markerColor == other.markerColor && labelColor == other.labelColor;
+	}
+
+	bool operator !=(const KnobTheme &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+
+#endif  // KNOBTYPES_H__